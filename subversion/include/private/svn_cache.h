@@ -561,6 +561,17 @@ svn_cache__get_global_membuffer_cache(void);
 svn_cache__info_t *
 svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 
+/**
+ * Set @a *gets and @a *hits to the total number of lookups and cache hits
+ * over all segments of the global membuffer cache.  Unlike
+ * svn_cache__membuffer_get_global_info(), this neither locks the cache nor
+ * allocates memory, making it cheap enough to be called per request.
+ * Both will be 0 if there is no global membuffer cache.
+ */
+void
+svn_cache__membuffer_get_global_access_stats(apr_uint64_t *gets,
+                                             apr_uint64_t *hits);
+
 /**
  * Remove all current contents from CACHE.
  *
@@ -211,6 +211,59 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Read the current revision property generation of @a fs from disk and
+ * return it in @a *generation.  The generation changes whenever any
+ * revision property in @a fs gets modified; an odd value indicates that
+ * such a modification is in progress.  Data derived from revprops can
+ * therefore be cached for as long as the even generation does not change.
+ *
+ * Set @a *supported to FALSE if the backend or the repository format does
+ * not track a revprop generation; @a *generation is undefined then.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_fs__try_get_revprop_generation(svn_boolean_t *supported,
+                                   apr_int64_t *generation,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool);
+
+/** Set @a *instance_id to a string that identifies the on-disk instance
+ * of @a fs, allocated in @a result_pool.  Unlike the UUID, it changes
+ * whenever the repository gets created, recovered or hotcopied.  Data
+ * that outlives the process, e.g. in a cache on disk, must be tagged with
+ * it if it depends on the revprop generation.
+ *
+ * Set @a *instance_id to NULL if the backend does not provide one.
+ */
+svn_error_t *
+svn_fs__try_get_instance_id(const char **instance_id,
+                            svn_fs_t *fs,
+                            apr_pool_t *result_pool);
+
+/** Attempt to locate the contents of the file @a path under @a root as
+ * a contiguous range of unprocessed bytes within some repository file,
+ * e.g. to transmit it to a network peer without copying it through user
+ * space.
+ *
+ * On success, set @a *file to an open file handle, allocated in
+ * @a result_pool, set @a *offset and @a *length to the range within it
+ * that holds the fulltext and set @a *success to TRUE.  If the backend
+ * doesn't support this or the data is not stored as a plain fulltext,
+ * set @a *success to FALSE; the other outputs are undefined then.
+ *
+ * Unlike svn_fs_file_contents(), the data will not be checksummed.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_fs__try_get_file_range(svn_boolean_t *success,
+                           apr_file_t **file,
+                           apr_off_t *offset,
+                           svn_filesize_t *length,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
 
 /** @} */
 
@@ -104,6 +104,39 @@ do {                                                    \
   SVN_ERR(svn_mutex__unlock(svn_mutex__m, (expr)));     \
 } while (0)
 
+/**
+ * This is a simple wrapper around @c apr_thread_cond_t and will be a
+ * valid identifier even if APR does not support threading.
+ */
+
+/** A condition variable for signalling between threads.
+ */
+typedef struct svn_thread_cond__t svn_thread_cond__t;
+
+/** Create the condition variable @a *cond with a lifetime defined by
+ * @a result_pool.
+ *
+ * If threading is not supported by APR, the condition variable will be
+ * a dummy and all operations on it will be no-ops.
+ */
+svn_error_t *
+svn_thread_cond__create(svn_thread_cond__t **cond,
+                        apr_pool_t *result_pool);
+
+/** Wake up all threads waiting on @a cond.
+ */
+svn_error_t *
+svn_thread_cond__broadcast(svn_thread_cond__t *cond);
+
+/** Release @a mutex and wait until @a cond gets signalled.  @a mutex
+ * will be re-acquired before returning.  The caller must hold the lock
+ * on @a mutex, i.e. it must have been created with @c mutex_required
+ * set in svn_mutex__init().
+ */
+svn_error_t *
+svn_thread_cond__wait(svn_thread_cond__t *cond,
+                      svn_mutex__t *mutex);
+
 #if APR_HAS_THREADS
 
 /** Return the APR mutex encapsulated in @a mutex.
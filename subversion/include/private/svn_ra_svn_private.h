@@ -169,6 +169,27 @@ svn_ra_svn__write_string(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
                          const svn_string_t *str);
 
+/** Return TRUE if svn_ra_svn__write_file_range() may be used on @a conn.
+ * This is only the case for plain socket connections that are neither
+ * encrypted nor compressed.
+ */
+svn_boolean_t
+svn_ra_svn__can_write_file_range(svn_ra_svn_conn_t *conn);
+
+/** Write @a len bytes starting at @a offset in @a file over the net as
+ * a single string item.  The data will be passed from @a file to the
+ * socket by the kernel without being copied through user space.
+ *
+ * Only call this if svn_ra_svn__can_write_file_range() returned TRUE.
+ * Pending writes will be flushed before the data gets sent.
+ */
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len);
+
 /** Write a cstring over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -275,6 +296,96 @@ svn_ra_svn__read_item(svn_ra_svn_conn_t *conn,
                       apr_pool_t *pool,
                       svn_ra_svn__item_t **item);
 
+/** Flush @a conn and compress all data sent and received through it from
+ * now on.  Both sides of the connection must do this at the same point
+ * of the protocol exchange, i.e. after the client's response to the
+ * server greeting if both announced #SVN_RA_SVN_CAP_COMPRESSED_STREAM.
+ * Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool);
+
+/** Start recording all data written to @a conn, allocated in
+ * @a result_pool.  Data written before this call is not part of the
+ * recording.  The recording fails once it would grow beyond @a max_size
+ * bytes or when data gets read from @a conn before the recording ends.
+ * Only one recording may be active on @a conn at any time.
+ */
+svn_error_t *
+svn_ra_svn__start_recording(svn_ra_svn_conn_t *conn,
+                            apr_size_t max_size,
+                            apr_pool_t *result_pool);
+
+/** End the recording started by svn_ra_svn__start_recording() on @a conn
+ * and return the data written to @a conn since then.  Return NULL if the
+ * recording failed or no recording was active.
+ */
+svn_stringbuf_t *
+svn_ra_svn__stop_recording(svn_ra_svn_conn_t *conn);
+
+/** Write the @a len bytes at @a data verbatim to @a conn.  @a data must
+ * be a sequence of complete protocol items, e.g. a recording returned by
+ * svn_ra_svn__stop_recording().
+ *
+ * Writes will be buffered until the next read or flush.
+ */
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len);
+
+/** Network I/O statistics of an ra_svn connection, accumulated over its
+ * whole lifetime.  The times include any time spent blocked in the
+ * respective I/O calls, i.e. waiting for the peer or the network.
+ */
+typedef struct svn_ra_svn__io_stats_t
+{
+  /** Number of bytes written to / read from the underlying stream or
+   * socket.  For compressed connections, these are the uncompressed
+   * numbers. */
+  apr_uint64_t bytes_sent;
+  apr_uint64_t bytes_received;
+
+  /** Number of write / read calls issued to the underlying stream. */
+  apr_uint64_t send_calls;
+  apr_uint64_t receive_calls;
+
+  /** Total time spent in these calls. */
+  apr_interval_time_t send_time;
+  apr_interval_time_t receive_time;
+} svn_ra_svn__io_stats_t;
+
+/** Return the I/O statistics collected for @a conn so far.  The result
+ * will be updated as @a conn gets used.
+ */
+const svn_ra_svn__io_stats_t *
+svn_ra_svn__get_io_stats(svn_ra_svn_conn_t *conn);
+
+/** Callback invoked by svn_ra_svn__handle_command() around the execution
+ * of each top-level command @a cmdname received on @a conn.  It is called
+ * with @a finished set to FALSE right before the command handler runs and
+ * with @a finished set to TRUE once the command and its response are
+ * complete.  Commands nested within another command, e.g. the reporter
+ * commands of an update, will not be reported separately.  @a baton is
+ * the baton passed to svn_ra_svn__set_command_callback().  Use @a pool
+ * for temporary allocations.
+ */
+typedef svn_error_t *(*svn_ra_svn__command_cb_t)(void *baton,
+                                                 svn_ra_svn_conn_t *conn,
+                                                 const char *cmdname,
+                                                 svn_boolean_t finished,
+                                                 apr_pool_t *pool);
+
+/** Make @a conn invoke @a callback with @a baton for every command it
+ * handles.  Pass NULL for @a callback to disable the notification again.
+ */
+void
+svn_ra_svn__set_command_callback(svn_ra_svn_conn_t *conn,
+                                 svn_ra_svn__command_cb_t callback,
+                                 void *baton);
+
 /** Scan data on @a conn until we find something which looks like the
  * beginning of an svn server greeting (an open paren followed by a
  * whitespace character).  This function is appropriate for beginning
@@ -128,6 +128,82 @@ svn_repos__fs_type(const char **fs_type,
                    apr_pool_t *pool);
 
 
+/* Return a value that identifies the rules contents of AUTHZ, e.g. for
+ * use in cache keys.  Two authz objects with the same identity grant the
+ * same access.  Return NULL if AUTHZ has no such identity, e.g. because
+ * it has been created by svn_repos_authz_parse().
+ */
+const svn_membuf_t *
+svn_repos__authz_get_id(const svn_authz_t *authz);
+
+/* Let the reporter REPORT_BATON, as returned by svn_repos_begin_report3(),
+ * compute file deltas on up to WORKERS threads ahead of the editor drive.
+ * The editor will still be driven sequentially by the thread calling
+ * svn_repos_finish_report().  Each worker opens its own FS instance
+ * using FS_CONFIG, which must remain valid until the report is finished.
+ *
+ * A WORKERS count of 0 disables this feature, which is also the default.
+ * It is silently ignored if APR does not support threads or if the FS
+ * caches have been configured as single-threaded.
+ */
+svn_error_t *
+svn_repos__report_set_workers(void *report_baton,
+                              int workers,
+                              apr_hash_t *fs_config);
+
+/* Let svn_repos_get_logs5() on REPOS prepare the changed paths and
+ * revprops of upcoming log entries on up to WORKERS threads.  The log
+ * receivers as well as the authz callback will still be invoked in order
+ * by the thread calling svn_repos_get_logs5().  Each worker opens its own
+ * FS instance using FS_CONFIG, which must remain valid as long as REPOS.
+ *
+ * This applies whenever the sequence of revisions to log is known in
+ * advance, i.e. for unrestricted logs of the repository root and for
+ * logs in ascending order.  Logs that include merged revisions are never
+ * prepared ahead of time.
+ *
+ * A WORKERS count of 0 disables this feature, which is also the default.
+ * It is silently ignored if APR does not support threads or if the FS
+ * caches have been configured as single-threaded.
+ */
+void
+svn_repos__set_log_workers(svn_repos_t *repos,
+                           int workers,
+                           apr_hash_t *fs_config);
+
+/* A directory of recorded checkout editor drives, shared between all
+ * repositories of a server.  Instances may be used concurrently.
+ */
+typedef struct svn_repos__checkout_cache_t svn_repos__checkout_cache_t;
+
+/* Set *CACHE to a checkout cache that keeps its entries in the directory
+ * PATH, creating it as needed.  Once the entries exceed MAX_SIZE bytes
+ * in total, the least recently used ones will be removed.  Allocate the
+ * result in RESULT_POOL.
+ */
+svn_error_t *
+svn_repos__checkout_cache_create(svn_repos__checkout_cache_t **cache,
+                                 const char *path,
+                                 apr_uint64_t max_size,
+                                 apr_pool_t *result_pool);
+
+/* Let the reporter REPORT_BATON, as returned by svn_repos_begin_report3(),
+ * use CACHE for reports that turn out to be plain checkouts: a single
+ * empty report at depth infinity.  The editor drives for those will be
+ * recorded and replayed from CACHE instead of comparing trees.
+ *
+ * VIEW identifies the caller's read authorization, e.g. the authz rules
+ * and user name.  The caller guarantees that the authz_read_func given
+ * to svn_repos_begin_report3() returns the same results for every report
+ * using the same VIEW.  If VIEW is NULL, e.g. because the authorization
+ * cannot be identified, the cache will not be used.  Otherwise, VIEW must
+ * remain valid until the report is finished.
+ */
+svn_error_t *
+svn_repos__report_set_checkout_cache(void *report_baton,
+                                     svn_repos__checkout_cache_t *cache,
+                                     const char *view);
+
 /* Create a commit editor for REPOS, based on REVISION.  */
 svn_error_t *
 svn_repos__get_commit_ev2(svn_editor_t **editor,
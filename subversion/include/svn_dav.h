@@ -171,6 +171,23 @@ extern "C" {
  * @since New in 1.7.  */
 #define SVN_DAV_VTXN_ROOT_STUB_HEADER "SVN-VTxn-Root-Stub"
 
+/** This header provides an opaque URI that the client can append the
+ * hex SHA1 digest of file contents to, in order to construct a URI for
+ * these contents that does not depend on their path.  Caches can share
+ * such resources across branches and tags.  GET requests against them
+ * must name a location of the contents in
+ * @c SVN_DAV_SHA1_SOURCE_HEADER.  (HTTP protocol v2 only)
+ * @since New in 1.11.  */
+#define SVN_DAV_SHA1_STUB_HEADER "SVN-Sha1-Stub"
+
+/** This header is used in GET requests against a resource below
+ * @c SVN_DAV_SHA1_STUB_HEADER to name a file that has the requested
+ * contents, as PEGREV/PATH (relative to @c SVN_DAV_REV_ROOT_STUB_HEADER).
+ * The server reads the contents from there and authorizes the request
+ * against that path.  (HTTP protocol v2 only)
+ * @since New in 1.11.  */
+#define SVN_DAV_SHA1_SOURCE_HEADER "SVN-Sha1-Source"
+
 /** This header is used in the POST response to tell the client the
  * name of the Subversion transaction created by the request.  It can
  * then be appended to the transaction stub and transaction root stub
@@ -422,6 +439,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM\
             SVN_DAV_PROP_NS_DAV "svn/put-result-checksum"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to send
+ * the contents of small files inline in skelta mode update reports.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_INLINE_FILES\
+            SVN_DAV_PROP_NS_DAV "svn/inline-files"
+
 /** @} */
 
 /** @} */
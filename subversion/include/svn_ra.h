@@ -1075,6 +1075,73 @@ svn_ra_get_file(svn_ra_session_t *session,
                 apr_hash_t **props,
                 apr_pool_t *pool);
 
+/**
+ * A file to be fetched by svn_ra_get_files().  @a path is relative to
+ * the session URL.  @a revision may be SVN_INVALID_REVNUM, indicating
+ * that the HEAD revision should be used.
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_ra_file_spec_t
+{
+  const char *path;
+  svn_revnum_t revision;
+} svn_ra_file_spec_t;
+
+/**
+ * Callback type to be used with svn_ra_get_files().  It will be invoked
+ * once for every requested file, in the order they were requested,
+ * before the file's contents get delivered.
+ *
+ * @a idx is the index of the file in the request array and
+ * @a fetched_rev the actual revision that was retrieved.  If properties
+ * have been requested, @a props contains @em all properties of the file
+ * as described for svn_ra_get_file(); otherwise it is @c NULL.
+ *
+ * If contents have been requested, set @a *stream to the stream that
+ * shall receive them or to @c NULL to discard them.  The stream will be
+ * closed after the last byte has been written.
+ *
+ * @a baton is the user-provided receiver baton.  Allocate @a *stream in
+ * @a result_pool; @a scratch_pool may be used for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_ra_file_receiver_t)(svn_stream_t **stream,
+                                               void *baton,
+                                               int idx,
+                                               svn_revnum_t fetched_rev,
+                                               apr_hash_t *props,
+                                               apr_pool_t *result_pool,
+                                               apr_pool_t *scratch_pool);
+
+/**
+ * Fetch the contents and / or properties of all files in @a files, which
+ * is an array of <tt>svn_ra_file_spec_t *</tt>, and pass them to
+ * @a receiver with @a receiver_baton.  Retrieve the properties only if
+ * @a want_props is set and the contents only if @a want_contents is set.
+ *
+ * This is equivalent to calling svn_ra_get_file() for every element of
+ * @a files but RA layers may implement it with far fewer network round
+ * trips.  RA layers that don't support this natively will emulate it.
+ *
+ * If one of the files cannot be retrieved, return the respective error.
+ * No further files will be processed in that case.
+ *
+ * The stream handlers and @a receiver may not perform any RA operations
+ * using @a session.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_boolean_t want_contents,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 /**
  * If @a dirents is non @c NULL, set @a *dirents to contain all the entries
  * of directory @a path at @a revision.  The keys of @a dirents will be
@@ -71,6 +71,10 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* server supports the get-files command */
+#define SVN_RA_SVN_CAP_GET_FILES "get-files"
+/* compress the whole connection after the initial handshake */
+#define SVN_RA_SVN_CAP_COMPRESSED_STREAM "compressed-stream"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -1728,6 +1728,61 @@ svn_fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                            target_root, target_path, pool));
 }
 
+svn_error_t *
+svn_fs__try_get_revprop_generation(svn_boolean_t *supported,
+                                   apr_int64_t *generation,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool)
+{
+  if (fs->vtable->get_revprop_generation == NULL)
+    {
+      *supported = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->get_revprop_generation(supported,
+                                                            generation, fs,
+                                                            scratch_pool));
+}
+
+svn_error_t *
+svn_fs__try_get_instance_id(const char **instance_id,
+                            svn_fs_t *fs,
+                            apr_pool_t *result_pool)
+{
+  if (fs->vtable->get_instance_id == NULL)
+    {
+      *instance_id = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->get_instance_id(instance_id, fs,
+                                                     result_pool));
+}
+
+svn_error_t *
+svn_fs__try_get_file_range(svn_boolean_t *success,
+                           apr_file_t **file,
+                           apr_off_t *offset,
+                           svn_filesize_t *length,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  if (root->vtable->try_get_file_range == NULL)
+    {
+      *success = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(root->vtable->try_get_file_range(success, file,
+                                                          offset, length,
+                                                          root, path,
+                                                          result_pool,
+                                                          scratch_pool));
+}
+
 svn_error_t *
 svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          const char **node_path,
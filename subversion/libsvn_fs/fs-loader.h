@@ -266,6 +266,15 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  /* May be NULL if not supported by the backend. */
+  svn_error_t *(*get_revprop_generation)(svn_boolean_t *supported,
+                                         apr_int64_t *generation,
+                                         svn_fs_t *fs,
+                                         apr_pool_t *scratch_pool);
+  /* May be NULL if not supported by the backend. */
+  svn_error_t *(*get_instance_id)(const char **instance_id,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *result_pool);
 } fs_vtable_t;
 
 
@@ -427,6 +436,16 @@ typedef struct root_vtable_t
                                 svn_fs_mergeinfo_receiver_t receiver,
                                 void *baton,
                                 apr_pool_t *scratch_pool);
+
+  /* Zero-copy support.  May be NULL. */
+  svn_error_t *(*try_get_file_range)(svn_boolean_t *success,
+                                     apr_file_t **file,
+                                     apr_off_t *offset,
+                                     svn_filesize_t *length,
+                                     svn_fs_root_t *root,
+                                     const char *path,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
 } root_vtable_t;
 
 
@@ -399,6 +399,62 @@ fixup_node_revision(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Read the committed node-revision REV_ITEM in FS from the already open
+   REVISION_FILE, which must be the correct rev / pack file w.r.t. REV_ITEM.
+   Add it to the noderev cache, if enabled.  Set *NODEREV_P to the new
+   node-revision structure, allocated in RESULT_POOL.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+read_committed_node_revision(node_revision_t **noderev_p,
+                             svn_fs_t *fs,
+                             const svn_fs_fs__id_part_t *rev_item,
+                             svn_fs_fs__revision_file_t *revision_file,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t offset = -1;
+
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, revision_file,
+                                 rev_item->revision, NULL, rev_item->number,
+                                 scratch_pool));
+  SVN_ERR(aligned_seek(fs, revision_file->file, NULL, offset, scratch_pool));
+
+  if (use_block_read(fs))
+    {
+      /* block-read will parse the whole block and will also return
+         the one noderev that we need right now. */
+      SVN_ERR(block_read((void **)noderev_p, fs,
+                         rev_item->revision,
+                         rev_item->number,
+                         revision_file,
+                         result_pool,
+                         scratch_pool));
+    }
+  else
+    {
+      pair_cache_key_t key = { 0 };
+      key.revision = rev_item->revision;
+      key.second = rev_item->number;
+
+      /* physical addressing mode reading, parsing and caching */
+      SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
+                                      revision_file->stream,
+                                      result_pool,
+                                      scratch_pool));
+      SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
+
+      /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
+      if (ffd->node_revision_cache)
+        SVN_ERR(svn_cache__set(ffd->node_revision_cache,
+                               &key,
+                               *noderev_p,
+                               scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the node-revision for the node ID in FS.
    Set *NODEREV_P to the new node-revision structure, allocated in POOL.
    See svn_fs_fs__get_node_revision, which wraps this and adds another
@@ -465,45 +521,39 @@ get_node_revision_body(node_revision_t **noderev_p,
         }
 
       /* read the data from disk */
-      SVN_ERR(open_and_seek_revision(&revision_file, fs,
-                                     rev_item->revision,
-                                     rev_item->number,
-                                     scratch_pool));
-
-      if (use_block_read(fs))
-        {
-          /* block-read will parse the whole block and will also return
-             the one noderev that we need right now. */
-          SVN_ERR(block_read((void **)noderev_p, fs,
-                             rev_item->revision,
-                             rev_item->number,
-                             revision_file,
-                             result_pool,
-                             scratch_pool));
-        }
-      else
-        {
-          /* physical addressing mode reading, parsing and caching */
-          SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
-                                          revision_file->stream,
-                                          result_pool,
-                                          scratch_pool));
-          SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
-
-          /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
-          if (ffd->node_revision_cache)
-            SVN_ERR(svn_cache__set(ffd->node_revision_cache,
-                                   &key,
-                                   *noderev_p,
-                                   scratch_pool));
-        }
-
+      SVN_ERR(svn_fs_fs__ensure_revision_exists(rev_item->revision, fs,
+                                                scratch_pool));
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&revision_file, fs,
+                                               rev_item->revision,
+                                               scratch_pool, scratch_pool));
+      SVN_ERR(read_committed_node_revision(noderev_p, fs, rev_item,
+                                           revision_file, result_pool,
+                                           scratch_pool));
       SVN_ERR(svn_fs_fs__close_revision_file(revision_file));
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Wrap ERR, returned while reading the node-revision ID, such that it
+   identifies that node-revision if ERR indicates a corruption.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+wrap_noderev_error(svn_error_t *err,
+                   const svn_fs_id_t *id,
+                   apr_pool_t *scratch_pool)
+{
+  if (err && err->apr_err == SVN_ERR_FS_CORRUPT)
+    {
+      svn_string_t *id_string = svn_fs_fs__id_unparse(id, scratch_pool);
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
+                               "Corrupt node-revision '%s'",
+                               id_string->data);
+    }
+
+  return err;
+}
+
 svn_error_t *
 svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              svn_fs_t *fs,
@@ -515,13 +565,7 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
 
   svn_error_t *err = get_node_revision_body(noderev_p, fs, id,
                                             result_pool, scratch_pool);
-  if (err && err->apr_err == SVN_ERR_FS_CORRUPT)
-    {
-      svn_string_t *id_string = svn_fs_fs__id_unparse(id, scratch_pool);
-      return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
-                               "Corrupt node-revision '%s'",
-                               id_string->data);
-    }
+  SVN_ERR(wrap_noderev_error(err, id, scratch_pool));
 
   SVN_ERR(dbg_log_access(fs,
                          rev_item->revision,
@@ -530,7 +574,193 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                          SVN_FS_FS__ITEM_TYPE_NODEREV,
                          scratch_pool));
 
-  return svn_error_trace(err);
+  return SVN_NO_ERROR;
+}
+
+/* A committed node-revision that svn_fs_fs__get_node_revisions still
+   needs to read from disk. */
+typedef struct noderev_request_t
+{
+  /* The node-revision's ID. */
+  const svn_fs_id_t *id;
+
+  /* Position of the ID in the list of IDs given by the caller. */
+  int idx;
+} noderev_request_t;
+
+/* Sort svn_sort__array callback ordering noderev_request_t * elements
+   by revision and item number, i.e. approximately by their position in
+   the rev / pack files. */
+static int
+compare_noderev_requests(const void *lhs,
+                         const void *rhs)
+{
+  const svn_fs_fs__id_part_t *lhs_item
+    = svn_fs_fs__id_rev_item((*(const noderev_request_t * const *)lhs)->id);
+  const svn_fs_fs__id_part_t *rhs_item
+    = svn_fs_fs__id_rev_item((*(const noderev_request_t * const *)rhs)->id);
+
+  if (lhs_item->revision != rhs_item->revision)
+    return lhs_item->revision < rhs_item->revision ? -1 : 1;
+  if (lhs_item->number != rhs_item->number)
+    return lhs_item->number < rhs_item->number ? -1 : 1;
+
+  return 0;
+}
+
+/* Return TRUE, if REVISION_FILE is the rev / pack file that contains
+   revision REV in FS. */
+static svn_boolean_t
+rev_file_contains(svn_fs_fs__revision_file_t *revision_file,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev)
+{
+  if (revision_file->is_packed)
+    return svn_fs_fs__is_packed_rev(fs, rev)
+        && svn_fs_fs__packed_base_rev(fs, rev)
+             == revision_file->start_revision;
+
+  return revision_file->start_revision == rev;
+}
+
+/* Set *IS_CACHED to TRUE, iff the committed node-revision REV_ITEM in FS
+   is in the node-revision cache.  If NODEREV_P is not NULL, return the
+   cached node-revision in *NODEREV_P, allocated in RESULT_POOL.  The
+   cache must exist. */
+static svn_error_t *
+get_cached_node_revision(node_revision_t **noderev_p,
+                         svn_boolean_t *is_cached,
+                         svn_fs_t *fs,
+                         const svn_fs_fs__id_part_t *rev_item,
+                         apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  pair_cache_key_t key = { 0 };
+  key.revision = rev_item->revision;
+  key.second = rev_item->number;
+
+  /* Don't deserialize noderevs that the caller doesn't want. */
+  if (noderev_p)
+    return svn_error_trace(svn_cache__get((void **) noderev_p, is_cached,
+                                          ffd->node_revision_cache, &key,
+                                          result_pool));
+
+  return svn_error_trace(svn_cache__has_key(is_cached,
+                                            ffd->node_revision_cache, &key,
+                                            result_pool));
+}
+
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs_p,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *noderevs
+    = apr_array_make(result_pool, ids->nelts, sizeof(node_revision_t *));
+  apr_array_header_t *requests
+    = apr_array_make(scratch_pool, 0, sizeof(noderev_request_t *));
+  svn_fs_fs__revision_file_t *revision_file = NULL;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Fetch what we can from cache and transactions.  Collect the rest. */
+  for (i = 0; i < ids->nelts; ++i)
+    {
+      const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+      node_revision_t *noderev = NULL;
+      svn_boolean_t found = FALSE;
+
+      svn_pool_clear(iterpool);
+      if (svn_fs_fs__id_is_txn(id))
+        {
+          /* Transaction noderevs don't get cached, i.e. there is nothing
+             to prefetch. */
+          if (noderevs_p)
+            SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id,
+                                                 result_pool, iterpool));
+          found = TRUE;
+        }
+      else if (ffd->node_revision_cache)
+        {
+          SVN_ERR(get_cached_node_revision(noderevs_p ? &noderev : NULL,
+                                           &found, fs,
+                                           svn_fs_fs__id_rev_item(id),
+                                           result_pool));
+        }
+
+      if (!found)
+        {
+          noderev_request_t *request = apr_palloc(scratch_pool,
+                                                  sizeof(*request));
+          request->id = id;
+          request->idx = i;
+          APR_ARRAY_PUSH(requests, noderev_request_t *) = request;
+        }
+
+      APR_ARRAY_PUSH(noderevs, node_revision_t *) = noderev;
+    }
+
+  /* Read the missing ones in file order, re-using the open rev / pack
+   * file as long as possible.  With block-read, reading one noderev will
+   * put its neighbors into the cache as well. */
+  svn_sort__array(requests, compare_noderev_requests);
+  for (i = 0; i < requests->nelts; ++i)
+    {
+      noderev_request_t *request
+        = APR_ARRAY_IDX(requests, i, noderev_request_t *);
+      const svn_fs_fs__id_part_t *rev_item
+        = svn_fs_fs__id_rev_item(request->id);
+      node_revision_t **noderev_p
+        = &APR_ARRAY_IDX(noderevs, request->idx, node_revision_t *);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* A previous block-read may have cached this one already. */
+      if (ffd->node_revision_cache && use_block_read(fs))
+        {
+          svn_boolean_t is_cached;
+
+          SVN_ERR(get_cached_node_revision(noderevs_p ? noderev_p : NULL,
+                                           &is_cached, fs, rev_item,
+                                           result_pool));
+          if (is_cached)
+            continue;
+        }
+
+      if (   revision_file
+          && !rev_file_contains(revision_file, fs, rev_item->revision))
+        {
+          SVN_ERR(svn_fs_fs__close_revision_file(revision_file));
+          revision_file = NULL;
+        }
+
+      if (!revision_file)
+        {
+          SVN_ERR(svn_fs_fs__ensure_revision_exists(rev_item->revision, fs,
+                                                    iterpool));
+          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&revision_file, fs,
+                                                   rev_item->revision,
+                                                   scratch_pool, iterpool));
+        }
+
+      err = read_committed_node_revision(noderev_p, fs, rev_item,
+                                         revision_file, result_pool,
+                                         iterpool);
+      SVN_ERR(wrap_noderev_error(err, request->id, iterpool));
+    }
+
+  if (revision_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(revision_file));
+
+  svn_pool_destroy(iterpool);
+  if (noderevs_p)
+    *noderevs_p = noderevs;
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -2402,6 +2632,57 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__try_get_plain_range(svn_boolean_t *success,
+                               apr_file_t **file,
+                               apr_off_t *offset,
+                               svn_filesize_t *length,
+                               svn_fs_t *fs,
+                               node_revision_t *noderev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  representation_t *rep = noderev->data_rep;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t item_offset;
+
+  *success = FALSE;
+
+  /* Only committed reps live in immutable rev / pack files.  Empty reps
+     and reps whose expanded size differs from their on-disk size can't
+     be PLAIN. */
+  if (   !rep
+      || svn_fs_fs__id_txn_used(&rep->txn_id)
+      || !SVN_IS_VALID_REVNUM(rep->revision)
+      || rep->size == 0
+      || (rep->expanded_size != 0 && rep->expanded_size != rep->size))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           result_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&item_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, item_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  if (header->type != svn_fs_fs__rep_plain)
+    {
+      /* Deltified.  The caller must use the regular stream interface. */
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+      return SVN_NO_ERROR;
+    }
+
+  *file = rev_file->file;
+  *offset = item_offset + header->header_size;
+  *length = rep->size;
+  *success = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Baton used when reading delta windows. */
 struct delta_read_baton
@@ -2562,6 +2843,57 @@ compare_dirent_name(const void *a, const void *b)
   return strcmp(lhs->name, rhs);
 }
 
+/* Set *DIRENT_P to the directory entry described by the key-value pair
+ * ENTRY read from a directory representation.  ENTRY->VAL must not be
+ * NULL and will be modified.  ID is provided for nicer error messages.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+parse_dir_entry(svn_fs_dirent_t **dirent_p,
+                svn_hash__entry_t *entry,
+                const svn_fs_id_t *id,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_dirent_t *dirent;
+  char *str;
+
+  dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+  dirent->name = apr_pstrmemdup(result_pool, entry->key, entry->keylen);
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
+    {
+      dirent->kind = svn_node_file;
+    }
+  else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
+    {
+      dirent->kind = svn_node_dir;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+    }
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+
+  *dirent_p = dirent;
+  return SVN_NO_ERROR;
+}
+
 /* Into *ENTRIES_P, read all directories entries from the key-value text in
  * STREAM.  If INCREMENTAL is TRUE, read until the end of the STREAM and
  * update the data.  ID is provided for nicer error messages.
@@ -2591,7 +2923,6 @@ read_dir_entries(apr_array_header_t **entries_p,
     {
       svn_hash__entry_t entry;
       svn_fs_dirent_t *dirent;
-      char *str;
 
       svn_pool_clear(iterpool);
       SVN_ERR_W(svn_hash__read_entry(&entry, stream, terminator,
@@ -2621,37 +2952,7 @@ read_dir_entries(apr_array_header_t **entries_p,
         }
 
       /* Add a new directory entry. */
-      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
-      dirent->name = apr_pstrmemdup(result_pool, entry.key, entry.keylen);
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
-        {
-          dirent->kind = svn_node_dir;
-        }
-      else
-        {
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-        }
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+      SVN_ERR(parse_dir_entry(&dirent, &entry, id, result_pool, iterpool));
 
       /* In incremental mode, update the hash; otherwise, write to the
        * final array.  Be sure to use hash keys that survive this iteration.
@@ -2765,10 +3066,26 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
       SVN_ERR(svn_stringbuf_from_stream(&text, contents, len, scratch_pool));
       SVN_ERR(svn_stream_close(contents));
 
-      /* de-serialize hash */
-      contents = svn_stream_from_stringbuf(text, scratch_pool);
-      SVN_ERR(read_dir_entries(&dir->entries, contents, FALSE, noderev->id,
-                               result_pool, scratch_pool));
+      /* de-serialize binary encoding or hash dump */
+      if (svn_fs_fs__is_binary_dir(text->data, text->len))
+        {
+          SVN_ERR_W(svn_fs_fs__read_binary_dir(&dir->entries, text->data,
+                                               text->len, result_pool,
+                                               scratch_pool),
+                    apr_psprintf(scratch_pool,
+                                 _("Directory representation corrupt in "
+                                   "'%s'"),
+                                 svn_fs_fs__id_unparse(noderev->id,
+                                                       scratch_pool)->data));
+          if (!sorted(dir->entries))
+            svn_sort__array(dir->entries, compare_dirents);
+        }
+      else
+        {
+          contents = svn_stream_from_stringbuf(text, scratch_pool);
+          SVN_ERR(read_dir_entries(&dir->entries, contents, FALSE,
+                                   noderev->id, result_pool, scratch_pool));
+        }
     }
   else
     {
@@ -2779,6 +3096,427 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
 }
 
 
+/* Maximum number of entries in a single chunk of a txn_dir_t.  Larger
+ * chunks get split into two halves. */
+#define TXN_DIR_CHUNK_SIZE 256
+
+/* In-process representation of a mutable directory in the current
+ * transaction.  Its entries are kept in a sorted list of sorted chunks
+ * such that lookups, insertions and removals are O(log n) plus a small
+ * constant, independent of how many entries the directory has.
+ *
+ * The children file on disk remains authoritative.  Because it is
+ * append-only, TXN_FILESIZE tells us whether we are up to date and, if
+ * not, where the changes that we have not seen yet start. */
+typedef struct txn_dir_t
+{
+  /* Pool that all of the below is allocated in. */
+  apr_pool_t *pool;
+
+  /* Size of the children file that this structure reflects. */
+  svn_filesize_t txn_filesize;
+
+  /* Sorted array of non-empty apr_array_header_t * chunks, each of them
+   * a sorted array of svn_fs_dirent_t *.  All names in a chunk are
+   * smaller than those in any later chunk. */
+  apr_array_header_t *chunks;
+
+  /* Total number of entries in all CHUNKS. */
+  int count;
+
+  /* Number of dirents in POOL that are no longer referenced. */
+  int garbage;
+} txn_dir_t;
+
+/* Compare the name of the last dirent in the chunk given in **A with the
+ * C string in *B. */
+static int
+compare_chunk_name(const void *a, const void *b)
+{
+  const apr_array_header_t *lhs = *((const apr_array_header_t * const *) a);
+  const char *rhs = b;
+
+  return strcmp(APR_ARRAY_IDX(lhs, lhs->nelts - 1, svn_fs_dirent_t *)->name,
+                rhs);
+}
+
+/* Return the index of the chunk in DIR that does or would contain an
+ * entry called NAME.  DIR must contain at least one chunk. */
+static int
+find_txn_dir_chunk(txn_dir_t *dir,
+                   const char *name)
+{
+  int idx = svn_sort__bsearch_lower_bound(dir->chunks, name,
+                                          compare_chunk_name);
+
+  /* Names beyond the last entry get appended to the last chunk. */
+  return idx < dir->chunks->nelts ? idx : dir->chunks->nelts - 1;
+}
+
+/* Return a deep copy of DIRENT allocated in RESULT_POOL. */
+static svn_fs_dirent_t *
+copy_dir_entry(const svn_fs_dirent_t *dirent,
+               apr_pool_t *result_pool)
+{
+  svn_fs_dirent_t *copy = apr_palloc(result_pool, sizeof(*copy));
+  copy->name = apr_pstrdup(result_pool, dirent->name);
+  copy->id = svn_fs_fs__id_copy(dirent->id, result_pool);
+  copy->kind = dirent->kind;
+
+  return copy;
+}
+
+/* Return a new txn_dir_t allocated in a sub-pool of PARENT_POOL that
+ * contains deep copies of the sorted ENTRIES and reflects a children
+ * file of size FILESIZE. */
+static txn_dir_t *
+create_txn_dir(const apr_array_header_t *entries,
+               svn_filesize_t filesize,
+               apr_pool_t *parent_pool)
+{
+  apr_pool_t *pool = svn_pool_create(parent_pool);
+  txn_dir_t *dir = apr_pcalloc(pool, sizeof(*dir));
+  apr_array_header_t *chunk = NULL;
+  int i;
+
+  dir->pool = pool;
+  dir->txn_filesize = filesize;
+  dir->count = entries->nelts;
+  dir->chunks = apr_array_make(pool,
+                               entries->nelts / (TXN_DIR_CHUNK_SIZE / 2) + 1,
+                               sizeof(apr_array_header_t *));
+
+  /* Fill the chunks only half-way such that inserts don't cause immediate
+   * chunk splits. */
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      if (i % (TXN_DIR_CHUNK_SIZE / 2) == 0)
+        {
+          chunk = apr_array_make(pool, TXN_DIR_CHUNK_SIZE,
+                                 sizeof(svn_fs_dirent_t *));
+          APR_ARRAY_PUSH(dir->chunks, apr_array_header_t *) = chunk;
+        }
+
+      APR_ARRAY_PUSH(chunk, svn_fs_dirent_t *)
+        = copy_dir_entry(APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *), pool);
+    }
+
+  return dir;
+}
+
+/* Return the entry called NAME in DIR or NULL, if no such entry exists. */
+static svn_fs_dirent_t *
+txn_dir_lookup(txn_dir_t *dir,
+               const char *name)
+{
+  apr_array_header_t *chunk;
+
+  if (dir->chunks->nelts == 0)
+    return NULL;
+
+  chunk = APR_ARRAY_IDX(dir->chunks, find_txn_dir_chunk(dir, name),
+                        apr_array_header_t *);
+  return svn_fs_fs__find_dir_entry(chunk, name, NULL);
+}
+
+/* Return a sorted array of deep copies of all entries in DIR.  Allocate
+ * it in RESULT_POOL. */
+static apr_array_header_t *
+txn_dir_entries(txn_dir_t *dir,
+                apr_pool_t *result_pool)
+{
+  apr_array_header_t *entries = apr_array_make(result_pool, dir->count,
+                                               sizeof(svn_fs_dirent_t *));
+  int i, k;
+
+  for (i = 0; i < dir->chunks->nelts; ++i)
+    {
+      apr_array_header_t *chunk = APR_ARRAY_IDX(dir->chunks, i,
+                                                apr_array_header_t *);
+      for (k = 0; k < chunk->nelts; ++k)
+        APR_ARRAY_PUSH(entries, svn_fs_dirent_t *)
+          = copy_dir_entry(APR_ARRAY_IDX(chunk, k, svn_fs_dirent_t *),
+                           result_pool);
+    }
+
+  return entries;
+}
+
+/* In *DIR_P, set the entry called NAME to a copy of DIRENT.  If the
+ * latter is NULL, remove the entry called NAME (if it exists).  Update
+ * the structure's file size info to FILESIZE.
+ *
+ * This may replace *DIR_P with a new, compacted structure.  The caller
+ * is responsible for releasing the old one, e.g. through store_txn_dir. */
+static void
+txn_dir_set_entry(txn_dir_t **dir_p,
+                  const char *name,
+                  const svn_fs_dirent_t *dirent,
+                  svn_filesize_t filesize)
+{
+  txn_dir_t *dir = *dir_p;
+  apr_array_header_t *chunk;
+  svn_fs_dirent_t **entry;
+  int chunk_idx;
+  int idx = -1;
+
+  dir->txn_filesize = filesize;
+
+  /* Empty directory.  Start a new chunk list, if necessary. */
+  if (dir->chunks->nelts == 0)
+    {
+      if (dirent)
+        {
+          chunk = apr_array_make(dir->pool, TXN_DIR_CHUNK_SIZE,
+                                 sizeof(svn_fs_dirent_t *));
+          APR_ARRAY_PUSH(chunk, svn_fs_dirent_t *)
+            = copy_dir_entry(dirent, dir->pool);
+          APR_ARRAY_PUSH(dir->chunks, apr_array_header_t *) = chunk;
+          dir->count++;
+        }
+
+      return;
+    }
+
+  chunk_idx = find_txn_dir_chunk(dir, name);
+  chunk = APR_ARRAY_IDX(dir->chunks, chunk_idx, apr_array_header_t *);
+  entry = svn_sort__array_lookup(chunk, name, &idx, compare_dirent_name);
+
+  if (dirent)
+    {
+      svn_fs_dirent_t *copy = copy_dir_entry(dirent, dir->pool);
+
+      /* Replace an existing entry or insert a new one. */
+      if (entry)
+        {
+          *entry = copy;
+          dir->garbage++;
+        }
+      else
+        {
+          svn_sort__array_insert(chunk, &copy, idx);
+          dir->count++;
+        }
+
+      /* Split oversized chunks into two halves. */
+      if (chunk->nelts > TXN_DIR_CHUNK_SIZE)
+        {
+          int half = chunk->nelts / 2;
+          apr_array_header_t *upper
+            = apr_array_make(dir->pool, TXN_DIR_CHUNK_SIZE,
+                             sizeof(svn_fs_dirent_t *));
+
+          memcpy(upper->elts, chunk->elts + half * chunk->elt_size,
+                 (chunk->nelts - half) * chunk->elt_size);
+          upper->nelts = chunk->nelts - half;
+          chunk->nelts = half;
+
+          svn_sort__array_insert(dir->chunks, &upper, chunk_idx + 1);
+        }
+    }
+  else if (entry)
+    {
+      /* Remove the entry and drop the chunk once it becomes empty. */
+      svn_sort__array_delete(chunk, idx, 1);
+      if (chunk->nelts == 0)
+        svn_sort__array_delete(dir->chunks, chunk_idx, 1);
+
+      dir->count--;
+      dir->garbage++;
+    }
+
+  /* Replaced and removed entries still occupy memory in DIR->POOL.
+   * Once they outnumber the live entries, copy the latter into a fresh
+   * pool to limit the memory usage. */
+  if (dir->garbage > 64 && dir->garbage > dir->count)
+    {
+      apr_pool_t *parent_pool = apr_pool_parent_get(dir->pool);
+      apr_pool_t *scratch_pool = svn_pool_create(parent_pool);
+
+      *dir_p = create_txn_dir(txn_dir_entries(dir, scratch_pool),
+                              dir->txn_filesize, parent_pool);
+
+      svn_pool_destroy(scratch_pool);
+    }
+}
+
+/* Store DIR as the in-txn index entry for the directory with the unparsed
+ * node ID KEY in FS, replacing and releasing any previous entry for KEY.
+ * If DIR is NULL, simply remove the entry. */
+static void
+store_txn_dir(svn_fs_t *fs,
+              const char *key,
+              txn_dir_t *dir)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  txn_dir_t *old_dir = svn_hash_gets(ffd->txn_dir_index, key);
+
+  if (old_dir == dir)
+    return;
+
+  /* Replacing the value would keep the old key, which lives in the pool
+   * we are about to destroy.  So, remove the entry and add a new one
+   * whose key lives as long as DIR. */
+  svn_hash_sets(ffd->txn_dir_index, key, NULL);
+  if (dir)
+    svn_hash_sets(ffd->txn_dir_index, apr_pstrdup(dir->pool, key), dir);
+
+  if (old_dir)
+    svn_pool_destroy(old_dir->pool);
+}
+
+/* Set *DIR_P to the up-to-date in-txn index entry for the mutable
+ * directory NODEREV in FS.  Directories not indexed yet will be read
+ * and added to the index.  Changes made to the directory since we last
+ * looked at it will be read from the end of its children file and
+ * applied incrementally.  FS must have a txn dir index.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_txn_dir(txn_dir_t **dir_p,
+            svn_fs_t *fs,
+            node_revision_t *noderev,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *key = svn_fs_fs__id_unparse(noderev->id, scratch_pool)->data;
+  txn_dir_t *dir = svn_hash_gets(ffd->txn_dir_index, key);
+  svn_filesize_t filesize;
+  apr_file_t *file;
+  svn_stream_t *contents;
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_fs_fs__path_txn_node_children(fs,
+                                                             noderev->id,
+                                                             scratch_pool),
+                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_size_get(&filesize, file, scratch_pool));
+
+  if (   dir
+      && dir->txn_filesize != SVN_INVALID_FILESIZE
+      && dir->txn_filesize <= filesize)
+    {
+      /* The children file is append-only.  Anything beyond what we
+       * already know is a sequence of incremental changes. */
+      if (dir->txn_filesize < filesize)
+        {
+          apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+          apr_off_t offset = dir->txn_filesize;
+
+          SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+          contents = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
+
+          while (1)
+            {
+              svn_hash__entry_t entry;
+              svn_fs_dirent_t *dirent = NULL;
+              const char *name;
+
+              svn_pool_clear(iterpool);
+              SVN_ERR_W(svn_hash__read_entry(&entry, contents, NULL, TRUE,
+                                             iterpool),
+                        apr_psprintf(iterpool,
+                                     _("Directory representation corrupt "
+                                       "in '%s'"), key));
+              if (entry.key == NULL)
+                break;
+
+              name = apr_pstrmemdup(iterpool, entry.key, entry.keylen);
+              if (entry.val)
+                SVN_ERR(parse_dir_entry(&dirent, &entry, noderev->id,
+                                        iterpool, iterpool));
+
+              /* Until we are done, mark DIR as incomplete.  Should we
+               * fail to read the changes, the next reader will then
+               * start from scratch. */
+              txn_dir_set_entry(&dir, name, dirent, SVN_INVALID_FILESIZE);
+              store_txn_dir(fs, key, dir);
+            }
+
+          dir->txn_filesize = filesize;
+          svn_pool_destroy(iterpool);
+        }
+    }
+  else
+    {
+      /* Not indexed yet or not the same file anymore.  Read it all. */
+      apr_pool_t *subpool = svn_pool_create(scratch_pool);
+      apr_array_header_t *entries;
+
+      contents = svn_stream_from_aprfile2(file, TRUE, subpool);
+      SVN_ERR(read_dir_entries(&entries, contents, TRUE, noderev->id,
+                               subpool, subpool));
+
+      dir = create_txn_dir(entries, filesize,
+                           apr_hash_pool_get(ffd->txn_dir_index));
+      store_txn_dir(fs, key, dir);
+      svn_pool_destroy(subpool);
+    }
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  *dir_p = dir;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__update_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *dir_id,
+                          const char *name,
+                          const svn_fs_id_t *id,
+                          svn_node_kind_t kind,
+                          svn_filesize_t old_filesize,
+                          svn_filesize_t new_filesize,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *key;
+  txn_dir_t *dir;
+
+  if (!ffd->txn_dir_index)
+    return SVN_NO_ERROR;
+
+  key = svn_fs_fs__id_unparse(dir_id, scratch_pool)->data;
+  dir = svn_hash_gets(ffd->txn_dir_index, key);
+
+  /* If we don't have the state just before this change, the next reader
+   * will catch up with the file contents (or re-read it).  Nothing to do
+   * for us now. */
+  if (!dir || dir->txn_filesize != old_filesize)
+    return SVN_NO_ERROR;
+
+  if (id)
+    {
+      svn_fs_dirent_t dirent;
+      dirent.name = name;
+      dirent.id = id;
+      dirent.kind = kind;
+
+      txn_dir_set_entry(&dir, name, &dirent, new_filesize);
+    }
+  else
+    {
+      txn_dir_set_entry(&dir, name, NULL, new_filesize);
+    }
+
+  store_txn_dir(fs, key, dir);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_fs_fs__remove_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *dir_id,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->txn_dir_index)
+    store_txn_dir(fs, svn_fs_fs__id_unparse(dir_id, scratch_pool)->data,
+                  NULL);
+}
+
+
 /* Return the cache object in FS responsible to storing the directory the
  * NODEREV plus the corresponding *KEY.  If no cache exists, return NULL.
  * PAIR_KEY must point to some key struct, which does not need to be
@@ -2802,10 +3540,9 @@ locate_dir_cache(svn_fs_t *fs,
 
   if (svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
     {
-      /* data in txns requires the expensive fs_id-based addressing mode */
-      *key = svn_fs_fs__id_unparse(noderev->id, pool)->data;
-
-      return ffd->txn_dir_cache;
+      /* data in txns is handled by the txn dir index, if at all */
+      *key = NULL;
+      return NULL;
     }
   else
     {
@@ -2825,13 +3562,25 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   pair_cache_key_t pair_key = { 0 };
   const void *key;
   svn_fs_fs__dir_data_t *dir;
+  svn_cache__t *cache;
+
+  /* Mutable directories are best served by the txn dir index. */
+  if (ffd->txn_dir_index && noderev->data_rep
+      && svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+    {
+      txn_dir_t *txn_dir;
+      SVN_ERR(get_txn_dir(&txn_dir, fs, noderev, scratch_pool));
+      *entries_p = txn_dir_entries(txn_dir, result_pool);
+
+      return SVN_NO_ERROR;
+    }
 
   /* find the cache we may use */
-  svn_cache__t *cache = locate_dir_cache(fs, &key, &pair_key, noderev,
-                                         scratch_pool);
+  cache = locate_dir_cache(fs, &key, &pair_key, noderev, scratch_pool);
   if (cache)
     {
       svn_boolean_t found;
@@ -2888,14 +3637,29 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   extract_dir_entry_baton_t baton;
   svn_boolean_t found = FALSE;
-
-  /* find the cache we may use */
   pair_cache_key_t pair_key = { 0 };
   const void *key;
-  svn_cache__t *cache = locate_dir_cache(fs, &key, &pair_key, noderev,
-                                         scratch_pool);
+  svn_cache__t *cache;
+
+  /* Mutable directories are best served by the txn dir index. */
+  if (ffd->txn_dir_index && noderev->data_rep
+      && svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+    {
+      txn_dir_t *txn_dir;
+      svn_fs_dirent_t *entry;
+
+      SVN_ERR(get_txn_dir(&txn_dir, fs, noderev, scratch_pool));
+      entry = txn_dir_lookup(txn_dir, name);
+      *dirent = entry ? copy_dir_entry(entry, result_pool) : NULL;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* find the cache we may use */
+  cache = locate_dir_cache(fs, &key, &pair_key, noderev, scratch_pool);
   if (cache)
     {
       svn_filesize_t filesize;
@@ -3638,9 +4402,99 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Read up to FS' configured number of read-ahead blocks following the
+ * block that ends at the aligned OFFSET in the already open REVISION_FILE,
+ * which must be the correct rev / pack file w.r.t. REVISION.  Put all
+ * items that start and end within that range into cache, unless they are
+ * already cached.  The read-ahead will never cross the end of the file.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+block_read_ahead(svn_fs_t *fs,
+                 svn_revnum_t revision,
+                 svn_fs_fs__revision_file_t *revision_file,
+                 apr_off_t offset,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t max_offset, end_offset;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (ffd->block_read_ahead == 0)
+    return SVN_NO_ERROR;
+
+  /* Don't read beyond the end of the rev / pack file. */
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, revision_file,
+                                        revision, scratch_pool));
+  end_offset = MIN(max_offset,
+                   offset + ffd->block_read_ahead * ffd->block_size);
+  if (offset >= end_offset)
+    return SVN_NO_ERROR;
+
+  /* Fetch the list of items in the whole read-ahead range at once.
+   * This will also pull the respective p2l index pages into cache. */
+  SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, revision_file,
+                                      revision, offset, end_offset - offset,
+                                      scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(aligned_seek(fs, revision_file->file, NULL, offset, iterpool));
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t* entry
+        = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+      /* Skip empty sections and items that are not fully within the
+       * read-ahead range. */
+      if (   entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED
+          || entry->offset < offset
+          || entry->offset + entry->size > end_offset)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
+                               &entry->offset, iterpool));
+      switch (entry->type)
+        {
+          case SVN_FS_FS__ITEM_TYPE_FILE_REP:
+          case SVN_FS_FS__ITEM_TYPE_DIR_REP:
+          case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
+          case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
+            SVN_ERR(block_read_contents(fs, revision_file, entry, end_offset,
+                                        iterpool));
+            break;
+
+          case SVN_FS_FS__ITEM_TYPE_NODEREV:
+            if (ffd->node_revision_cache)
+              {
+                node_revision_t *noderev;
+                SVN_ERR(block_read_noderev(&noderev, fs, revision_file,
+                                           entry, FALSE, iterpool,
+                                           iterpool));
+              }
+            break;
+
+          case SVN_FS_FS__ITEM_TYPE_CHANGES:
+            SVN_ERR(block_read_changes(fs, revision_file, entry, iterpool));
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
- * neighboring blocks may also get read.  The data is being read from
+ * neighboring blocks may also get read.  If configured, the blocks
+ * following those will be read ahead as well.  The data is being read from
  * already open REVISION_FILE, which must be the correct rev / pack file
  * w.r.t. REVISION.
  *
@@ -3778,6 +4632,10 @@ block_read(void **result,
   while(run_count++ == 1); /* can only be true once and only if a block
                             * boundary got crossed */
 
+  /* Optionally, prime the caches with the contents of the next blocks. */
+  SVN_ERR(block_read_ahead(fs, revision, revision_file,
+                           block_start + ffd->block_size, iterpool));
+
   /* if the caller requested a result, we must have provided one by now */
   assert(!result || *result);
   svn_pool_destroy(iterpool);
@@ -51,6 +51,22 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/* Set *NODEREVS_P to an array of node_revision_t * containing the
+   node-revisions for all node IDS (const svn_fs_id_t *) in FS, in the
+   same order as IDS.  Committed node-revisions that are not in cache yet
+   are read in rev / pack file order, re-using open files, and added to
+   the cache.  Allocate the result in RESULT_POOL and use SCRATCH_POOL
+   for temporary allocations.
+
+   If NODEREVS_P is NULL, only make sure that the committed node-revisions
+   are in the cache. */
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs_p,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Set *ROOT_ID to the node-id for the root of revision REV in
    filesystem FS.  Do any allocations in POOL. */
 svn_error_t *
@@ -119,6 +135,27 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* Attempt to locate the text representation of node-revision NODEREV as
+   seen in filesystem FS as a contiguous, unprocessed byte range within
+   a revision or pack file.  This is only possible for committed PLAIN
+   representations.  On success, set *FILE to the opened rev / pack file
+   (allocated in RESULT_POOL), *OFFSET to the start of the fulltext within
+   it and *LENGTH to the number of bytes, then set *SUCCESS to TRUE.
+   Otherwise, set *SUCCESS to FALSE and leave the other outputs untouched.
+
+   Note that the data is not checksummed on the way out.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__try_get_plain_range(svn_boolean_t *success,
+                               apr_file_t **file,
+                               apr_off_t *offset,
+                               svn_filesize_t *length,
+                               svn_fs_t *fs,
+                               node_revision_t *noderev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
@@ -161,6 +198,29 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/* Tell the txn dir index of FS that the entry NAME in the mutable
+   directory with node DIR_ID has been set to ID of KIND, growing the
+   directory's children file from OLD_FILESIZE to NEW_FILESIZE.  If ID
+   is NULL, the entry has been removed.  If the index does not hold the
+   state at OLD_FILESIZE, the next read will update it from disk instead.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *dir_id,
+                          const char *name,
+                          const svn_fs_id_t *id,
+                          svn_node_kind_t kind,
+                          svn_filesize_t old_filesize,
+                          svn_filesize_t new_filesize,
+                          apr_pool_t *scratch_pool);
+
+/* Drop the mutable directory with node DIR_ID from the txn dir index of
+   FS, if it is there.  Use SCRATCH_POOL for temporary allocations. */
+void
+svn_fs_fs__remove_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *dir_id,
+                          apr_pool_t *scratch_pool);
+
 /* Set *PROPLIST to be an apr_hash_t containing the property list of
    node-revision NODEREV as seen in filesystem FS.  Use POOL for
    temporary allocations. */
@@ -353,6 +353,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   const char *prefix = apr_pstrcat(pool,
                                    "fsfs:", fs->uuid,
+                                   "--", ffd->instance_id,
                                    "/", normalize_key_part(fs->path, pool),
                                    ":",
                                    SVN_VA_NULL);
@@ -731,10 +732,10 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
 struct txn_cleanup_baton_t
 {
   /* the cache to reset */
-  svn_cache__t *txn_cache;
+  void *txn_cache;
 
   /* the position where to reset it */
-  svn_cache__t **to_reset;
+  void **to_reset;
 
   /* pool that TXN_CACHE was allocated in */
   apr_pool_t *txn_pool;
@@ -798,7 +799,7 @@ remove_txn_cache_fs(void *baton_void)
  */
 static void
 init_txn_callbacks(svn_fs_t *fs,
-                   svn_cache__t **cache,
+                   void **cache,
                    apr_pool_t *pool)
 {
   if (*cache != NULL)
@@ -832,58 +833,24 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
                                  apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  const char *prefix;
 
   /* We don't support caching for concurrent transactions in the SAME
    * FSFS session. Maybe, you forgot to clean POOL. */
-  if (ffd->txn_dir_cache != NULL || ffd->concurrent_transactions)
+  if (ffd->txn_dir_index != NULL || ffd->concurrent_transactions)
     {
-      ffd->txn_dir_cache = NULL;
+      ffd->txn_dir_index = NULL;
       ffd->concurrent_transactions = TRUE;
 
       return SVN_NO_ERROR;
     }
 
-  /* Transaction content needs to be carefully prefixed to virtually
-     eliminate any chance for conflicts. The (repo, txn_id) pair
-     should be unique but if the filesystem format doesn't store the
-     global transaction ID via the txn-current file, and a transaction
-     fails, it might be possible to start a new transaction later that
-     receives the same id.  For such older formats, throw in an uuid as
-     well -- just to be sure. */
-  if (ffd->format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
-    prefix = apr_pstrcat(pool,
-                         "fsfs:", fs->uuid,
-                         "/", fs->path,
-                         ":", txn_id,
-                         ":", "TXNDIR",
-                         SVN_VA_NULL);
-  else
-    prefix = apr_pstrcat(pool,
-                         "fsfs:", fs->uuid,
-                         "/", fs->path,
-                         ":", txn_id,
-                         ":", svn_uuid_generate(pool),
-                         ":", "TXNDIR",
-                         SVN_VA_NULL);
-
-  /* create a txn-local directory cache */
-  SVN_ERR(create_cache(&ffd->txn_dir_cache,
-                       NULL,
-                       svn_cache__get_global_membuffer_cache(),
-                       1024, 8,
-                       svn_fs_fs__serialize_txndir_entries,
-                       svn_fs_fs__deserialize_dir_entries,
-                       APR_HASH_KEY_STRING,
-                       prefix,
-                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
-                       TRUE, /* The TXN-ID is our namespace. */
-                       fs,
-                       TRUE,
-                       pool, pool));
+  /* Create a txn-local directory index.  Unlike a membuffer cache, it
+   * never evicts entries, so changing huge directories does not require
+   * re-reading them from disk over and over. */
+  ffd->txn_dir_index = svn_hash__make(pool);
 
-  /* reset the transaction-specific cache if the pool gets cleaned up. */
-  init_txn_callbacks(fs, &(ffd->txn_dir_cache), pool);
+  /* reset the transaction-specific index if the pool gets cleaned up. */
+  init_txn_callbacks(fs, (void **)&(ffd->txn_dir_index), pool);
 
   return SVN_NO_ERROR;
 }
@@ -895,5 +862,5 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs)
    * can never cause in incorrect behavior. */
 
   fs_fs_data_t *ffd = fs->fsap_data;
-  ffd->txn_dir_cache = NULL;
+  ffd->txn_dir_index = NULL;
 }
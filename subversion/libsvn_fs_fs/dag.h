@@ -426,6 +426,22 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          void* baton,
                                          apr_pool_t *pool);
 
+/* Attempt to locate the contents of the file NODE as an unprocessed byte
+   range in a revision or pack file.  See svn_fs_fs__try_get_plain_range()
+   for the meaning of SUCCESS, FILE, OFFSET and LENGTH.
+
+   If NODE is not a file, return SVN_ERR_FS_NOT_FILE.
+   Allocate *FILE in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__dag_try_get_plain_range(svn_boolean_t *success,
+                                   apr_file_t **file,
+                                   apr_off_t *offset,
+                                   svn_filesize_t *length,
+                                   dag_node_t *node,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
 
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
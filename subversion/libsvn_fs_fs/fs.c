@@ -253,6 +253,17 @@ fs_set_uuid(svn_fs_t *fs,
   return svn_error_trace(svn_fs_fs__set_uuid(fs, uuid, NULL, pool));
 }
 
+/* Implements the get_instance_id method of fs_vtable_t. */
+static svn_error_t *
+fs_get_instance_id(const char **instance_id,
+                   svn_fs_t *fs,
+                   apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  *instance_id = apr_pstrdup(result_pool, ffd->instance_id);
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The vtable associated with a specific open filesystem. */
@@ -279,7 +290,9 @@ static fs_vtable_t fs_vtable = {
   fs_info,
   svn_fs_fs__verify_root,
   fs_freeze,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__get_revprop_generation,
+  fs_get_instance_id
 };
 
 
@@ -292,6 +305,7 @@ initialize_fs_struct(svn_fs_t *fs)
   fs_fs_data_t *ffd = apr_pcalloc(fs->pool, sizeof(*ffd));
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
+  ffd->revprop_generation = -1;
   ffd->flush_to_disk = TRUE;
 
   fs->vtable = &fs_vtable;
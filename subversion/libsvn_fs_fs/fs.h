@@ -108,11 +108,13 @@ extern "C" {
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_STORE_PLAIN_FULLTEXTS "store-plain-fulltexts"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
 #define CONFIG_SECTION_IO                "io"
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
+#define CONFIG_OPTION_BLOCK_READ_AHEAD   "block-read-ahead"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
 #define CONFIG_SECTION_DEBUG             "debug"
@@ -127,7 +129,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -200,6 +202,15 @@ extern "C" {
     database. */
 #define SVN_FS_FS__MIN_REP_CACHE_SCHEMA_V2_FORMAT 8
 
+/* The minimum format number that tracks revprop changes in the
+   "revprop-generation" file, allowing cached revprops to survive
+   svn_fs_refresh_revision_props(). */
+#define SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT 9
+
+/* The minimum format number that stores directory contents in a compact
+   binary encoding instead of hash dumps. */
+#define SVN_FS_FS__MIN_BINARY_DIR_FORMAT 9
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -336,6 +347,10 @@ typedef struct fs_fs_data_t
   /* Rev / pack file read granularity in bytes. */
   apr_int64_t block_size;
 
+  /* Number of blocks following the one that contains the requested item
+   * that block-read shall parse and cache as well.  0 disables read-ahead. */
+  apr_int64_t block_read_ahead;
+
   /* Capacity in entries of log-to-phys index pages */
   apr_int64_t l2p_page_size;
 
@@ -381,12 +396,18 @@ typedef struct fs_fs_data_t
   svn_cache__t *fulltext_cache;
 
   /* The current prefix to be used for revprop cache entries.
-     If this is 0, a new unique prefix must be chosen. */
+     If this is 0, a new unique prefix must be chosen.
+     Only used for formats without revprop generation tracking. */
   apr_uint64_t revprop_prefix;
 
-  /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
-     Unparsed svn_string_t representations of the serialized hash
-     will be written to the cache but the getter returns apr_hash_t. */
+  /* The revprop generation as last read from the "revprop-generation"
+     file.  Used instead of REVPROP_PREFIX for formats that support it.
+     If this is negative, the generation must be re-read. */
+  apr_int64_t revprop_generation;
+
+  /* Revision property cache.  Maps from (rev,prefix) or (rev,generation)
+     to apr_hash_t.  Unparsed svn_string_t representations of the serialized
+     hash will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
 
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
@@ -452,9 +473,10 @@ typedef struct fs_fs_data_t
   /* If set, there are or have been more than one concurrent transaction */
   svn_boolean_t concurrent_transactions;
 
-  /* Temporary cache for changed directories yet to be committed; maps from
-     unparsed FS ID to ###x.  NULL outside transactions. */
-  svn_cache__t *txn_dir_cache;
+  /* Index of the changed directories yet to be committed; maps from
+     unparsed FS ID to their current contents (see cached_data.c).
+     NULL outside transactions. */
+  apr_hash_t *txn_dir_index;
 
   /* Data shared between all svn_fs_t objects for a given filesystem. */
   fs_fs_shared_data_t *shared;
@@ -499,6 +521,10 @@ typedef struct fs_fs_data_t
   /* Compression level (currently, only used with compression_type_zlib). */
   int delta_compression_level;
 
+  /* Whether file contents without a delta base shall be stored as PLAIN
+   * representations instead of self-compressed svndiff. */
+  svn_boolean_t store_plain_fulltexts;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -683,6 +683,30 @@ verify_block_size(apr_int64_t block_size,
   return SVN_NO_ERROR;
 }
 
+/* The largest number of blocks that we allow to be read ahead. */
+#define MAX_BLOCK_READ_AHEAD 64
+
+/* Check that READ_AHEAD is a valid number of blocks to read ahead, i.e.
+ * it is not negative and within MAX_BLOCK_READ_AHEAD.  NAME is the name
+ * of the fsfs.conf setting.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+verify_read_ahead(apr_int64_t read_ahead,
+                  const char *name,
+                  apr_pool_t *scratch_pool)
+{
+  if (read_ahead < 0 || read_ahead > MAX_BLOCK_READ_AHEAD)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("%s is out of range for fsfs.conf setting "
+                               "'%s'.  Valid values are 0 to %d."),
+                             apr_psprintf(scratch_pool,
+                                          "%" APR_INT64_T_FMT,
+                                          read_ahead),
+                             name, MAX_BLOCK_READ_AHEAD);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 parse_compression_option(compression_type_t *compression_type_p,
                          int *compression_level_p,
@@ -779,6 +803,10 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(svn_config_get_bool(config, &ffd->store_plain_fulltexts,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_STORE_PLAIN_FULLTEXTS,
+                                  FALSE));
     }
   else
     {
@@ -786,6 +814,7 @@ read_config(fs_fs_data_t *ffd,
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->store_plain_fulltexts = FALSE;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -816,6 +845,10 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_BLOCK_SIZE,
                                    64));
+      SVN_ERR(svn_config_get_int64(config, &ffd->block_read_ahead,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_BLOCK_READ_AHEAD,
+                                   0));
       SVN_ERR(svn_config_get_int64(config, &ffd->l2p_page_size,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_L2P_PAGE_SIZE,
@@ -834,6 +867,9 @@ read_config(fs_fs_data_t *ffd,
                                 CONFIG_OPTION_P2L_PAGE_SIZE, scratch_pool));
       SVN_ERR(verify_block_size(ffd->l2p_page_size, sizeof(apr_off_t),
                                 CONFIG_OPTION_L2P_PAGE_SIZE, scratch_pool));
+      SVN_ERR(verify_read_ahead(ffd->block_read_ahead,
+                                CONFIG_OPTION_BLOCK_READ_AHEAD,
+                                scratch_pool));
 
       /* convert kBytes to bytes */
       ffd->block_size *= 0x400;
@@ -844,6 +880,7 @@ read_config(fs_fs_data_t *ffd,
     {
       /* should be irrelevant but we initialize them anyway */
       ffd->block_size = 0x1000; /* Matches default APR file buffer size. */
+      ffd->block_read_ahead = 0;
       ffd->l2p_page_size = 0x2000;    /* Matches above default. */
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
     }
@@ -1055,6 +1092,16 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### File contents that are not stored as a delta against some other"       NL
+"### version are normally still stored as compressed svndiff data.  If the"  NL
+"### following option is enabled, those fulltexts will be stored verbatim"   NL
+"### instead.  This costs disk space but allows svnserve to send large files" NL
+"### straight from the revision files without decompressing and copying"     NL
+"### them.  Combine it with a small " CONFIG_OPTION_MAX_DELTIFICATION_WALK " value for repositories"  NL
+"### dominated by large, mostly incompressible binaries."                    NL
+"### Plain fulltexts are disabled by default."                               NL
+"# " CONFIG_OPTION_STORE_PLAIN_FULLTEXTS " = false"                          NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
@@ -1120,6 +1167,16 @@ write_config(svn_fs_t *fs,
 "### block-size is given in kBytes and with a default of 64 kBytes."         NL
 "# " CONFIG_OPTION_BLOCK_SIZE " = 64"                                        NL
 "###"                                                                        NL
+"### Every time a block has to be read from disk, the following blocks may"  NL
+"### be read and cached as well.  This helps when the storage has a high"    NL
+"### latency, e.g. network file systems with cold caches, because the data"  NL
+"### needed next is likely stored right after the current block.  Items"     NL
+"### already in cache will not be read again.  Read-ahead only takes effect" NL
+"### if block-read has been enabled and does not cross rev / pack file"      NL
+"### boundaries.  Values must be between 0 and 64."                          NL
+"### block-read-ahead is given in blocks and defaults to 0 (disabled)."      NL
+"# " CONFIG_OPTION_BLOCK_READ_AHEAD " = 0"                                   NL
+"###"                                                                        NL
 "### The log-to-phys index maps data item numbers to offsets within the"     NL
 "### rev or pack file.  This index is organized in pages of a fixed maximum" NL
 "### capacity.  To access an item, the page table and the respective page"   NL
@@ -1387,6 +1444,10 @@ upgrade_body(void *baton, apr_pool_t *pool)
      accidentally uses outdated information.  Keep the UUID. */
   SVN_ERR(svn_fs_fs__set_uuid(fs, fs->uuid, NULL, pool));
 
+  /* Start tracking the revprop generation. */
+  if (format < SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT)
+    SVN_ERR(svn_fs_fs__reset_revprop_generation_file(fs, pool));
+
   /* Bump the format file. */
   SVN_ERR(svn_fs_fs__write_format(fs, TRUE, pool));
 
@@ -1885,6 +1946,10 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
   /* Global configuration options. */
   SVN_ERR(read_global_config(fs));
 
+  /* Initialize the revprop caching info before writing the first revprops. */
+  if (ffd->format >= SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT)
+    SVN_ERR(svn_fs_fs__reset_revprop_generation_file(fs, pool));
+
   /* Add revision 0. */
   SVN_ERR(write_revision_zero(fs, pool));
 
@@ -1950,6 +2015,8 @@ svn_fs_fs__create(svn_fs_t *fs,
                   break;
           case 9: format = 7;
                   break;
+          case 10: format = 8;
+                  break;
 
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
@@ -2322,8 +2389,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 11;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -995,6 +995,19 @@ hotcopy_body(void *baton, apr_pool_t *pool)
     SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
                                  PATH_TXN_CURRENT, pool));
 
+  /* We copied revprops without going through the revprop change protocol.
+   * A new destination gets a new instance ID and therefore its own cache
+   * namespace; it starts at generation 0.  An incremental hotcopy may
+   * update a repository that is being served, so move the generation past
+   * anything that readers of the destination may have cached. */
+  if (dst_ffd->format >= SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT)
+    {
+      if (incremental)
+        SVN_ERR(svn_fs_fs__bump_revprop_generation_file(dst_fs, pool));
+      else
+        SVN_ERR(svn_fs_fs__reset_revprop_generation_file(dst_fs, pool));
+    }
+
   /* Hotcopied FS is complete. Stamp it with a format file. */
   SVN_ERR(svn_fs_fs__write_format(dst_fs, TRUE, pool));
 
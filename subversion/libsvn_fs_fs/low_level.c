@@ -1245,6 +1245,189 @@ svn_fs_fs__write_noderev(svn_stream_t *outfile,
   return svn_stream_puts(outfile, "\n");
 }
 
+svn_boolean_t
+svn_fs_fs__is_binary_dir(const char *data,
+                         apr_size_t len)
+{
+  return len >= sizeof(SVN_FS_FS__BINARY_DIR_MAGIC) - 1
+      && memcmp(data, SVN_FS_FS__BINARY_DIR_MAGIC,
+                sizeof(SVN_FS_FS__BINARY_DIR_MAGIC) - 1) == 0;
+}
+
+/* Return the corruption error for binary directory contents. */
+static svn_error_t *
+binary_dir_corrupt(void)
+{
+  return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                          _("Binary directory representation corrupt"));
+}
+
+/* Decode an unsigned integer from *P into *VALUE and advance *P.  Don't
+ * read beyond END.  Return a corruption error if that is not possible. */
+static svn_error_t *
+decode_dir_uint(apr_uint64_t *value,
+                const unsigned char **p,
+                const unsigned char *end)
+{
+  *p = svn__decode_uint(value, *p, end);
+  if (*p == NULL)
+    return svn_error_trace(binary_dir_corrupt());
+
+  return SVN_NO_ERROR;
+}
+
+/* Decode an ID part from *P into *PART and advance *P.  Don't read beyond
+ * END.  Return a corruption error if that is not possible. */
+static svn_error_t *
+decode_dir_id_part(svn_fs_fs__id_part_t *part,
+                   const unsigned char **p,
+                   const unsigned char *end)
+{
+  apr_uint64_t value;
+
+  SVN_ERR(decode_dir_uint(&value, p, end));
+  if (value > APR_INT32_MAX)
+    return svn_error_trace(binary_dir_corrupt());
+  part->revision = (svn_revnum_t)value;
+
+  SVN_ERR(decode_dir_uint(&part->number, p, end));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__read_binary_dir(apr_array_header_t **entries_p,
+                           const char *data,
+                           apr_size_t len,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  const unsigned char *end = p + len;
+  apr_array_header_t *entries;
+  const char *previous = "";
+  apr_size_t previous_len = 0;
+  apr_uint64_t count, i;
+
+  if (!svn_fs_fs__is_binary_dir(data, len))
+    return svn_error_trace(binary_dir_corrupt());
+  p += sizeof(SVN_FS_FS__BINARY_DIR_MAGIC) - 1;
+
+  /* Each entry takes at least 8 bytes.  Don't allow corrupted data to
+   * trigger huge allocations. */
+  SVN_ERR(decode_dir_uint(&count, &p, end));
+  if (count > (apr_uint64_t)(end - p) / 8)
+    return svn_error_trace(binary_dir_corrupt());
+
+  entries = apr_array_make(result_pool, (int)count,
+                           sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < count; ++i)
+    {
+      svn_fs_fs__id_part_t node_id, copy_id, rev_item;
+      apr_uint64_t prefix_len, suffix_info, suffix_len;
+      svn_fs_dirent_t *dirent;
+      char *name;
+
+      /* Reconstruct the name from the PREVIOUS one. */
+      SVN_ERR(decode_dir_uint(&prefix_len, &p, end));
+      SVN_ERR(decode_dir_uint(&suffix_info, &p, end));
+      suffix_len = suffix_info >> 1;
+      if (   prefix_len > previous_len
+          || suffix_len > (apr_uint64_t)(end - p)
+          || prefix_len + suffix_len == 0)
+        return svn_error_trace(binary_dir_corrupt());
+
+      name = apr_palloc(result_pool, (apr_size_t)(prefix_len + suffix_len) + 1);
+      memcpy(name, previous, (apr_size_t)prefix_len);
+      memcpy(name + prefix_len, p, (apr_size_t)suffix_len);
+      name[prefix_len + suffix_len] = '\0';
+      p += suffix_len;
+
+      /* Node kind and ID. */
+      SVN_ERR(decode_dir_id_part(&node_id, &p, end));
+      SVN_ERR(decode_dir_id_part(&copy_id, &p, end));
+      SVN_ERR(decode_dir_id_part(&rev_item, &p, end));
+
+      dirent = apr_palloc(result_pool, sizeof(*dirent));
+      dirent->name = name;
+      dirent->kind = (suffix_info & 1) ? svn_node_dir : svn_node_file;
+      dirent->id = svn_fs_fs__id_rev_create(&node_id, &copy_id, &rev_item,
+                                            result_pool);
+      APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
+
+      previous = name;
+      previous_len = (apr_size_t)(prefix_len + suffix_len);
+    }
+
+  if (p != end)
+    return svn_error_trace(binary_dir_corrupt());
+
+  *entries_p = entries;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_binary_dir(svn_stream_t *stream,
+                            apr_array_header_t *entries,
+                            apr_pool_t *scratch_pool)
+{
+  /* Name lengths plus a generous estimate for the numbers. */
+  svn_stringbuf_t *buffer
+    = svn_stringbuf_create_ensure(16 + entries->nelts * 32, scratch_pool);
+  unsigned char numbers[8 * SVN__MAX_ENCODED_UINT_LEN];
+  const char *previous = "";
+  int i;
+
+  svn_stringbuf_appendbytes(buffer, SVN_FS_FS__BINARY_DIR_MAGIC,
+                            sizeof(SVN_FS_FS__BINARY_DIR_MAGIC) - 1);
+  svn_stringbuf_appendbytes(buffer, (const char *)numbers,
+                            svn__encode_uint(numbers, entries->nelts)
+                              - numbers);
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      const svn_fs_fs__id_part_t *node_id = svn_fs_fs__id_node_id(dirent->id);
+      const svn_fs_fs__id_part_t *copy_id = svn_fs_fs__id_copy_id(dirent->id);
+      const svn_fs_fs__id_part_t *rev_item
+        = svn_fs_fs__id_rev_item(dirent->id);
+      apr_size_t name_len = strlen(dirent->name);
+      apr_size_t prefix_len = 0;
+      unsigned char *p = numbers;
+
+      /* Only permanent IDs can be stored in revisions. */
+      SVN_ERR_ASSERT(!svn_fs_fs__id_is_txn(dirent->id)
+                     && SVN_IS_VALID_REVNUM(node_id->revision)
+                     && SVN_IS_VALID_REVNUM(copy_id->revision));
+
+      /* Length of the common prefix with the previous name. */
+      while (   previous[prefix_len]
+             && previous[prefix_len] == dirent->name[prefix_len])
+        ++prefix_len;
+
+      p = svn__encode_uint(p, prefix_len);
+      p = svn__encode_uint(p, ((apr_uint64_t)(name_len - prefix_len) << 1)
+                              | (dirent->kind == svn_node_dir ? 1 : 0));
+      svn_stringbuf_appendbytes(buffer, (const char *)numbers, p - numbers);
+      svn_stringbuf_appendbytes(buffer, dirent->name + prefix_len,
+                                name_len - prefix_len);
+
+      p = numbers;
+      p = svn__encode_uint(p, node_id->revision);
+      p = svn__encode_uint(p, node_id->number);
+      p = svn__encode_uint(p, copy_id->revision);
+      p = svn__encode_uint(p, copy_id->number);
+      p = svn__encode_uint(p, rev_item->revision);
+      p = svn__encode_uint(p, rev_item->number);
+      svn_stringbuf_appendbytes(buffer, (const char *)numbers, p - numbers);
+
+      previous = dirent->name;
+    }
+
+  return svn_error_trace(svn_stream_write(stream, buffer->data,
+                                          &buffer->len));
+}
+
 svn_error_t *
 svn_fs_fs__read_rep_header(svn_fs_fs__rep_header_t **header,
                            svn_stream_t *stream,
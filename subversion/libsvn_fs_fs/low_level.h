@@ -35,6 +35,7 @@
  * - revision footer (since format 7)
  * - changed path list
  * - node revision
+ * - binary directory contents (since format 9)
  * - representation (as in "text:" and "props:" lines)
  * - representation header ("PLAIN" and "DELTA" lines)
  */
@@ -157,6 +158,42 @@ svn_fs_fs__write_noderev(svn_stream_t *outfile,
                          svn_boolean_t include_mergeinfo,
                          apr_pool_t *scratch_pool);
 
+/* Directory contents in binary encoding start with this magic string.
+ * Hash dumps as used by older formats always start with "K " or "END". */
+#define SVN_FS_FS__BINARY_DIR_MAGIC   "DIR\1"
+
+/* Return TRUE, if the DATA of length LEN is a directory in binary
+ * encoding.  Otherwise, it is a hash dump. */
+svn_boolean_t
+svn_fs_fs__is_binary_dir(const char *data,
+                         apr_size_t len);
+
+/* Parse the binary directory contents in DATA of length LEN and return
+ * them as a sorted array of svn_fs_dirent_t * in *ENTRIES_P, allocated in
+ * RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__read_binary_dir(apr_array_header_t **entries_p,
+                           const char *data,
+                           apr_size_t len,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Write the directory ENTRIES (svn_fs_dirent_t *, sorted by name) in
+ * binary encoding to STREAM.  All entries must refer to committed nodes.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * The encoding uses 7b/8b variable-length integers.  After the magic and
+ * the number of entries, each entry consists of the length of the prefix
+ * that its name shares with the previous name, the remaining name length
+ * (shifted left by one with the LSB set for directories), the remaining
+ * name bytes and the six numbers of the node-revision ID.
+ */
+svn_error_t *
+svn_fs_fs__write_binary_dir(svn_stream_t *stream,
+                            apr_array_header_t *entries,
+                            apr_pool_t *scratch_pool);
+
 /* Parse the description of a representation from TEXT and store it
    into *REP_P.  TEXT will be invalidated by this call.  Allocate *REP_P in
    RESULT_POOL and use SCRATCH_POOL for temporaries. */
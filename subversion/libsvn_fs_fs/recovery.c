@@ -358,6 +358,13 @@ recover_body(void *baton, apr_pool_t *pool)
      Bump the instance ID. */
   SVN_ERR(svn_fs_fs__set_uuid(fs, fs->uuid, NULL, pool));
 
+  /* An interrupted revprop change may have left the revprop generation
+     in an inconsistent state.  Move on to a fresh one.  Servers that still
+     have this repository open must not find their cached revprops under
+     it, so we may not reset it to 0. */
+  if (ffd->format >= SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT)
+    SVN_ERR(svn_fs_fs__bump_revprop_generation_file(fs, pool));
+
   /* We need to know the largest revision in the filesystem. */
   SVN_ERR(recover_get_largest_revision(fs, &max_rev, pool));
 
@@ -207,14 +207,323 @@ parse_revprop(apr_hash_t **properties,
   return SVN_NO_ERROR;
 }
 
+/* Revprop caching management.
+ *
+ * Revprops are cached using (revision, key) pairs.  The second part of
+ * the key must change whenever revprops may have been modified by any
+ * other svn_fs_t instance, be it in this or another process.
+ *
+ * For formats prior to SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT, we have
+ * no way to detect such changes.  Hence, we pick a new unique prefix upon
+ * every sync barrier (svn_fs_refresh_revision_props) and never re-use
+ * cached data beyond that point.
+ *
+ * Newer formats track the revprop generation in a separate file.  Every
+ * revprop change bumps the generation twice: once immediately before
+ * switching to the new revprop data (creating an odd number) and once
+ * after the switch (even number).  A sync barrier then only needs to
+ * re-read that tiny file and all cached revprops of the same generation
+ * remain valid - even across svn_fs_t instances and sessions.
+ *
+ * A writer holding the write lock can immediately assume a crashed writer
+ * in case of an odd generation or they would not have been able to acquire
+ * the lock.  A reader detecting an odd generation will use that number and
+ * be forced to re-read any revprop data - usually getting the new revprops
+ * already.  If the generation file modification timestamp is too old, the
+ * reader will assume a crashed writer, acquire the write lock and bump
+ * the generation if it is still odd.  So, for about REVPROP_CHANGE_TIMEOUT
+ * after the crash, reader caches may be stale.
+ */
+
+/* Give writing processes 10 seconds to replace an existing revprop
+   file with a new one. After that time, we assume that the writing
+   process got aborted and that we have re-read revprops. */
+#define REVPROP_CHANGE_TIMEOUT (10 * 1000000)
+
+/* In case of an inconsistent read, yield and re-read the generation file.
+   This is the number of times we try this before giving up. */
+#define GENERATION_READ_RETRY_COUNT 100
+
+/* Return TRUE if FS tracks its revprop generation on disk. */
+static svn_boolean_t
+has_revprop_generation(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->format >= SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT;
+}
+
+/* Read revprop generation as stored on disk for repository FS. The result
+ * is returned in *CURRENT.  Call only for repos that support revprop
+ * generation tracking.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_revprop_generation_file(apr_int64_t *current,
+                             svn_fs_t *fs,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+  svn_error_t *err = SVN_NO_ERROR;
+  const char *path = svn_fs_fs__path_revprop_generation(fs, scratch_pool);
+
+  /* Retry in case of incomplete file buffer updates. */
+  for (i = 0; i < GENERATION_READ_RETRY_COUNT; ++i)
+    {
+      svn_stringbuf_t *buf;
+
+      svn_error_clear(err);
+      svn_pool_clear(iterpool);
+
+      /* Read the generation file. */
+      err = svn_stringbuf_from_file2(&buf, path, iterpool);
+
+      /* If we could read the file, it should be complete due to our atomic
+       * file replacement scheme. */
+      if (!err)
+        {
+          svn_stringbuf_strip_whitespace(buf);
+          SVN_ERR(svn_cstring_atoi64(current, buf->data));
+          break;
+        }
+
+      /* Got unlucky the file was not available.  Retry. */
+#if APR_HAS_THREADS
+      apr_thread_yield();
+#else
+      apr_sleep(0);
+#endif
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* If we had to give up, propagate the error. */
+  return svn_error_trace(err);
+}
+
+/* Write the CURRENT revprop generation to disk for repository FS.
+ * Call only for repos that support revprop generation tracking.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_revprop_generation_file(svn_fs_t *fs,
+                              apr_int64_t current,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *buffer;
+  const char *path = svn_fs_fs__path_revprop_generation(fs, scratch_pool);
+
+  /* Invalidate our cached revprop generation in case the file operations
+   * below fail. */
+  ffd->revprop_generation = -1;
+
+  /* Write the new number.  We use the permissions of the 'current' file
+   * because the generation file may not exist, yet. */
+  buffer = svn_stringbuf_createf(scratch_pool, "%" APR_INT64_T_FMT "\n",
+                                 current);
+  SVN_ERR(svn_io_write_atomic2(path, buffer->data, buffer->len,
+                               svn_fs_fs__path_current(fs, scratch_pool),
+                               FALSE, scratch_pool));
+
+  /* Remember it to spare us the re-read. */
+  ffd->revprop_generation = current;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__reset_revprop_generation_file(svn_fs_t *fs,
+                                         apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(has_revprop_generation(fs));
+
+  /* Write the initial revprop generation file contents. */
+  SVN_ERR(write_revprop_generation_file(fs, 0, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__bump_revprop_generation_file(svn_fs_t *fs,
+                                        apr_pool_t *scratch_pool)
+{
+  apr_int64_t current;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(has_revprop_generation(fs));
+
+  /* A broken or missing file is what we may have to recover from.
+     Other processes may still have revprops cached under any generation
+     up to the one that got lost; their FS instances have a different
+     instance ID, though, which keeps them apart from ours. */
+  err = read_revprop_generation_file(&current, fs, scratch_pool);
+  if (err || current < 0)
+    {
+      svn_error_clear(err);
+      current = 0;
+    }
+
+  /* Never go back to a generation that may already be in someone's
+     cache.  Odd values indicate an unfinished change and must be
+     followed by the next even one. */
+  SVN_ERR(write_revprop_generation_file(fs, current + 2 - current % 2,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* If the revprop generation has an odd value, it means the original writer
+   of the revprop got killed. We don't know whether that process as able
+   to change the revprop data but we assume that it was. Therefore, we
+   increase the generation in that case to basically invalidate everyone's
+   cache content.
+   Execute this only while holding the write lock to the repo in BATON.
+   This implements the svn_fs_fs__with_write_lock() 'body' callback type.
+   BATON is the svn_fs_t.
+ */
+static svn_error_t *
+revprop_generation_fixup(void *baton,
+                         apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int64_t current;
+  assert(ffd->has_write_lock);
+
+  /* Maybe, either the original revprop writer or some other reader has
+     already corrected / bumped the revprop generation.  Thus, we need
+     to read it again.  However, we will now be the only ones changing
+     the file contents due to us holding the write lock. */
+  SVN_ERR(read_revprop_generation_file(&current, fs, scratch_pool));
+
+  /* Cause everyone to re-read revprops upon their next access, if the
+     last revprop write did not complete properly. */
+  if (current % 2)
+    SVN_ERR(write_revprop_generation_file(fs, current + 1, scratch_pool));
+  else
+    ffd->revprop_generation = current;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the current revprop generation of FS and store it in FS->FSAP_DATA.
+   Also, detect aborted / crashed writers and recover from that.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_revprop_generation(svn_fs_t *fs,
+                        apr_pool_t *scratch_pool)
+{
+  apr_int64_t current = 0;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* read the current revprop generation number */
+  SVN_ERR(read_revprop_generation_file(&current, fs, scratch_pool));
+  ffd->revprop_generation = current;
+
+  /* is an unfinished revprop write under the way? */
+  if (current % 2)
+    {
+      svn_boolean_t timeout = FALSE;
+
+      /* Has the writer process been aborted?
+       * Either by timeout or by us being the writer now.
+       */
+      if (!ffd->has_write_lock)
+        {
+          apr_time_t mtime;
+          SVN_ERR(svn_io_file_affected_time(&mtime,
+                        svn_fs_fs__path_revprop_generation(fs, scratch_pool),
+                        scratch_pool));
+          timeout = apr_time_now() > mtime + REVPROP_CHANGE_TIMEOUT;
+        }
+
+      /* Ensure that the original writer process no longer exists by
+       * acquiring the write lock to this repository.  Then, fix up
+       * the revprop generation.
+       */
+      if (ffd->has_write_lock)
+        SVN_ERR(revprop_generation_fixup(fs, scratch_pool));
+      else if (timeout)
+        SVN_ERR(svn_fs_fs__with_write_lock(fs, revprop_generation_fixup,
+                                           fs, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop generation in FS to the next odd number to indicate
+   that there is a revprop write process under way.  Update the value
+   in FS->FSAP_DATA accordingly.  If the change times out, readers shall
+   recover from that state & re-read revprops.
+   Call this only while holding the write lock or while creating FS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+begin_revprop_change(svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Set the revprop generation to an odd value to indicate
+   * that a write is in progress.
+   */
+  SVN_ERR(read_revprop_generation(fs, scratch_pool));
+  SVN_ERR_ASSERT(ffd->revprop_generation % 2 == 0);
+  SVN_ERR(write_revprop_generation_file(fs, ffd->revprop_generation + 1,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop generation in FS to the next even generation after
+   the odd value in FS->FSAP_DATA to indicate that
+   a) readers shall re-read revprops, and
+   b) the write process has been completed (no recovery required).
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+end_revprop_change(svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  SVN_ERR_ASSERT(ffd->revprop_generation % 2);
+
+  /* Set the revprop generation to an even value to indicate
+   * that a write has been completed.  Since we held the write
+   * lock, nobody else could have updated the file contents.
+   */
+  SVN_ERR(write_revprop_generation_file(fs, ffd->revprop_generation + 1,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_revprop_generation(svn_boolean_t *supported,
+                                  apr_int64_t *generation,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  *supported = has_revprop_generation(fs);
+  if (*supported)
+    {
+      /* Other processes may have changed revprops since our last look. */
+      SVN_ERR(read_revprop_generation(fs, scratch_pool));
+      *generation = ffd->revprop_generation;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   ffd->revprop_prefix = 0;
+  ffd->revprop_generation = -1;
 }
 
-/* If FS has not a revprop cache prefix set, generate one.
+/* If FS has not a revprop cache prefix or generation set, determine one.
  * Always call this before accessing the revprop cache.
  */
 static svn_error_t *
@@ -222,12 +531,34 @@ prepare_revprop_cache(svn_fs_t *fs,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  if (!ffd->revprop_prefix)
-    SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+  if (has_revprop_generation(fs))
+    {
+      if (ffd->revprop_generation < 0)
+        SVN_ERR(read_revprop_generation(fs, scratch_pool));
+    }
+  else if (!ffd->revprop_prefix)
+    {
+      SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+    }
 
   return SVN_NO_ERROR;
 }
 
+/* Set *KEY to the revprop cache key for REVISION in FS.
+ * Make sure prepare_revprop_cache() has been called before. */
+static void
+get_revprop_cache_key(pair_cache_key_t *key,
+                      svn_fs_t *fs,
+                      svn_revnum_t revision)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  key->revision = revision;
+  key->second = has_revprop_generation(fs)
+              ? ffd->revprop_generation
+              : (apr_int64_t)ffd->revprop_prefix;
+}
+
 /* Store the unparsed revprop hash CONTENT for REVISION in FS's revprop
  * cache.  If CACHED is not NULL, set *CACHED if there already is such
  * an entry and skip the cache write in that case.  Use SCRATCH_POOL for
@@ -243,9 +574,10 @@ cache_revprops(svn_boolean_t *is_cached,
   pair_cache_key_t key;
 
   /* Make sure prepare_revprop_cache() has been called. */
-  SVN_ERR_ASSERT(ffd->revprop_prefix);
-  key.revision = revision;
-  key.second = ffd->revprop_prefix;
+  SVN_ERR_ASSERT(has_revprop_generation(fs)
+                 ? ffd->revprop_generation >= 0
+                 : ffd->revprop_prefix != 0);
+  get_revprop_cache_key(&key, fs, revision);
 
   if (is_cached)
     {
@@ -652,6 +984,14 @@ read_pack_revprop(packed_revprops_t **revprops,
                                 file_path,
                                 i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
                                 pool));
+
+      /* If we could not find the file, there was a write.
+       * So, we should refresh our revprop generation info as well such
+       * that others may find data we will put into the cache.  They would
+       * consider it outdated, otherwise.
+       */
+      if (missing && populate_cache && has_revprop_generation(fs))
+        SVN_ERR(read_revprop_generation(fs, iterpool));
     }
 
   /* the file content should be available now */
@@ -686,10 +1026,12 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
-  /* Only populate the cache if we did not just cross a sync barrier.
-   * This is to eliminate overhead from code that always sets REFRESH.
-   * For callers that want caching, the caching kicks in on read "later". */
-  svn_boolean_t populate_cache = !refresh;
+  /* Without revprop generation tracking, only populate the cache if we
+   * did not just cross a sync barrier.  This is to eliminate overhead
+   * from code that always sets REFRESH.  For callers that want caching,
+   * the caching kicks in on read "later".  With generation tracking,
+   * the cache contents survives sync barriers. */
+  svn_boolean_t use_cache = !refresh || has_revprop_generation(fs);
 
   /* not found, yet */
   *proplist_p = NULL;
@@ -697,21 +1039,19 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   /* should they be available at all? */
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, scratch_pool));
 
+  /* Previous cache contents may be invalid now. */
   if (refresh)
-    {
-      /* Previous cache contents is invalid now. */
-      svn_fs_fs__reset_revprop_cache(fs);
-    }
-  else
+    svn_fs_fs__reset_revprop_cache(fs);
+
+  if (use_cache)
     {
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
       pair_cache_key_t key;
 
-      /* Auto-alloc prefix and construct the key. */
+      /* Auto-alloc prefix / read the generation and construct the key. */
       SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
-      key.revision = rev;
-      key.second = ffd->revprop_prefix;
+      get_revprop_cache_key(&key, fs, rev);
 
       /* The only way that this might error out is due to parser error. */
       SVN_ERR_W(svn_cache__get((void **) proplist_p, &is_cached,
@@ -729,7 +1069,7 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   if (!svn_fs_fs__is_packed_revprop(fs, rev))
     {
       svn_error_t *err = read_non_packed_revprop(proplist_p, fs, rev,
-                                                 populate_cache, result_pool);
+                                                 use_cache, result_pool);
       if (err)
         {
           if (!APR_STATUS_IS_ENOENT(err->apr_err)
@@ -747,7 +1087,7 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT && !*proplist_p)
     {
       packed_revprops_t *revprops;
-      SVN_ERR(read_pack_revprop(&revprops, fs, rev, FALSE, populate_cache,
+      SVN_ERR(read_pack_revprop(&revprops, fs, rev, FALSE, use_cache,
                                 result_pool));
       *proplist_p = revprops->properties;
     }
@@ -1189,8 +1529,12 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
     SVN_ERR(write_non_packed_revprop(&final_path, &tmp_path,
                                      fs, rev, proplist, pool));
 
-  /* Previous cache contents is invalid now. */
-  svn_fs_fs__reset_revprop_cache(fs);
+  /* Previous cache contents is invalid now.  With generation tracking,
+   * tell all readers that a change is in progress. */
+  if (has_revprop_generation(fs))
+    SVN_ERR(begin_revprop_change(fs, pool));
+  else
+    svn_fs_fs__reset_revprop_cache(fs);
 
   /* We use the rev file of this revision as the perms reference,
    * because when setting revprops for the first time, the revprop
@@ -1203,6 +1547,10 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
                                 files_to_delete, pool));
 
+  /* Indicate that the update has been completed. */
+  if (has_revprop_generation(fs))
+    SVN_ERR(end_revprop_change(fs, pool));
+
   return SVN_NO_ERROR;
 }
 
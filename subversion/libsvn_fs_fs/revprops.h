@@ -58,10 +58,42 @@ svn_fs_fs__upgrade_cleanup_pack_revprops(svn_fs_t *fs,
                                          void *cancel_baton,
                                          apr_pool_t *scratch_pool);
 
-/* Invalidate the revprop cache in FS. */
+/* Invalidate the revprop cache in FS.  For formats that track the revprop
+ * generation, this only forces the generation to be re-read from disk such
+ * that cached revprops remain valid if it did not change. */
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs);
 
+/* Read the current revprop generation of FS from disk and return it in
+ * *GENERATION.  Set *SUPPORTED to FALSE, if FS' format does not track
+ * the revprop generation.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_revprop_generation(svn_boolean_t *supported,
+                                  apr_int64_t *generation,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *scratch_pool);
+
+/* Write the initial revprop generation file contents for FS, i.e. reset
+ * the generation to 0.  Call this only for formats that support revprop
+ * generation tracking and only for new filesystems or while holding the
+ * write lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__reset_revprop_generation_file(svn_fs_t *fs,
+                                         apr_pool_t *scratch_pool);
+
+/* Advance the revprop generation of FS to the next even value, such that
+ * all revprops cached under previous generations become invalid.  Use
+ * this when the revprops of FS may have changed without the usual revprop
+ * change protocol, e.g. during recovery.  If the generation file can't be
+ * read, start over at the lowest non-zero generation.  Call this only for
+ * formats that support revprop generation tracking and only while holding
+ * the write lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__bump_revprop_generation_file(svn_fs_t *fs,
+                                        apr_pool_t *scratch_pool);
+
 /* Read the revprops for revision REV in FS and return them in *PROPERTIES_P.
  * If REFRESH is set, clear the revprop cache before accessing the data.
  *
@@ -28,7 +28,6 @@
 #include "svn_fs.h"
 
 #include "private/svn_fs_util.h"
-#include "private/svn_sorts_private.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_subr_private.h"
 
@@ -788,18 +787,16 @@ svn_fs_fs__deserialize_node_revision(void **item,
 }
 
 /* Utility function that returns the directory serialized inside CONTEXT
- * to DATA and DATA_LEN.  If OVERPROVISION is set, allocate some extra
- * room for future in-place changes by svn_fs_fs__replace_dir_entry. */
+ * to DATA and DATA_LEN. */
 static svn_error_t *
 return_serialized_dir_context(svn_temp_serializer__context_t *context,
                               void **data,
-                              apr_size_t *data_len,
-                              svn_boolean_t overprovision)
+                              apr_size_t *data_len)
 {
   svn_stringbuf_t *serialized = svn_temp_serializer__get(context);
 
   *data = serialized->data;
-  *data_len = overprovision ? serialized->blocksize : serialized->len;
+  *data_len = serialized->len;
   ((dir_data_t *)serialized->data)->len = serialized->len;
 
   return SVN_NO_ERROR;
@@ -817,24 +814,7 @@ svn_fs_fs__serialize_dir_entries(void **data,
    * and return the serialized data */
   return return_serialized_dir_context(serialize_dir(dir, pool),
                                        data,
-                                       data_len,
-                                       FALSE);
-}
-
-svn_error_t *
-svn_fs_fs__serialize_txndir_entries(void **data,
-                                    apr_size_t *data_len,
-                                    void *in,
-                                    apr_pool_t *pool)
-{
-  svn_fs_fs__dir_data_t *dir = in;
-
-  /* serialize the dir content into a new serialization context
-   * and return the serialized data */
-  return return_serialized_dir_context(serialize_dir(dir, pool),
-                                       data,
-                                       data_len,
-                                       TRUE);
+                                       data_len);
 }
 
 svn_error_t *
@@ -867,20 +847,6 @@ svn_fs_fs__get_sharded_offset(void **out,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__extract_dir_filesize(void **out,
-                                const void *data,
-                                apr_size_t data_len,
-                                void *baton,
-                                apr_pool_t *pool)
-{
-  const dir_data_t *dir_data = data;
-
-  *(svn_filesize_t *)out = dir_data->txn_filesize;
-
-  return SVN_NO_ERROR;
-}
-
 /* Utility function that returns the lowest index of the first entry in
  * *ENTRIES that points to a dir entry with a name equal or larger than NAME.
  * If an exact match has been found, *FOUND will be set to TRUE. COUNT is
@@ -981,159 +947,6 @@ svn_fs_fs__extract_dir_entry(void **out,
   return SVN_NO_ERROR;
 }
 
-/* Utility function for svn_fs_fs__replace_dir_entry that implements the
- * modification as a simply deserialize / modify / serialize sequence.
- */
-static svn_error_t *
-slowly_replace_dir_entry(void **data,
-                         apr_size_t *data_len,
-                         void *baton,
-                         apr_pool_t *pool)
-{
-  replace_baton_t *replace_baton = (replace_baton_t *)baton;
-  dir_data_t *dir_data = (dir_data_t *)*data;
-  svn_fs_fs__dir_data_t *dir;
-  int idx = -1;
-  svn_fs_dirent_t *entry;
-  apr_array_header_t *entries;
-
-  SVN_ERR(svn_fs_fs__deserialize_dir_entries((void **)&dir,
-                                             *data,
-                                             dir_data->len,
-                                             pool));
-
-  entries = dir->entries;
-  entry = svn_fs_fs__find_dir_entry(entries, replace_baton->name, &idx);
-
-  /* Replacement or removal? */
-  if (replace_baton->new_entry)
-    {
-      /* Replace ENTRY with / insert the NEW_ENTRY */
-      if (entry)
-        APR_ARRAY_IDX(entries, idx, svn_fs_dirent_t *)
-          = replace_baton->new_entry;
-      else
-        svn_sort__array_insert(entries, &replace_baton->new_entry, idx);
-    }
-  else
-    {
-      /* Remove the old ENTRY. */
-      if (entry)
-        svn_sort__array_delete(entries, idx, 1);
-    }
-
-  return svn_fs_fs__serialize_dir_entries(data, data_len, dir, pool);
-}
-
-svn_error_t *
-svn_fs_fs__replace_dir_entry(void **data,
-                             apr_size_t *data_len,
-                             void *baton,
-                             apr_pool_t *pool)
-{
-  replace_baton_t *replace_baton = (replace_baton_t *)baton;
-  dir_data_t *dir_data = (dir_data_t *)*data;
-  svn_boolean_t found;
-  svn_fs_dirent_t **entries;
-  apr_uint32_t *lengths;
-  apr_uint32_t length;
-  apr_size_t pos;
-
-  svn_temp_serializer__context_t *context;
-
-  /* update the cached file length info.
-   * Because we are writing to the cache, it is fair to assume that the
-   * caller made sure that the current contents is consistent with the
-   * previous state of the directory file. */
-  dir_data->txn_filesize = replace_baton->txn_filesize;
-
-  /* after quite a number of operations, let's re-pack everything.
-   * This is to limit the number of wasted space as we cannot overwrite
-   * existing data but must always append. */
-  if (dir_data->operations > 2 + dir_data->count / 4)
-    return slowly_replace_dir_entry(data, data_len, baton, pool);
-
-  /* resolve the reference to the entries array */
-  entries = (svn_fs_dirent_t **)
-    svn_temp_deserializer__ptr(dir_data,
-                               (const void *const *)&dir_data->entries);
-
-  /* resolve the reference to the lengths array */
-  lengths = (apr_uint32_t *)
-    svn_temp_deserializer__ptr(dir_data,
-                               (const void *const *)&dir_data->lengths);
-
-  /* binary search for the desired entry by name */
-  pos = find_entry(entries, replace_baton->name, dir_data->count, &found);
-
-  /* handle entry removal (if found at all) */
-  if (replace_baton->new_entry == NULL)
-    {
-      if (found)
-        {
-          /* remove reference to the entry from the index */
-          memmove(&entries[pos],
-                  &entries[pos + 1],
-                  sizeof(entries[pos]) * (dir_data->count - pos));
-          memmove(&lengths[pos],
-                  &lengths[pos + 1],
-                  sizeof(lengths[pos]) * (dir_data->count - pos));
-
-          dir_data->count--;
-          dir_data->over_provision++;
-          dir_data->operations++;
-        }
-
-      return SVN_NO_ERROR;
-    }
-
-  /* if not found, prepare to insert the new entry */
-  if (!found)
-    {
-      /* fallback to slow operation if there is no place left to insert an
-       * new entry to index. That will automatically give add some spare
-       * entries ("overprovision"). */
-      if (dir_data->over_provision == 0)
-        return slowly_replace_dir_entry(data, data_len, baton, pool);
-
-      /* make entries[index] available for pointing to the new entry */
-      memmove(&entries[pos + 1],
-              &entries[pos],
-              sizeof(entries[pos]) * (dir_data->count - pos));
-      memmove(&lengths[pos + 1],
-              &lengths[pos],
-              sizeof(lengths[pos]) * (dir_data->count - pos));
-
-      dir_data->count++;
-      dir_data->over_provision--;
-      dir_data->operations++;
-    }
-
-  /* de-serialize the new entry */
-  entries[pos] = replace_baton->new_entry;
-  context = svn_temp_serializer__init_append(dir_data,
-                                             entries,
-                                             dir_data->len,
-                                             *data_len,
-                                             pool);
-  serialize_dir_entry(context, &entries[pos], &length);
-
-  /* return the updated serialized data */
-  SVN_ERR(return_serialized_dir_context(context, data, data_len, TRUE));
-
-  /* since the previous call may have re-allocated the buffer, the lengths
-   * pointer may no longer point to the entry in that buffer. Therefore,
-   * re-map it again and store the length value after that. */
-
-  dir_data = (dir_data_t *)*data;
-  lengths = (apr_uint32_t *)
-    svn_temp_deserializer__ptr(dir_data,
-                               (const void *const *)&dir_data->lengths);
-  lengths[pos] = length;
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__reset_txn_filesize(void **data,
                               apr_size_t *data_len,
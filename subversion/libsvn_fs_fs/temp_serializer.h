@@ -220,16 +220,6 @@ svn_fs_fs__serialize_dir_entries(void **data,
                                  void *in,
                                  apr_pool_t *pool);
 
-/**
- * Same as svn_fs_fs__serialize_dir_entries but allocates extra room for
- * in-place modification.
- */
-svn_error_t *
-svn_fs_fs__serialize_txndir_entries(void **data,
-                                    apr_size_t *data_len,
-                                    void *in,
-                                    apr_pool_t *pool);
-
 /**
  * Implements #svn_cache__deserialize_func_t for a #svn_fs_fs__dir_data_t
  */
@@ -250,18 +240,6 @@ svn_fs_fs__get_sharded_offset(void **out,
                               void *baton,
                               apr_pool_t *pool);
 
-/**
- * Implements #svn_cache__partial_getter_func_t.
- * Set (svn_filesize_t) @a *out to the filesize info stored with the
- * serialized directory in @a data of @a data_len.  @a baton is unused.
- */
-svn_error_t *
-svn_fs_fs__extract_dir_filesize(void **out,
-                                const void *data,
-                                apr_size_t data_len,
-                                void *baton,
-                                apr_pool_t *pool);
-
 /**
  * Describes the entry to be found in a directory: Identifies the entry
  * by @a name and requires the directory file size to be @a filesize.
@@ -297,39 +275,6 @@ svn_fs_fs__extract_dir_entry(void **out,
                              void *baton,
                              apr_pool_t *pool);
 
-/**
- * Describes the change to be done to a directory: Set the entry
- * identify by @a name to the value @a new_entry. If the latter is
- * @c NULL, the entry shall be removed if it exists. Otherwise it
- * will be replaced or automatically added, respectively.  The
- * @a filesize allows readers to identify stale cache data (e.g.
- * due to concurrent access to txns); writers use it to update the
- * cached file size info.
- */
-typedef struct replace_baton_t
-{
-  /** name of the directory entry to modify */
-  const char *name;
-
-  /** directory entry to insert instead */
-  svn_fs_dirent_t *new_entry;
-
-  /** Current length of the in-txn in-disk representation of the directory.
-   * SVN_INVALID_FILESIZE if unknown. */
-  svn_filesize_t txn_filesize;
-} replace_baton_t;
-
-/**
- * Implements #svn_cache__partial_setter_func_t for a single
- * #svn_fs_dirent_t within a serialized directory contents hash,
- * identified by its name in the #replace_baton_t in @a baton.
- */
-svn_error_t *
-svn_fs_fs__replace_dir_entry(void **data,
-                             apr_size_t *data_len,
-                             void *baton,
-                             apr_pool_t *pool);
-
 /**
  * Implements #svn_cache__partial_setter_func_t for a #svn_fs_fs__dir_data_t
  * at @a *data, resetting its txn_filesize field to SVN_INVALID_FILESIZE.
@@ -1545,8 +1545,8 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
     = svn_fs_fs__path_txn_node_children(fs, parent_noderev->id, pool);
   apr_file_t *file;
   svn_stream_t *out;
+  svn_filesize_t old_filesize = SVN_INVALID_FILESIZE;
   svn_filesize_t filesize;
-  fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *subpool = svn_pool_create(pool);
 
   if (!rep || !is_txn_rep(rep))
@@ -1572,27 +1572,6 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       SVN_ERR(svn_fs_fs__put_node_revision(fs, parent_noderev->id,
                                            parent_noderev, FALSE, pool));
 
-      /* Immediately populate the txn dir cache to avoid re-reading
-       * the file we just wrote. */
-      if (ffd->txn_dir_cache)
-        {
-          const char *key
-            = svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
-          svn_fs_fs__dir_data_t dir_data;
-
-          /* Flush APR buffers. */
-          SVN_ERR(svn_io_file_flush(file, subpool));
-
-          /* Obtain final file size to update txn_dir_cache. */
-          SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
-
-          /* Store in the cache. */
-          dir_data.entries = entries;
-          dir_data.txn_filesize = filesize;
-          SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, &dir_data,
-                                 subpool));
-        }
-
       svn_pool_clear(subpool);
     }
   else
@@ -1602,35 +1581,12 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
                                APR_OS_DEFAULT, subpool));
       out = svn_stream_from_aprfile2(file, TRUE, subpool);
 
-      /* If the cache contents is stale, drop it.
+      /* Remember where our change will start.  If the txn dir index is
+       * in sync with that state, it can simply apply our change.
        *
        * Note that the directory file is append-only, i.e. if the size
        * did not change, the contents didn't either. */
-      if (ffd->txn_dir_cache)
-        {
-          const char *key
-            = svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
-          svn_boolean_t found;
-          svn_filesize_t cached_filesize;
-
-          /* Get the file size that corresponds to the cached contents
-           * (if any). */
-          SVN_ERR(svn_cache__get_partial((void **)&cached_filesize, &found,
-                                         ffd->txn_dir_cache, key,
-                                         svn_fs_fs__extract_dir_filesize,
-                                         NULL, subpool));
-
-          /* File size info still matches?
-           * If not, we need to drop the cache entry. */
-          if (found)
-            {
-              SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
-
-              if (cached_filesize != filesize)
-                SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL,
-                                       subpool));
-            }
-        }
+      SVN_ERR(svn_io_file_size_get(&old_filesize, file, subpool));
     }
 
   /* Append an incremental hash entry for the entry change. */
@@ -1652,38 +1608,16 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
   /* Flush APR buffers. */
   SVN_ERR(svn_io_file_flush(file, subpool));
 
-  /* Obtain final file size to update txn_dir_cache. */
+  /* Obtain final file size to update the txn dir index. */
   SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
 
   /* Close file. */
   SVN_ERR(svn_io_file_close(file, subpool));
   svn_pool_clear(subpool);
 
-  /* if we have a directory cache for this transaction, update it */
-  if (ffd->txn_dir_cache)
-    {
-      /* build parameters: name, new entry, new file size  */
-      const char *key =
-          svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
-      replace_baton_t baton;
-
-      baton.name = name;
-      baton.new_entry = NULL;
-      baton.txn_filesize = filesize;
-
-      if (id)
-        {
-          baton.new_entry = apr_pcalloc(subpool, sizeof(*baton.new_entry));
-          baton.new_entry->name = name;
-          baton.new_entry->kind = kind;
-          baton.new_entry->id = id;
-        }
-
-      /* actually update the cached directory (if cached) */
-      SVN_ERR(svn_cache__set_partial(ffd->txn_dir_cache, key,
-                                     svn_fs_fs__replace_dir_entry, &baton,
-                                     subpool));
-    }
+  /* Update the in-memory directory, if we have one. */
+  SVN_ERR(svn_fs_fs__update_txn_dir(fs, parent_noderev->id, name, id, kind,
+                                    old_filesize, filesize, subpool));
 
   svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
@@ -2205,6 +2139,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_txdelta_window_handler_t wh;
   void *whb;
   svn_fs_fs__rep_header_t header = { 0 };
+  fs_fs_data_t *ffd = fs->fsap_data;
 
   b = apr_pcalloc(pool, sizeof(*b));
 
@@ -2232,11 +2167,14 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   /* Get the base for this delta. */
   SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE, b->scratch_pool));
-  SVN_ERR(svn_fs_fs__get_contents(&source, fs, base_rep, TRUE,
-                                  b->scratch_pool));
 
   /* Write out the rep header. */
-  if (base_rep)
+  if (!base_rep && ffd->store_plain_fulltexts)
+    {
+      /* rep_write_contents will write the data directly to REP_STREAM. */
+      header.type = svn_fs_fs__rep_plain;
+    }
+  else if (base_rep)
     {
       header.base_revision = base_rep->revision;
       header.base_item_index = base_rep->item_index;
@@ -2259,10 +2197,15 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                             apr_pool_cleanup_null);
 
   /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+  if (header.type != svn_fs_fs__rep_plain)
+    {
+      SVN_ERR(svn_fs_fs__get_contents(&source, fs, base_rep, TRUE,
+                                      b->scratch_pool));
+      txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+      b->delta_stream = svn_txdelta_target_push(wh, whb, source,
+                                                b->scratch_pool);
+    }
 
   *wb_p = b;
 
@@ -2769,6 +2712,19 @@ write_directory_to_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement collection_writer_t writing the svn_fs_dirent_t* array given
+   as BATON in binary encoding. */
+static svn_error_t *
+write_binary_directory_to_stream(svn_stream_t *stream,
+                                 void *baton,
+                                 apr_pool_t *pool)
+{
+  apr_array_header_t *dir = baton;
+  SVN_ERR(svn_fs_fs__write_binary_dir(stream, dir, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write out the COLLECTION as a text representation to file FILE using
    WRITER.  In the process, record position, the total size of the dump and
    MD5 as well as SHA1 in REP.   Add the representation of type ITEM_TYPE to
@@ -3191,19 +3147,22 @@ write_final_rev(const svn_fs_id_t **new_id_p,
         {
           pair_cache_key_t *key;
           svn_fs_fs__dir_data_t dir_data;
+          collection_writer_t writer
+            = ffd->format >= SVN_FS_FS__MIN_BINARY_DIR_FORMAT
+            ? write_binary_directory_to_stream
+            : write_directory_to_stream;
 
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
           if (ffd->deltify_directories)
             SVN_ERR(write_container_delta_rep(noderev->data_rep, file,
-                                              entries,
-                                              write_directory_to_stream,
+                                              entries, writer,
                                               fs, noderev, NULL, FALSE,
                                               SVN_FS_FS__ITEM_TYPE_DIR_REP,
                                               pool));
           else
             SVN_ERR(write_container_rep(noderev->data_rep, file, entries,
-                                        write_directory_to_stream, fs, NULL,
+                                        writer, fs, NULL,
                                         FALSE, SVN_FS_FS__ITEM_TYPE_DIR_REP,
                                         pool));
 
@@ -4136,17 +4095,12 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
   if (noderev->data_rep && is_txn_rep(noderev->data_rep)
       && noderev->kind == svn_node_dir)
     {
-      fs_fs_data_t *ffd = fs->fsap_data;
       SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_txn_node_children(fs, id,
                                                                     pool),
                                   FALSE, pool));
 
-      /* remove the corresponding entry from the cache, if such exists */
-      if (ffd->txn_dir_cache)
-        {
-          const char *key = svn_fs_fs__id_unparse(id, pool)->data;
-          SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL, pool));
-        }
+      /* remove the corresponding entry from the index, if such exists */
+      svn_fs_fs__remove_txn_dir(fs, id, pool);
     }
 
   return svn_io_remove_file2(svn_fs_fs__path_txn_node_rev(fs, id, pool),
@@ -2451,6 +2451,33 @@ fs_dir_entries(apr_hash_t **table_p,
   return SVN_NO_ERROR;
 }
 
+/* Make sure that the node-revisions of all directory ENTRIES
+   (svn_fs_dirent_t *) in FS are in the noderev cache.  Read the missing
+   ones as a single batch.  This is a no-op if noderevs don't get cached.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_entry_noderevs(svn_fs_t *fs,
+                        const apr_array_header_t *entries,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *ids;
+  int i;
+
+  if (!ffd->node_revision_cache || entries->nelts < 2)
+    return SVN_NO_ERROR;
+
+  ids = apr_array_make(scratch_pool, entries->nelts,
+                       sizeof(const svn_fs_id_t *));
+  for (i = 0; i < entries->nelts; ++i)
+    APR_ARRAY_PUSH(ids, const svn_fs_id_t *)
+      = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *)->id;
+
+  return svn_error_trace(svn_fs_fs__get_node_revisions(NULL, fs, ids,
+                                                       scratch_pool,
+                                                       scratch_pool));
+}
+
 static svn_error_t *
 fs_dir_optimal_order(apr_array_header_t **ordered_p,
                      svn_fs_root_t *root,
@@ -2461,6 +2488,11 @@ fs_dir_optimal_order(apr_array_header_t **ordered_p,
   *ordered_p = svn_fs_fs__order_dir_entries(root->fs, entries, result_pool,
                                             scratch_pool);
 
+  /* The caller is about to visit all entries in that order.  Fetch their
+   * node-revisions in one go. */
+  if (!root->is_txn_root)
+    SVN_ERR(prefetch_entry_noderevs(root->fs, *ordered_p, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -2938,6 +2970,36 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__try_get_file_range() ---  */
+
+static svn_error_t *
+fs_try_get_file_range(svn_boolean_t *success,
+                      apr_file_t **file,
+                      apr_off_t *offset,
+                      svn_filesize_t *length,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+
+  /* Txn contents may still change underneath us. */
+  if (root->is_txn_root)
+    {
+      *success = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_fs_fs__dag_try_get_plain_range(success, file, offset, length,
+                                            node, result_pool, scratch_pool);
+}
+
+/* --- End machinery for svn_fs__try_get_file_range() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -4162,6 +4224,7 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, dir_dag, scratch_pool));
+  SVN_ERR(prefetch_entry_noderevs(root->fs, entries, scratch_pool));
   for (i = 0; i < entries->nelts; ++i)
     {
       svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
@@ -4554,6 +4617,7 @@ static root_vtable_t root_vtable = {
   fs_get_file_delta_stream,
   fs_merge,
   fs_get_mergeinfo,
+  fs_try_get_file_range,
 };
 
 /* Construct a new root object in FS, allocated from POOL.  */
@@ -4726,11 +4790,26 @@ verify_node(dag_node_t *node,
   if (kind == svn_node_dir)
     {
       apr_array_header_t *entries;
+      apr_array_header_t *ids;
+      apr_array_header_t *noderevs;
+      int old_children = 0;
       apr_int64_t children_mergeinfo = 0;
       APR_ARRAY_PUSH(parent_nodes, dag_node_t*) = node;
 
       SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, node, pool));
 
+      /* Fetch the noderevs of all older children in one batch. */
+      ids = apr_array_make(pool, entries->nelts, sizeof(const svn_fs_id_t *));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_dirent_t *dirent
+            = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+          if (svn_fs_fs__id_rev(dirent->id) != rev)
+            APR_ARRAY_PUSH(ids, const svn_fs_id_t *) = dirent->id;
+        }
+
+      SVN_ERR(svn_fs_fs__get_node_revisions(&noderevs, fs, ids, pool, pool));
+
       /* Compute CHILDREN_MERGEINFO. */
       for (i = 0; i < entries->nelts; ++i)
         {
@@ -4753,9 +4832,8 @@ verify_node(dag_node_t *node,
           else
             {
               /* access mergeinfo counter with minimal overhead */
-              node_revision_t *noderev;
-              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
-                                                   iterpool, iterpool));
+              node_revision_t *noderev
+                = APR_ARRAY_IDX(noderevs, old_children++, node_revision_t *);
               child_mergeinfo = noderev->mergeinfo_count;
             }
 
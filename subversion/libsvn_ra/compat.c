@@ -952,3 +952,58 @@ svn_ra__get_inherited_props_walk(svn_ra_session_t *session,
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_ra__get_files_from_get_file(svn_ra_session_t *session,
+                                const apr_array_header_t *files,
+                                svn_boolean_t want_props,
+                                svn_boolean_t want_contents,
+                                svn_ra_file_receiver_t receiver,
+                                void *receiver_baton,
+                                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < files->nelts; i++)
+    {
+      const svn_ra_file_spec_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_spec_t *);
+      svn_revnum_t revision = file->revision;
+      apr_hash_t *props = NULL;
+      svn_stream_t *stream = NULL;
+      svn_boolean_t fetched_info = FALSE;
+
+      svn_pool_clear(iterpool);
+
+      /* The receiver must be given the props and actual revision before
+         we can fetch any contents.  Skip that extra request if we know
+         everything already.  Fetching the contents will then make sure
+         that the file exists. */
+      if (want_props || !want_contents || !SVN_IS_VALID_REVNUM(revision))
+        {
+          SVN_ERR(session->vtable->get_file(session, file->path, revision,
+                                            NULL, &revision,
+                                            want_props ? &props : NULL,
+                                            iterpool));
+          fetched_info = TRUE;
+        }
+
+      SVN_ERR(receiver(&stream, receiver_baton, i, revision, props,
+                       iterpool, iterpool));
+
+      if (want_contents && (stream || !fetched_info))
+        {
+          if (!stream)
+            stream = svn_stream_empty(iterpool);
+
+          SVN_ERR(session->vtable->get_file(session, file->path, revision,
+                                            stream, NULL, NULL, iterpool));
+          SVN_ERR(svn_stream_close(stream));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -631,6 +631,45 @@ svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                                    fetched_rev, props, pool);
 }
 
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_boolean_t want_contents,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  int i;
+
+  for (i = 0; i < files->nelts; i++)
+    {
+      const svn_ra_file_spec_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_spec_t *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(file->path));
+    }
+
+  if (session->vtable->get_files)
+    {
+      err = session->vtable->get_files(session, files, want_props,
+                                       want_contents, receiver,
+                                       receiver_baton, scratch_pool);
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  /* Do it the slow way, one file at a time. */
+  return svn_error_trace(svn_ra__get_files_from_get_file(session, files,
+                                                         want_props,
+                                                         want_contents,
+                                                         receiver,
+                                                         receiver_baton,
+                                                         scratch_pool));
+}
+
 svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                              apr_hash_t **dirents,
                              svn_revnum_t *fetched_rev,
@@ -343,6 +343,16 @@ typedef struct svn_ra__vtable_t {
                        void *receiver_baton,
                        apr_pool_t *scratch_pool);
 
+  /* See svn_ra_get_files().  May be NULL or return
+     SVN_ERR_RA_NOT_IMPLEMENTED, in which case the call gets emulated. */
+  svn_error_t *(*get_files)(svn_ra_session_t *session,
+                            const apr_array_header_t *files,
+                            svn_boolean_t want_props,
+                            svn_boolean_t want_contents,
+                            svn_ra_file_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
@@ -537,6 +547,23 @@ svn_ra__get_deleted_rev_from_log(svn_ra_session_t *session,
                                  apr_pool_t *pool);
 
 
+/**
+ * Fallback logic for svn_ra_get_files() for RA layers that don't
+ * implement it natively.  Fetches one file after the other using the
+ * get_file function of SESSION's vtable.
+ *
+ * All arguments are as per svn_ra_get_files().
+ */
+svn_error_t *
+svn_ra__get_files_from_get_file(svn_ra_session_t *session,
+                                const apr_array_header_t *files,
+                                svn_boolean_t want_props,
+                                svn_boolean_t want_contents,
+                                svn_ra_file_receiver_t receiver,
+                                void *receiver_baton,
+                                apr_pool_t *scratch_pool);
+
+
 /**
  * Fallback logic for svn_ra_get_inherited_props() when that API
  * need to find PATH's inherited properties on a legacy server that
@@ -1323,6 +1323,93 @@ svn_ra_local__get_file(svn_ra_session_t *session,
 
 
 
+/* Getting many files at once. */
+static svn_error_t *
+svn_ra_local__get_files(svn_ra_session_t *session,
+                        const apr_array_header_t *files,
+                        svn_boolean_t want_props,
+                        svn_boolean_t want_contents,
+                        svn_ra_file_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_revnum_t youngest_rev = SVN_INVALID_REVNUM;
+  apr_hash_t *roots = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < files->nelts; i++)
+    {
+      const svn_ra_file_spec_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_spec_t *);
+      svn_revnum_t revision = file->revision;
+      const char *abs_path;
+      svn_fs_root_t *root;
+      svn_node_kind_t node_kind;
+      apr_hash_t *props = NULL;
+      svn_stream_t *stream = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* All HEAD requests shall see the same revision. */
+      if (! SVN_IS_VALID_REVNUM(revision))
+        {
+          if (! SVN_IS_VALID_REVNUM(youngest_rev))
+            SVN_ERR(svn_fs_youngest_rev(&youngest_rev, sess->fs,
+                                        scratch_pool));
+          revision = youngest_rev;
+        }
+
+      /* Share revision roots and their caches between files. */
+      root = apr_hash_get(roots, &revision, sizeof(revision));
+      if (! root)
+        {
+          svn_revnum_t *key = apr_pmemdup(scratch_pool, &revision,
+                                          sizeof(revision));
+          SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision,
+                                       scratch_pool));
+          apr_hash_set(roots, key, sizeof(*key), root);
+        }
+
+      abs_path = svn_fspath__join(sess->fs_path->data, file->path, iterpool);
+      SVN_ERR(svn_fs_check_path(&node_kind, root, abs_path, iterpool));
+      if (node_kind == svn_node_none)
+        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                 _("'%s' path not found"), abs_path);
+      else if (node_kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                                 _("'%s' is not a file"), abs_path);
+
+      if (want_props)
+        SVN_ERR(get_node_props(&props, root, abs_path, sess->uuid,
+                               iterpool, iterpool));
+
+      SVN_ERR(receiver(&stream, receiver_baton, i, revision, props,
+                       iterpool, iterpool));
+
+      /* As in svn_ra_local__get_file, svn_fs_file_contents() verifies
+         the checksum for us. */
+      if (want_contents && stream)
+        {
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_file_contents(&contents, root, abs_path, iterpool));
+          SVN_ERR(svn_stream_copy3(contents, stream,
+                                   sess->callbacks
+                                     ? sess->callbacks->cancel_func : NULL,
+                                   sess->callback_baton,
+                                   iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
 /* Getting a directory's entries */
 static svn_error_t *
 svn_ra_local__get_dir(svn_ra_session_t *session,
@@ -1914,6 +2001,7 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  svn_ra_local__get_files,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
@@ -0,0 +1,293 @@
+/*
+ * fetch_sched.c: Scheduling of the GET requests of an update report.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "fetch_sched.h"
+
+/* Every fetch queued later is treated as if its file were
+   FETCH_AGING_BYTES larger.  Files of unknown size count as
+   FETCH_UNKNOWN_SIZE. */
+#define FETCH_AGING_BYTES 4096
+#define FETCH_UNKNOWN_SIZE 16384
+
+/* Lower limit for the number of fetches that we pipeline on a single
+   connection. */
+#define PIPELINE_DEPTH_MIN 2
+
+/* Re-evaluate the pipeline depth after this many completed fetches. */
+#define PIPELINE_SAMPLE_SIZE 8
+
+/* A queued fetch. */
+typedef struct queued_fetch_t
+{
+  /* The caller's object. */
+  void *fetch;
+
+  /* Position in the queue; lower values get sent first. */
+  apr_uint64_t priority;
+} queued_fetch_t;
+
+/* Scheduler state of a single connection. */
+typedef struct fetch_conn_t
+{
+  /* Number of fetches sent on this connection that have not completed. */
+  int in_flight;
+
+  /* Number of fetches that we allow to be in flight. */
+  int depth;
+
+  /* Shortest time from sending a fetch until its response started.
+     0 while unknown. */
+  apr_interval_time_t min_latency;
+
+  /* Number of fetches completed, the time that fetches were in flight and
+     the bytes received during that time, since the last depth
+     adjustment. */
+  int completed;
+  apr_interval_time_t busy_time;
+  apr_uint64_t bytes;
+
+  /* Start of the current BUSY_TIME interval. */
+  apr_time_t last_event;
+} fetch_conn_t;
+
+struct svn_ra_serf__fetch_sched_t
+{
+  /* Fetches waiting to be sent (queued_fetch_t), lowest PRIORITY first. */
+  svn_priority_queue__t *queue;
+
+  /* Number of fetches queued so far.  Used for aging. */
+  apr_uint64_t seq;
+
+  /* Number of fetches sent on any connection that have not completed. */
+  int in_flight;
+
+  /* Pipeline depth limit. */
+  int max_depth;
+
+  /* Per-connection state, MAX_CONNS elements. */
+  fetch_conn_t *conns;
+  int max_conns;
+
+  /* What we report to our callers. */
+  svn_ra_serf__fetch_stats_t stats;
+};
+
+/* Compares the queued_fetch_t elements pointed to by A and B by their
+   priority.  Comparison function for our QUEUE. */
+static int
+compare_fetch_priority(const void *a, const void *b)
+{
+  const queued_fetch_t *lhs = a;
+  const queued_fetch_t *rhs = b;
+
+  if (lhs->priority == rhs->priority)
+    return 0;
+
+  return lhs->priority < rhs->priority ? -1 : 1;
+}
+
+svn_ra_serf__fetch_sched_t *
+svn_ra_serf__fetch_sched_create(int max_conns,
+                                int initial_depth,
+                                int max_depth,
+                                apr_interval_time_t latency,
+                                apr_pool_t *result_pool)
+{
+  svn_ra_serf__fetch_sched_t *sched = apr_pcalloc(result_pool,
+                                                  sizeof(*sched));
+  int i;
+
+  sched->queue
+    = svn_priority_queue__create(apr_array_make(result_pool, 16,
+                                                sizeof(queued_fetch_t)),
+                                 compare_fetch_priority);
+  sched->max_depth = MAX(max_depth, PIPELINE_DEPTH_MIN);
+  sched->max_conns = max_conns;
+  sched->conns = apr_pcalloc(result_pool, max_conns * sizeof(*sched->conns));
+
+  for (i = 0; i < max_conns; i++)
+    {
+      sched->conns[i].depth = MAX(MIN(initial_depth, sched->max_depth),
+                                  PIPELINE_DEPTH_MIN);
+      if (latency > 0)
+        sched->conns[i].min_latency = latency;
+      sched->stats.max_depth = sched->conns[i].depth;
+    }
+
+  return sched;
+}
+
+void
+svn_ra_serf__fetch_sched_queue(svn_ra_serf__fetch_sched_t *sched,
+                               void *fetch,
+                               svn_filesize_t size)
+{
+  queued_fetch_t entry;
+
+  entry.fetch = fetch;
+  entry.priority = (size >= 0 ? (apr_uint64_t)size : FETCH_UNKNOWN_SIZE)
+                 + sched->seq * FETCH_AGING_BYTES;
+  sched->seq++;
+
+  svn_priority_queue__push(sched->queue, &entry);
+
+  sched->stats.queued++;
+  sched->stats.max_queued
+    = MAX(sched->stats.max_queued,
+          (int)svn_priority_queue__size(sched->queue));
+}
+
+void *
+svn_ra_serf__fetch_sched_next(int *conn_idx,
+                              svn_ra_serf__fetch_sched_t *sched,
+                              int first_conn,
+                              int num_conns,
+                              apr_time_t now)
+{
+  queued_fetch_t *entry;
+  fetch_conn_t *fc;
+  void *fetch;
+  int i, best_conn = -1;
+
+  if (svn_priority_queue__size(sched->queue) == 0)
+    return NULL;
+
+  /* Prefer the connection with the least filled pipeline. */
+  for (i = first_conn; i < MIN(num_conns, sched->max_conns); i++)
+    {
+      fc = &sched->conns[i];
+      if (fc->in_flight >= fc->depth)
+        continue;
+
+      if (best_conn < 0
+          || (fc->in_flight * sched->conns[best_conn].depth
+              < sched->conns[best_conn].in_flight * fc->depth))
+        best_conn = i;
+    }
+
+  if (best_conn < 0)
+    return NULL;
+
+  entry = svn_priority_queue__peek(sched->queue);
+  fetch = entry->fetch;
+  svn_priority_queue__pop(sched->queue);
+
+  fc = &sched->conns[best_conn];
+  if (fc->in_flight == 0)
+    fc->last_event = now;
+  fc->in_flight++;
+
+  sched->in_flight++;
+  sched->stats.max_in_flight = MAX(sched->stats.max_in_flight,
+                                   sched->in_flight);
+
+  *conn_idx = best_conn;
+  return fetch;
+}
+
+void
+svn_ra_serf__fetch_sched_started(svn_ra_serf__fetch_sched_t *sched,
+                                 int conn_idx,
+                                 apr_time_t sent,
+                                 apr_time_t now)
+{
+  fetch_conn_t *fc = &sched->conns[conn_idx];
+  apr_interval_time_t latency = now - sent;
+
+  /* Requests that had to wait for others in the pipeline take longer.
+     The shortest time is our best guess for the round trip plus server
+     processing time. */
+  if (latency > 0 && (fc->min_latency == 0 || latency < fc->min_latency))
+    fc->min_latency = latency;
+
+  if (latency > 0 && (sched->stats.min_latency == 0
+                      || latency < sched->stats.min_latency))
+    sched->stats.min_latency = latency;
+}
+
+/* The depth is chosen such that the responses queued on the connection
+   cover twice the data that can be in flight during one round trip, i.e.
+   the bandwidth-delay product divided by the average response size.  As
+   long as the connection is latency bound, the measured throughput grows
+   with the depth, so the depth keeps growing until the bandwidth becomes
+   the limit.  Connections serving large files get short pipelines, which
+   leaves more room for small ones on the other connections. */
+void
+svn_ra_serf__fetch_sched_completed(svn_ra_serf__fetch_sched_t *sched,
+                                   int conn_idx,
+                                   apr_uint64_t bytes,
+                                   apr_time_t now)
+{
+  fetch_conn_t *fc = &sched->conns[conn_idx];
+
+  fc->busy_time += now - fc->last_event;
+  fc->last_event = now;
+  fc->bytes += bytes;
+  fc->completed++;
+  fc->in_flight--;
+
+  sched->in_flight--;
+  sched->stats.completed++;
+  sched->stats.bytes += bytes;
+
+  if (   fc->completed >= PIPELINE_SAMPLE_SIZE
+      && fc->busy_time > 0
+      && fc->min_latency > 0)
+    {
+      apr_uint64_t avg_size = MAX(fc->bytes / fc->completed, 1);
+      apr_uint64_t bdp = fc->bytes * fc->min_latency / fc->busy_time;
+      apr_uint64_t depth = 2 * ((bdp + avg_size - 1) / avg_size);
+
+      fc->depth = (int)MAX(MIN(depth, (apr_uint64_t)sched->max_depth),
+                           PIPELINE_DEPTH_MIN);
+      sched->stats.max_depth = MAX(sched->stats.max_depth, fc->depth);
+
+      fc->completed = 0;
+      fc->busy_time = 0;
+      fc->bytes = 0;
+    }
+}
+
+int
+svn_ra_serf__fetch_sched_depth(svn_ra_serf__fetch_sched_t *sched,
+                               int num_conns)
+{
+  int i, depth = 0;
+
+  for (i = 0; i < MIN(num_conns, sched->max_conns); i++)
+    depth += sched->conns[i].depth;
+
+  return depth;
+}
+
+const svn_ra_serf__fetch_stats_t *
+svn_ra_serf__fetch_sched_stats(svn_ra_serf__fetch_sched_t *sched)
+{
+  return &sched->stats;
+}
@@ -0,0 +1,145 @@
+/*
+ * fetch_sched.h: Scheduling of the GET requests of an update report.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_SERF_FETCH_SCHED_H
+#define SVN_LIBSVN_RA_SERF_FETCH_SCHED_H
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Fetch scheduler.  It decides which of the queued file fetches (GETs) of
+ * an update report gets sent next and on which connection.
+ *
+ * Fetches are sent in the order of their file sizes, smallest first, so
+ * that many small files don't have to wait for a few large ones.  To not
+ * starve the large files, every fetch queued later is treated as if its
+ * file were a bit larger.
+ *
+ * Each connection has a pipeline depth, i.e. a limit on the number of
+ * fetches in flight.  It adapts to the measured latency and throughput of
+ * the connection: The responses in flight shall cover about twice the
+ * bandwidth-delay product.
+ *
+ * The scheduler does not send any requests itself and takes the current
+ * time from its callers, so it does not depend on serf.
+ */
+typedef struct svn_ra_serf__fetch_sched_t svn_ra_serf__fetch_sched_t;
+
+/* Statistics of the fetches handled by a fetch scheduler. */
+typedef struct svn_ra_serf__fetch_stats_t
+{
+  /* Number of fetches queued resp. completed, and the bytes received
+     with the completed ones. */
+  apr_uint64_t queued;
+  apr_uint64_t completed;
+  apr_uint64_t bytes;
+
+  /* Maximum number of fetches waiting to be sent resp. sent and waiting
+     for their completion at the same time. */
+  int max_queued;
+  int max_in_flight;
+
+  /* Largest pipeline depth of any connection. */
+  int max_depth;
+
+  /* Shortest time measured from sending a fetch until its response
+     started, 0 if unknown. */
+  apr_interval_time_t min_latency;
+} svn_ra_serf__fetch_stats_t;
+
+/* Return a new fetch scheduler for up to MAX_CONNS connections, allocated
+ * in RESULT_POOL.  The pipeline depth of every connection starts at
+ * INITIAL_DEPTH and may grow up to MAX_DEPTH.  If LATENCY is positive,
+ * use it as the initial round trip time estimate.
+ */
+svn_ra_serf__fetch_sched_t *
+svn_ra_serf__fetch_sched_create(int max_conns,
+                                int initial_depth,
+                                int max_depth,
+                                apr_interval_time_t latency,
+                                apr_pool_t *result_pool);
+
+/* Queue FETCH, an opaque caller object, in SCHED.  SIZE is the size of
+ * the file to fetch and negative if unknown.
+ */
+void
+svn_ra_serf__fetch_sched_queue(svn_ra_serf__fetch_sched_t *sched,
+                               void *fetch,
+                               svn_filesize_t size);
+
+/* Remove the next fetch from SCHED's queue and return it, if one of the
+ * connections FIRST_CONN to NUM_CONNS-1 has room in its pipeline.  Set
+ * *CONN_IDX to the connection that the fetch shall be sent on at time
+ * NOW.  Return NULL if the queue is empty or all pipelines are full.
+ */
+void *
+svn_ra_serf__fetch_sched_next(int *conn_idx,
+                              svn_ra_serf__fetch_sched_t *sched,
+                              int first_conn,
+                              int num_conns,
+                              apr_time_t now);
+
+/* Note that the response to a fetch that has been sent on connection
+ * CONN_IDX of SCHED at time SENT started to arrive at time NOW.
+ */
+void
+svn_ra_serf__fetch_sched_started(svn_ra_serf__fetch_sched_t *sched,
+                                 int conn_idx,
+                                 apr_time_t sent,
+                                 apr_time_t now);
+
+/* Note that a fetch on connection CONN_IDX of SCHED has been completed at
+ * time NOW after receiving BYTES.  This frees a slot in the pipeline of
+ * that connection and may adapt its depth.
+ */
+void
+svn_ra_serf__fetch_sched_completed(svn_ra_serf__fetch_sched_t *sched,
+                                   int conn_idx,
+                                   apr_uint64_t bytes,
+                                   apr_time_t now);
+
+/* Return the sum of the pipeline depths of the first NUM_CONNS
+ * connections in SCHED.
+ */
+int
+svn_ra_serf__fetch_sched_depth(svn_ra_serf__fetch_sched_t *sched,
+                               int num_conns);
+
+/* Return the statistics of all fetches queued in SCHED so far.  The
+ * result is valid as long as SCHED is and gets updated by the other
+ * functions above.
+ */
+const svn_ra_serf__fetch_stats_t *
+svn_ra_serf__fetch_sched_stats(svn_ra_serf__fetch_sched_t *sched);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_FETCH_SCHED_H */
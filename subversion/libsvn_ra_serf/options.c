@@ -251,6 +251,10 @@ capabilities_headers_iterator_callback(void *baton,
         {
           session->supports_put_result_checksum = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_INLINE_FILES, vals))
+        {
+          session->supports_inline_files = TRUE;
+        }
     }
 
   /* SVN-specific headers -- if present, server supports HTTP protocol v2 */
@@ -314,6 +318,10 @@ capabilities_headers_iterator_callback(void *baton,
         {
           session->vtxn_root_stub = apr_pstrdup(session->pool, val);
         }
+      else if (svn_cstring_casecmp(key, SVN_DAV_SHA1_STUB_HEADER) == 0)
+        {
+          session->sha1_stub = apr_pstrdup(session->pool, val);
+        }
       else if (svn_cstring_casecmp(key, SVN_DAV_REPOS_UUID_HEADER) == 0)
         {
           session->uuid = apr_pstrdup(session->pool, val);
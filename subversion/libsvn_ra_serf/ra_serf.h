@@ -42,6 +42,7 @@
 #include "private/svn_editor.h"
 
 #include "blncache.h"
+#include "fetch_sched.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -144,6 +145,9 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Offer http/2 during the TLS handshake. */
+  svn_boolean_t use_http2;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -234,6 +238,7 @@ struct svn_ra_serf__session_t {
   const char *txn_root_stub;    /* for accessing TXN/PATH pairs */
   const char *vtxn_stub;        /* for accessing transactions (i.e. txnprops) */
   const char *vtxn_root_stub;   /* for accessing TXN/PATH pairs */
+  const char *sha1_stub;        /* for accessing contents by their SHA1 */
 
   /* Hash mapping const char * server-supported POST types to
      disinteresting-but-non-null values. */
@@ -273,7 +278,14 @@ struct svn_ra_serf__session_t {
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
 
+  /* Indicates whether the server can send the contents of small files
+   * inline in skelta mode update reports. */
+  svn_boolean_t supports_inline_files;
+
   apr_interval_time_t conn_latency;
+
+  /* Statistics of the file fetches of the last update report. */
+  svn_ra_serf__fetch_stats_t update_stats;
 };
 
 #define SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(sess) ((sess)->me_resource != NULL)
@@ -1310,6 +1322,12 @@ svn_ra_serf__do_switch(svn_ra_session_t *ra_session,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool);
 
+/* Return the statistics of the file fetches of the last update, switch
+   or status report that has been finished in RA_SESSION.  All counters
+   are 0 if there has been none. */
+const svn_ra_serf__fetch_stats_t *
+svn_ra_serf__get_update_stats(svn_ra_session_t *ra_session);
+
 /* Implements svn_ra__vtable_t.get_file_revs(). */
 svn_error_t *
 svn_ra_serf__get_file_revs(svn_ra_session_t *session,
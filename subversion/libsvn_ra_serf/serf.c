@@ -251,6 +251,12 @@ load_config(svn_ra_serf__session_t *session,
                                   SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                   "auto", svn_tristate_unknown));
 
+  /* Should we offer http/2 to the server.  This is still experimental
+     and therefore has to be enabled explicitly. */
+  SVN_ERR(svn_config_get_bool(config, &session->use_http2,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP2, FALSE));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   SVN_ERR(svn_config_get_int64(config, &log_components,
                                SVN_CONFIG_SECTION_GLOBAL,
@@ -318,6 +324,12 @@ load_config(svn_ra_serf__session_t *session,
                                       SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                       "auto", chunked_requests));
 
+      /* Should we offer http/2 to the server. */
+      SVN_ERR(svn_config_get_bool(config, &session->use_http2,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP2,
+                                  session->use_http2));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
       SVN_ERR(svn_config_get_int64(config, &log_components,
                                    server_group,
@@ -643,6 +655,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* using_compression */
   /* http10 */
   /* http20 */
+  /* use_http2 */
   /* using_chunked_requests */
   /* detect_chunking */
 
@@ -725,6 +738,8 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   if (new_sess->vtxn_root_stub)
     new_sess->vtxn_root_stub = apr_pstrdup(result_pool,
                                            new_sess->vtxn_root_stub);
+  if (new_sess->sha1_stub)
+    new_sess->sha1_stub = apr_pstrdup(result_pool, new_sess->sha1_stub);
 
   /* Keys and values are static */
   if (new_sess->supported_posts)
@@ -759,7 +774,9 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_svndiff1 */
   /* supports_svndiff2 */
   /* supports_put_result_checksum */
+  /* supports_inline_files */
   /* conn_latency */
+  /* update_stats */
 
   new_sess->context = serf_context_create(result_pool);
 
@@ -1064,6 +1081,7 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_serf__list,
+  NULL /* get_files */,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
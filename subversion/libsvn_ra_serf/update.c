@@ -47,6 +47,7 @@
 #include "private/svn_string_private.h"
 
 #include "ra_serf.h"
+#include "fetch_sched.h"
 #include "../libsvn_ra/ra_loader.h"
 
 
@@ -103,7 +104,8 @@ typedef enum report_state_e {
 #define V_ SVN_DAV_PROP_NS_DAV
 static const svn_ra_serf__xml_transition_t update_ttable[] = {
   { INITIAL, S_, "update-report", UPDATE_REPORT,
-    FALSE, { "?inline-props", "?send-all", NULL }, TRUE },
+    FALSE, { "?inline-props", "?send-all", "?inline-max-size", NULL },
+    TRUE },
 
   { UPDATE_REPORT, S_, "target-revision", TARGET_REVISION,
     FALSE, { "rev", NULL }, TRUE },
@@ -133,11 +135,11 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
 
   { OPEN_DIR, S_, "add-file", ADD_FILE,
     FALSE, { "name", "?copyfrom-path", "?copyfrom-rev",
-             "?sha1-checksum", NULL }, TRUE },
+             "?sha1-checksum", "?size", NULL }, TRUE },
 
   { ADD_DIR, S_, "add-file", ADD_FILE,
     FALSE, { "name", "?copyfrom-path", "?copyfrom-rev",
-             "?sha1-checksum", NULL }, TRUE },
+             "?sha1-checksum", "?size", NULL }, TRUE },
 
   { OPEN_DIR, S_, "delete-entry", DELETE_ENTRY,
     FALSE, { "?rev", "name", NULL }, TRUE },
@@ -212,10 +214,10 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
     FALSE, { "?base-checksum" }, TRUE },
 
   { OPEN_FILE, S_, "fetch-file", FETCH_FILE,
-    FALSE, { "?base-checksum", "?sha1-checksum", NULL }, TRUE},
+    FALSE, { "?base-checksum", "?sha1-checksum", "?size", NULL }, TRUE},
 
   { ADD_FILE, S_, "fetch-file", FETCH_FILE,
-    FALSE, { "?base-checksum", "?sha1-checksum", NULL }, TRUE },
+    FALSE, { "?base-checksum", "?sha1-checksum", "?size", NULL }, TRUE },
 
   { CHECKED_IN, D_, "href", CHECKED_IN_HREF,
     TRUE, { NULL }, TRUE },
@@ -251,10 +253,31 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
    can make the measurements quite imprecise.
 
    We measure outstanding requests as the sum of NUM_ACTIVE_FETCHES and
-   NUM_ACTIVE_PROPFINDS in the report_context_t structure.  */
+   NUM_ACTIVE_PROPFINDS in the report_context_t structure.  The GETs among
+   them are either on the wire or queued in our fetch scheduler, so these
+   numbers only apply while the pipelines are shallow; see
+   request_count_to_resume().  */
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+/* With http/2, all requests get multiplexed over a single connection and
+   the server processes them concurrently.  Per-stream flow control keeps
+   the REPORT response from blocking them, so keep many more in flight. */
+#define REQUEST_COUNT_TO_RESUME_HTTP2 250
+
+/* Initial and maximum number of GETs that we pipeline on a single
+   connection.  Within these limits, the depth adapts to the measured
+   latency and throughput of the connection; see fetch_sched.h. */
+#define PIPELINE_DEPTH_INITIAL 8
+#define PIPELINE_DEPTH_MAX 64
+#define PIPELINE_DEPTH_INITIAL_HTTP2 64
+#define PIPELINE_DEPTH_MAX_HTTP2 REQUEST_COUNT_TO_RESUME_HTTP2
+
+/* In skelta mode, ask servers that support it to send the contents of
+   files up to this size inline in the REPORT response.  Only larger files
+   are then fetched with separate GETs. */
+#define INLINE_FILE_MAX_SIZE (16 * 1024)
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
@@ -352,6 +375,10 @@ typedef struct file_baton_t
   svn_checksum_t *final_md5_checksum;
   svn_checksum_t *final_sha1_checksum;
 
+  /* Size of the final contents as announced by the server.
+     SVN_INVALID_FILESIZE if unknown. */
+  svn_filesize_t size;
+
   svn_stream_t *txdelta_stream;         /* Stream that feeds windows when
                                            written to within txdelta*/
 } file_baton_t;
@@ -388,6 +415,15 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* If set, we GET the contents by their SHA1 at SHA1_URL and name
+     SHA1_SOURCE (REV/PATH) as where the server can find them. */
+  const char *sha1_url;
+  const char *sha1_source;
+
+  /* Index of the connection that we sent the request on and when. */
+  int conn_idx;
+  apr_time_t sent;
+
 } fetch_ctx_t;
 
 /*
@@ -426,6 +462,10 @@ struct report_context_t {
      files/dirs? */
   svn_boolean_t add_props_included;
 
+  /* Is the server including the contents of files up to this size
+     inline?  0 if not. */
+  svn_filesize_t inline_max_size;
+
   /* Path -> const char *repos_relpath mapping */
   apr_hash_t *switched_paths;
 
@@ -439,9 +479,13 @@ struct report_context_t {
   /* Buffer holding request body for the REPORT (can spill to disk). */
   svn_ra_serf__request_body_t *body;
 
-  /* number of pending GET requests */
+  /* number of pending GET requests, i.e. queued or in flight */
   unsigned int num_active_fetches;
 
+  /* Decides when and on which connection queued GETs get sent.  Its
+     connection indexes are those of SESS->CONNS. */
+  svn_ra_serf__fetch_sched_t *fetch_sched;
+
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
@@ -536,6 +580,7 @@ create_file_baton(file_baton_t **new_file,
   /* Sane defaults */
   file->base_rev = SVN_INVALID_REVNUM;
   file->copyfrom_rev = SVN_INVALID_REVNUM;
+  file->size = SVN_INVALID_FILESIZE;
 
   *new_file = file;
 
@@ -555,6 +600,10 @@ create_file_baton(file_baton_t **new_file,
 static svn_error_t *
 open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
 {
+  /* A single http/2 connection carries all requests. */
+  if (sess->http20)
+    return SVN_NO_ERROR;
+
   /* For each REQS_PER_CONN outstanding requests open a new connection, with
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
@@ -585,12 +634,15 @@ open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
   return SVN_NO_ERROR;
 }
 
-/* Returns best connection for fetching files/properties. */
-static svn_ra_serf__connection_t *
-get_best_connection(report_context_t *ctx)
+/* Returns the index of the first connection of CTX's session that we may
+   use for fetching files/properties. */
+static int
+first_aux_connection(report_context_t *ctx)
 {
-  svn_ra_serf__connection_t *conn;
-  int first_conn = 1;
+  /* With http/2, the REPORT response does not block other requests on
+     the same connection, which is the only one we use. */
+  if (ctx->sess->http20)
+    return 0;
 
   /* Skip the first connection if the REPORT response hasn't been completely
      received yet or if we're being told to limit our connections to
@@ -606,7 +658,17 @@ get_best_connection(report_context_t *ctx)
      ### See http://subversion.tigris.org/issues/show_bug.cgi?id=4116.
   */
   if (ctx->report_received && (ctx->sess->max_connections > 2))
-    first_conn = 0;
+    return 0;
+
+  return 1;
+}
+
+/* Returns best connection for fetching files/properties. */
+static svn_ra_serf__connection_t *
+get_best_connection(report_context_t *ctx)
+{
+  svn_ra_serf__connection_t *conn;
+  int first_conn = first_aux_connection(ctx);
 
   /* If there's only one available auxiliary connection to use, don't bother
      doing all the cur_conn math -- just return that one connection.  */
@@ -651,6 +713,21 @@ get_best_connection(report_context_t *ctx)
     }
   return conn;
 }
+
+/* Returns the number of outstanding GETs and PROPFINDs of CTX below which
+   we continue processing the REPORT response. */
+static unsigned int
+request_count_to_resume(report_context_t *ctx)
+{
+  unsigned int count = ctx->sess->http20 ? REQUEST_COUNT_TO_RESUME_HTTP2
+                                         : REQUEST_COUNT_TO_RESUME;
+  unsigned int depths = svn_ra_serf__fetch_sched_depth(ctx->fetch_sched,
+                                                       ctx->sess->num_conns);
+
+  /* Keep about as many GETs queued as there are in flight, so that we
+     can choose which ones to send next. */
+  return MAX(count, 2 * depths);
+}
 
 /** Helpers to open and close directories */
 
@@ -804,6 +881,10 @@ headers_fetch(serf_bucket_t *headers,
       serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip");
     }
 
+  if (fetch_ctx->sha1_source)
+    serf_bucket_headers_setn(headers, SVN_DAV_SHA1_SOURCE_HEADER,
+                             fetch_ctx->sha1_source);
+
   return SVN_NO_ERROR;
 }
 
@@ -971,6 +1052,10 @@ handle_fetch(serf_request_t *request,
           return SVN_NO_ERROR; /* Will return an error in the DONE handler */
         }
 
+      svn_ra_serf__fetch_sched_started(file->parent_dir->ctx->fetch_sched,
+                                       fetch_ctx->conn_idx, fetch_ctx->sent,
+                                       apr_time_now());
+
       hdrs = serf_bucket_response_get_headers(response);
       val = serf_bucket_headers_get(hdrs, "Content-Type");
 
@@ -1141,6 +1226,82 @@ set_file_props(void *baton,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+file_fetch_done(serf_request_t *request,
+                void *baton,
+                apr_pool_t *scratch_pool);
+
+/* Send the GET request for FETCH_CTX on connection CONN_IDX of CTX at
+   time NOW. */
+static void
+send_fetch(report_context_t *ctx,
+           fetch_ctx_t *fetch_ctx,
+           int conn_idx,
+           apr_time_t now)
+{
+  file_baton_t *file = fetch_ctx->file;
+  svn_ra_serf__handler_t *handler;
+
+  handler = svn_ra_serf__create_handler(ctx->sess, file->pool);
+
+  handler->method = "GET";
+  handler->path = fetch_ctx->sha1_url ? fetch_ctx->sha1_url : file->url;
+
+  handler->conn = ctx->sess->conns[conn_idx]; /* Explicit scheduling */
+
+  handler->custom_accept_encoding = TRUE;
+  handler->no_dav_headers = TRUE;
+  handler->header_delegate = headers_fetch;
+  handler->header_delegate_baton = fetch_ctx;
+
+  handler->response_handler = handle_fetch;
+  handler->response_baton = fetch_ctx;
+
+  handler->response_error = cancel_fetch;
+  handler->response_error_baton = fetch_ctx;
+
+  handler->done_delegate = file_fetch_done;
+  handler->done_delegate_baton = fetch_ctx;
+
+  fetch_ctx->handler = handler;
+  fetch_ctx->conn_idx = conn_idx;
+  fetch_ctx->sent = now;
+
+  svn_ra_serf__request_create(handler);
+}
+
+/* Send queued GETs of CTX as long as our connections' pipelines have
+   room for them. */
+static void
+dispatch_fetches(report_context_t *ctx)
+{
+  while (TRUE)
+    {
+      int conn_idx;
+      apr_time_t now = apr_time_now();
+      fetch_ctx_t *fetch_ctx
+        = svn_ra_serf__fetch_sched_next(&conn_idx, ctx->fetch_sched,
+                                        first_aux_connection(ctx),
+                                        ctx->sess->num_conns, now);
+
+      if (!fetch_ctx)
+        break;
+
+      send_fetch(ctx, fetch_ctx, conn_idx, now);
+    }
+}
+
+/* Queue the GET request for FETCH_CTX in CTX and send whatever GETs fit
+   into the pipelines now. */
+static void
+queue_fetch(report_context_t *ctx,
+            fetch_ctx_t *fetch_ctx)
+{
+  svn_ra_serf__fetch_sched_queue(ctx->fetch_sched, fetch_ctx,
+                                 fetch_ctx->file->size);
+  dispatch_fetches(ctx);
+}
+
 /* Implements svn_ra_serf__response_done_delegate_t */
 static svn_error_t *
 file_props_done(serf_request_t *request,
@@ -1191,6 +1352,12 @@ file_fetch_done(serf_request_t *request,
 
   file->parent_dir->ctx->num_active_fetches--;
 
+  /* Make room in the pipeline for the next GET. */
+  svn_ra_serf__fetch_sched_completed(file->parent_dir->ctx->fetch_sched,
+                                     fetch_ctx->conn_idx,
+                                     fetch_ctx->read_size, apr_time_now());
+  dispatch_fetches(file->parent_dir->ctx);
+
   file->fetch_file = FALSE;
 
   if (file->fetch_props)
@@ -1213,7 +1380,6 @@ fetch_for_file(file_baton_t *file,
 {
   report_context_t *ctx = file->parent_dir->ctx;
   svn_ra_serf__connection_t *conn;
-  svn_ra_serf__handler_t *handler;
 
   /* Open extra connections if we have enough requests to send. */
   if (ctx->sess->num_conns < ctx->sess->max_connections)
@@ -1324,32 +1490,35 @@ fetch_for_file(file_baton_t *file,
                                         : NULL;
             }
 
-          handler = svn_ra_serf__create_handler(ctx->sess, file->pool);
-
-          handler->method = "GET";
-          handler->path = file->url;
-
-          handler->conn = conn; /* Explicit scheduling */
-
-          handler->custom_accept_encoding = TRUE;
-          handler->no_dav_headers = TRUE;
-          handler->header_delegate = headers_fetch;
-          handler->header_delegate_baton = fetch_ctx;
-
-          handler->response_handler = handle_fetch;
-          handler->response_baton = fetch_ctx;
-
-          handler->response_error = cancel_fetch;
-          handler->response_error_baton = fetch_ctx;
-
-          handler->done_delegate = file_fetch_done;
-          handler->done_delegate_baton = fetch_ctx;
+          /* Fulltexts can be fetched by their SHA1 instead, which allows
+             caching proxies to share identical contents between paths
+             and revisions.  The server finds the contents through the
+             REV/PATH part of the file's revision root URL. */
+          if (!fetch_ctx->delta_base
+              && ctx->sess->sha1_stub && ctx->sess->rev_root_stub
+              && file->final_sha1_checksum)
+            {
+              apr_size_t len = strlen(ctx->sess->rev_root_stub);
 
-          fetch_ctx->handler = handler;
+              if (strncmp(file->url, ctx->sess->rev_root_stub, len) == 0
+                  && file->url[len] == '/')
+                {
+                  const char *digest;
 
-          svn_ra_serf__request_create(handler);
+                  digest = svn_checksum_to_cstring_display(
+                                                file->final_sha1_checksum,
+                                                scratch_pool);
+                  fetch_ctx->sha1_source = file->url + len + 1;
+                  fetch_ctx->sha1_url = apr_pstrcat(file->pool,
+                                                    ctx->sess->sha1_stub,
+                                                    "/", digest,
+                                                    SVN_VA_NULL);
+                }
+            }
 
+          /* The GET goes out once a connection has room for it. */
           ctx->num_active_fetches++;
+          queue_fetch(ctx, fetch_ctx);
         }
     }
 
@@ -1502,6 +1671,16 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
           if (val && (strcmp(val, "true") == 0))
             ctx->add_props_included = TRUE;
 
+          val = svn_hash_gets(attrs, "inline-max-size");
+
+          if (val)
+            {
+              apr_int64_t size;
+
+              SVN_ERR(svn_cstring_atoi64(&size, val));
+              ctx->inline_max_size = (svn_filesize_t)size;
+            }
+
           val = svn_hash_gets(attrs, "send-all");
 
           if (val && (strcmp(val, "true") == 0))
@@ -1586,6 +1765,7 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
           else
             {
               const char *sha1_checksum;
+              const char *size_str;
               file->copyfrom_path = svn_hash_gets(attrs, "copyfrom-path");
 
               if (file->copyfrom_path)
@@ -1619,6 +1799,17 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
                                                  file->pool));
                 }
 
+              /* Servers since 1.11 tell us how large the file is, which
+                 lets us send the GETs for small files first. */
+              size_str = svn_hash_gets(attrs, "size");
+              if (size_str)
+                {
+                  apr_int64_t size;
+
+                  SVN_ERR(svn_cstring_atoi64(&size, size_str));
+                  file->size = (svn_filesize_t)size;
+                }
+
               /* If the server isn't in "send-all" mode, we should expect to
                  fetch contents for added files. */
               if (! ctx->send_all_mode)
@@ -1640,8 +1831,9 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
           /* Pre 1.2, mod_dav_svn was using <txdelta> tags (in
              addition to <fetch-file>s and such) when *not* in
              "send-all" mode.  As a client, we're smart enough to know
-             that's wrong, so we'll just ignore these tags. */
-          if (! ctx->send_all_mode)
+             that's wrong, so we'll just ignore these tags -- unless
+             we asked for small files to be sent inline. */
+          if (! ctx->send_all_mode && ! ctx->inline_max_size)
             break;
 
           file->fetch_file = FALSE;
@@ -1880,6 +2072,7 @@ update_closed(svn_ra_serf__xml_estate_t *xes,
           file_baton_t *file = ctx->cur_file;
           const char *base_checksum = svn_hash_gets(attrs, "base-checksum");
           const char *sha1_checksum = svn_hash_gets(attrs, "sha1-checksum");
+          const char *size_str = svn_hash_gets(attrs, "size");
 
           if (base_checksum)
             SVN_ERR(svn_checksum_parse_hex(&file->base_md5_checksum,
@@ -1893,6 +2086,14 @@ update_closed(svn_ra_serf__xml_estate_t *xes,
                                            sha1_checksum,
                                            file->pool));
 
+          if (size_str)
+            {
+              apr_int64_t size;
+
+              SVN_ERR(svn_cstring_atoi64(&size, size_str));
+              file->size = (svn_filesize_t)size;
+            }
+
           /* Some 0.3x mod_dav_svn wrote both txdelta and fetch-file
              elements in send-all mode. (See neon for history) */
           if (! ctx->send_all_mode)
@@ -2251,7 +2452,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < request_count_to_resume(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2335,7 +2536,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < request_count_to_resume(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2503,6 +2704,8 @@ finish_report(void *report_baton,
 
   err = process_editor_report(report, handler, scratch_pool);
 
+  sess->update_stats = *svn_ra_serf__fetch_sched_stats(report->fetch_sched);
+
   if (err)
     {
       err = svn_error_trace(err);
@@ -2519,6 +2722,14 @@ finish_report(void *report_baton,
 }
 
 
+const svn_ra_serf__fetch_stats_t *
+svn_ra_serf__get_update_stats(svn_ra_session_t *ra_session)
+{
+  svn_ra_serf__session_t *sess = ra_session->priv;
+
+  return &sess->update_stats;
+}
+
 static svn_error_t *
 abort_report(void *report_baton,
              apr_pool_t *pool)
@@ -2605,6 +2816,14 @@ make_update_reporter(svn_ra_session_t *ra_session,
   report->editor_baton = update_baton;
   report->done = FALSE;
 
+  report->fetch_sched = svn_ra_serf__fetch_sched_create(
+                          SVN_RA_SERF__MAX_CONNECTIONS_LIMIT,
+                          sess->http20 ? PIPELINE_DEPTH_INITIAL_HTTP2
+                                       : PIPELINE_DEPTH_INITIAL,
+                          sess->http20 ? PIPELINE_DEPTH_MAX_HTTP2
+                                       : PIPELINE_DEPTH_MAX,
+                          sess->conn_latency, report->pool);
+
   *reporter = &ra_serf_reporter;
   *report_baton = report;
 
@@ -2688,6 +2907,14 @@ make_update_reporter(svn_ra_session_t *ra_session,
       /* Subversion 1.8+ servers can be told to send properties for newly
          added items inline even when doing a skelta response. */
       make_simple_xml_tag(&buf, "S:include-props", "yes", scratch_pool);
+
+      /* Subversion 1.11+ servers can also send the contents of small
+         files inline, leaving only the larger ones to parallel GETs. */
+      if (sess->supports_inline_files && text_deltas)
+        make_simple_xml_tag(&buf, "S:inline-max-size",
+                            apr_psprintf(scratch_pool, "%d",
+                                         INLINE_FILE_MAX_SIZE),
+                            scratch_pool);
     }
 
   make_simple_xml_tag(&buf, "S:src-path", report->source, scratch_pool);
@@ -65,9 +65,12 @@ struct svn_ra_serf__xml_context_t {
   svn_ra_serf__xml_cdata_t cdata_cb;
   void *baton;
 
-  /* Linked list of free states.  */
+  /* Linked list of free states, recycled by xml_cb_start().  */
   svn_ra_serf__xml_estate_t *free_states;
 
+  /* The pool that states and their state pools are allocated in.  */
+  apr_pool_t *pool;
+
 #ifdef SVN_DEBUG
   /* Used to verify we are not re-entering a callback, specifically to
      ensure SCRATCH_POOL is not cleared while an outer callback is
@@ -110,7 +113,9 @@ struct svn_ra_serf__xml_estate_t {
      this tag is closed?  */
   svn_boolean_t custom_close;
 
-  /* A pool may be constructed for this state.  */
+  /* A pool may be constructed for this state.  It is cleared when the
+     state is popped and kept for the next state that reuses this
+     structure.  */
   apr_pool_t *state_pool;
 
   /* The namespaces extent for this state/element. This will start with
@@ -442,23 +447,21 @@ void svn_ra_serf__add_tag_buckets(serf_bucket_t *agg_bucket, const char *tag,
   svn_ra_serf__add_close_tag_buckets(agg_bucket, bkt_alloc, tag);
 }
 
-/* Return a pool for XES to use for self-alloc (and other specifics).  */
-static apr_pool_t *
-xes_pool(const svn_ra_serf__xml_estate_t *xes)
-{
-  /* Move up through parent states looking for one with a pool. This
-     will always terminate since the initial state has a pool.  */
-  while (xes->state_pool == NULL)
-    xes = xes->prev;
-  return xes->state_pool;
-}
-
-
 static void
 ensure_pool(svn_ra_serf__xml_estate_t *xes)
 {
   if (xes->state_pool == NULL)
-    xes->state_pool = svn_pool_create(xes_pool(xes));
+    {
+      const svn_ra_serf__xml_estate_t *root = xes;
+
+      /* State pools are not nested but all created in the pool of the
+         initial state, which lives as long as the parser.  This allows
+         them to be recycled along with their state.  */
+      while (root->prev)
+        root = root->prev;
+
+      xes->state_pool = svn_pool_create(root->state_pool);
+    }
 }
 
 
@@ -537,14 +540,15 @@ svn_ra_serf__xml_context_create(
   xmlctx->closed_cb = closed_cb;
   xmlctx->cdata_cb = cdata_cb;
   xmlctx->baton = baton;
+  xmlctx->pool = result_pool;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
 
   xes = apr_pcalloc(result_pool, sizeof(*xes));
   /* XES->STATE == 0  */
 
-  /* Child states may use this pool to allocate themselves. If a child
-     needs to collect information, then it will construct a subpool and
-     will use that to allocate itself and its collected data.  */
+  /* All states and their pools get allocated in RESULT_POOL, see
+     alloc_state() and ensure_pool().  A child state that collects
+     information allocates that data in its own state pool.  */
   xes->state_pool = result_pool;
 
   xmlctx->current = xes;
@@ -631,6 +635,28 @@ svn_ra_serf__xml_state_pool(svn_ra_serf__xml_estate_t *xes)
 }
 
 
+/* Return a state structure for XMLCTX, recycled from its free list if
+   possible.  All fields but STATE_POOL are zeroed.  */
+static svn_ra_serf__xml_estate_t *
+alloc_state(svn_ra_serf__xml_context_t *xmlctx)
+{
+  svn_ra_serf__xml_estate_t *xes = xmlctx->free_states;
+
+  if (xes)
+    {
+      apr_pool_t *state_pool = xes->state_pool;
+
+      xmlctx->free_states = xes->prev;
+      memset(xes, 0, sizeof(*xes));
+      xes->state_pool = state_pool;
+    }
+  else
+    xes = apr_pcalloc(xmlctx->pool, sizeof(*xes));
+
+  return xes;
+}
+
+
 static svn_error_t *
 xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
              const char *raw_name,
@@ -639,7 +665,6 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   svn_ra_serf__xml_estate_t *current = xmlctx->current;
   svn_ra_serf__dav_props_t elemname;
   const svn_ra_serf__xml_transition_t *scan;
-  apr_pool_t *new_pool;
   svn_ra_serf__xml_estate_t *new_xes;
 
   /* If we're waiting for an element to close, then just ignore all
@@ -690,22 +715,20 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Found a transition. Make it happen.  */
 
-  /* ### todo. push state  */
-
-  /* ### how to use free states?  */
-  /* This state should be allocated in the extent pool. If we will be
-     collecting information for this state, then construct a subpool.
+  /* Prep the new state.  Parsing large reports pushes and pops states
+     at a high rate, so we recycle both the state and its pool (if
+     any) instead of allocating new ones.  */
+  new_xes = alloc_state(xmlctx);
+  new_xes->prev = current;
 
-     ### potentially optimize away the subpool if none of the
-     ### attributes are present. subpools are cheap, tho...  */
-  new_pool = xes_pool(current);
+  /* If we will be collecting information for this state, then make sure
+     it has a pool.  */
   if (scan->collect_cdata || scan->collect_attrs[0])
     {
-      new_pool = svn_pool_create(new_pool);
+      apr_pool_t *new_pool;
 
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      new_xes->state_pool = new_pool;
+      ensure_pool(new_xes);
+      new_pool = new_xes->state_pool;
 
       /* If we're supposed to collect cdata, then set up a buffer for
          this. The existence of this buffer will instruct our cdata
@@ -746,24 +769,29 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
             }
         }
     }
-  else
-    {
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      /* STATE_POOL remains NULL.  */
-    }
 
   /* Some basic copies to set up the new estate.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
   new_xes->custom_close = scan->custom_close;
 
+  /* A specific transition names the element for us.  Only wildcard
+     matches need a copy of the name, which lives in the parser.  */
+  if (*scan->name == '*')
+    {
+      ensure_pool(new_xes);
+      new_xes->tag.name = apr_pstrdup(new_xes->state_pool, elemname.name);
+      new_xes->tag.xmlns = apr_pstrdup(new_xes->state_pool, elemname.xmlns);
+    }
+  else
+    {
+      new_xes->tag.name = scan->name;
+      new_xes->tag.xmlns = scan->ns;
+    }
+
   /* Start with the parent's namespace set.  */
   new_xes->ns_list = current->ns_list;
 
   /* The new state is prepared. Make it current.  */
-  new_xes->prev = current;
   xmlctx->current = new_xes;
 
   if (xmlctx->opened_cb)
@@ -820,17 +848,15 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
   /* Pop the state.  */
   xmlctx->current = xes->prev;
 
-  /* ### not everything should go on the free state list. XES may go
-     ### away with the state pool.  */
+  /* If there is a STATE_POOL, then clear it. This will get rid of as much
+     memory as possible, while keeping the pool for the next state that
+     reuses XES.  */
+  if (xes->state_pool)
+    svn_pool_clear(xes->state_pool);
+
   xes->prev = xmlctx->free_states;
   xmlctx->free_states = xes;
 
-  /* If there is a STATE_POOL, then toss it. This will get rid of as much
-     memory as possible. Potentially the XES (if we didn't create a pool
-     right away, then XES may be in a parent pool).  */
-  if (xes->state_pool)
-    svn_pool_destroy(xes->state_pool);
-
   return SVN_NO_ERROR;
 }
 
@@ -631,6 +631,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   const char *client_string = NULL;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
+  svn_boolean_t compress_stream;
 
   parent = apr_pcalloc(pool, sizeof(*parent));
   parent->client_url = svn_stringbuf_create(url, pool);
@@ -747,7 +748,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  compress_stream = svn_ra_svn_has_capability(conn,
+                                        SVN_RA_SVN_CAP_COMPRESSED_STREAM);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,9 +759,18 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  compress_stream
+                                    ? SVN_RA_SVN_CAP_COMPRESSED_STREAM
+                                    : NULL,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
+
+  /* Accepting the server's offer to compress the connection takes effect
+   * right after our response. */
+  if (compress_stream)
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, pool));
+
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -1433,37 +1445,21 @@ parse_iproplist(apr_array_header_t **inherited_props,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
-                                    svn_revnum_t rev, svn_stream_t *stream,
-                                    svn_revnum_t *fetched_rev,
-                                    apr_hash_t **props,
-                                    apr_pool_t *pool)
+/* Read the contents of a file from CONN, as sent by get-file and
+   get-files, and push them into STREAM (which may be NULL).  Verify them
+   against the hex MD5 EXPECTED_DIGEST, if given.  PATH is used for error
+   messages only.  Use POOL for temporary allocations. */
+static svn_error_t *
+read_file_contents(svn_ra_svn_conn_t *conn,
+                   svn_stream_t *stream,
+                   const char *expected_digest,
+                   const char *path,
+                   apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist;
-  const char *expected_digest;
   svn_checksum_t *expected_checksum = NULL;
-  svn_checksum_ctx_t *checksum_ctx;
+  svn_checksum_ctx_t *checksum_ctx = NULL;
   apr_pool_t *iterpool;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
-                                         (props != NULL), (stream != NULL)));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
-                                        &expected_digest,
-                                        &rev, &proplist));
-
-  if (fetched_rev)
-    *fetched_rev = rev;
-  if (props)
-    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
-
-  /* We're done if the contents weren't wanted. */
-  if (!stream)
-    return SVN_NO_ERROR;
-
   if (expected_digest)
     {
       SVN_ERR(svn_checksum_parse_hex(&expected_checksum, svn_checksum_md5,
@@ -1471,7 +1467,6 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
       checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
     }
 
-  /* Read the file's contents. */
   iterpool = svn_pool_create(pool);
   while (1)
     {
@@ -1489,11 +1484,13 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
         SVN_ERR(svn_checksum_update(checksum_ctx, item->u.string.data,
                                     item->u.string.len));
 
-      SVN_ERR(svn_stream_write(stream, item->u.string.data,
-                               &item->u.string.len));
+      if (stream)
+        SVN_ERR(svn_stream_write(stream, item->u.string.data,
+                                 &item->u.string.len));
     }
   svn_pool_destroy(iterpool);
 
+  /* Errors while sending the contents are reported here. */
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, ""));
 
   if (expected_checksum)
@@ -1510,6 +1507,39 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
+                                    svn_revnum_t rev, svn_stream_t *stream,
+                                    svn_revnum_t *fetched_rev,
+                                    apr_hash_t **props,
+                                    apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist;
+  const char *expected_digest;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
+                                         (props != NULL), (stream != NULL)));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
+                                        &expected_digest,
+                                        &rev, &proplist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+  if (props)
+    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
+
+  /* We're done if the contents weren't wanted. */
+  if (!stream)
+    return SVN_NO_ERROR;
+
+  /* Read the file's contents. */
+  return svn_error_trace(read_file_contents(conn, stream, expected_digest,
+                                            path, pool));
+}
+
 /* Write the protocol words that correspond to DIRENT_FIELDS to CONN
  * and use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
@@ -1836,6 +1866,134 @@ is_done_response(const svn_ra_svn__item_t *item)
           && svn_string_compare(&item->u.word, &str_done));
 }
 
+static svn_error_t *
+ra_svn_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_boolean_t want_contents,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+  int i;
+
+  /* Let the RA loader fall back to a series of get-file commands. */
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_GET_FILES))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support fetching multiple "
+                              "files at once"));
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "get-files"));
+  for (i = 0; i < files->nelts; ++i)
+    {
+      const svn_ra_file_spec_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_spec_t *);
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = reparent_path(session, file->path, iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "c(?r)", path,
+                                      file->revision));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)bb)",
+                                  want_props, want_contents));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read the file entries in request order.  The server stops at the
+     first failure.  After a local error, keep reading and discarding the
+     entries to keep the connection in a well-defined state. */
+  for (i = 0; i < files->nelts; ++i)
+    {
+      const svn_ra_file_spec_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_spec_t *);
+      svn_ra_svn__item_t *elt;
+      svn_ra_svn__list_t *list, *proplist;
+      const char *status, *expected_digest;
+      svn_revnum_t rev;
+      apr_hash_t *props = NULL;
+      svn_stream_t *stream = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_error_compose_create(err,
+                svn_ra_svn__read_item(conn, iterpool, &elt)));
+
+      /* A fatal server error or a failed file ends the list early. */
+      if (is_done_response(elt))
+        {
+          done = TRUE;
+          break;
+        }
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_compose_create(err,
+                 svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                  _("File entry not a list")));
+
+      SVN_ERR(svn_error_compose_create(err,
+                svn_ra_svn__parse_tuple(&elt->u.list, "wl",
+                                        &status, &list)));
+      if (strcmp(status, "failure") == 0)
+        {
+          err = svn_error_compose_create(err,
+                  svn_ra_svn__handle_failure_status(list));
+          break;
+        }
+      else if (strcmp(status, "success") != 0)
+        return svn_error_compose_create(err,
+                 svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                  _("Unknown status for get-files "
+                                    "command")));
+
+      SVN_ERR(svn_error_compose_create(err,
+                svn_ra_svn__parse_tuple(list, "(?c)rl", &expected_digest,
+                                        &rev, &proplist)));
+
+      if (!err && want_props)
+        err = svn_ra_svn__parse_proplist(proplist, iterpool, &props);
+      if (!err)
+        err = receiver(&stream, receiver_baton, i, rev, props,
+                       iterpool, iterpool);
+
+      if (want_contents)
+        {
+          svn_error_t *read_err;
+
+          read_err = read_file_contents(conn, err ? NULL : stream,
+                                        err ? NULL : expected_digest,
+                                        file->path, iterpool);
+          if (!read_err && !err && stream)
+            read_err = svn_stream_close(stream);
+
+          err = svn_error_compose_create(err, read_err);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (!done)
+    {
+      svn_ra_svn__item_t *elt;
+      svn_error_t *read_err;
+
+      read_err = svn_ra_svn__read_item(conn, scratch_pool, &elt);
+      if (!read_err && !is_done_response(elt))
+        read_err = svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Didn't receive end marker for "
+                                      "get-files entries"));
+      if (read_err)
+        return svn_error_compose_create(err, read_err);
+    }
+
+  return svn_error_compose_create(
+           err, svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+}
+
 
 static svn_error_t *
 perform_ra_svn_log(svn_error_t **outer_error,
@@ -3282,6 +3440,7 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_get_files,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 
 #define APR_WANT_STRFUNC
+#define APR_WANT_IOVEC
 #include <apr_want.h>
 #include <apr_general.h>
 #include <apr_lib.h>
@@ -215,11 +216,25 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->recording = NULL;
+  conn->max_recording = 0;
+  conn->recording_failed = FALSE;
+  memset(&conn->io_stats, 0, sizeof(conn->io_stats));
+  conn->command_cb = NULL;
+  conn->command_baton = NULL;
+  conn->command_depth = 0;
   conn->pool = result_pool;
 
   if (sock != NULL)
     {
       apr_sockaddr_t *sa;
+
+      /* We buffer our output and flush it explicitly whenever we are
+       * waiting for the other side.  Delaying the last segment of each
+       * flush until the previous ones got acknowledged only adds a round
+       * trip.  It is not an error if we can't change that. */
+      apr_socket_opt_set(sock, APR_TCP_NODELAY, 1);
+
       conn->stream = svn_ra_svn__stream_from_sock(sock, result_pool);
       if (!(apr_socket_addr_get(&sa, APR_REMOTE, sock) == APR_SUCCESS
             && apr_sockaddr_ip_get(&conn->remote_ip, sa) == APR_SUCCESS))
@@ -343,6 +358,21 @@ svn_ra_svn__reset_command_io_counters(svn_ra_svn_conn_t *conn)
   conn->current_out = 0;
 }
 
+const svn_ra_svn__io_stats_t *
+svn_ra_svn__get_io_stats(svn_ra_svn_conn_t *conn)
+{
+  return &conn->io_stats;
+}
+
+void
+svn_ra_svn__set_command_callback(svn_ra_svn_conn_t *conn,
+                                 svn_ra_svn__command_cb_t callback,
+                                 void *baton)
+{
+  conn->command_cb = callback;
+  conn->command_baton = baton;
+}
+
 
 /* --- WRITE BUFFER MANAGEMENT --- */
 
@@ -363,14 +393,42 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+/* Stop the active recording on CONN and mark it as failed. */
+static void
+cancel_recording(svn_ra_svn_conn_t *conn)
 {
-  const char *end = data + len;
-  apr_size_t count;
+  conn->recording = NULL;
+  conn->recording_failed = TRUE;
+}
+
+/* Append the LEN bytes at DATA to the active recording on CONN unless
+ * that would exceed the recording size limit. */
+static void
+record_output(svn_ra_svn_conn_t *conn,
+              const char *data,
+              apr_size_t len)
+{
+  if (conn->recording->len + len > conn->max_recording)
+    cancel_recording(conn);
+  else
+    svn_stringbuf_appendbytes(conn->recording, data, len);
+}
+
+/* Write the NVEC buffers in VEC to socket or output file as appropriate.
+ * The contents of VEC will be modified. */
+static svn_error_t *writebuf_outputv(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     struct iovec *vec, int nvec)
+{
+  apr_size_t len = 0;
+  apr_size_t count, left;
+  apr_time_t start;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
+  int i;
+
+  for (i = 0; i < nvec; ++i)
+    len += vec[i].iov_len;
 
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
@@ -378,14 +436,28 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   conn->current_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  for (i = 0; i < nvec && conn->recording; ++i)
+    record_output(conn, vec[i].iov_base, vec[i].iov_len);
+
+  while (nvec > 0)
     {
-      count = end - data;
+      /* Skip buffers that have been sent completely. */
+      if (vec->iov_len == 0)
+        {
+          ++vec;
+          --nvec;
+          continue;
+        }
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      start = apr_time_now();
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec, &count));
+      conn->io_stats.send_time += apr_time_now() - start;
+      conn->io_stats.send_calls++;
+      conn->io_stats.bytes_sent += count;
+
       if (count == 0)
         {
           if (!subpool)
@@ -394,7 +466,16 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
+
+      /* Skip what has been sent. */
+      left = count;
+      for (i = 0; i < nvec && left > 0; ++i)
+        {
+          apr_size_t consumed = MIN(left, vec[i].iov_len);
+          vec[i].iov_base = (char *)vec[i].iov_base + consumed;
+          vec[i].iov_len -= consumed;
+          left -= consumed;
+        }
 
       if (session)
         {
@@ -416,6 +497,18 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Write data to socket or output file as appropriate. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  struct iovec vec;
+
+  vec.iov_base = (void *)data;
+  vec.iov_len = len;
+
+  return svn_error_trace(writebuf_outputv(conn, pool, &vec, 1));
+}
+
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
@@ -430,13 +523,22 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
+  /* data >= 8k is sent immediately, together with what has been buffered
+     so far.  Passing both to the kernel at once saves a system call and,
+     more importantly, a small packet of its own for the buffered part. */
   if (len >= sizeof(conn->write_buf) / 2)
     {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
+      struct iovec vec[2];
 
-      return writebuf_output(conn, pool, data, len);
+      vec[0].iov_base = conn->write_buf;
+      vec[0].iov_len = conn->write_pos;
+      vec[1].iov_base = (void *)data;
+      vec[1].iov_len = len;
+
+      /* Clear conn->write_pos first in case the block handler does a
+         read. */
+      conn->write_pos = 0;
+      return svn_error_trace(writebuf_outputv(conn, pool, vec, 2));
     }
 
   /* ensure room for the data to add */
@@ -504,8 +606,21 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
    * we first read the whole request into memory before process it. */
   SVN_ERR(check_io_limits(conn));
 
+  /* A response that depends on further client input can't be replayed. */
+  if (conn->recording)
+    cancel_recording(conn);
+
   /* Actually fill the buffer. */
-  SVN_ERR(svn_ra_svn__stream_read(conn->stream, data, len));
+  {
+    apr_time_t start = apr_time_now();
+    svn_error_t *err = svn_ra_svn__stream_read(conn->stream, data, len);
+
+    conn->io_stats.receive_time += apr_time_now() - start;
+    conn->io_stats.receive_calls++;
+    SVN_ERR(err);
+  }
+
+  conn->io_stats.bytes_received += *len;
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
   conn->current_in += *len;
@@ -762,6 +877,64 @@ svn_ra_svn__write_string(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_boolean_t
+svn_ra_svn__can_write_file_range(svn_ra_svn_conn_t *conn)
+{
+  /* File contents sent by the kernel would be missing from a recording. */
+  return conn->recording == NULL
+      && svn_ra_svn__stream_supports_sendfile(conn->stream);
+}
+
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len)
+{
+  apr_off_t end = offset + len;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* The string header must go out before the contents.  Flush all data
+   * that we buffered so far since the file contents bypass WRITE_BUF.
+   * Keep the kernel from sending that as a short packet of its own. */
+  svn_ra_svn__stream_cork(conn->stream, TRUE);
+  SVN_ERR(write_number(conn, pool, len, ':'));
+  SVN_ERR(writebuf_flush(conn, pool));
+
+  /* Same accounting as in writebuf_output. */
+  conn->current_out += len;
+  SVN_ERR(check_io_limits(conn));
+
+  if (conn->recording)
+    cancel_recording(conn);
+
+  while (offset < end && !err)
+    {
+      apr_size_t count = (apr_size_t)(end - offset);
+      apr_time_t start = apr_time_now();
+
+      err = svn_ra_svn__stream_sendfile(conn->stream, file, offset, &count);
+      conn->io_stats.send_time += apr_time_now() - start;
+      conn->io_stats.send_calls++;
+      conn->io_stats.bytes_sent += count;
+
+      if (!err && count == 0)
+        err = svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL,
+                               _("Unexpected end of file"));
+      offset += count;
+    }
+
+  svn_ra_svn__stream_cork(conn->stream, FALSE);
+  SVN_ERR(err);
+
+  conn->written_since_error_check += len;
+  conn->may_check_for_error
+    = conn->written_since_error_check >= conn->error_check_interval;
+
+  return writebuf_writechar(conn, pool, ' ');
+}
+
 svn_error_t *
 svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
@@ -866,6 +1039,68 @@ svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool)
+{
+  /* Everything written so far must still go out uncompressed. */
+  SVN_ERR(svn_ra_svn__flush(conn, pool));
+
+  /* Anything we already received beyond the current item belongs to
+   * the compressed stream. */
+  conn->stream = svn_ra_svn__stream_compressed(conn->stream,
+                                               conn->read_ptr,
+                                               conn->read_end
+                                                 - conn->read_ptr,
+                                               conn->pool);
+  conn->read_end = conn->read_ptr;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__start_recording(svn_ra_svn_conn_t *conn,
+                            apr_size_t max_size,
+                            apr_pool_t *result_pool)
+{
+  SVN_ERR_ASSERT(conn->recording == NULL);
+
+  /* Data written before this call is not part of the recording. */
+  if (conn->write_pos)
+    SVN_ERR(writebuf_flush(conn, result_pool));
+
+  conn->recording = svn_stringbuf_create_empty(result_pool);
+  conn->max_recording = max_size;
+  conn->recording_failed = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_stringbuf_t *
+svn_ra_svn__stop_recording(svn_ra_svn_conn_t *conn)
+{
+  svn_stringbuf_t *result = conn->recording;
+
+  /* Whatever is still in the write buffer has been written as well. */
+  if (result)
+    record_output(conn, conn->write_buf, conn->write_pos);
+
+  result = conn->recording_failed ? NULL : conn->recording;
+  conn->recording = NULL;
+  conn->recording_failed = FALSE;
+
+  return result;
+}
+
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len)
+{
+  return svn_error_trace(writebuf_write(conn, pool, data, len));
+}
+
 /* --- WRITING TUPLES --- */
 
 static svn_error_t *
@@ -1549,17 +1784,282 @@ read_command_only(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of lists within a single item that parse_buffered_item
+ * will handle.  Items with more lists take the streaming path. */
+#define SCAN_MAX_LISTS 512
+
+/* State of the two-pass in-buffer parser used by parse_buffered_item. */
+typedef struct scan_state_t
+{
+  /* Total number of items, including the top-level item. */
+  apr_size_t item_count;
+
+  /* Total number of bytes required for strings and words, including
+   * their NUL terminators. */
+  apr_size_t string_bytes;
+
+  /* Number of elements per list, in pre-order. */
+  int list_counts[SCAN_MAX_LISTS];
+  int list_count;
+
+  /* Index of the next LIST_COUNTS element to use while building. */
+  int next_list;
+
+  /* Unused parts of the arena while building. */
+  svn_ra_svn__item_t *next_item;
+  char *next_string;
+} scan_state_t;
+
+/* Scan the item starting at *P, which must not be whitespace, up to the
+ * whitespace terminating it and set *P to the first byte after that.
+ * Do not read beyond END.  Count the item sizes in STATE.  LEVEL is the
+ * recursion level as in read_item.
+ *
+ * Return FALSE if the item is not completely contained in the buffer or
+ * if it is not well-formed.  In that case, nothing has been consumed and
+ * read_item will take care of it, including any error reporting.
+ *
+ * This function must accept exactly the same syntax as read_item. */
+static svn_boolean_t
+scan_item(const char **p,
+          const char *end,
+          scan_state_t *state,
+          int level)
+{
+  const char *ptr = *p;
+  char c = *ptr++;
+
+  if (++level >= ITEM_NESTING_LIMIT)
+    return FALSE;
+
+  ++state->item_count;
+  if (svn_ctype_isdigit(c))
+    {
+      apr_uint64_t val = c - '0';
+      while (1)
+        {
+          if (ptr == end)
+            return FALSE;
+
+          c = *ptr++;
+          if (!svn_ctype_isdigit(c))
+            break;
+
+          /* Let read_item decide how to handle potential overflows. */
+          if (val >= (APR_UINT64_MAX / 10))
+            return FALSE;
+          val = val * 10 + (c - '0');
+        }
+
+      if (c == ':')
+        {
+          if ((apr_uint64_t)(end - ptr) <= val)
+            return FALSE;
+
+          state->string_bytes += (apr_size_t)val + 1;
+          ptr += val;
+          c = *ptr++;
+        }
+    }
+  else if (svn_ctype_isalpha(c))
+    {
+      const char *word = ptr - 1;
+      do
+        {
+          if (ptr == end)
+            return FALSE;
+          c = *ptr++;
+        }
+      while (svn_ctype_isalnum(c) || c == '-');
+
+      if (ptr - 1 - word >= MAX_WORD_LENGTH)
+        return FALSE;
+
+      state->string_bytes += ptr - word;
+    }
+  else if (c == '(')
+    {
+      int list = state->list_count;
+      int count = 0;
+
+      if (list == SCAN_MAX_LISTS)
+        return FALSE;
+      ++state->list_count;
+
+      while (1)
+        {
+          do
+            {
+              if (ptr == end)
+                return FALSE;
+              c = *ptr++;
+            }
+          while (svn_iswhitespace(c));
+
+          if (c == ')')
+            break;
+
+          --ptr;
+          if (!scan_item(&ptr, end, state, level))
+            return FALSE;
+          ++count;
+        }
+
+      state->list_counts[list] = count;
+
+      if (ptr == end)
+        return FALSE;
+      c = *ptr++;
+    }
+
+  if (!svn_iswhitespace(c))
+    return FALSE;
+
+  *p = ptr;
+  return TRUE;
+}
+
+/* Construct ITEM from the data at *P that has been validated by scan_item
+ * and set *P to the first byte after the item's terminating whitespace.
+ * Take all memory from the arena in STATE. */
+static void
+build_item(svn_ra_svn__item_t *item,
+           const char **p,
+           scan_state_t *state)
+{
+  const char *ptr = *p;
+  char c = *ptr++;
+
+  if (svn_ctype_isdigit(c))
+    {
+      apr_uint64_t val = c - '0';
+      for (c = *ptr++; svn_ctype_isdigit(c); c = *ptr++)
+        val = val * 10 + (c - '0');
+
+      if (c == ':')
+        {
+          apr_size_t len = (apr_size_t)val;
+          char *data = state->next_string;
+
+          memcpy(data, ptr, len);
+          data[len] = '\0';
+          state->next_string += len + 1;
+
+          item->kind = SVN_RA_SVN_STRING;
+          item->u.string.data = data;
+          item->u.string.len = len;
+          ptr += len + 1;
+        }
+      else
+        {
+          item->kind = SVN_RA_SVN_NUMBER;
+          item->u.number = val;
+        }
+    }
+  else if (svn_ctype_isalpha(c))
+    {
+      const char *word = ptr - 1;
+      apr_size_t len;
+      char *data = state->next_string;
+
+      while (svn_ctype_isalnum(*ptr) || *ptr == '-')
+        ++ptr;
+
+      len = ptr - word;
+      memcpy(data, word, len);
+      data[len] = '\0';
+      state->next_string += len + 1;
+
+      item->kind = SVN_RA_SVN_WORD;
+      item->u.word.data = data;
+      item->u.word.len = len;
+      ++ptr;
+    }
+  else
+    {
+      int count = state->list_counts[state->next_list++];
+      int i;
+
+      item->kind = SVN_RA_SVN_LIST;
+      item->u.list.nelts = count;
+      item->u.list.items = count ? state->next_item : NULL;
+      state->next_item += count;
+
+      for (i = 0; i < count; ++i)
+        {
+          while (svn_iswhitespace(*ptr))
+            ++ptr;
+          build_item(&item->u.list.items[i], &ptr, state);
+        }
+
+      /* Skip to the closing paren and the whitespace after it. */
+      while (*ptr != ')')
+        ++ptr;
+      ptr += 2;
+    }
+
+  *p = ptr;
+}
+
+/* If the item starting at CONN->READ_PTR - 1 is completely contained in
+ * CONN's read buffer, parse it, allocating all of it in a single block
+ * from POOL, return it in *ITEM and advance the read pointer past it.
+ * Otherwise, set *ITEM to NULL and don't consume anything.
+ *
+ * This avoids the per-byte overhead of readbuf_getchar and the many small
+ * allocations in read_item for the vast majority of items.
+ * SCRATCH must be used for state data only and may be uninitialized. */
+static void
+parse_buffered_item(svn_ra_svn__item_t **item,
+                    svn_ra_svn_conn_t *conn,
+                    scan_state_t *scratch,
+                    apr_pool_t *pool)
+{
+  const char *start = conn->read_ptr - 1;
+  const char *p = start;
+  char *arena;
+
+  scratch->item_count = 0;
+  scratch->string_bytes = 0;
+  scratch->list_count = 0;
+  if (!scan_item(&p, conn->read_end, scratch, 0))
+    {
+      *item = NULL;
+      return;
+    }
+
+  /* Items first to keep them properly aligned, strings afterwards. */
+  arena = apr_palloc(pool, scratch->item_count * sizeof(**item)
+                           + scratch->string_bytes);
+  scratch->next_list = 0;
+  scratch->next_item = (svn_ra_svn__item_t *)arena;
+  scratch->next_string = arena + scratch->item_count * sizeof(**item);
+
+  *item = scratch->next_item++;
+  p = start;
+  build_item(*item, &p, scratch);
+
+  conn->read_ptr = (char *)p;
+}
+
 svn_error_t *
 svn_ra_svn__read_item(svn_ra_svn_conn_t *conn,
                       apr_pool_t *pool,
                       svn_ra_svn__item_t **item)
 {
   char c;
+  scan_state_t scratch;
 
-  /* Allocate space, read the first character, and then do the rest of
-   * the work.  This makes sense because of the way lists are read. */
-  *item = apr_palloc(pool, sizeof(**item));
   SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+
+  /* Fast path, if the item is fully available already. */
+  parse_buffered_item(item, conn, &scratch, pool);
+  if (*item)
+    return SVN_NO_ERROR;
+
+  /* Allocate space and then do the rest of the work.  This makes sense
+   * because of the way lists are read. */
+  *item = apr_palloc(pool, sizeof(**item));
   return read_item(conn, pool, *item, c, 0);
 }
 
@@ -1915,9 +2415,13 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   svn_error_t *err, *write_err;
   svn_ra_svn__list_t *params;
   const svn_ra_svn__cmd_entry_t *command;
+  svn_ra_svn__command_cb_t command_cb;
 
   *terminate = FALSE;
 
+  /* Only report top-level commands, not those nested within them. */
+  command_cb = conn->command_depth == 0 ? conn->command_cb : NULL;
+
   /* Limit I/O for every command separately. */
   svn_ra_svn__reset_command_io_counters(conn);
 
@@ -1937,9 +2441,13 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      if (command_cb)
+        SVN_ERR(command_cb(conn->command_baton, conn, cmdname, FALSE, pool));
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
+      conn->command_depth++;
       if (command->handler)
         {
           err = (*command->handler)(conn, pool, params, baton);
@@ -1951,6 +2459,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
           err = (*command->deprecated_handler)(conn, pool, deprecated_params,
                                                baton);
         }
+      conn->command_depth--;
 
       /* The command implementation may have swallowed or wrapped the I/O
        * error not knowing that we may no longer be able to send data.
@@ -1974,9 +2483,14 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
                       conn, pool,
                       svn_ra_svn__locate_real_error_child(err));
       svn_error_clear(err);
-      return write_err ? write_err : SVN_NO_ERROR;
+      err = write_err;
     }
 
+  if (command && command_cb)
+    err = svn_error_compose_create(err,
+                                   command_cb(conn->command_baton, conn,
+                                              cmdname, TRUE, pool));
+
   return err;
 }
 
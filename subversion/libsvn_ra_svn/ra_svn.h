@@ -102,6 +102,14 @@ struct svn_ra_svn_conn_st {
   apr_uint64_t max_out;
   apr_uint64_t current_out;
 
+  /* lifetime I/O statistics, see svn_ra_svn__get_io_stats() */
+  svn_ra_svn__io_stats_t io_stats;
+
+  /* per-command notification, see svn_ra_svn__set_command_callback() */
+  svn_ra_svn__command_cb_t command_cb;
+  void *command_baton;
+  int command_depth;
+
   /* repository info */
   const char *uuid;
   const char *repos_root;
@@ -115,6 +123,11 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* response recording, see svn_ra_svn__start_recording() */
+  svn_stringbuf_t *recording;
+  apr_size_t max_recording;
+  svn_boolean_t recording_failed;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -222,12 +235,57 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM, in that order, and return the
+ * number of bytes written in *LEN.  Socket-backed streams send all of
+ * them with a single system call if possible.  Other streams may write
+ * only the first non-empty buffer.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec,
+                                       int nvec,
+                                       apr_size_t *len);
+
+/* If STREAM writes directly to a TCP socket, tell the kernel to hold back
+ * partial segments while CORK is TRUE, so that data written with several
+ * calls leaves in as few packets as possible.  Setting CORK to FALSE sends
+ * any pending partial segment.  This is a no-op for other streams.
+ */
+void svn_ra_svn__stream_cork(svn_ra_svn__stream_t *stream,
+                             svn_boolean_t cork);
+
+/* Return TRUE if svn_ra_svn__stream_sendfile() may be used on STREAM.
+ */
+svn_boolean_t
+svn_ra_svn__stream_supports_sendfile(svn_ra_svn__stream_t *stream);
+
+/* Send up to *LEN bytes starting at OFFSET in FILE directly to the
+ * socket underlying STREAM, bypassing the stream's write function.
+ * Return the number of bytes sent in *LEN.  This must only be called
+ * if svn_ra_svn__stream_supports_sendfile() returned TRUE for STREAM.
+ */
+svn_error_t *
+svn_ra_svn__stream_sendfile(svn_ra_svn__stream_t *stream,
+                            apr_file_t *file,
+                            apr_off_t offset,
+                            apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
 svn_error_t *svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream,
                                      char *data, apr_size_t *len);
 
+/* Return a stream that wraps STREAM and compresses all data written to
+ * it and decompresses all data read from it.  PENDING_LEN bytes at
+ * PENDING_DATA have already been read from STREAM and will be the first
+ * data to decompress.  Allocate the result in RESULT_POOL.
+ */
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              const char *pending_data,
+                              apr_size_t pending_len,
+                              apr_pool_t *result_pool);
+
 /* Read the command word from CONN, return it in *COMMAND and skip to the
  * end of the command.  Allocate data in POOL.
  */
@@ -31,9 +31,11 @@
 #include "svn_error.h"
 #include "svn_pools.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 #include "svn_private_config.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_svn.h"
 
@@ -42,6 +44,11 @@ struct svn_ra_svn__stream_st {
   svn_stream_t *out_stream;
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* The socket that OUT_STREAM writes to unmodified.  NULL if the
+     stream is not socket-backed or if the data is being transformed
+     on the way out (e.g. encrypted). */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
@@ -167,6 +174,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *stream;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +185,11 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  stream = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                     b, sock_timeout_cb, result_pool);
+  stream->sock = sock;
+
+  return stream;
 }
 
 svn_ra_svn__stream_t *
@@ -193,6 +204,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   s->out_stream = out_stream;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
+  s->sock = NULL;
   return s;
 }
 
@@ -203,6 +215,86 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec,
+                          int nvec,
+                          apr_size_t *len)
+{
+  int i;
+
+  if (stream->sock)
+    {
+      apr_status_t status = apr_socket_sendv(stream->sock, vec, nvec, len);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+      return SVN_NO_ERROR;
+    }
+
+  /* Without a socket, there is no point in trying to combine the
+   * buffers.  Let the caller come back for the remainder. */
+  for (i = 0; i < nvec; ++i)
+    if (vec[i].iov_len)
+      {
+        *len = vec[i].iov_len;
+        return svn_error_trace(svn_stream_write(stream->out_stream,
+                                                vec[i].iov_base, len));
+      }
+
+  *len = 0;
+  return SVN_NO_ERROR;
+}
+
+void
+svn_ra_svn__stream_cork(svn_ra_svn__stream_t *stream,
+                        svn_boolean_t cork)
+{
+  /* This is merely an optimization.  Ignore failures. */
+  if (stream->sock)
+    apr_socket_opt_set(stream->sock, APR_TCP_NOPUSH, cork ? 1 : 0);
+}
+
+svn_boolean_t
+svn_ra_svn__stream_supports_sendfile(svn_ra_svn__stream_t *stream)
+{
+#if APR_HAS_SENDFILE
+  return stream->sock != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+svn_error_t *
+svn_ra_svn__stream_sendfile(svn_ra_svn__stream_t *stream,
+                            apr_file_t *file,
+                            apr_off_t offset,
+                            apr_size_t *len)
+{
+#if APR_HAS_SENDFILE
+  apr_status_t status;
+  apr_interval_time_t interval;
+  apr_hdtr_t hdtr = { 0 };
+
+  SVN_ERR_ASSERT(stream->sock);
+
+  status = apr_socket_timeout_get(stream->sock, &interval);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get socket timeout"));
+
+  /* Like sock_read_cb, always block.  We have nothing else to do but
+   * wait for the peer while the kernel moves the data. */
+  apr_socket_timeout_set(stream->sock, -1);
+  status = apr_socket_sendfile(stream->sock, file, &hdtr, &offset, len, 0);
+  apr_socket_timeout_set(stream->sock, interval);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to connection"));
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+#endif
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
@@ -230,3 +322,219 @@ svn_ra_svn__stream_data_available(svn_ra_svn__stream_t *stream,
           svn_stream_data_available(stream->in_stream,
                                     data_available));
 }
+
+/* Functions to implement a compressed svn_ra_svn__stream_t.
+ *
+ * The data is sent as a sequence of frames, each consisting of the
+ * encoded size of the frame body followed by the body, which is the
+ * output of svn__compress_lz4 for up to COMPRESSED_FRAME_SIZE bytes.
+ * Every write produces at least one complete frame, i.e. flushing the
+ * connection never leaves data behind in the compressor. */
+
+/* Maximum amount of uncompressed data per frame.  This is larger than
+ * the connection's write buffer, so a flush usually results in a single
+ * frame. */
+#define COMPRESSED_FRAME_SIZE 0x10000
+
+/* Upper limit for the size of a frame body. */
+#define COMPRESSED_FRAME_MAX_BODY \
+  (COMPRESSED_FRAME_SIZE + SVN__MAX_ENCODED_UINT_LEN)
+
+/* Baton for a compressed svn_ra_svn__stream_t. */
+typedef struct compressed_baton_t {
+  svn_ra_svn__stream_t *stream;  /* Inherited stream. */
+  svn_stringbuf_t *read_buf;     /* Received data not decompressed yet. */
+  svn_stringbuf_t *decompressed; /* Contents of the last frame read. */
+  apr_size_t decompressed_pos;   /* Part of DECOMPRESSED already read. */
+  svn_stringbuf_t *frame;        /* The frame currently being written. */
+  apr_size_t frame_pos;          /* Part of FRAME already written. */
+  apr_size_t frame_len;          /* Uncompressed size of FRAME. */
+  svn_stringbuf_t *scratch;      /* Temporary buffer for compression. */
+} compressed_baton_t;
+
+/* If the read buffer in B contains a complete frame, set *FOUND to TRUE
+ * and *BODY and *LEN to the frame body.  Otherwise, set *FOUND to FALSE. */
+static svn_error_t *
+find_frame(svn_boolean_t *found,
+           const unsigned char **body,
+           apr_size_t *len,
+           compressed_baton_t *b)
+{
+  const unsigned char *start = (const unsigned char *)b->read_buf->data;
+  const unsigned char *end = start + b->read_buf->len;
+  apr_uint64_t body_len;
+
+  *found = FALSE;
+  *body = svn__decode_uint(&body_len, start, end);
+  if (*body == NULL)
+    {
+      /* Only an incomplete header can be shorter than its maximum size. */
+      if (end - start >= SVN__MAX_ENCODED_UINT_LEN)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Invalid compressed frame header"));
+      return SVN_NO_ERROR;
+    }
+
+  if (body_len > COMPRESSED_FRAME_MAX_BODY)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Compressed frame too large"));
+
+  if ((apr_uint64_t)(end - *body) >= body_len)
+    {
+      *found = TRUE;
+      *len = (apr_size_t)body_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compressed_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+  apr_size_t available;
+
+  /* Decompress the next frame, reading more data as necessary. */
+  while (b->decompressed_pos == b->decompressed->len)
+    {
+      svn_boolean_t found;
+      const unsigned char *body;
+      apr_size_t body_len;
+
+      SVN_ERR(find_frame(&found, &body, &body_len, b));
+      if (found)
+        {
+          SVN_ERR(svn__decompress_lz4(body, body_len, b->decompressed,
+                                      COMPRESSED_FRAME_SIZE));
+          b->decompressed_pos = 0;
+          svn_stringbuf_remove(b->read_buf, 0,
+                               body + body_len
+                                 - (const unsigned char *)b->read_buf->data);
+        }
+      else
+        {
+          apr_size_t count = SVN__STREAM_CHUNK_SIZE;
+
+          svn_stringbuf_ensure(b->read_buf, b->read_buf->len + count);
+          SVN_ERR(svn_ra_svn__stream_read(b->stream,
+                                          b->read_buf->data
+                                            + b->read_buf->len,
+                                          &count));
+          b->read_buf->len += count;
+          b->read_buf->data[b->read_buf->len] = '\0';
+        }
+    }
+
+  /* Hand out as much of the decompressed data as the caller wants. */
+  available = b->decompressed->len - b->decompressed_pos;
+  if (*len > available)
+    *len = available;
+
+  memcpy(buffer, b->decompressed->data + b->decompressed_pos, *len);
+  b->decompressed_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compressed_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  /* Unless we still have to send the frame from the last call, which
+     will be made with the same arguments, create a new one. */
+  if (b->frame_pos == b->frame->len)
+    {
+      unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+      unsigned char *header_end;
+
+      b->frame_len = MIN(*len, COMPRESSED_FRAME_SIZE);
+      SVN_ERR(svn__compress_lz4(buffer, b->frame_len, b->scratch));
+
+      header_end = svn__encode_uint(header, b->scratch->len);
+      svn_stringbuf_setempty(b->frame);
+      svn_stringbuf_appendbytes(b->frame, (const char *)header,
+                                header_end - header);
+      svn_stringbuf_appendstr(b->frame, b->scratch);
+      b->frame_pos = 0;
+    }
+
+  do
+    {
+      apr_size_t count = b->frame->len - b->frame_pos;
+      SVN_ERR(svn_ra_svn__stream_write(b->stream,
+                                       b->frame->data + b->frame_pos,
+                                       &count));
+      if (count == 0)
+        {
+          /* The rest of the frame will be written during the next call
+             to this function. */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+      b->frame_pos += count;
+    }
+  while (b->frame_pos < b->frame->len);
+
+  *len = b->frame_len;
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compressed_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compressed_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compressed_data_available_cb(void *baton, svn_boolean_t *data_available)
+{
+  compressed_baton_t *b = baton;
+  const unsigned char *body;
+  apr_size_t body_len;
+
+  if (b->decompressed_pos < b->decompressed->len)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(find_frame(data_available, &body, &body_len, b));
+  if (*data_available)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              const char *pending_data,
+                              apr_size_t pending_len,
+                              apr_pool_t *result_pool)
+{
+  compressed_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *in_stream = svn_stream_create(b, result_pool);
+  svn_stream_t *out_stream = svn_stream_create(b, result_pool);
+
+  b->stream = stream;
+  b->read_buf = svn_stringbuf_ncreate(pending_data, pending_len,
+                                      result_pool);
+  b->decompressed = svn_stringbuf_create_empty(result_pool);
+  b->frame = svn_stringbuf_create_empty(result_pool);
+  b->scratch = svn_stringbuf_create_empty(result_pool);
+
+  svn_stream_set_read2(in_stream, compressed_read_cb,
+                       NULL /* use default */);
+  svn_stream_set_data_available(in_stream, compressed_data_available_cb);
+  svn_stream_set_write(out_stream, compressed_write_cb);
+
+  /* Note that the result does not support sendfile. */
+  return svn_ra_svn__stream_create(in_stream, out_stream, b,
+                                   compressed_timeout_cb, result_pool);
+}
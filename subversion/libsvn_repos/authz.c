@@ -967,30 +967,90 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* A state of the deterministic automaton that we use to follow paths
+ * through a filtered rule tree.  It stands for the set of tree nodes that
+ * apply to all paths leading to it, together with the access rights on
+ * these paths.
+ *
+ * Since path segments are not limited to any finite alphabet, the automaton
+ * gets constructed lazily:  The transition for a path segment is added when
+ * the first path containing that segment is looked up.  All later lookups
+ * following the same transition don't have to match the segment against
+ * any of the rules, i.e. their costs no longer depend on the number of
+ * wildcard rules.
+ */
+typedef struct dfa_state_t
+{
+  /* Rights immediately applying to the paths leading to this state and
+   * limits to the rights to any of their sub-paths. */
+  limited_rights_t rights;
+
+  /* Nodes applying to the paths leading to this state, sorted by address
+   * and without duplicates.  NODE_COUNT may be 0. */
+  node_t **nodes;
+  int node_count;
+
+  /* Transitions constructed so far.  Maps path segments (const char *) to
+   * the respective next state (dfa_state_t *). */
+  apr_hash_t *transitions;
+} dfa_state_t;
+
+/* Maximum number of transitions that we keep per automaton.  If exceeded,
+ * we start over with a new, empty automaton.  This limits memory usage
+ * for e.g. full tree walks over large repositories. */
+#define MAX_DFA_TRANSITIONS 0x4000
+
+/* The state of a lookup after following some parent path.  Keeping these
+ * allows the next lookup to resume at any common parent path. */
+typedef struct lookup_level_t
+{
+  /* Length of the parent path this level belongs to. */
+  apr_size_t path_len;
+
+  /* State of the automaton at that path. */
+  dfa_state_t *state;
+
+} lookup_level_t;
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
 {
-  /* Rights immediately applying to this node and limits to the rights to
-   * any sub-path. */
-  limited_rights_t rights;
+  /* Root of the filtered tree that the automaton has been built for. */
+  node_t *root;
+
+  /* The automaton.  All states, indexed by the keys constructed in
+   * intern_dfa_state(), and the number of transitions between them.
+   * Everything is allocated in DFA_POOL. */
+  apr_hash_t *dfa_states;
+  int dfa_transitions;
+  apr_pool_t *dfa_pool;
 
-  /* Nodes applying to the path followed so far. */
-  apr_array_header_t *current;
+  /* Start state of the automaton, i.e. the state for the repository root. */
+  dfa_state_t *start;
 
-  /* Temporary array containing the nodes applying to the next path
-   * segment (used to build up the next contents of CURRENT). */
+  /* State for the path followed so far. */
+  dfa_state_t *current;
+
+  /* Rights and nodes applying to the next path segment, used while
+   * constructing a transition from CURRENT. */
+  limited_rights_t rights;
   apr_array_header_t *next;
 
   /* Scratch pad for path operations. */
   svn_stringbuf_t *scratch_pad;
 
-  /* After each lookup iteration, CURRENT and PARENT_RIGHTS will
-   * apply to this path. */
+  /* Scratch pad for automaton state keys. */
+  svn_stringbuf_t *key;
+
+  /* After each lookup iteration, CURRENT will apply to this path. */
   svn_stringbuf_t *parent_path;
 
-  /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
-  limited_rights_t parent_rights;
+  /* Automaton states for PARENT_PATH and each of its parents, shallowest
+   * first (lookup_level_t).  Only the first DEPTH entries are valid,
+   * the others are being kept for reuse. */
+  apr_array_header_t *levels;
+  int depth;
 
 } lookup_state_t;
 
@@ -1000,8 +1060,9 @@ create_lookup_state(apr_pool_t *result_pool)
 {
   lookup_state_t *state = apr_pcalloc(result_pool, sizeof(*state));
  
+  state->dfa_pool = svn_pool_create(result_pool);
   state->next = apr_array_make(result_pool, 4, sizeof(node_t *));
-  state->current = apr_array_make(result_pool, 4, sizeof(node_t *));
+  state->levels = apr_array_make(result_pool, 8, sizeof(lookup_level_t));
 
   /* Virtually all path segments should fit into this buffer.  If they
    * don't, the buffer gets automatically reallocated.
@@ -1015,40 +1076,99 @@ create_lookup_state(apr_pool_t *result_pool)
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
 
+  /* Keys are a few rights values plus a few node pointers. */
+  state->key = svn_stringbuf_create_ensure(64, result_pool);
+
   return state;
 }
 
-/* Clear the current contents of STATE and re-initialize it for ROOT.
- * Check whether we can reuse a previous parent path lookup to shorten
- * the current PATH walk.  Return the full or remaining portion of
- * PATH, respectively.  PATH must not be NULL. */
-static const char *
-init_lockup_state(lookup_state_t *state,
-                  node_t *root,
-                  const char *path)
+/* Compare the node_t pointers in *LHS and *RHS by address. */
+static int
+compare_node_addresses(const void *lhs,
+                       const void *rhs)
 {
-  apr_size_t len = strlen(path);
-  if (   (len > state->parent_path->len)
-      && state->parent_path->len
-      && (path[state->parent_path->len] == '/')
-      && !memcmp(path, state->parent_path->data, state->parent_path->len))
-    {
-      /* The PARENT_PATH of the previous lookup is actually a parent path
-       * of PATH.  The CURRENT node list already matches the parent path
-       * and we only have to set the correct rights info. */
-      state->rights = state->parent_rights;
+  apr_uintptr_t lhs_address = (apr_uintptr_t)*(node_t * const *)lhs;
+  apr_uintptr_t rhs_address = (apr_uintptr_t)*(node_t * const *)rhs;
+
+  if (lhs_address < rhs_address)
+    return -1;
 
-      /* Tell the caller where to proceed. */
-      return path + state->parent_path->len;
+  return lhs_address > rhs_address ? 1 : 0;
+}
+
+/* Return the automaton state in STATE for the NEXT nodes and RIGHTS in
+ * STATE.  Add a new state if necessary.  This modifies NEXT. */
+static dfa_state_t *
+intern_dfa_state(lookup_state_t *state)
+{
+  apr_array_header_t *nodes = state->next;
+  const limited_rights_t *rights = &state->rights;
+  svn_stringbuf_t *key = state->key;
+  dfa_state_t *result;
+  int i, count;
+
+  /* Different routes through the rule tree may lead to the same node.
+   * Normalize the node list. */
+  svn_sort__array(nodes, compare_node_addresses);
+  for (i = 0, count = 0; i < nodes->nelts; ++i)
+    {
+      node_t *node = APR_ARRAY_IDX(nodes, i, node_t *);
+      if (count == 0 || APR_ARRAY_IDX(nodes, count - 1, node_t *) != node)
+        APR_ARRAY_IDX(nodes, count++, node_t *) = node;
+    }
+  nodes->nelts = count;
+
+  /* Lookups continue the same way for states with the same nodes and
+   * rights.  Hence, they are the same state. */
+  svn_stringbuf_setempty(key);
+  svn_stringbuf_appendbytes(key,
+                            (const char *)&rights->access.sequence_number,
+                            sizeof(rights->access.sequence_number));
+  svn_stringbuf_appendbytes(key, (const char *)&rights->access.rights,
+                            sizeof(rights->access.rights));
+  svn_stringbuf_appendbytes(key, (const char *)&rights->min_rights,
+                            sizeof(rights->min_rights));
+  svn_stringbuf_appendbytes(key, (const char *)&rights->max_rights,
+                            sizeof(rights->max_rights));
+  svn_stringbuf_appendbytes(key, nodes->elts, nodes->nelts * nodes->elt_size);
+
+  result = apr_hash_get(state->dfa_states, key->data, key->len);
+  if (!result)
+    {
+      result = apr_pcalloc(state->dfa_pool, sizeof(*result));
+      result->rights = *rights;
+      result->node_count = nodes->nelts;
+      result->nodes = apr_pmemdup(state->dfa_pool, nodes->elts,
+                                  nodes->nelts * nodes->elt_size);
+      result->transitions = svn_hash__make(state->dfa_pool);
+
+      apr_hash_set(state->dfa_states,
+                   apr_pmemdup(state->dfa_pool, key->data, key->len),
+                   key->len, result);
     }
 
-  /* Start lookup at ROOT for the full PATH. */
+  return result;
+}
+
+/* Drop the automaton in STATE and start a new one for the tree at ROOT. */
+static void
+reset_dfa(lookup_state_t *state,
+          node_t *root)
+{
+  svn_pool_clear(state->dfa_pool);
+  state->dfa_states = svn_hash__make(state->dfa_pool);
+  state->dfa_transitions = 0;
+  state->root = root;
+
+  /* Nothing may refer to the old states anymore. */
+  state->depth = 0;
+  svn_stringbuf_setempty(state->parent_path);
+
+  /* The start state represents ROOT. */
   state->rights = root->rights;
-  state->parent_rights = root->rights;
 
   apr_array_clear(state->next);
-  apr_array_clear(state->current);
-  APR_ARRAY_PUSH(state->current, node_t *) = root;
+  APR_ARRAY_PUSH(state->next, node_t *) = root;
 
   /* Var-segment rules match empty segments as well */
   if (root->pattern_sub_nodes && root->pattern_sub_nodes->any_var)
@@ -1058,9 +1178,77 @@ init_lockup_state(lookup_state_t *state,
       /* This is non-recursive due to ACL normalization. */
       combine_access(&state->rights, &node->rights);
       combine_right_limits(&state->rights, &node->rights);
-      APR_ARRAY_PUSH(state->current, node_t *) = node;
+      APR_ARRAY_PUSH(state->next, node_t *) = node;
    }
 
+  state->start = intern_dfa_state(state);
+  state->current = state->start;
+}
+
+/* Record the CURRENT automaton state in STATE as the one for its
+ * PARENT_PATH. */
+static void
+push_lookup_level(lookup_state_t *state)
+{
+  lookup_level_t *level;
+
+  if (state->depth < state->levels->nelts)
+    level = &APR_ARRAY_IDX(state->levels, state->depth, lookup_level_t);
+  else
+    level = apr_array_push(state->levels);
+
+  level->path_len = state->parent_path->len;
+  level->state = state->current;
+
+  ++state->depth;
+}
+
+/* Re-initialize STATE for a lookup in the tree at ROOT.
+ * Check whether we can reuse a previous parent path lookup to shorten
+ * the current PATH walk.  Return the full or remaining portion of
+ * PATH, respectively.  PATH must not be NULL. */
+static const char *
+init_lockup_state(lookup_state_t *state,
+                  node_t *root,
+                  const char *path)
+{
+  apr_size_t len = strlen(path);
+  int i;
+
+  /* Start a new automaton if the current one is for a different tree
+   * or has grown too large. */
+  if (state->root != root || state->dfa_transitions > MAX_DFA_TRANSITIONS)
+    reset_dfa(state, root);
+
+  /* Find the deepest parent path of the previous lookup that is also
+   * a parent path of PATH.  Most of the time, this will be PARENT_PATH
+   * itself, i.e. we look up a sibling of the previous path.  During
+   * depth-first tree walks, we often return to some further up parent. */
+  for (i = state->depth; i > 0; --i)
+    {
+      lookup_level_t *level = &APR_ARRAY_IDX(state->levels, i - 1,
+                                             lookup_level_t);
+      if (   (len > level->path_len)
+          && (path[level->path_len] == '/')
+          && !memcmp(path, state->parent_path->data, level->path_len))
+        {
+          if (i < state->depth)
+            {
+              state->depth = i;
+              svn_stringbuf_chop(state->parent_path,
+                                 state->parent_path->len - level->path_len);
+            }
+
+          state->current = level->state;
+
+          /* Tell the caller where to proceed. */
+          return path + level->path_len;
+        }
+    }
+
+  /* Start lookup at ROOT for the full PATH. */
+  state->current = state->start;
+  state->depth = 0;
   svn_stringbuf_setempty(state->parent_path);
   svn_stringbuf_setempty(state->scratch_pad);
 
@@ -1222,6 +1410,96 @@ next_segment(svn_stringbuf_t *segment,
   return NULL;
 }
 
+/* Return the automaton state that CURRENT in STATE transitions to for
+ * SEGMENT.  If that transition has not been constructed yet, match SEGMENT
+ * against the rules of all nodes in CURRENT and add it.  The contents of
+ * SEGMENT may get modified. */
+static dfa_state_t *
+next_dfa_state(lookup_state_t *state,
+               svn_stringbuf_t *segment)
+{
+  dfa_state_t *current = state->current;
+  dfa_state_t *next;
+  const char *key;
+  int i;
+
+  /* Most of the time, we have seen SEGMENT in this state before. */
+  next = apr_hash_get(current->transitions, segment->data, segment->len);
+  if (next)
+    return next;
+
+  /* Pattern matching below may destroy SEGMENT. */
+  key = apr_pstrmemdup(state->dfa_pool, segment->data, segment->len);
+
+  /* Initial state for this segment. */
+  apr_array_clear(state->next);
+  state->rights.access.sequence_number = NO_SEQUENCE_NUMBER;
+  state->rights.access.rights = authz_access_none;
+
+  /* These init values ensure that the first node's value will be used
+   * when combined with them.  If there is no first node,
+   * state->access.sequence_number remains unchanged and we will use
+   * the parent's (i.e. inherited) access rights. */
+  state->rights.min_rights = authz_access_write;
+  state->rights.max_rights = authz_access_none;
+
+  /* Scan follow all alternative routes to the next level. */
+  for (i = 0; i < current->node_count; ++i)
+    {
+      node_t *node = current->nodes[i];
+      if (node->sub_nodes)
+        add_next_node(state, apr_hash_get(node->sub_nodes, segment->data,
+                                          segment->len));
+
+      /* Process alternative, wildcard-based sub-nodes. */
+      if (node->pattern_sub_nodes)
+        {
+          add_next_node(state, node->pattern_sub_nodes->any);
+
+          /* If the current node represents a "**" pattern, it matches
+           * to all levels. So, add it to the list for the NEXT level. */
+          if (node->pattern_sub_nodes->repeat)
+            add_next_node(state, node);
+
+          /* Find all prefix pattern matches. */
+          if (node->pattern_sub_nodes->prefixes)
+            add_prefix_matches(state, segment,
+                               node->pattern_sub_nodes->prefixes);
+
+          if (node->pattern_sub_nodes->complex)
+            add_complex_matches(state, segment,
+                                node->pattern_sub_nodes->complex);
+
+          /* Find all suffux pattern matches.
+           * This must be the last check as it destroys SEGMENT. */
+          if (node->pattern_sub_nodes->suffixes)
+            {
+              /* Suffixes behave like reversed prefixes. */
+              svn_authz__reverse_string(segment->data, segment->len);
+              add_prefix_matches(state, segment,
+                                 node->pattern_sub_nodes->suffixes);
+            }
+        }
+    }
+
+  /* If no rule applied to this SEGMENT directly, the parent rights
+   * will apply to at least the SEGMENT node itself and possibly
+   * other parts deeper in it's subtree. */
+  if (!has_local_rule(&state->rights))
+    {
+      state->rights.access = current->rights.access;
+      state->rights.min_rights &= current->rights.access.rights;
+      state->rights.max_rights |= current->rights.access.rights;
+    }
+
+  /* Remember the transition. */
+  next = intern_dfa_state(state);
+  apr_hash_set(current->transitions, key, segment->len, next);
+  ++state->dfa_transitions;
+
+  return next;
+}
+
 /* Starting at the respective user's authz root node provided with STATE,
  * follow PATH and return TRUE, iff the REQUIRED access has been granted to
  * that user for this PATH.  REQUIRED must not contain svn_authz_recursive.
@@ -1257,38 +1535,27 @@ lookup(lookup_state_t *state,
 
   /* Actually walk the path rule tree following PATH until we run out of
    * either tree or PATH. */
-  while (state->current->nelts && path)
+  while (state->current->node_count && path)
     {
-      apr_array_header_t *temp;
-      int i;
+      const limited_rights_t *rights = &state->current->rights;
       svn_stringbuf_t *segment = state->scratch_pad;
 
       /* Shortcut 1: We could nowhere find enough rights in this sub-tree. */
-      if ((state->rights.max_rights & required) != required)
+      if ((rights->max_rights & required) != required)
         return FALSE;
 
       /* Shortcut 2: We will find enough rights everywhere in this sub-tree. */
-      if ((state->rights.min_rights & required) == required)
+      if ((rights->min_rights & required) == required)
         return TRUE;
 
       /* Extract the next segment. */
       path = next_segment(segment, path);
 
-      /* Initial state for this segment. */
-      apr_array_clear(state->next);
-      state->rights.access.sequence_number = NO_SEQUENCE_NUMBER;
-      state->rights.access.rights = authz_access_none;
-
-      /* These init values ensure that the first node's value will be used
-       * when combined with them.  If there is no first node,
-       * state->access.sequence_number remains unchanged and we will use
-       * the parent's (i.e. inherited) access rights. */
-      state->rights.min_rights = authz_access_write;
-      state->rights.max_rights = authz_access_none;
-
-      /* Update the PARENT_PATH member in STATE to match the nodes in
-       * CURRENT at the end of this iteration, i.e. if and when NEXT
-       * has become CURRENT. */
+      /* Update the PARENT_PATH member in STATE to match CURRENT at the end
+       * of this iteration, unless this is the end of the path.  We keep
+       * the parent path and state such that sibling lookups will benefit
+       * from it.  This must happen before next_dfa_state() which may
+       * destroy SEGMENT. */
       if (path)
         {
           svn_stringbuf_appendbyte(state->parent_path, '/');
@@ -1296,70 +1563,10 @@ lookup(lookup_state_t *state,
                                     segment->len);
         }
 
-      /* Scan follow all alternative routes to the next level. */
-      for (i = 0; i < state->current->nelts; ++i)
-        {
-          node_t *node = APR_ARRAY_IDX(state->current, i, node_t *);
-          if (node->sub_nodes)
-            add_next_node(state, apr_hash_get(node->sub_nodes, segment->data,
-                                              segment->len));
-
-          /* Process alternative, wildcard-based sub-nodes. */
-          if (node->pattern_sub_nodes)
-            {
-              add_next_node(state, node->pattern_sub_nodes->any);
-
-              /* If the current node represents a "**" pattern, it matches
-               * to all levels. So, add it to the list for the NEXT level. */
-              if (node->pattern_sub_nodes->repeat)
-                add_next_node(state, node);
-
-              /* Find all prefix pattern matches. */
-              if (node->pattern_sub_nodes->prefixes)
-                add_prefix_matches(state, segment,
-                                   node->pattern_sub_nodes->prefixes);
-
-              if (node->pattern_sub_nodes->complex)
-                add_complex_matches(state, segment,
-                                    node->pattern_sub_nodes->complex);
-
-              /* Find all suffux pattern matches.
-               * This must be the last check as it destroys SEGMENT. */
-              if (node->pattern_sub_nodes->suffixes)
-                {
-                  /* Suffixes behave like reversed prefixes. */
-                  svn_authz__reverse_string(segment->data, segment->len);
-                  add_prefix_matches(state, segment,
-                                     node->pattern_sub_nodes->suffixes);
-                }
-            }
-        }
-
-      /* If no rule applied to this SEGMENT directly, the parent rights
-       * will apply to at least the SEGMENT node itself and possibly
-       * other parts deeper in it's subtree. */
-      if (!has_local_rule(&state->rights))
-        {
-          state->rights.access = state->parent_rights.access;
-          state->rights.min_rights &= state->parent_rights.access.rights;
-          state->rights.max_rights |= state->parent_rights.access.rights;
-        }
-
-      /* The list of nodes for SEGMENT is now complete.  If we need to
-       * continue, make it the current and put the old one into the recycler.
-       *
-       * If this is the end of the path, keep the parent path and rights in
-       * STATE as are such that sibling lookups will benefit from it.
-       */
+      /* Follow SEGMENT. */
+      state->current = next_dfa_state(state, segment);
       if (path)
-        {
-          temp = state->current;
-          state->current = state->next;
-          state->next = temp;
-
-          /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
-          state->parent_rights = state->rights;
-        }
+        push_lookup_level(state);
     }
 
   /* If we check recursively, none of the (potential) sub-paths must have
@@ -1367,16 +1574,41 @@ lookup(lookup_state_t *state,
    * verify that the respective paths actually exist in the repository.
    */
   if (recursive)
-    return (state->rights.min_rights & required) == required;
+    return (state->current->rights.min_rights & required) == required;
 
   /* Return whether the access rights on PATH fully include REQUIRED. */
-  return (state->rights.access.rights & required) == required;
+  return (state->current->rights.access.rights & required) == required;
 }
 
-
+
 
 /*** The authz data structure. ***/
 
+/* Maximum number of paths for which we remember access decisions per
+ * authz_user_rules_t.  When exceeded, we start over with an empty cache. */
+#define DECISION_CACHE_SIZE 4096
+
+/* The access decisions already made for a given path.  Bit N in GRANTED
+ * is only valid if bit N in KNOWN is set, with N as per decision_bit(). */
+typedef struct authz_decision_t
+{
+  unsigned char known;
+  unsigned char granted;
+} authz_decision_t;
+
+/* Return the bit that represents the access check for REQUIRED and
+ * RECURSIVE in authz_decision_t. */
+static unsigned char
+decision_bit(authz_access_t required,
+             svn_boolean_t recursive)
+{
+  int index = ((required & authz_access_read_flag) ? 1 : 0)
+            | ((required & authz_access_write_flag) ? 2 : 0)
+            | (recursive ? 4 : 0);
+
+  return (unsigned char)(1 << index);
+}
+
 /* An entry in svn_authz_t's USER_RULES cache.  All members must be
  * allocated in the POOL and the latter has to be cleared / destroyed
  * before overwriting the entries' contents.
@@ -1401,6 +1633,11 @@ struct authz_user_rules_t
   /* Reusable lookup state instance. */
   lookup_state_t *lookup_state;
 
+  /* Access decisions made for individual paths in the filtered tree
+   * (const char * -> authz_decision_t *), allocated in DECISION_POOL. */
+  apr_hash_t *decisions;
+  apr_pool_t *decision_pool;
+
   /* Pool from which all data within this struct got allocated.
    * Can be destroyed or cleaned up with no further side-effects. */
   apr_pool_t *pool;
@@ -1460,6 +1697,8 @@ get_user_rules(svn_authz_t *authz,
   authz->filtered->user = user ? apr_pstrdup(pool, user) : NULL;
   authz->filtered->lookup_state = create_lookup_state(pool);
   authz->filtered->root = NULL;
+  authz->filtered->decision_pool = svn_pool_create(pool);
+  authz->filtered->decisions = svn_hash__make(authz->filtered->decision_pool);
 
   svn_authz__get_global_rights(&authz->filtered->global_rights,
                                authz->full, user, repos_name);
@@ -1665,6 +1904,12 @@ svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+const svn_membuf_t *
+svn_repos__authz_get_id(const svn_authz_t *authz)
+{
+  return authz->authz_id;
+}
+
 svn_error_t *
 svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              const char *path, const char *user,
@@ -1675,6 +1920,11 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
   const authz_access_t required =
     ((required_access & svn_authz_read ? authz_access_read_flag : 0)
      | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  svn_boolean_t recursive;
+  unsigned char bit;
+  apr_size_t path_len;
+  authz_decision_t *decision;
+  const char *remainder;
 
   /* Pick or create the suitable pre-filtered path rule tree. */
   authz_user_rules_t *rules = get_user_rules(
@@ -1707,6 +1957,18 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
       return SVN_NO_ERROR;
     }
 
+  /* Have we been asked the same question before? */
+  recursive = !!(required_access & svn_authz_recursive);
+  bit = decision_bit(required, recursive);
+  path_len = strlen(path);
+
+  decision = apr_hash_get(rules->decisions, path, path_len);
+  if (decision && (decision->known & bit))
+    {
+      *access_granted = (decision->granted & bit) != 0;
+      return SVN_NO_ERROR;
+    }
+
   /* Rules tree lookup */
 
   /* Did we already filter the data model? */
@@ -1714,16 +1976,35 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
     SVN_ERR(filter_tree(authz, pool));
 
   /* Re-use previous lookup results, if possible. */
-  path = init_lockup_state(authz->filtered->lookup_state,
-                           authz->filtered->root, path);
+  remainder = init_lockup_state(authz->filtered->lookup_state,
+                                authz->filtered->root, path);
 
   /* Sanity check. */
-  SVN_ERR_ASSERT(path[0] == '/');
+  SVN_ERR_ASSERT(remainder[0] == '/');
 
   /* Determine the granted access for the requested path.
    * PATH does not need to be normalized for lockup(). */
-  *access_granted = lookup(rules->lookup_state, path, required,
-                           !!(required_access & svn_authz_recursive), pool);
+  *access_granted = lookup(rules->lookup_state, remainder, required,
+                           recursive, pool);
+
+  /* Remember the decision. */
+  if (!decision)
+    {
+      if (apr_hash_count(rules->decisions) >= DECISION_CACHE_SIZE)
+        {
+          svn_pool_clear(rules->decision_pool);
+          rules->decisions = svn_hash__make(rules->decision_pool);
+        }
+
+      decision = apr_pcalloc(rules->decision_pool, sizeof(*decision));
+      apr_hash_set(rules->decisions,
+                   apr_pstrmemdup(rules->decision_pool, path, path_len),
+                   path_len, decision);
+    }
+
+  decision->known |= bit;
+  if (*access_granted)
+    decision->granted |= bit;
 
   return SVN_NO_ERROR;
 }
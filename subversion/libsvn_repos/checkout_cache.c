@@ -0,0 +1,1251 @@
+/* checkout_cache.c : recording and replaying checkout editor drives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_checksum.h"
+#include "svn_delta.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+
+#include "repos.h"
+
+/* Theory of operation: the cache is a directory with one file per
+   recorded editor drive.  The file name is the SHA1 of the entry's key,
+   and the file's modification time gets bumped upon every use.  When
+   the directory grows beyond its size limit, the least recently used
+   entries get removed.
+
+   New entries are written to temporary files in the same directory and
+   only get renamed into place once the editor drive has been completed
+   successfully.  Hence, readers never see partial entries and multiple
+   processes may share the same cache directory.
+
+   Entry file format: a header line, followed by the key and a sequence
+   of editor operations.  The latter mimic the way the reporter drives
+   its editor: directories are strictly nested and there is at most one
+   open file, so the batons are implicit.  Each operation is a single
+   command character followed by its arguments, encoded as in the
+   reporter's spill-buffer ("+/-" indicates the single character '+' or
+   '-'):
+
+     String:   +<length>:<bytes>  or  -  for NULL
+     Revision: +<revnum>:         or  -  for SVN_INVALID_REVNUM
+
+     R <rev>                          set_target_revision
+     O <rev>                          open_root
+     D <path> <rev>                   delete_entry
+     A <path> <copyfrom> <rev>        add_directory
+     o <path> <rev>                   open_directory
+     P <name> <value>                 change_dir_prop
+     C                                close_directory
+     X <path>                         absent_directory
+     a <path> <copyfrom> <rev>        add_file
+     f <path> <rev>                   open_file
+     p <name> <value>                 change_file_prop
+     d <base checksum>                apply_textdelta
+     c <svndiff data>                 a chunk of the text delta
+     e                                end of the text delta
+     F <text checksum>                close_file
+     x <path>                         absent_file
+     E                                close_edit
+ */
+
+/* First line of every cache entry file. */
+#define CACHE_ENTRY_HEADER "SVN checkout cache 1\n"
+
+/* File name suffix of entries being written. */
+#define TEMP_FILE_SUFFIX ".tmp"
+
+/* Temporary files older than this have been left behind by crashed
+   writers and may be removed. */
+#define STALE_TEMP_FILE_AGE apr_time_from_sec(24 * 60 * 60)
+
+struct svn_repos__checkout_cache_t
+{
+  /* Directory containing the cache entries. */
+  const char *path;
+
+  /* Size limit for the directory contents in bytes. */
+  apr_uint64_t max_size;
+
+  /* Serializes the clean-ups within this process. */
+  svn_mutex__t *mutex;
+};
+
+svn_error_t *
+svn_repos__checkout_cache_create(svn_repos__checkout_cache_t **cache,
+                                 const char *path,
+                                 apr_uint64_t max_size,
+                                 apr_pool_t *result_pool)
+{
+  svn_repos__checkout_cache_t *result
+    = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->path = apr_pstrdup(result_pool, path);
+  result->max_size = max_size;
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+  SVN_ERR(svn_io_make_dir_recursively(result->path, result_pool));
+
+  *cache = result;
+  return SVN_NO_ERROR;
+}
+
+/* Return the path of the entry for KEY in CACHE, allocated in
+   RESULT_POOL. */
+static const char *
+entry_path(svn_repos__checkout_cache_t *cache,
+           const char *key,
+           apr_pool_t *result_pool)
+{
+  svn_checksum_t *checksum;
+
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1, key,
+                               strlen(key), result_pool));
+  return svn_dirent_join(cache->path,
+                         svn_checksum_to_cstring(checksum, result_pool),
+                         result_pool);
+}
+
+/* Sort svn_sort__item_t of svn_io_dirent2_t by ascending mtime. */
+static int
+compare_mtime(const svn_sort__item_t *a,
+              const svn_sort__item_t *b)
+{
+  const svn_io_dirent2_t *lhs = a->value;
+  const svn_io_dirent2_t *rhs = b->value;
+
+  if (lhs->mtime == rhs->mtime)
+    return 0;
+
+  return lhs->mtime < rhs->mtime ? -1 : 1;
+}
+
+/* Remove the least recently used entries from CACHE until it fits its
+   size limit again.  Also remove stale temporary files.  Other processes
+   may clean up the same directory concurrently.  Use SCRATCH_POOL for
+   temporary allocations.  CACHE's mutex must be held. */
+static svn_error_t *
+remove_old_entries(svn_repos__checkout_cache_t *cache,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_uint64_t total_size = 0;
+  apr_time_t now = apr_time_now();
+  apr_size_t suffix_len = strlen(TEMP_FILE_SUFFIX);
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, cache->path, FALSE, scratch_pool,
+                              scratch_pool));
+  sorted = svn_sort__hash(dirents, compare_mtime, scratch_pool);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+      const char *name = item->key;
+
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      svn_pool_clear(iterpool);
+      if (strlen(name) > suffix_len
+          && strcmp(name + strlen(name) - suffix_len, TEMP_FILE_SUFFIX) == 0
+          && dirent->mtime + STALE_TEMP_FILE_AGE < now)
+        svn_error_clear(svn_io_remove_file2(
+                          svn_dirent_join(cache->path, name, iterpool),
+                          TRUE, iterpool));
+      else
+        total_size += dirent->filesize;
+    }
+
+  /* Drop the oldest entries first.  Entries names are plain SHA1 sums,
+     so anything with a dot in it is a temporary file in use. */
+  for (i = 0; i < sorted->nelts && total_size > cache->max_size; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+      const char *name = item->key;
+
+      if (dirent->kind != svn_node_file
+          || strchr(name, '.') != NULL)
+        continue;
+
+      svn_pool_clear(iterpool);
+      svn_error_clear(svn_io_remove_file2(
+                        svn_dirent_join(cache->path, name, iterpool),
+                        TRUE, iterpool));
+      total_size -= dirent->filesize;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* --- RECORDING AN EDITOR DRIVE --- */
+
+/* Append STR of length LEN, which may be NULL, to RECORD. */
+static void
+append_string(svn_stringbuf_t *record,
+              const char *str,
+              apr_size_t len)
+{
+  if (str)
+    {
+      char buf[SVN_INT64_BUFFER_SIZE];
+
+      svn_stringbuf_appendbyte(record, '+');
+      svn_stringbuf_appendbytes(record, buf, svn__ui64toa(buf, len));
+      svn_stringbuf_appendbyte(record, ':');
+      svn_stringbuf_appendbytes(record, str, len);
+    }
+  else
+    svn_stringbuf_appendbyte(record, '-');
+}
+
+/* Append the C string STR, which may be NULL, to RECORD. */
+static void
+append_cstring(svn_stringbuf_t *record,
+               const char *str)
+{
+  append_string(record, str, str ? strlen(str) : 0);
+}
+
+/* Append REVISION to RECORD. */
+static void
+append_rev(svn_stringbuf_t *record,
+           svn_revnum_t revision)
+{
+  if (SVN_IS_VALID_REVNUM(revision))
+    {
+      char buf[SVN_INT64_BUFFER_SIZE];
+
+      svn_stringbuf_appendbyte(record, '+');
+      svn_stringbuf_appendbytes(record, buf, svn__i64toa(buf, revision));
+      svn_stringbuf_appendbyte(record, ':');
+    }
+  else
+    svn_stringbuf_appendbyte(record, '-');
+}
+
+/* Baton for the recording editor. */
+typedef struct record_edit_baton_t
+{
+  /* The editor to forward all calls to. */
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_edit_baton;
+
+  /* The cache to add the new entry to, and the entry's final path. */
+  svn_repos__checkout_cache_t *cache;
+  const char *entry_path;
+
+  /* The temporary file being written and its path.  FILE is NULL once
+     the recording has been given up. */
+  apr_file_t *file;
+  const char *temp_path;
+} record_edit_baton_t;
+
+/* Baton for directories and files in the recording editor. */
+typedef struct record_baton_t
+{
+  record_edit_baton_t *eb;
+  void *wrapped_baton;
+} record_baton_t;
+
+/* Stop recording in EB, discarding the partial entry. */
+static void
+abandon_recording(record_edit_baton_t *eb,
+                  apr_pool_t *scratch_pool)
+{
+  if (eb->file)
+    {
+      svn_error_clear(svn_io_file_close(eb->file, scratch_pool));
+      svn_error_clear(svn_io_remove_file2(eb->temp_path, TRUE,
+                                          scratch_pool));
+      eb->file = NULL;
+    }
+}
+
+/* Write RECORD to EB's temporary file.  Failing to do so is not an error
+   for the editor drive; we simply give up on the recording then. */
+static void
+write_record(record_edit_baton_t *eb,
+             const svn_stringbuf_t *record,
+             apr_pool_t *scratch_pool)
+{
+  if (eb->file)
+    {
+      svn_error_t *err = svn_io_file_write_full(eb->file, record->data,
+                                                record->len, NULL,
+                                                scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          abandon_recording(eb, scratch_pool);
+        }
+    }
+}
+
+/* Return a new baton for the child object WRAPPED_BATON in EB. */
+static record_baton_t *
+make_baton(record_edit_baton_t *eb,
+           void *wrapped_baton,
+           apr_pool_t *result_pool)
+{
+  record_baton_t *baton = apr_palloc(result_pool, sizeof(*baton));
+  baton->eb = eb;
+  baton->wrapped_baton = wrapped_baton;
+
+  return baton;
+}
+
+/* Record and forward a path / copyfrom / revision operation. */
+static void
+record_path_op(record_edit_baton_t *eb,
+               char command,
+               const char *path,
+               svn_boolean_t has_copyfrom,
+               const char *copyfrom_path,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *record;
+
+  if (!eb->file)
+    return;
+
+  record = svn_stringbuf_create_ensure(64, scratch_pool);
+  svn_stringbuf_appendbyte(record, command);
+  append_cstring(record, path);
+  if (has_copyfrom)
+    append_cstring(record, copyfrom_path);
+  append_rev(record, revision);
+  write_record(eb, record, scratch_pool);
+}
+
+/* Record a property change or a checksum argument for COMMAND. */
+static void
+record_value_op(record_edit_baton_t *eb,
+                char command,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *record;
+
+  if (!eb->file)
+    return;
+
+  record = svn_stringbuf_create_ensure(64, scratch_pool);
+  svn_stringbuf_appendbyte(record, command);
+  if (name)
+    append_cstring(record, name);
+  append_string(record, value ? value->data : NULL, value ? value->len : 0);
+  write_record(eb, record, scratch_pool);
+}
+
+/* Record COMMAND that has no arguments. */
+static void
+record_command(record_edit_baton_t *eb,
+               char command,
+               apr_pool_t *scratch_pool)
+{
+  if (eb->file)
+    write_record(eb, svn_stringbuf_ncreate(&command, 1, scratch_pool),
+                 scratch_pool);
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *scratch_pool)
+{
+  record_edit_baton_t *eb = edit_baton;
+
+  SVN_ERR(eb->wrapped_editor->set_target_revision(eb->wrapped_edit_baton,
+                                                  target_revision,
+                                                  scratch_pool));
+  record_path_op(eb, 'R', NULL, FALSE, NULL, target_revision, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *result_pool,
+                 void **root_baton)
+{
+  record_edit_baton_t *eb = edit_baton;
+  void *wrapped_baton;
+
+  SVN_ERR(eb->wrapped_editor->open_root(eb->wrapped_edit_baton,
+                                        base_revision, result_pool,
+                                        &wrapped_baton));
+  record_path_op(eb, 'O', NULL, FALSE, NULL, base_revision, result_pool);
+
+  *root_baton = make_baton(eb, wrapped_baton, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *scratch_pool)
+{
+  record_baton_t *pb = parent_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->delete_entry(path, revision,
+                                               pb->wrapped_baton,
+                                               scratch_pool));
+  record_path_op(pb->eb, 'D', path, FALSE, NULL, revision, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *result_pool,
+                     void **child_baton)
+{
+  record_baton_t *pb = parent_baton;
+  void *wrapped_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->add_directory(path, pb->wrapped_baton,
+                                                copyfrom_path,
+                                                copyfrom_revision,
+                                                result_pool,
+                                                &wrapped_baton));
+  record_path_op(pb->eb, 'A', path, TRUE, copyfrom_path, copyfrom_revision,
+                 result_pool);
+
+  *child_baton = make_baton(pb->eb, wrapped_baton, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *result_pool,
+                      void **child_baton)
+{
+  record_baton_t *pb = parent_baton;
+  void *wrapped_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->open_directory(path, pb->wrapped_baton,
+                                                 base_revision, result_pool,
+                                                 &wrapped_baton));
+  record_path_op(pb->eb, 'o', path, FALSE, NULL, base_revision,
+                 result_pool);
+
+  *child_baton = make_baton(pb->eb, wrapped_baton, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *scratch_pool)
+{
+  record_baton_t *db = dir_baton;
+
+  SVN_ERR(db->eb->wrapped_editor->change_dir_prop(db->wrapped_baton, name,
+                                                  value, scratch_pool));
+  record_value_op(db->eb, 'P', name, value, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *scratch_pool)
+{
+  record_baton_t *db = dir_baton;
+
+  SVN_ERR(db->eb->wrapped_editor->close_directory(db->wrapped_baton,
+                                                  scratch_pool));
+  record_command(db->eb, 'C', scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *scratch_pool)
+{
+  record_baton_t *pb = parent_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->absent_directory(path, pb->wrapped_baton,
+                                                   scratch_pool));
+  record_value_op(pb->eb, 'X', NULL, svn_string_create(path, scratch_pool),
+                  scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *result_pool,
+                void **file_baton)
+{
+  record_baton_t *pb = parent_baton;
+  void *wrapped_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->add_file(path, pb->wrapped_baton,
+                                           copyfrom_path, copyfrom_revision,
+                                           result_pool, &wrapped_baton));
+  record_path_op(pb->eb, 'a', path, TRUE, copyfrom_path, copyfrom_revision,
+                 result_pool);
+
+  *file_baton = make_baton(pb->eb, wrapped_baton, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *result_pool,
+                 void **file_baton)
+{
+  record_baton_t *pb = parent_baton;
+  void *wrapped_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->open_file(path, pb->wrapped_baton,
+                                            base_revision, result_pool,
+                                            &wrapped_baton));
+  record_path_op(pb->eb, 'f', path, FALSE, NULL, base_revision,
+                 result_pool);
+
+  *file_baton = make_baton(pb->eb, wrapped_baton, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the window handler returned by record_apply_textdelta. */
+typedef struct record_window_baton_t
+{
+  record_edit_baton_t *eb;
+
+  /* The wrapped editor's window handler. */
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  /* Writes the windows as svndiff to record_chunk. */
+  svn_txdelta_window_handler_t svndiff_handler;
+  void *svndiff_baton;
+
+  apr_pool_t *pool;
+} record_window_baton_t;
+
+/* Implements svn_write_fn_t, recording the svndiff data in *BATON,
+   a record_window_baton_t, as a text delta chunk. */
+static svn_error_t *
+record_chunk(void *baton,
+             const char *data,
+             apr_size_t *len)
+{
+  record_window_baton_t *wb = baton;
+  svn_stringbuf_t *record = svn_stringbuf_create_ensure(*len + 32, wb->pool);
+
+  svn_stringbuf_appendbyte(record, 'c');
+  append_string(record, data, *len);
+  write_record(wb->eb, record, wb->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t, recording the end of the text delta in
+   *BATON, a record_window_baton_t. */
+static svn_error_t *
+record_delta_end(void *baton)
+{
+  record_window_baton_t *wb = baton;
+  record_command(wb->eb, 'e', wb->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t. */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  record_window_baton_t *wb = baton;
+
+  if (wb->handler != svn_delta_noop_window_handler)
+    SVN_ERR(wb->handler(window, wb->handler_baton));
+
+  /* The svndiff writer will call record_delta_end upon the final
+     window. */
+  if (wb->eb->file)
+    {
+      svn_error_t *err = wb->svndiff_handler(window, wb->svndiff_baton);
+      if (err)
+        {
+          svn_error_clear(err);
+          abandon_recording(wb->eb, wb->pool);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *result_pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  record_baton_t *fb = file_baton;
+  record_edit_baton_t *eb = fb->eb;
+  record_window_baton_t *wb;
+  svn_stream_t *stream;
+
+  wb = apr_pcalloc(result_pool, sizeof(*wb));
+  SVN_ERR(eb->wrapped_editor->apply_textdelta(fb->wrapped_baton,
+                                              base_checksum, result_pool,
+                                              &wb->handler,
+                                              &wb->handler_baton));
+  record_value_op(eb, 'd', NULL,
+                  base_checksum
+                    ? svn_string_create(base_checksum, result_pool)
+                    : NULL,
+                  result_pool);
+
+  /* Even if this consumer does not want the delta, e.g. in a skelta mode
+     checkout, a consumer that we replay this entry to may want it.  So,
+     record it unless we have given up on the recording anyway. */
+  if (!eb->file)
+    {
+      *handler = wb->handler;
+      *handler_baton = wb->handler_baton;
+      return SVN_NO_ERROR;
+    }
+
+  wb->eb = eb;
+  wb->pool = result_pool;
+  stream = svn_stream_create(wb, result_pool);
+  svn_stream_set_write(stream, record_chunk);
+  svn_stream_set_close(stream, record_delta_end);
+  svn_txdelta_to_svndiff3(&wb->svndiff_handler, &wb->svndiff_baton, stream,
+                          2, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                          result_pool);
+
+  *handler = record_window;
+  *handler_baton = wb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *scratch_pool)
+{
+  record_baton_t *fb = file_baton;
+
+  SVN_ERR(fb->eb->wrapped_editor->change_file_prop(fb->wrapped_baton, name,
+                                                   value, scratch_pool));
+  record_value_op(fb->eb, 'p', name, value, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *scratch_pool)
+{
+  record_baton_t *fb = file_baton;
+
+  SVN_ERR(fb->eb->wrapped_editor->close_file(fb->wrapped_baton,
+                                             text_checksum, scratch_pool));
+  record_value_op(fb->eb, 'F', NULL,
+                  text_checksum
+                    ? svn_string_create(text_checksum, scratch_pool)
+                    : NULL,
+                  scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *scratch_pool)
+{
+  record_baton_t *pb = parent_baton;
+
+  SVN_ERR(pb->eb->wrapped_editor->absent_file(path, pb->wrapped_baton,
+                                              scratch_pool));
+  record_value_op(pb->eb, 'x', NULL, svn_string_create(path, scratch_pool),
+                  scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Move the completed recording in EB into its place in the cache.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+commit_recording(record_edit_baton_t *eb,
+                 apr_pool_t *scratch_pool)
+{
+  apr_file_t *file = eb->file;
+
+  eb->file = NULL;
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  SVN_ERR(svn_io_file_rename2(eb->temp_path, eb->entry_path, FALSE,
+                              scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(eb->cache->mutex,
+                       remove_old_entries(eb->cache, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_edit(void *edit_baton,
+                  apr_pool_t *scratch_pool)
+{
+  record_edit_baton_t *eb = edit_baton;
+  svn_error_t *err;
+
+  SVN_ERR(eb->wrapped_editor->close_edit(eb->wrapped_edit_baton,
+                                         scratch_pool));
+  record_command(eb, 'E', scratch_pool);
+
+  /* The client got its data.  Caching is just a bonus. */
+  if (eb->file)
+    {
+      err = commit_recording(eb, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_error_clear(svn_io_remove_file2(eb->temp_path, TRUE,
+                                              scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_abort_edit(void *edit_baton,
+                  apr_pool_t *scratch_pool)
+{
+  record_edit_baton_t *eb = edit_baton;
+
+  abandon_recording(eb, scratch_pool);
+  return svn_error_trace(eb->wrapped_editor->abort_edit(
+                           eb->wrapped_edit_baton, scratch_pool));
+}
+
+svn_error_t *
+svn_repos__checkout_cache_record(const svn_delta_editor_t **editor,
+                                 void **edit_baton,
+                                 svn_repos__checkout_cache_t *cache,
+                                 const char *key,
+                                 const svn_delta_editor_t *wrapped_editor,
+                                 void *wrapped_edit_baton,
+                                 apr_pool_t *result_pool)
+{
+  svn_delta_editor_t *record_editor;
+  record_edit_baton_t *eb;
+  svn_stringbuf_t *header;
+  svn_error_t *err;
+
+  eb = apr_pcalloc(result_pool, sizeof(*eb));
+  eb->wrapped_editor = wrapped_editor;
+  eb->wrapped_edit_baton = wrapped_edit_baton;
+  eb->cache = cache;
+  eb->entry_path = entry_path(cache, key, result_pool);
+
+  /* Without a recording, we still want to serve the request. */
+  err = svn_io_open_uniquely_named(&eb->file, &eb->temp_path, cache->path,
+                                   svn_dirent_basename(eb->entry_path,
+                                                       result_pool),
+                                   TEMP_FILE_SUFFIX, svn_io_file_del_none,
+                                   result_pool, result_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      eb->file = NULL;
+    }
+
+  header = svn_stringbuf_create(CACHE_ENTRY_HEADER, result_pool);
+  append_cstring(header, key);
+  write_record(eb, header, result_pool);
+
+  record_editor = svn_delta_default_editor(result_pool);
+  record_editor->set_target_revision = record_set_target_revision;
+  record_editor->open_root = record_open_root;
+  record_editor->delete_entry = record_delete_entry;
+  record_editor->add_directory = record_add_directory;
+  record_editor->open_directory = record_open_directory;
+  record_editor->change_dir_prop = record_change_dir_prop;
+  record_editor->close_directory = record_close_directory;
+  record_editor->absent_directory = record_absent_directory;
+  record_editor->add_file = record_add_file;
+  record_editor->open_file = record_open_file;
+  record_editor->apply_textdelta = record_apply_textdelta;
+  record_editor->change_file_prop = record_change_file_prop;
+  record_editor->close_file = record_close_file;
+  record_editor->absent_file = record_absent_file;
+  record_editor->close_edit = record_close_edit;
+  record_editor->abort_edit = record_abort_edit;
+
+  *editor = record_editor;
+  *edit_baton = eb;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* --- REPLAYING AN EDITOR DRIVE --- */
+
+/* Return the error for a malformed cache entry at PATH. */
+static svn_error_t *
+corrupt_entry(const char *path,
+              apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                           _("Corrupt checkout cache entry '%s'"),
+                           svn_dirent_local_style(path, scratch_pool));
+}
+
+/* Read a non-negative decimal number terminated by ':' from FILE into
+   *NUM.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_number(apr_uint64_t *num,
+            apr_file_t *file,
+            apr_pool_t *scratch_pool)
+{
+  char c;
+
+  *num = 0;
+  while (1)
+    {
+      SVN_ERR(svn_io_file_getc(&c, file, scratch_pool));
+      if (c == ':')
+        break;
+
+      if (c < '0' || c > '9' || *num > APR_UINT64_MAX / 10)
+        return svn_error_create(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                                _("Invalid number in checkout cache"));
+
+      *num = *num * 10 + (c - '0');
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read an optional string from FILE into *STR, allocated in
+   RESULT_POOL.  Set *STR to NULL if it has not been given. */
+static svn_error_t *
+read_string(svn_string_t **str,
+            apr_file_t *file,
+            apr_pool_t *result_pool)
+{
+  apr_uint64_t len;
+  char *buf;
+  char c;
+
+  SVN_ERR(svn_io_file_getc(&c, file, result_pool));
+  if (c == '-')
+    {
+      *str = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (c != '+')
+    return svn_error_create(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                            _("Invalid string in checkout cache"));
+
+  SVN_ERR(read_number(&len, file, result_pool));
+  if (len >= APR_SIZE_MAX)
+    return svn_error_create(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                            _("Invalid string in checkout cache"));
+
+  buf = apr_palloc(result_pool, (apr_size_t)len + 1);
+  SVN_ERR(svn_io_file_read_full2(file, buf, (apr_size_t)len, NULL, NULL,
+                                 result_pool));
+  buf[len] = 0;
+
+  *str = apr_palloc(result_pool, sizeof(**str));
+  (*str)->data = buf;
+  (*str)->len = (apr_size_t)len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like read_string but return a C string. */
+static svn_error_t *
+read_cstring(const char **str,
+             apr_file_t *file,
+             apr_pool_t *result_pool)
+{
+  svn_string_t *value;
+
+  SVN_ERR(read_string(&value, file, result_pool));
+  *str = value ? value->data : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read an optional revision number from FILE into *REV.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_rev(svn_revnum_t *rev,
+         apr_file_t *file,
+         apr_pool_t *scratch_pool)
+{
+  char c;
+  apr_uint64_t num;
+
+  SVN_ERR(svn_io_file_getc(&c, file, scratch_pool));
+  if (c == '+')
+    {
+      SVN_ERR(read_number(&num, file, scratch_pool));
+      *rev = (svn_revnum_t) num;
+    }
+  else
+    *rev = SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
+}
+
+/* An open directory during the replay. */
+typedef struct replay_dir_t
+{
+  void *baton;
+  apr_pool_t *pool;
+} replay_dir_t;
+
+/* Return the innermost open directory in DIRS in *DIR.  Error out if
+   there is none, reporting PATH as the culprit. */
+static svn_error_t *
+current_dir(replay_dir_t **dir,
+            apr_array_header_t *dirs,
+            const char *path,
+            apr_pool_t *scratch_pool)
+{
+  if (dirs->nelts == 0)
+    return svn_error_trace(corrupt_entry(path, scratch_pool));
+
+  *dir = &APR_ARRAY_IDX(dirs, dirs->nelts - 1, replay_dir_t);
+  return SVN_NO_ERROR;
+}
+
+/* Add a new directory to DIRS and return it.  Its pool will be a
+   sub-pool of the enclosing directory's pool or of PARENT_POOL for the
+   root directory. */
+static replay_dir_t *
+push_dir(apr_array_header_t *dirs,
+         apr_pool_t *parent_pool)
+{
+  replay_dir_t *dir = apr_array_push(dirs);
+  dir->pool = svn_pool_create(dirs->nelts > 1
+                                ? APR_ARRAY_IDX(dirs, dirs->nelts - 2,
+                                                replay_dir_t).pool
+                                : parent_pool);
+  dir->baton = NULL;
+
+  return dir;
+}
+
+/* Drive EDITOR with the operations recorded in FILE, the cache entry at
+   PATH.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+replay_entry(apr_file_t *file,
+             const char *path,
+             const svn_delta_editor_t *editor,
+             void *edit_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *file_pool = svn_pool_create(scratch_pool);
+  apr_array_header_t *dirs = apr_array_make(scratch_pool, 16,
+                                            sizeof(replay_dir_t));
+  void *file_baton = NULL;
+  svn_txdelta_window_handler_t handler = NULL;
+  void *handler_baton = NULL;
+  svn_stream_t *delta_stream = NULL;
+
+  while (TRUE)
+    {
+      replay_dir_t *dir;
+      const char *name, *copyfrom_path;
+      svn_string_t *value;
+      svn_revnum_t rev;
+      char command;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_file_getc(&command, file, iterpool));
+
+      /* File operations require an open file. */
+      if (command && strchr("pdceF", command) && !file_baton)
+        return svn_error_trace(corrupt_entry(path, iterpool));
+
+      switch (command)
+        {
+          case 'R':
+            SVN_ERR(read_rev(&rev, file, iterpool));
+            SVN_ERR(editor->set_target_revision(edit_baton, rev, iterpool));
+            break;
+
+          case 'O':
+            SVN_ERR(read_rev(&rev, file, iterpool));
+            dir = push_dir(dirs, scratch_pool);
+            SVN_ERR(editor->open_root(edit_baton, rev, dir->pool,
+                                      &dir->baton));
+            break;
+
+          case 'D':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            SVN_ERR(read_cstring(&name, file, iterpool));
+            SVN_ERR(read_rev(&rev, file, iterpool));
+            SVN_ERR(editor->delete_entry(name, rev, dir->baton, iterpool));
+            break;
+
+          case 'A':
+          case 'o':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            {
+              void *parent_baton = dir->baton;
+
+              dir = push_dir(dirs, scratch_pool);
+              SVN_ERR(read_cstring(&name, file, dir->pool));
+              if (command == 'A')
+                {
+                  SVN_ERR(read_cstring(&copyfrom_path, file, dir->pool));
+                  SVN_ERR(read_rev(&rev, file, iterpool));
+                  SVN_ERR(editor->add_directory(name, parent_baton,
+                                                copyfrom_path, rev,
+                                                dir->pool, &dir->baton));
+                }
+              else
+                {
+                  SVN_ERR(read_rev(&rev, file, iterpool));
+                  SVN_ERR(editor->open_directory(name, parent_baton, rev,
+                                                 dir->pool, &dir->baton));
+                }
+            }
+            break;
+
+          case 'P':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            SVN_ERR(read_cstring(&name, file, dir->pool));
+            SVN_ERR(read_string(&value, file, dir->pool));
+            SVN_ERR(editor->change_dir_prop(dir->baton, name, value,
+                                            dir->pool));
+            break;
+
+          case 'C':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            SVN_ERR(editor->close_directory(dir->baton, dir->pool));
+            svn_pool_destroy(dir->pool);
+            apr_array_pop(dirs);
+            break;
+
+          case 'X':
+          case 'x':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            SVN_ERR(read_cstring(&name, file, iterpool));
+            if (!name)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            if (command == 'X')
+              SVN_ERR(editor->absent_directory(name, dir->baton, iterpool));
+            else
+              SVN_ERR(editor->absent_file(name, dir->baton, iterpool));
+            break;
+
+          case 'a':
+          case 'f':
+            SVN_ERR(current_dir(&dir, dirs, path, iterpool));
+            if (file_baton)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            svn_pool_clear(file_pool);
+            SVN_ERR(read_cstring(&name, file, file_pool));
+            if (command == 'a')
+              {
+                SVN_ERR(read_cstring(&copyfrom_path, file, file_pool));
+                SVN_ERR(read_rev(&rev, file, iterpool));
+                SVN_ERR(editor->add_file(name, dir->baton, copyfrom_path,
+                                         rev, file_pool, &file_baton));
+              }
+            else
+              {
+                SVN_ERR(read_rev(&rev, file, iterpool));
+                SVN_ERR(editor->open_file(name, dir->baton, rev, file_pool,
+                                          &file_baton));
+              }
+            break;
+
+          case 'p':
+            SVN_ERR(read_cstring(&name, file, file_pool));
+            SVN_ERR(read_string(&value, file, file_pool));
+            SVN_ERR(editor->change_file_prop(file_baton, name, value,
+                                             file_pool));
+            break;
+
+          case 'd':
+            SVN_ERR(read_string(&value, file, file_pool));
+            SVN_ERR(editor->apply_textdelta(file_baton,
+                                            value ? value->data : NULL,
+                                            file_pool, &handler,
+                                            &handler_baton));
+            break;
+
+          case 'c':
+            if (!handler)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            SVN_ERR(read_string(&value, file, iterpool));
+            if (!value)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            /* Don't decode what the consumer will discard anyway. */
+            if (handler == svn_delta_noop_window_handler)
+              break;
+
+            if (!delta_stream)
+              delta_stream = svn_txdelta_parse_svndiff(handler,
+                                                       handler_baton, TRUE,
+                                                       file_pool);
+            SVN_ERR(svn_stream_write(delta_stream, value->data,
+                                     &value->len));
+            break;
+
+          case 'e':
+            if (!handler)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            /* Without any data, this has been an empty delta. */
+            if (delta_stream)
+              SVN_ERR(svn_stream_close(delta_stream));
+            else
+              SVN_ERR(handler(NULL, handler_baton));
+
+            delta_stream = NULL;
+            handler = NULL;
+            break;
+
+          case 'F':
+            if (handler)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            SVN_ERR(read_cstring(&name, file, file_pool));
+            SVN_ERR(editor->close_file(file_baton, name, file_pool));
+            file_baton = NULL;
+            break;
+
+          case 'E':
+            if (dirs->nelts || file_baton)
+              return svn_error_trace(corrupt_entry(path, iterpool));
+
+            SVN_ERR(editor->close_edit(edit_baton, iterpool));
+            svn_pool_destroy(iterpool);
+            svn_pool_destroy(file_pool);
+            return SVN_NO_ERROR;
+
+          default:
+            return svn_error_trace(corrupt_entry(path, iterpool));
+        }
+    }
+}
+
+svn_error_t *
+svn_repos__checkout_cache_replay(svn_boolean_t *found,
+                                 svn_repos__checkout_cache_t *cache,
+                                 const char *key,
+                                 const svn_delta_editor_t *editor,
+                                 void *edit_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  const char *path = entry_path(cache, key, scratch_pool);
+  apr_size_t header_len = strlen(CACHE_ENTRY_HEADER);
+  char *header = apr_palloc(scratch_pool, header_len);
+  const char *stored_key;
+  apr_file_t *file;
+  svn_error_t *err;
+
+  *found = FALSE;
+
+  /* Entries may get evicted at any time. */
+  err = svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Entries for other keys are not for us, even if the hashes match. */
+  SVN_ERR(svn_io_file_read_full2(file, header, header_len, NULL, NULL,
+                                 scratch_pool));
+  if (memcmp(header, CACHE_ENTRY_HEADER, header_len))
+    return svn_error_trace(svn_error_compose_create(
+                             corrupt_entry(path, scratch_pool),
+                             svn_io_file_close(file, scratch_pool)));
+
+  SVN_ERR(read_cstring(&stored_key, file, scratch_pool));
+  if (!stored_key || strcmp(stored_key, key))
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  /* Mark the entry as recently used. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), path,
+                                                scratch_pool));
+
+  *found = TRUE;
+  err = replay_entry(file, path, editor, edit_baton, scratch_pool);
+
+  return svn_error_trace(svn_error_compose_create(
+                           err, svn_io_file_close(file, scratch_pool)));
+}
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
+#include <apr_thread_proc.h>
 
 #include "svn_compat.h"
 #include "svn_private_config.h"
@@ -37,15 +38,91 @@
 #include "svn_sorts.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_cache_config.h"
 #include "repos.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 
 
+/* Number of log entries per worker thread that may be prepared ahead of
+   the receiver. */
+#define PREFETCH_REVS_PER_WORKER 8
+
+/* The FS data for a log entry, as prepared by a worker thread. */
+typedef struct log_prefetch_entry_t
+{
+  /* Protected by the log_prefetch_t mutex. */
+  svn_boolean_t done;
+
+  /* Copies of the changes in the revision, with known node kinds.
+     NULL if they were not requested. */
+  apr_array_header_t *changes;
+
+  /* All revprops of the revision.  NULL if they were not requested. */
+  apr_hash_t *revprops;
+
+  /* If set, the above are invalid. */
+  svn_error_t *err;
+
+  /* Gets cleared whenever the entry is being reused. */
+  apr_pool_t *pool;
+} log_prefetch_entry_t;
+
+/* The worker threads preparing log entries for a known sequence of
+   revisions ahead of the receiver. */
+typedef struct log_prefetch_t
+{
+  /* Read-only parameters for the worker threads. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_boolean_t want_changes;
+  svn_boolean_t want_revprops;
+
+  /* The COUNT revisions to prepare, in the order they will be sent.
+     If REVS is not NULL, these are its elements, starting at the back.
+     Otherwise, they count down or up from FIRST, depending on
+     DESCENDING. */
+  const apr_array_header_t *revs;
+  svn_revnum_t first;
+  svn_boolean_t descending;
+  int count;
+
+  /* Worker threads that have been started. */
+  apr_array_header_t *threads;
+
+  /* Everything below is protected by MUTEX.  COND gets signaled on
+     any change to it. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Ring buffer of WINDOW entries.  The revision with index I in the
+     sequence gets prepared in ENTRIES[I % WINDOW]. */
+  log_prefetch_entry_t *entries;
+  int window;
+
+  /* Index of the next revision that a worker will prepare. */
+  int next_fetch;
+
+  /* Index of the next revision that the receiver will send. */
+  int next_send;
+
+  /* Set if the receiver still uses the entry before NEXT_SEND. */
+  svn_boolean_t held;
+
+  /* Set to tell the worker threads to terminate. */
+  svn_boolean_t shutdown;
+
+  /* Pool that all of the above lives in.  Uses a thread-safe
+     allocator. */
+  apr_pool_t *pool;
+} log_prefetch_t;
+
 /* This is a mere convenience struct such that we don't need to pass that
    many parameters around individually. */
 typedef struct log_callbacks_t
@@ -56,6 +133,12 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The repository being logged, for its log_workers settings. */
+  svn_repos_t *repos;
+
+  /* Worker threads preparing upcoming log entries.  NULL if not used. */
+  log_prefetch_t *prefetch;
 } log_callbacks_t;
 
 
@@ -221,6 +304,74 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
 }
 
 
+/* Pre-1.6 revision files don't store the change path kind, so fetch
+ * it manually for CHANGE in ROOT of FS if necessary.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+resolve_node_kind(svn_fs_path_change3_t *change,
+                  svn_fs_root_t *root,
+                  svn_fs_t *fs,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *check_root = root;
+  const char *check_path = change->path.data;
+
+  if (change->node_kind != svn_node_unknown)
+    return SVN_NO_ERROR;
+
+  /* Deleted items don't exist so check earlier revision.  We
+     know the parent must exist and could be a copy */
+  if (change->change_kind == svn_fs_path_change_delete)
+    {
+      svn_fs_history_t *history;
+      svn_revnum_t prev_rev;
+      const char *parent_path, *name;
+
+      svn_fspath__split(&parent_path, &name, check_path, scratch_pool);
+
+      SVN_ERR(svn_fs_node_history2(&history, root, parent_path,
+                                   scratch_pool, scratch_pool));
+
+      /* Two calls because the first call returns the original
+         revision as the deleted child means it is 'interesting' */
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                   scratch_pool));
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                   scratch_pool));
+
+      SVN_ERR(svn_fs_history_location(&parent_path, &prev_rev,
+                                      history, scratch_pool));
+      SVN_ERR(svn_fs_revision_root(&check_root, fs, prev_rev,
+                                   scratch_pool));
+      check_path = svn_fspath__join(parent_path, name, scratch_pool);
+    }
+
+  return svn_error_trace(svn_fs_check_path(&change->node_kind, check_root,
+                                           check_path, scratch_pool));
+}
+
+/* Set *CHANGE to the next change from ITERATOR or, if CHANGES is not
+ * NULL, to the element *IDX of that array of svn_fs_path_change3_t *
+ * and increment *IDX.  Set *CHANGE to NULL after the last change.
+ */
+static svn_error_t *
+next_change(svn_fs_path_change3_t **change,
+            svn_fs_path_change_iterator_t *iterator,
+            const apr_array_header_t *changes,
+            int *idx)
+{
+  if (!changes)
+    return svn_error_trace(svn_fs_path_change_get(change, iterator));
+
+  if (*idx < changes->nelts)
+    *change = APR_ARRAY_IDX(changes, (*idx)++, svn_fs_path_change3_t *);
+  else
+    *change = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Find all significant changes under ROOT and, if not NULL, report them
  * to the CALLBACKS->PATH_CHANGE_RECEIVER.  "Significant" means that the
  * text or properties of the node were changed, or that the node was added
@@ -243,23 +394,30 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
  *     *ACCESS_LEVEL to svn_repos_revision_access_none.  (This is
  *     to distinguish a revision which truly has no changed paths
  *     from a revision in which all paths are unreadable.)
+ *
+ * If CHANGES is not NULL, it contains the changes under ROOT, as
+ * prepared by a worker thread.
  */
 static svn_error_t *
 detect_changed(svn_repos_revision_access_level_t *access_level,
                svn_fs_root_t *root,
                svn_fs_t *fs,
+               const apr_array_header_t *changes,
                const log_callbacks_t *callbacks,
                apr_pool_t *scratch_pool)
 {
-  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change_iterator_t *iterator = NULL;
   svn_fs_path_change3_t *change;
   apr_pool_t *iterpool;
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
+  int idx = 0;
 
   /* Retrieve the first change in the list. */
-  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
-  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  if (!changes)
+    SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                  scratch_pool));
+  SVN_ERR(next_change(&change, iterator, changes, &idx));
 
   if (!change)
     {
@@ -288,7 +446,7 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
           if (! readable)
             {
               found_unreadable = TRUE;
-              SVN_ERR(svn_fs_path_change_get(&change, iterator));
+              SVN_ERR(next_change(&change, iterator, changes, &idx));
               continue;
             }
         }
@@ -296,43 +454,7 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
       /* At least one changed-path was readable. */
       found_readable = TRUE;
 
-      /* Pre-1.6 revision files don't store the change path kind, so fetch
-         it manually. */
-      if (change->node_kind == svn_node_unknown)
-        {
-          svn_fs_root_t *check_root = root;
-          const char *check_path = path;
-
-          /* Deleted items don't exist so check earlier revision.  We
-             know the parent must exist and could be a copy */
-          if (change->change_kind == svn_fs_path_change_delete)
-            {
-              svn_fs_history_t *history;
-              svn_revnum_t prev_rev;
-              const char *parent_path, *name;
-
-              svn_fspath__split(&parent_path, &name, path, iterpool);
-
-              SVN_ERR(svn_fs_node_history2(&history, root, parent_path,
-                                           iterpool, iterpool));
-
-              /* Two calls because the first call returns the original
-                 revision as the deleted child means it is 'interesting' */
-              SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
-                                           iterpool));
-              SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
-                                           iterpool));
-
-              SVN_ERR(svn_fs_history_location(&parent_path, &prev_rev,
-                                              history, iterpool));
-              SVN_ERR(svn_fs_revision_root(&check_root, fs, prev_rev,
-                                           iterpool));
-              check_path = svn_fspath__join(parent_path, name, iterpool);
-            }
-
-          SVN_ERR(svn_fs_check_path(&change->node_kind, check_root, check_path,
-                                    iterpool));
-        }
+      SVN_ERR(resolve_node_kind(change, root, fs, iterpool));
 
       if (   (change->change_kind == svn_fs_path_change_add)
           || (change->change_kind == svn_fs_path_change_replace))
@@ -384,7 +506,7 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
                                      iterpool));
 
       /* Next changed path. */
-      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      SVN_ERR(next_change(&change, iterator, changes, &idx));
     }
 
   svn_pool_destroy(iterpool);
@@ -1095,11 +1217,13 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
 }
 
 
-/* Fill LOG_ENTRY with history information in FS at REV. */
+/* Fill LOG_ENTRY with history information in FS at REV.  Take the FS
+   data from PREFETCHED if that is not NULL. */
 static svn_error_t *
 fill_log_entry(svn_repos_log_entry_t *log_entry,
                svn_revnum_t rev,
                svn_fs_t *fs,
+               const log_prefetch_entry_t *prefetched,
                const apr_array_header_t *revprops,
                const log_callbacks_t *callbacks,
                apr_pool_t *pool)
@@ -1117,7 +1241,9 @@ fill_log_entry(svn_repos_log_entry_t *log_entry,
       svn_repos_revision_access_level_t access_level;
 
       SVN_ERR(svn_fs_revision_root(&newroot, fs, rev, pool));
-      SVN_ERR(detect_changed(&access_level, newroot, fs, callbacks, pool));
+      SVN_ERR(detect_changed(&access_level, newroot, fs,
+                             prefetched ? prefetched->changes : NULL,
+                             callbacks, pool));
 
       if (access_level == svn_repos_revision_access_none)
         {
@@ -1136,8 +1262,11 @@ fill_log_entry(svn_repos_log_entry_t *log_entry,
   if (get_revprops && want_revprops)
     {
       /* User is allowed to see at least some revprops. */
-      SVN_ERR(svn_fs_revision_proplist2(&r_props, fs, rev, FALSE, pool,
-                                        pool));
+      if (prefetched)
+        r_props = prefetched->revprops;
+      else
+        SVN_ERR(svn_fs_revision_proplist2(&r_props, fs, rev, FALSE, pool,
+                                          pool));
       if (revprops == NULL)
         {
           /* Requested all revprops... */
@@ -1212,6 +1341,329 @@ fill_log_entry(svn_repos_log_entry_t *log_entry,
   return SVN_NO_ERROR;
 }
 
+/* --- PREPARING LOG ENTRIES AHEAD OF THE RECEIVER --- */
+
+/* Return the revision with index IDX in P's sequence. */
+static svn_revnum_t
+prefetch_rev(const log_prefetch_t *p,
+             int idx)
+{
+  if (p->revs)
+    return APR_ARRAY_IDX(p->revs, p->revs->nelts - idx - 1, svn_revnum_t);
+
+  return p->descending ? p->first - idx : p->first + idx;
+}
+
+/* Return ENTRY, which is no longer used by the receiver, to P.
+   P's mutex must be held. */
+static svn_error_t *
+release_prefetch_entry(log_prefetch_t *p,
+                       log_prefetch_entry_t *entry)
+{
+  svn_error_clear(entry->err);
+  entry->err = SVN_NO_ERROR;
+  entry->changes = NULL;
+  entry->revprops = NULL;
+  entry->done = FALSE;
+  svn_pool_clear(entry->pool);
+
+  return svn_error_trace(svn_thread_cond__broadcast(p->cond));
+}
+
+#if APR_HAS_THREADS
+
+/* The per-thread data of a worker thread. */
+typedef struct prefetch_worker_baton_t
+{
+  log_prefetch_t *p;
+  apr_pool_t *pool;
+} prefetch_worker_baton_t;
+
+/* Fill in ENTRY for REV in FS as requested by P.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+run_prefetch(log_prefetch_entry_t *entry,
+             const log_prefetch_t *p,
+             svn_fs_t *fs,
+             svn_revnum_t rev,
+             apr_pool_t *scratch_pool)
+{
+  if (p->want_changes && rev > 0)
+    {
+      svn_fs_root_t *root;
+      svn_fs_path_change_iterator_t *iterator;
+      svn_fs_path_change3_t *change;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, scratch_pool));
+      SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                    scratch_pool));
+
+      entry->changes = apr_array_make(entry->pool, 16,
+                                      sizeof(svn_fs_path_change3_t *));
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      while (change)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(resolve_node_kind(change, root, fs, iterpool));
+          APR_ARRAY_PUSH(entry->changes, svn_fs_path_change3_t *)
+            = svn_fs_path_change3_dup(change, entry->pool);
+
+          SVN_ERR(svn_fs_path_change_get(&change, iterator));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  if (p->want_revprops)
+    SVN_ERR(svn_fs_revision_proplist2(&entry->revprops, fs, rev, FALSE,
+                                      entry->pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Claim the next revision in P's sequence that needs to be prepared and
+   return its index in *IDX.  Wait for one to become available.  Set *IDX
+   to -1 if P is being shut down.  P's mutex must be held. */
+static svn_error_t *
+next_prefetch_rev(int *idx,
+                  log_prefetch_t *p)
+{
+  /* One slot in the ring buffer is reserved for the entry held by the
+     receiver. */
+  while (!p->shutdown
+         && (p->next_fetch >= p->count
+             || p->next_fetch >= p->next_send + p->window - 1))
+    SVN_ERR(svn_thread_cond__wait(p->cond, p->mutex));
+
+  *idx = p->shutdown ? -1 : p->next_fetch++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Publish ENTRY to the receiver.  P's mutex must be held. */
+static svn_error_t *
+complete_prefetch(log_prefetch_t *p,
+                  log_prefetch_entry_t *entry)
+{
+  entry->done = TRUE;
+
+  return svn_error_trace(svn_thread_cond__broadcast(p->cond));
+}
+
+/* Prepare log entries for the revisions in P's sequence until P gets
+   shut down.  Use POOL for all allocations. */
+static svn_error_t *
+prefetch_worker_loop(log_prefetch_t *p,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* FS instances must not be shared between threads.  If we can't get
+     one, the receiver will prepare the log entries by itself. */
+  SVN_ERR(svn_fs_open2(&fs, p->fs_path, p->fs_config, pool, pool));
+
+  while (TRUE)
+    {
+      log_prefetch_entry_t *entry;
+      int idx;
+
+      SVN_MUTEX__WITH_LOCK(p->mutex, next_prefetch_rev(&idx, p));
+      if (idx < 0)
+        break;
+
+      /* Failures are for the receiver to deal with. */
+      svn_pool_clear(iterpool);
+      entry = &p->entries[idx % p->window];
+      entry->err = run_prefetch(entry, p, fs, prefetch_rev(p, idx),
+                                iterpool);
+
+      SVN_MUTEX__WITH_LOCK(p->mutex, complete_prefetch(p, entry));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running prefetch_worker_loop on the
+   prefetch_worker_baton_t in DATA. */
+static void * APR_THREAD_FUNC
+prefetch_worker(apr_thread_t *thread,
+                void *data)
+{
+  prefetch_worker_baton_t *baton = data;
+
+  svn_error_clear(prefetch_worker_loop(baton->p, baton->pool));
+
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Shut down and join all worker threads of CALLBACKS->PREFETCH, if any,
+   and release all of its resources. */
+static svn_error_t *
+stop_prefetch(log_callbacks_t *callbacks)
+{
+  log_prefetch_t *p = callbacks->prefetch;
+  svn_error_t *err;
+  int i;
+
+  if (!p)
+    return SVN_NO_ERROR;
+
+  callbacks->prefetch = NULL;
+  err = svn_mutex__lock(p->mutex);
+  if (!err)
+    {
+      p->shutdown = TRUE;
+      err = svn_mutex__unlock(p->mutex,
+                              svn_thread_cond__broadcast(p->cond));
+    }
+
+  /* We can't safely release anything if we failed to notify the
+     workers. */
+  if (err)
+    return svn_error_trace(err);
+
+#if APR_HAS_THREADS
+  while (p->threads->nelts)
+    {
+      apr_thread_t *thread = *(apr_thread_t **)apr_array_pop(p->threads);
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(status, _("Can't join thread")));
+    }
+#endif
+
+  if (err)
+    return svn_error_trace(err);
+
+  for (i = 0; i < p->window; ++i)
+    svn_error_clear(p->entries[i].err);
+
+  svn_pool_destroy(p->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If CALLBACKS->REPOS has log workers configured, start them preparing
+   the log entries for COUNT revisions and store them in
+   CALLBACKS->PREFETCH.  The sequence of revisions is given by REVS,
+   FIRST and DESCENDING as described for log_prefetch_t.  REVPROPS is
+   as for send_log.  REVS must remain valid until stop_prefetch. */
+static svn_error_t *
+start_prefetch(log_callbacks_t *callbacks,
+               const apr_array_header_t *revs,
+               svn_revnum_t first,
+               svn_boolean_t descending,
+               int count,
+               const apr_array_header_t *revprops)
+{
+#if APR_HAS_THREADS
+  svn_repos_t *repos = callbacks->repos;
+  log_prefetch_t *p;
+  apr_pool_t *pool;
+  int i;
+
+  /* The FS caches are shared between all worker threads. */
+  if (!repos || repos->log_workers <= 0 || count < 2
+      || svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  p = apr_pcalloc(pool, sizeof(*p));
+  p->fs_path = repos->db_path;
+  p->fs_config = repos->log_fs_config;
+  p->want_changes = (callbacks->authz_read_func
+                     || callbacks->path_change_receiver);
+  p->want_revprops = !revprops || revprops->nelts;
+  p->revs = revs;
+  p->first = first;
+  p->descending = descending;
+  p->count = count;
+  p->threads = apr_array_make(pool, repos->log_workers,
+                              sizeof(apr_thread_t *));
+  p->window = PREFETCH_REVS_PER_WORKER * repos->log_workers + 1;
+  p->entries = apr_pcalloc(pool, p->window * sizeof(*p->entries));
+  p->pool = pool;
+  SVN_ERR(svn_mutex__init(&p->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&p->cond, pool));
+
+  for (i = 0; i < p->window; ++i)
+    p->entries[i].pool = svn_pool_create(pool);
+
+  /* From here on, stop_prefetch takes care of the cleanup. */
+  callbacks->prefetch = p;
+  for (i = 0; i < repos->log_workers; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status;
+      prefetch_worker_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+
+      baton->p = p;
+      baton->pool = svn_pool_create(pool);
+      status = apr_thread_create(&thread, NULL, prefetch_worker, baton,
+                                 pool);
+
+      /* Make do with what we got. */
+      if (status)
+        break;
+
+      APR_ARRAY_PUSH(p->threads, apr_thread_t *) = thread;
+    }
+
+  if (p->threads->nelts == 0)
+    SVN_ERR(stop_prefetch(callbacks));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ENTRY to the log entry prepared by P for REV, if REV is the next
+   revision in P's sequence and has been prepared successfully.  Wait
+   for a worker thread to finish it if necessary.  Otherwise, set *ENTRY
+   to NULL.  The entry returned by the previous call becomes invalid.
+   P's mutex must be held. */
+static svn_error_t *
+take_prefetched(const log_prefetch_entry_t **entry,
+                log_prefetch_t *p,
+                svn_revnum_t rev)
+{
+  log_prefetch_entry_t *slot;
+
+  *entry = NULL;
+  if (p->held)
+    {
+      p->held = FALSE;
+      SVN_ERR(release_prefetch_entry(p,
+                           &p->entries[(p->next_send - 1) % p->window]));
+    }
+
+  if (p->next_send >= p->count || prefetch_rev(p, p->next_send) != rev)
+    return SVN_NO_ERROR;
+
+  /* Don't wait for revisions that no worker has picked up, yet. */
+  if (p->next_fetch <= p->next_send)
+    {
+      p->next_fetch = ++p->next_send;
+      return SVN_NO_ERROR;
+    }
+
+  slot = &p->entries[p->next_send % p->window];
+  while (!slot->done)
+    SVN_ERR(svn_thread_cond__wait(p->cond, p->mutex));
+
+  p->next_send++;
+  p->held = TRUE;
+  if (!slot->err)
+    *entry = slot;
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type to be used with the interesting_merge callback. */
 typedef struct interesting_merge_baton_t
 {
@@ -1316,6 +1768,7 @@ send_log(svn_revnum_t rev,
 {
   svn_repos_log_entry_t log_entry = { 0 };
   log_callbacks_t my_callbacks = *callbacks;
+  const log_prefetch_entry_t *prefetched = NULL;
 
   interesting_merge_baton_t baton;
 
@@ -1343,7 +1796,13 @@ send_log(svn_revnum_t rev,
       baton.found_rev_of_interest = TRUE;
     }
 
-  SVN_ERR(fill_log_entry(&log_entry, rev, fs, revprops, callbacks, pool));
+  if (callbacks->prefetch)
+    SVN_MUTEX__WITH_LOCK(callbacks->prefetch->mutex,
+                         take_prefetched(&prefetched, callbacks->prefetch,
+                                         rev));
+
+  SVN_ERR(fill_log_entry(&log_entry, rev, fs, prefetched, revprops,
+                         callbacks, pool));
   log_entry.has_children = has_children;
   log_entry.subtractive_merge = subtractive_merge;
 
@@ -2160,6 +2619,16 @@ do_logs(svn_fs_t *fs,
 
   if (revs)
     {
+      svn_error_t *err = SVN_NO_ERROR;
+
+      /* Without merged revisions, we know exactly which log entries we
+         are going to send. */
+      if (!include_merged_revisions)
+        SVN_ERR(start_prefetch(callbacks, revs, SVN_INVALID_REVNUM, FALSE,
+                               limit > 0 ? MIN(limit, revs->nelts)
+                                         : revs->nelts,
+                               revprops));
+
       /* Work loop for processing the revisions we found since they wanted
          history in forward order. */
       iterpool = svn_pool_create(pool);
@@ -2186,10 +2655,13 @@ do_logs(svn_fs_t *fs,
                               || apr_hash_count(deleted_mergeinfo) > 0);
             }
 
-          SVN_ERR(send_log(current, fs,
-                           log_target_history_as_mergeinfo, nested_merges,
-                           subtractive_merge, handling_merged_revisions,
-                           revprops, has_children, callbacks, iterpool));
+          err = send_log(current, fs,
+                         log_target_history_as_mergeinfo, nested_merges,
+                         subtractive_merge, handling_merged_revisions,
+                         revprops, has_children, callbacks, iterpool);
+          if (err)
+            break;
+
           if (has_children)
             {
               if (!nested_merges)
@@ -2198,19 +2670,23 @@ do_logs(svn_fs_t *fs,
                   nested_merges = svn_bit_array__create(current, subpool);
                 }
 
-              SVN_ERR(handle_merged_revisions(current, fs,
-                                              log_target_history_as_mergeinfo,
-                                              nested_merges,
-                                              processed,
-                                              added_mergeinfo,
-                                              deleted_mergeinfo,
-                                              strict_node_history,
-                                              revprops, callbacks,
-                                              iterpool));
+              err = handle_merged_revisions(current, fs,
+                                            log_target_history_as_mergeinfo,
+                                            nested_merges,
+                                            processed,
+                                            added_mergeinfo,
+                                            deleted_mergeinfo,
+                                            strict_node_history,
+                                            revprops, callbacks,
+                                            iterpool);
+              if (err)
+                break;
             }
           if (limit && i + 1 >= limit)
             break;
         }
+
+      SVN_ERR(svn_error_compose_create(err, stop_prefetch(callbacks)));
       svn_pool_destroy(iterpool);
     }
 
@@ -2303,6 +2779,15 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__set_log_workers(svn_repos_t *repos,
+                           int workers,
+                           apr_hash_t *fs_config)
+{
+  repos->log_workers = MAX(workers, 0);
+  repos->log_fs_config = fs_config;
+}
+
 svn_error_t *
 svn_repos_get_logs5(svn_repos_t *repos,
                     const apr_array_header_t *paths,
@@ -2332,6 +2817,8 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.repos = repos;
+  callbacks.prefetch = NULL;
 
   if (revprops)
     {
@@ -2398,6 +2885,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
       apr_uint64_t send_count = 0;
       int i;
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      svn_error_t *err = SVN_NO_ERROR;
 
       /* If we are provided an authz callback function, use it to
          verify that the user has read access to the root path in the
@@ -2424,6 +2912,12 @@ svn_repos_get_logs5(svn_repos_t *repos,
       send_count = end - start + 1;
       if (limit > 0 && send_count > limit)
         send_count = limit;
+
+      /* All log entries in that range will be sent. */
+      SVN_ERR(start_prefetch(&callbacks, NULL,
+                             descending_order ? end : start,
+                             descending_order, (int)send_count, revprops));
+
       for (i = 0; i < send_count; ++i)
         {
           svn_revnum_t rev;
@@ -2434,13 +2928,15 @@ svn_repos_get_logs5(svn_repos_t *repos,
             rev = end - i;
           else
             rev = start + i;
-          SVN_ERR(send_log(rev, fs, NULL, NULL,
-                           FALSE, FALSE, revprops, FALSE,
-                           &callbacks, iterpool));
+          err = send_log(rev, fs, NULL, NULL,
+                         FALSE, FALSE, revprops, FALSE,
+                         &callbacks, iterpool);
+          if (err)
+            break;
         }
       svn_pool_destroy(iterpool);
 
-      return SVN_NO_ERROR;
+      return svn_error_compose_create(err, stop_prefetch(&callbacks));
     }
 
   /* If we are including merged revisions, then create mergeinfo that
@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_path.h"
@@ -31,16 +33,28 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_cache_config.h"
 #include "repos.h"
 #include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
+/* Number of file delta prefetch jobs per worker thread that may be
+   waiting for the editor drive to pick them up. */
+#define PREFETCH_JOBS_PER_WORKER 4
+
+/* Prefetch jobs buffer at most this many bytes of delta windows.
+   Larger deltas get streamed by the editor drive itself. */
+#define MAX_PREFETCH_DELTA_SIZE 0x100000
+
 /* Theory of operation: we write report operations out to a spill-buffer
    as we receive them.  When the report is finished, we read the
    operations back out again, using them to guide the progression of
@@ -100,6 +114,97 @@ typedef struct revision_info_t
   svn_string_t* author;        /* name of the revisions' author */
 } revision_info_t;
 
+/* Life cycle of a prefetch job. */
+typedef enum prefetch_state_t
+{
+  /* Waiting for a worker thread to pick it up. */
+  prefetch_queued,
+
+  /* A worker thread is computing the results. */
+  prefetch_running,
+
+  /* All results are available. */
+  prefetch_done,
+
+  /* The editor drive lost interest while the job was running.  The
+     worker thread will dispose of the job once it is done. */
+  prefetch_abandoned
+} prefetch_state_t;
+
+/* Pre-computed information on how to turn S_REV/S_PATH into T_PATH in
+   the target revision of the report.  This covers the file-specific
+   parts of delta_proplists and delta_files. */
+typedef struct prefetch_job_t
+{
+  /* The file to compare.  S_PATH is NULL for added files. */
+  const char *t_path;
+  const char *s_path;
+  svn_revnum_t s_rev;
+
+  /* Protected by the prefetch_t mutex. */
+  prefetch_state_t state;
+
+  /* The results.  These are only valid in state prefetch_done and if
+     ERR is SVN_NO_ERROR.  PROPS_CHANGED and CONTENTS_CHANGED are always
+     TRUE for added files.  WINDOWS is a list of svn_txdelta_window_t *
+     and NULL if the text delta has not been buffered. */
+  svn_boolean_t props_changed;
+  apr_hash_t *s_props;
+  apr_hash_t *t_props;
+  svn_boolean_t contents_changed;
+  const char *s_hex_digest;
+  apr_array_header_t *windows;
+  svn_error_t *err;
+
+  /* Next job in the queue of waiting jobs. */
+  struct prefetch_job_t *next;
+
+  /* Root pool containing this job, recycled through prefetch_t. */
+  apr_pool_t *pool;
+} prefetch_job_t;
+
+/* The worker threads and job queue used to compute file deltas ahead
+   of the editor drive.  Jobs get created and consumed by the editor
+   drive only; the worker threads merely process them. */
+typedef struct prefetch_t
+{
+  /* Read-only parameters for the worker threads. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t t_rev;
+  svn_boolean_t text_deltas;
+
+  /* Worker threads that have been started. */
+  apr_array_header_t *threads;
+
+  /* Recycled root pools for the workers and jobs. */
+  svn_root_pools__t *pools;
+
+  /* Everything below is protected by MUTEX.  COND gets signaled on
+     any change to it. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Maps T_PATH to all prefetch_job_t * that have not been taken by
+     the editor drive, yet.  Only the editor drive modifies this. */
+  apr_hash_t *jobs;
+
+  /* FIFO of jobs in state prefetch_queued. */
+  prefetch_job_t *first;
+  prefetch_job_t *last;
+
+  /* Set to tell the worker threads to terminate. */
+  svn_boolean_t shutdown;
+
+  /* Set when worker threads failed to start up.  No further jobs will
+     be queued then. */
+  svn_boolean_t failed;
+
+  /* Pool that the thread objects and synchronization objects live in.
+     Uses a thread-safe allocator. */
+  apr_pool_t *pool;
+} prefetch_t;
+
 /* A structure used by the routines within the `reporter' vtable,
    driven by the client as it describes its working copy revisions. */
 typedef struct report_baton_t
@@ -114,6 +219,12 @@ typedef struct report_baton_t
   apr_size_t zero_copy_limit;  /* Max item size that will be sent using
                                   the zero-copy code path. */
 
+  /* Number of worker threads to compute file deltas with and the FS
+     config to open their FS instances with.  See
+     svn_repos__report_set_workers. */
+  int workers;
+  apr_hash_t *fs_config;
+
   /* If the client requested a specific depth, record it here; if the
      client did not, then this is svn_depth_unknown, and the depth of
      information transmitted from server to client will be governed
@@ -137,6 +248,15 @@ typedef struct report_baton_t
   svn_fs_root_t *t_root;
   svn_fs_root_t *s_roots[NUM_CACHED_SOURCE_ROOTS];
 
+  /* Worker threads computing file deltas ahead of the editor drive.
+     NULL if not used. */
+  prefetch_t *prefetch;
+
+  /* Cache of recorded checkout editor drives and the authz view to use
+     it with.  See svn_repos__report_set_checkout_cache. */
+  svn_repos__checkout_cache_t *checkout_cache;
+  const char *checkout_cache_view;
+
   /* Cache for revision properties. This is used to eliminate redundant
      revprop fetching. */
   apr_hash_t *revision_infos;
@@ -508,15 +628,481 @@ get_revision_info(report_baton_t *b,
   return SVN_NO_ERROR;
 }
 
+/* --- COMPUTING FILE DELTAS AHEAD OF THE EDITOR DRIVE --- */
+
+/* Root pools for worker threads and prefetch jobs, shared by all reports
+   within this process.  Recycling them keeps the allocator churn low. */
+static svn_root_pools__t *prefetch_pools = NULL;
+static volatile svn_atomic_t prefetch_pools_initialized = FALSE;
+
+/* Return JOB's memory to the pool of root pools.  JOB must no longer be
+   referenced by any prefetch_t. */
+static void
+release_prefetch_job(prefetch_job_t *job)
+{
+  svn_error_clear(job->err);
+  svn_root_pools__release_pool(job->pool, prefetch_pools);
+}
+
+#if APR_HAS_THREADS
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+create_prefetch_pools(void *baton,
+                      apr_pool_t *pool)
+{
+  return svn_error_trace(svn_root_pools__create(&prefetch_pools));
+}
+
+/* Fill in the results of JOB using the target revision root T_ROOT.
+   *S_ROOT is the last source revision root opened in FS and allocated
+   in S_ROOT_POOL; replace it if JOB needs a different revision.  Buffer
+   the text delta only if TEXT_DELTAS is set.  Allocate the results in
+   JOB's pool and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_prefetch_job(prefetch_job_t *job,
+                 svn_fs_t *fs,
+                 svn_fs_root_t *t_root,
+                 svn_fs_root_t **s_root,
+                 apr_pool_t *s_root_pool,
+                 svn_boolean_t text_deltas,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *result_pool = job->pool;
+  svn_fs_root_t *source = NULL;
+  svn_txdelta_stream_t *dstream;
+  apr_array_header_t *windows;
+  apr_pool_t *iterpool;
+  apr_size_t size = 0;
+
+  if (job->s_path)
+    {
+      if (!*s_root || svn_fs_revision_root_revision(*s_root) != job->s_rev)
+        {
+          svn_pool_clear(s_root_pool);
+          *s_root = NULL;
+          SVN_ERR(svn_fs_revision_root(s_root, fs, job->s_rev,
+                                       s_root_pool));
+        }
+
+      source = *s_root;
+    }
+
+  /* The property lists, cf. delta_proplists. */
+  job->props_changed = TRUE;
+  if (source)
+    SVN_ERR(svn_fs_props_different(&job->props_changed, t_root, job->t_path,
+                                   source, job->s_path, scratch_pool));
+  if (job->props_changed)
+    {
+      if (source)
+        SVN_ERR(svn_fs_node_proplist(&job->s_props, source, job->s_path,
+                                     result_pool));
+      SVN_ERR(svn_fs_node_proplist(&job->t_props, t_root, job->t_path,
+                                   result_pool));
+    }
+
+  /* The contents, cf. delta_files. */
+  job->contents_changed = TRUE;
+  if (source)
+    {
+      svn_checksum_t *s_checksum;
+
+      SVN_ERR(svn_fs_contents_different(&job->contents_changed,
+                                        t_root, job->t_path,
+                                        source, job->s_path, scratch_pool));
+      if (!job->contents_changed)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_fs_file_checksum(&s_checksum, svn_checksum_md5, source,
+                                   job->s_path, TRUE, scratch_pool));
+      job->s_hex_digest = svn_checksum_to_cstring(s_checksum, result_pool);
+    }
+
+  if (!text_deltas)
+    return SVN_NO_ERROR;
+
+  /* Buffer the delta windows unless they get too large. */
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, source, job->s_path,
+                                       t_root, job->t_path, scratch_pool));
+  windows = apr_array_make(result_pool, 4, sizeof(svn_txdelta_window_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  while (TRUE)
+    {
+      svn_txdelta_window_t *window;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+      if (!window)
+        break;
+
+      size += window->num_ops * sizeof(*window->ops)
+            + (window->new_data ? window->new_data->len : 0);
+      if (size > MAX_PREFETCH_DELTA_SIZE)
+        {
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+
+      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *)
+        = svn_txdelta_window_dup(window, result_pool);
+    }
+
+  svn_pool_destroy(iterpool);
+  job->windows = windows;
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the first job from P's queue, mark it as running and return
+   it in *JOB.  Wait for a job to become available.  Set *JOB to NULL if
+   P is being shut down.  P's mutex must be held. */
+static svn_error_t *
+next_prefetch_job(prefetch_job_t **job,
+                  prefetch_t *p)
+{
+  while (!p->shutdown && !p->first)
+    SVN_ERR(svn_thread_cond__wait(p->cond, p->mutex));
+
+  if (p->shutdown)
+    {
+      *job = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *job = p->first;
+  p->first = (*job)->next;
+  if (!p->first)
+    p->last = NULL;
+
+  (*job)->next = NULL;
+  (*job)->state = prefetch_running;
+
+  return SVN_NO_ERROR;
+}
+
+/* Publish the results of JOB, or dispose of it if the editor drive lost
+   interest in it.  P's mutex must be held. */
+static svn_error_t *
+complete_prefetch_job(prefetch_t *p,
+                      prefetch_job_t *job)
+{
+  if (job->state == prefetch_abandoned)
+    release_prefetch_job(job);
+  else
+    job->state = prefetch_done;
+
+  return svn_error_trace(svn_thread_cond__broadcast(p->cond));
+}
+
+/* Prevent further jobs from being queued in P and return ERR.
+   P's mutex must be held. */
+static svn_error_t *
+fail_prefetch(prefetch_t *p,
+              svn_error_t *err)
+{
+  p->failed = TRUE;
+  return svn_error_trace(err);
+}
+
+/* Process jobs from P's queue until P gets shut down.
+   Use POOL for all allocations. */
+static svn_error_t *
+prefetch_worker_loop(prefetch_t *p,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *t_root;
+  svn_fs_root_t *s_root = NULL;
+  apr_pool_t *s_root_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_error_t *err;
+
+  /* FS instances must not be shared between threads. */
+  err = svn_fs_open2(&fs, p->fs_path, p->fs_config, pool, pool);
+  if (!err)
+    err = svn_fs_revision_root(&t_root, fs, p->t_rev, pool);
+  if (err)
+    SVN_MUTEX__WITH_LOCK(p->mutex, fail_prefetch(p, err));
+
+  while (TRUE)
+    {
+      prefetch_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(p->mutex, next_prefetch_job(&job, p));
+      if (!job)
+        break;
+
+      /* Failures are for the editor drive to deal with. */
+      svn_pool_clear(iterpool);
+      job->err = run_prefetch_job(job, fs, t_root, &s_root, s_root_pool,
+                                  p->text_deltas, iterpool);
+
+      SVN_MUTEX__WITH_LOCK(p->mutex, complete_prefetch_job(p, job));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running prefetch_worker_loop on the prefetch_t in
+   DATA. */
+static void * APR_THREAD_FUNC
+prefetch_worker(apr_thread_t *thread,
+                void *data)
+{
+  prefetch_t *p = data;
+  apr_pool_t *pool = svn_root_pools__acquire_pool(prefetch_pools);
+
+  /* Jobs left in the queue will be handled by the editor drive. */
+  svn_error_clear(prefetch_worker_loop(p, pool));
+  svn_root_pools__release_pool(pool, prefetch_pools);
+
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Shut down and join all worker threads of B's prefetcher, if any,
+   and release all of its resources. */
+static svn_error_t *
+stop_prefetch(report_baton_t *b)
+{
+  prefetch_t *p = b->prefetch;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  if (!p)
+    return SVN_NO_ERROR;
+
+  b->prefetch = NULL;
+  err = svn_mutex__lock(p->mutex);
+  if (!err)
+    {
+      p->shutdown = TRUE;
+      err = svn_mutex__unlock(p->mutex,
+                              svn_thread_cond__broadcast(p->cond));
+    }
+
+  /* We can't safely release anything if we failed to notify the
+     workers. */
+  if (err)
+    return svn_error_trace(err);
+
+#if APR_HAS_THREADS
+  while (p->threads->nelts)
+    {
+      apr_thread_t *thread = *(apr_thread_t **)apr_array_pop(p->threads);
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(status, _("Can't join thread")));
+    }
+#endif
+
+  if (err)
+    return svn_error_trace(err);
+
+  /* No one else is accessing the jobs anymore. */
+  for (hi = apr_hash_first(p->pool, p->jobs); hi; hi = apr_hash_next(hi))
+    release_prefetch_job(apr_hash_this_val(hi));
+
+  svn_pool_destroy(p->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If B->workers is not 0, start that many worker threads computing file
+   deltas and store them in B->prefetch. */
+static svn_error_t *
+start_prefetch(report_baton_t *b)
+{
+#if APR_HAS_THREADS
+  prefetch_t *p;
+  apr_pool_t *pool;
+  int i;
+
+  /* The FS caches are shared between all worker threads. */
+  if (b->workers <= 0 || svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_atomic__init_once(&prefetch_pools_initialized,
+                                create_prefetch_pools, NULL, b->pool));
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  p = apr_pcalloc(pool, sizeof(*p));
+  p->fs_path = b->repos->db_path;
+  p->fs_config = b->fs_config;
+  p->t_rev = b->t_rev;
+  p->text_deltas = b->text_deltas;
+  p->threads = apr_array_make(pool, b->workers, sizeof(apr_thread_t *));
+  p->jobs = apr_hash_make(pool);
+  p->pool = pool;
+  SVN_ERR(svn_mutex__init(&p->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&p->cond, pool));
+
+  /* From here on, stop_prefetch takes care of the cleanup. */
+  b->prefetch = p;
+  for (i = 0; i < b->workers; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status = apr_thread_create(&thread, NULL,
+                                              prefetch_worker, p, pool);
+
+      /* Make do with what we got. */
+      if (status)
+        break;
+
+      APR_ARRAY_PUSH(p->threads, apr_thread_t *) = thread;
+    }
+
+  if (p->threads->nelts == 0)
+    SVN_ERR(stop_prefetch(b));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue a job in P, computing the delta from S_REV/S_PATH to T_PATH, and
+   set *QUEUED.  S_PATH may be NULL for added files.  If P has no room
+   for another job, leave *QUEUED as FALSE.  P's mutex must be held. */
+static svn_error_t *
+queue_prefetch_job(svn_boolean_t *queued,
+                   prefetch_t *p,
+                   svn_revnum_t s_rev,
+                   const char *s_path,
+                   const char *t_path)
+{
+  prefetch_job_t *job;
+  apr_pool_t *pool;
+
+  *queued = FALSE;
+  if (p->failed || p->shutdown
+      || apr_hash_count(p->jobs)
+           >= (unsigned)(PREFETCH_JOBS_PER_WORKER * p->threads->nelts))
+    return SVN_NO_ERROR;
+
+  if (svn_hash_gets(p->jobs, t_path))
+    {
+      *queued = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  pool = svn_root_pools__acquire_pool(prefetch_pools);
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->t_path = apr_pstrdup(pool, t_path);
+  job->s_path = s_path ? apr_pstrdup(pool, s_path) : NULL;
+  job->s_rev = s_rev;
+  job->state = prefetch_queued;
+  job->pool = pool;
+
+  svn_hash_sets(p->jobs, job->t_path, job);
+  if (p->last)
+    p->last->next = job;
+  else
+    p->first = job;
+  p->last = job;
+
+  *queued = TRUE;
+  return svn_error_trace(svn_thread_cond__broadcast(p->cond));
+}
+
+/* Remove JOB from P.  Dispose of it unless a worker thread is still
+   processing it.  P's mutex must be held. */
+static void
+drop_prefetch_job(prefetch_t *p,
+                  prefetch_job_t *job)
+{
+  svn_hash_sets(p->jobs, job->t_path, NULL);
+
+  if (job->state == prefetch_queued)
+    {
+      prefetch_job_t **link = &p->first;
+      prefetch_job_t *prev = NULL;
+
+      while (*link != job)
+        {
+          prev = *link;
+          link = &(*link)->next;
+        }
+
+      *link = job->next;
+      if (p->last == job)
+        p->last = prev;
+    }
+
+  if (job->state == prefetch_running)
+    job->state = prefetch_abandoned;
+  else
+    release_prefetch_job(job);
+}
+
+/* Remove the job for T_PATH from P, if any.  P's mutex must be held. */
+static svn_error_t *
+discard_prefetch_job(prefetch_t *p,
+                     const char *t_path)
+{
+  prefetch_job_t *job = svn_hash_gets(p->jobs, t_path);
+  if (job)
+    drop_prefetch_job(p, job);
+
+  return SVN_NO_ERROR;
+}
+
+/* Take the job for the delta from S_REV/S_PATH to T_PATH from P and
+   return it in *JOB, waiting for its results if necessary.  If no worker
+   thread has picked up that job, yet, discard it and set *JOB to NULL.
+   P's mutex must be held. */
+static svn_error_t *
+take_prefetch_job(prefetch_job_t **job,
+                  prefetch_t *p,
+                  svn_revnum_t s_rev,
+                  const char *s_path,
+                  const char *t_path)
+{
+  prefetch_job_t *found = svn_hash_gets(p->jobs, t_path);
+  svn_boolean_t same_source;
+
+  *job = NULL;
+  if (!found)
+    return SVN_NO_ERROR;
+
+  /* The editor drive may have chosen a different source, e.g. for
+     copies.  Computing the delta ourselves is quicker than waiting for
+     a queued job. */
+  if (found->s_path)
+    same_source = s_path
+               && found->s_rev == s_rev
+               && strcmp(found->s_path, s_path) == 0;
+  else
+    same_source = (s_path == NULL);
+
+  if (found->state == prefetch_queued || !same_source)
+    {
+      drop_prefetch_job(p, found);
+      return SVN_NO_ERROR;
+    }
+
+  while (found->state == prefetch_running)
+    SVN_ERR(svn_thread_cond__wait(p->cond, p->mutex));
+
+  svn_hash_sets(p->jobs, t_path, NULL);
+  *job = found;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Generate the appropriate property editing calls to turn the
    properties of S_REV/S_PATH into those of B->t_root/T_PATH.  If
    S_PATH is NULL, this is an add, so assume the target starts with no
    properties.  Pass OBJECT on to the editor function wrapper
-   CHANGE_FN. */
+   CHANGE_FN.  If JOB is not NULL, use the property lists prefetched
+   for this file. */
 static svn_error_t *
 delta_proplists(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                 const char *t_path, const char *lock_token,
+                const prefetch_job_t *job,
                 proplist_change_fn_t *change_fn,
                 void *object, apr_pool_t *pool)
 {
@@ -568,23 +1154,34 @@ delta_proplists(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                           NULL, pool));
     }
 
-  if (s_path)
+  if (job)
     {
-      svn_boolean_t changed;
-      SVN_ERR(get_source_root(b, &s_root, s_rev));
-
-      /* Is this deltification worth our time? */
-      SVN_ERR(svn_fs_props_different(&changed, b->t_root, t_path, s_root,
-                                     s_path, pool));
-      if (! changed)
+      if (! job->props_changed)
         return SVN_NO_ERROR;
 
-      /* If so, go ahead and get the source path's properties. */
-      SVN_ERR(svn_fs_node_proplist(&s_props, s_root, s_path, pool));
+      s_props = job->s_props;
+      t_props = job->t_props;
     }
+  else
+    {
+      if (s_path)
+        {
+          svn_boolean_t changed;
+          SVN_ERR(get_source_root(b, &s_root, s_rev));
+
+          /* Is this deltification worth our time? */
+          SVN_ERR(svn_fs_props_different(&changed, b->t_root, t_path,
+                                         s_root, s_path, pool));
+          if (! changed)
+            return SVN_NO_ERROR;
+
+          /* If so, go ahead and get the source path's properties. */
+          SVN_ERR(svn_fs_node_proplist(&s_props, s_root, s_path, pool));
+        }
 
-  /* Get the target path's properties */
-  SVN_ERR(svn_fs_node_proplist(&t_props, b->t_root, t_path, pool));
+      /* Get the target path's properties */
+      SVN_ERR(svn_fs_node_proplist(&t_props, b->t_root, t_path, pool));
+    }
 
   if (s_props && apr_hash_count(s_props))
     {
@@ -662,14 +1259,13 @@ send_zero_copy_delta(const unsigned char *contents,
 }
 
 
-/* Make the appropriate edits on FILE_BATON to change its contents and
-   properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
-   possibly using LOCK_TOKEN to determine if the client's lock on the file
-   is defunct. */
+/* Implement delta_files.  If JOB is not NULL, use the results
+   prefetched for this file. */
 static svn_error_t *
-delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
-            const char *s_path, const char *t_path, const char *lock_token,
-            apr_pool_t *pool)
+send_file_deltas(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
+                 const char *s_path, const char *t_path,
+                 const char *lock_token, const prefetch_job_t *job,
+                 apr_pool_t *pool)
 {
   svn_fs_root_t *s_root = NULL;
   svn_txdelta_stream_t *dstream = NULL;
@@ -679,10 +1275,19 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
   void *dbaton;
 
   /* Compare the files' property lists.  */
-  SVN_ERR(delta_proplists(b, s_rev, s_path, t_path, lock_token,
+  SVN_ERR(delta_proplists(b, s_rev, s_path, t_path, lock_token, job,
                           change_file_prop, file_baton, pool));
 
-  if (s_path)
+  if (job)
+    {
+      if (!job->contents_changed)
+        return SVN_NO_ERROR;
+
+      if (s_path)
+        SVN_ERR(get_source_root(b, &s_root, s_rev));
+      s_hex_digest = job->s_hex_digest;
+    }
+  else if (s_path)
     {
       svn_boolean_t changed;
       SVN_ERR(get_source_root(b, &s_root, s_rev));
@@ -710,6 +1315,19 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
+          /* Replay the windows that have already been computed. */
+          if (job && job->windows)
+            {
+              int i;
+
+              for (i = 0; i < job->windows->nelts; ++i)
+                SVN_ERR(dhandler(APR_ARRAY_IDX(job->windows, i,
+                                               svn_txdelta_window_t *),
+                                 dbaton));
+
+              return svn_error_trace(dhandler(NULL, dbaton));
+            }
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -743,6 +1361,38 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
   return SVN_NO_ERROR;
 }
 
+/* Make the appropriate edits on FILE_BATON to change its contents and
+   properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
+   possibly using LOCK_TOKEN to determine if the client's lock on the file
+   is defunct. */
+static svn_error_t *
+delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
+            const char *s_path, const char *t_path, const char *lock_token,
+            apr_pool_t *pool)
+{
+  prefetch_job_t *job = NULL;
+  svn_error_t *err;
+
+  if (b->prefetch)
+    SVN_MUTEX__WITH_LOCK(b->prefetch->mutex,
+                         take_prefetch_job(&job, b->prefetch, s_rev, s_path,
+                                           t_path));
+
+  /* Failed jobs get re-run here to report the error properly. */
+  if (job && job->err)
+    {
+      release_prefetch_job(job);
+      job = NULL;
+    }
+
+  err = send_file_deltas(b, file_baton, s_rev, s_path, t_path, lock_token,
+                         job, pool);
+  if (job)
+    release_prefetch_job(job);
+
+  return svn_error_trace(err);
+}
+
 /* Determine if the user is authorized to view B->t_root/PATH. */
 static svn_error_t *
 check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
@@ -1099,6 +1749,126 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
 
+/* Determine how delta_dirs shall handle the target entry T_ENTRY that
+   has not been mentioned in the report.  Set *SKIP if it is to be
+   ignored.  Otherwise, return the corresponding source entry from
+   S_ENTRIES in *S_ENTRY and its full path below S_PATH in *S_FULLPATH.
+   Both will be NULL if the entry is to be sent as a new one.  WC_DEPTH
+   and REQUESTED_DEPTH are the respective parameters of delta_dirs.
+   Allocate *S_FULLPATH in RESULT_POOL. */
+static void
+select_source_entry(svn_boolean_t *skip,
+                    const svn_fs_dirent_t **s_entry,
+                    const char **s_fullpath,
+                    const svn_fs_dirent_t *t_entry,
+                    apr_hash_t *s_entries,
+                    const char *s_path,
+                    svn_depth_t wc_depth,
+                    svn_depth_t requested_depth,
+                    apr_pool_t *result_pool)
+{
+  *skip = FALSE;
+  *s_entry = NULL;
+  *s_fullpath = NULL;
+
+  if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+    {
+      /* We're making the working copy deeper, pretend the source
+         doesn't exist. */
+      return;
+    }
+
+  if (t_entry->kind == svn_node_file
+      && requested_depth == svn_depth_unknown
+      && wc_depth < svn_depth_files)
+    {
+      *skip = TRUE;
+      return;
+    }
+
+  if (t_entry->kind == svn_node_dir
+      && (wc_depth < svn_depth_immediates
+          || requested_depth == svn_depth_files))
+    {
+      *skip = TRUE;
+      return;
+    }
+
+  /* Look for an entry with the same name in the source dirents. */
+  *s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name) : NULL;
+  *s_fullpath = *s_entry
+              ? svn_fspath__join(s_path, t_entry->name, result_pool)
+              : NULL;
+}
+
+/* Queue prefetch jobs in B for the files in T_ORDERED_ENTRIES, starting
+   at index *NEXT, until B->prefetch is full.  Update *NEXT to the first
+   entry not processed.  The other parameters are the respective
+   parameters of the calling delta_dirs.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prefetch_entries(report_baton_t *b,
+                 int *next,
+                 const apr_array_header_t *t_ordered_entries,
+                 apr_hash_t *s_entries,
+                 svn_revnum_t s_rev,
+                 const char *s_path,
+                 const char *t_path,
+                 svn_depth_t wc_depth,
+                 svn_depth_t requested_depth,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  for (; *next < t_ordered_entries->nelts; ++*next)
+    {
+      const svn_fs_dirent_t *t_entry
+        = APR_ARRAY_IDX(t_ordered_entries, *next, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry;
+      const char *s_fullpath, *t_fullpath;
+      svn_boolean_t skip, queued;
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      svn_pool_clear(iterpool);
+      select_source_entry(&skip, &s_entry, &s_fullpath, t_entry, s_entries,
+                          s_path, wc_depth, requested_depth, iterpool);
+      if (skip)
+        continue;
+
+      if (s_entry)
+        {
+          int distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+
+          /* Unchanged files don't need deltas. */
+          if (distance == 0)
+            continue;
+
+          /* Unrelated files get replaced, possibly by a copy. */
+          if (distance == -1 && !b->ignore_ancestry)
+            {
+              if (b->send_copyfrom_args)
+                continue;
+
+              s_fullpath = NULL;
+            }
+        }
+
+      t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
+      SVN_MUTEX__WITH_LOCK(b->prefetch->mutex,
+                           queue_prefetch_job(&queued, b->prefetch, s_rev,
+                                              s_fullpath, t_fullpath));
+      if (!queued)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Emit edits within directory DIR_BATON (with corresponding path
    E_PATH) with the changes from the directory S_REV/S_PATH to the
    directory B->t_rev/T_PATH.  S_PATH may be NULL if the entry does
@@ -1164,14 +1934,14 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
-  int i;
+  int i, next_prefetch = 0;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
      source path so that we add all the properties.
 
      When we support directory locks, we must pass the lock token here. */
   SVN_ERR(delta_proplists(b, s_rev, start_empty ? NULL : s_path, t_path,
-                          NULL, change_dir_prop, dir_baton, subpool));
+                          NULL, NULL, change_dir_prop, dir_baton, subpool));
   svn_pool_clear(subpool);
 
   if (requested_depth > svn_depth_empty
@@ -1310,34 +2080,21 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
              = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
           const svn_fs_dirent_t *s_entry;
           const char *s_fullpath, *t_fullpath, *e_fullpath;
+          svn_boolean_t skip;
 
           svn_pool_clear(iterpool);
 
-          if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
-            {
-              /* We're making the working copy deeper, pretend the source
-                 doesn't exist. */
-              s_entry = NULL;
-              s_fullpath = NULL;
-            }
-          else
-            {
-              if (t_entry->kind == svn_node_file
-                  && requested_depth == svn_depth_unknown
-                  && wc_depth < svn_depth_files)
-                continue;
-
-              if (t_entry->kind == svn_node_dir
-                  && (wc_depth < svn_depth_immediates
-                      || requested_depth == svn_depth_files))
-                continue;
+          /* Keep the worker threads busy with the files coming up. */
+          if (b->prefetch && next_prefetch < t_ordered_entries->nelts)
+            SVN_ERR(prefetch_entries(b, &next_prefetch, t_ordered_entries,
+                                     s_entries, s_rev, s_path, t_path,
+                                     wc_depth, requested_depth, iterpool));
 
-              /* Look for an entry with the same name in the source dirents. */
-              s_entry = s_entries ?
-                  svn_hash_gets(s_entries, t_entry->name) : NULL;
-              s_fullpath = s_entry ?
-                  svn_fspath__join(s_path, t_entry->name, iterpool) : NULL;
-            }
+          select_source_entry(&skip, &s_entry, &s_fullpath, t_entry,
+                              s_entries, s_path, wc_depth, requested_depth,
+                              iterpool);
+          if (skip)
+            continue;
 
           /* Compose the report, editor, and target paths for this entry. */
           e_fullpath = svn_relpath_join(e_path, t_entry->name, iterpool);
@@ -1348,6 +2105,12 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                DEPTH_BELOW_HERE(wc_depth),
                                DEPTH_BELOW_HERE(requested_depth),
                                iterpool));
+
+          /* Results not used by update_entry are of no use anymore. */
+          if (b->prefetch && t_entry->kind == svn_node_file)
+            SVN_MUTEX__WITH_LOCK(b->prefetch->mutex,
+                                 discard_prefetch_job(b->prefetch,
+                                                      t_fullpath));
         }
 
       /* iterpool is destroyed by destroying its parent (subpool) below */
@@ -1419,6 +2182,64 @@ drive(report_baton_t *b, svn_revnum_t s_rev, path_info_t *info,
   return svn_error_trace(b->editor->close_directory(root_baton, pool));
 }
 
+/* Set *KEY to the checkout cache key for the report in B with the top
+   level path INFO at revision S_REV, allocated in RESULT_POOL.  Set it
+   to NULL if the report is not a plain checkout or cannot be cached for
+   other reasons.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_checkout_cache_key(const char **key,
+                       report_baton_t *b,
+                       const path_info_t *info,
+                       svn_revnum_t s_rev,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_boolean_t supported;
+  apr_int64_t generation;
+  const char *uuid, *instance_id;
+
+  *key = NULL;
+  if (!b->checkout_cache || !b->checkout_cache_view)
+    return SVN_NO_ERROR;
+
+  /* Only a single, empty top-level entry describes a checkout. */
+  if (b->lookahead || !info->start_empty || info->link_path
+      || info->lock_token || info->depth != svn_depth_infinity
+      || (b->requested_depth != svn_depth_infinity
+          && b->requested_depth != svn_depth_unknown))
+    return SVN_NO_ERROR;
+
+  /* The editor drive contains revprops, e.g. svn:author, that may change
+     without a new revision. */
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &generation,
+                                             b->repos->fs, scratch_pool));
+  if (!supported || generation % 2)
+    return SVN_NO_ERROR;
+
+  /* The cache outlives this process.  A repository at the same path may
+     since have been replaced by another one, possibly with the same UUID,
+     or have been recovered.  The instance ID tells them apart. */
+  SVN_ERR(svn_fs__try_get_instance_id(&instance_id, b->repos->fs,
+                                      scratch_pool));
+  if (!instance_id)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(b->repos->fs, &uuid, scratch_pool));
+
+  *key = apr_psprintf(result_pool,
+                      "%s\n%s\n%s\n%s\n%s\n%s\n%ld:%ld:%" APR_INT64_T_FMT
+                      ":%d:%d:%d:%d:%d\n%s",
+                      uuid, instance_id,
+                      svn_repos_path(b->repos, scratch_pool),
+                      b->fs_base, b->s_operand, b->t_path, s_rev, b->t_rev,
+                      generation, b->requested_depth, b->text_deltas,
+                      b->send_copyfrom_args, b->ignore_ancestry,
+                      b->is_switch,
+                      b->checkout_cache_view);
+
+  return SVN_NO_ERROR;
+}
+
 /* Initialize the baton fields for editor-driving, and drive the editor. */
 static svn_error_t *
 finish_report(report_baton_t *b, apr_pool_t *pool)
@@ -1426,6 +2247,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   path_info_t *info;
   apr_pool_t *subpool;
   svn_revnum_t s_rev;
+  const char *cache_key;
   int i;
 
   /* Save our pool to manage the lookahead and fs_root cache with. */
@@ -1466,14 +2288,45 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
       SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
     }
 
+  /* Checkouts may have been recorded before.  Otherwise, record this
+     one for the next client. */
+  SVN_ERR(get_checkout_cache_key(&cache_key, b, info, s_rev, pool, pool));
+  if (cache_key)
+    {
+      svn_boolean_t found;
+      svn_error_t *err;
+
+      err = svn_repos__checkout_cache_replay(&found, b->checkout_cache,
+                                             cache_key, b->editor,
+                                             b->edit_baton, pool);
+      if (err)
+        return svn_error_trace(
+                    svn_error_compose_create(err,
+                                             b->editor->abort_edit(
+                                                          b->edit_baton,
+                                                          pool)));
+      if (found)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_repos__checkout_cache_record(&b->editor, &b->edit_baton,
+                                               b->checkout_cache, cache_key,
+                                               b->editor, b->edit_baton,
+                                               pool));
+    }
+
   /* Open the target root and initialize the source root cache. */
   SVN_ERR(svn_fs_revision_root(&b->t_root, b->repos->fs, b->t_rev, pool));
   for (i = 0; i < NUM_CACHED_SOURCE_ROOTS; i++)
     b->s_roots[i] = NULL;
 
+  /* Start computing file deltas in the background, if enabled. */
+  SVN_ERR(start_prefetch(b));
+
   {
     svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
 
+    /* The worker threads must be gone before we return. */
+    err = svn_error_compose_create(err, stop_prefetch(b));
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
 
@@ -1579,6 +2432,37 @@ svn_repos_abort_report(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos__report_set_workers(void *report_baton,
+                              int workers,
+                              apr_hash_t *fs_config)
+{
+  report_baton_t *b = report_baton;
+
+  if (workers < 0)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Invalid number of report workers %d"),
+                             workers);
+
+  b->workers = workers;
+  b->fs_config = fs_config;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__report_set_checkout_cache(void *report_baton,
+                                     svn_repos__checkout_cache_t *cache,
+                                     const char *view)
+{
+  report_baton_t *b = report_baton;
+
+  b->checkout_cache = cache;
+  b->checkout_cache_view = view;
+
+  return SVN_NO_ERROR;
+}
+
 /* --- BEGINNING THE REPORT --- */
 
 
@@ -1620,6 +2504,9 @@ svn_repos_begin_report3(void **report_baton,
                           : svn_fspath__join(b->fs_base, s_operand, pool);
   b->text_deltas = text_deltas;
   b->zero_copy_limit = zero_copy_limit;
+  b->workers = 0;
+  b->fs_config = NULL;
+  b->prefetch = NULL;
   b->requested_depth = depth;
   b->ignore_ancestry = ignore_ancestry;
   b->send_copyfrom_args = send_copyfrom_args;
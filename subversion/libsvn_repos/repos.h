@@ -28,6 +28,9 @@
 
 #include "svn_fs.h"
 #include "svn_config.h"
+#include "svn_delta.h"
+
+#include "private/svn_repos_private.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -153,6 +156,11 @@ struct svn_repos_t
      those constants' addresses, therefore). */
   apr_hash_t *repository_capabilities;
 
+  /* Number of worker threads preparing log entries and the FS config to
+     open their FS instances with.  See svn_repos__set_log_workers. */
+  int log_workers;
+  apr_hash_t *log_fs_config;
+
   /* Pool from which this structure was allocated.  Also used for
      auxiliary repository-related data that requires a matching
      lifespan.  (As the svn_repos_t structure tends to be relatively
@@ -387,6 +395,44 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+
+/*** Checkout Cache ***/
+
+/* Look up the editor drive recorded for KEY in CACHE.  If there is one,
+   replay it to EDITOR / EDIT_BATON, including close_edit(), and set
+   *FOUND to TRUE.  Otherwise, set *FOUND to FALSE and leave EDITOR
+   untouched.  Use SCRATCH_POOL for temporary allocations.
+
+   EDITOR's calls will be strictly nested, the way the reporter drives
+   its editors.  */
+svn_error_t *
+svn_repos__checkout_cache_replay(svn_boolean_t *found,
+                                 svn_repos__checkout_cache_t *cache,
+                                 const char *key,
+                                 const svn_delta_editor_t *editor,
+                                 void *edit_baton,
+                                 apr_pool_t *scratch_pool);
+
+/* Set *EDITOR and *EDIT_BATON to an editor that forwards all calls to
+   WRAPPED_EDITOR / WRAPPED_EDIT_BATON and records them in CACHE under
+   KEY.  The recording becomes visible to svn_repos__checkout_cache_replay()
+   only once the edit has been closed successfully.  Failure to record
+   the drive is not an error.  Allocate the result in RESULT_POOL.
+
+   Text deltas get recorded in full, even if WRAPPED_EDITOR discards them,
+   because a replay may go to an editor that wants them.  Hence, whether
+   the consumer of a drive wants text deltas need not be part of KEY.
+
+   The editor must be driven in strictly nested order.  */
+svn_error_t *
+svn_repos__checkout_cache_record(const svn_delta_editor_t **editor,
+                                 void **edit_baton,
+                                 svn_repos__checkout_cache_t *cache,
+                                 const char *key,
+                                 const svn_delta_editor_t *wrapped_editor,
+                                 void *wrapped_edit_baton,
+                                 apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -3478,3 +3478,23 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
 
   return info;
 }
+
+void
+svn_cache__membuffer_get_global_access_stats(apr_uint64_t *gets,
+                                             apr_uint64_t *hits)
+{
+  apr_uint32_t i;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+
+  *gets = 0;
+  *hits = 0;
+
+  /* No locking here.  The counters are only ever incremented, so a
+   * slightly stale or torn read merely under-reports a few accesses. */
+  if (membuffer)
+    for (i = 0; i < membuffer->segment_count; ++i)
+      {
+        *gets += membuffer[i].total_reads;
+        *hits += membuffer[i].total_hits;
+      }
+}
@@ -22,6 +22,7 @@
  */
 
 #include <apr_portable.h>
+#include <apr_thread_cond.h>
 
 #include "svn_private_config.h"
 #include "private/svn_atomic.h"
@@ -106,6 +107,63 @@ svn_mutex__unlock(svn_mutex__t *mutex,
   return err;
 }
 
+struct svn_thread_cond__t
+{
+#if APR_HAS_THREADS
+
+  apr_thread_cond_t *cond;
+
+#else
+
+  /* Truly empty structs are not allowed. */
+  int dummy;
+
+#endif
+};
+
+svn_error_t *
+svn_thread_cond__create(svn_thread_cond__t **cond_p,
+                        apr_pool_t *result_pool)
+{
+  svn_thread_cond__t *cond = apr_pcalloc(result_pool, sizeof(*cond));
+
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_create(&cond->cond, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+#endif
+
+  *cond_p = cond;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_cond__broadcast(svn_thread_cond__t *cond)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_broadcast(cond->cond);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't broadcast condition variable"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_cond__wait(svn_thread_cond__t *cond,
+                      svn_mutex__t *mutex)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_wait(cond->cond, mutex->mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 #if APR_HAS_THREADS
 
 apr_thread_mutex_t *
@@ -37,6 +37,7 @@
 #include "svn_path.h"
 #include "svn_xml.h"
 #include "private/svn_dav_protocol.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_skel.h"
 #include "mod_authz_svn.h"
 
@@ -182,7 +183,8 @@ enum dav_svn_private_restype {
   DAV_SVN_RESTYPE_REV_COLLECTION,       /* .../!svn/rev/ */
   DAV_SVN_RESTYPE_REVROOT_COLLECTION,   /* .../!svn/rvr/ */
   DAV_SVN_RESTYPE_TXN_COLLECTION,       /* .../!svn/txn/ */
-  DAV_SVN_RESTYPE_TXNROOT_COLLECTION    /* .../!svn/txr/ */
+  DAV_SVN_RESTYPE_TXNROOT_COLLECTION,   /* .../!svn/txr/ */
+  DAV_SVN_RESTYPE_SHA1_COLLECTION       /* .../!svn/sha1/ */
 };
 
 
@@ -303,6 +305,10 @@ struct dav_resource_private {
   /* whether this resource parameters are fixed and won't change
      between requests. */
   svn_boolean_t idempotent;
+
+  /* For file contents addressed by .../!svn/sha1/DIGEST: the hex SHA1
+     DIGEST.  NULL for all other resources. */
+  const char *sha1_digest;
 };
 
 
@@ -425,9 +431,16 @@ const char *dav_svn__get_root_dir(request_rec *r);
 /* Return the data compression level to be used over the wire. */
 int dav_svn__get_compression_level(request_rec *r);
 
+/* Return the cache of recorded checkouts, or NULL if not configured. */
+svn_repos__checkout_cache_t *dav_svn__get_checkout_cache(request_rec *r);
+
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
+/* Return the number of worker threads that prepare log entries for the
+ * repository referred to by this request. */
+int dav_svn__get_log_workers(request_rec *r);
+
 /** For HTTP protocol v2, these are the new URIs and URI stubs
     returned to the client in our OPTIONS response.  They all depend
     on the 'special uri', which is configurable in httpd.conf.  **/
@@ -453,6 +466,9 @@ const char *dav_svn__get_vtxn_stub(request_rec *r);
 /* For accessing transaction properties (typically "!svn/vtxr") */
 const char *dav_svn__get_vtxn_root_stub(request_rec *r);
 
+/* For accessing file contents by their SHA1 (typically "!svn/sha1") */
+const char *dav_svn__get_sha1_stub(request_rec *r);
+
 
 /*** Output helpers ***/
 
@@ -532,7 +548,9 @@ int dav_svn__status(request_rec *r);
 
 /*** repos.c ***/
 
-/* generate an ETag for RESOURCE and return it, allocated in POOL. */
+/* generate an ETag for RESOURCE and return it, allocated in POOL.
+   Immutable file contents get a strong ETag based on their SHA1 checksum,
+   everything else a weak or revision-based one. */
 const char *
 dav_svn__getetag(const dav_resource *resource, apr_pool_t *pool);
 
@@ -40,6 +40,7 @@
 #include "svn_utf.h"
 #include "svn_ctype.h"
 #include "svn_dso.h"
+#include "svn_dirent_uri.h"
 #include "mod_dav_svn.h"
 
 #include "private/svn_fspath.h"
@@ -57,6 +58,9 @@
  * subreq mechanism and make a call directly to mod_authz_svn. */
 #define PATHAUTHZ_BYPASS_ARG "short_circuit"
 
+/* Default size limit of the checkout cache in MB. */
+#define CHECKOUT_CACHE_SIZE 1024
+
 /* per-server configuration */
 typedef struct server_conf_t {
   const char *special_uri;
@@ -67,6 +71,12 @@ typedef struct server_conf_t {
      compression level. */
   int compression_level;
 
+  /* Directory and size limit in MB of the checkout cache.  Size 0 means
+     "use the default".  The cache itself gets created in init(). */
+  const char *checkout_cache_dir;
+  apr_uint64_t checkout_cache_size;
+  svn_repos__checkout_cache_t *checkout_cache;
+
 } server_conf_t;
 
 
@@ -108,6 +118,7 @@ typedef struct dir_conf_t {
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
   const char *hooks_env;             /* path to hook script env config file */
+  int log_workers;                   /* threads preparing log entries */
 } dir_conf_t;
 
 
@@ -150,6 +161,30 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* Virtual hosts may use different checkout caches. */
+  for (; s; s = s->next)
+    {
+      conf = ap_get_module_config(s->module_config, &dav_svn_module);
+      if (!conf->checkout_cache_dir)
+        continue;
+
+      serr = svn_repos__checkout_cache_create(
+                 &conf->checkout_cache, conf->checkout_cache_dir,
+                 (conf->checkout_cache_size ? conf->checkout_cache_size
+                                            : CHECKOUT_CACHE_SIZE)
+                   * 0x100000,
+                 p);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                        "mod_dav_svn: error creating the checkout cache "
+                        "'%s': '%s'", conf->checkout_cache_dir,
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+          return HTTP_INTERNAL_SERVER_ERROR;
+        }
+    }
+
   return OK;
 }
 
@@ -219,6 +254,10 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
   newconf = apr_pcalloc(p, sizeof(*newconf));
 
   newconf->special_uri = INHERIT_VALUE(parent, child, special_uri);
+  newconf->checkout_cache_dir = INHERIT_VALUE(parent, child,
+                                              checkout_cache_dir);
+  newconf->checkout_cache_size = INHERIT_VALUE(parent, child,
+                                               checkout_cache_size);
 
   if (child->compression_level < 0)
     {
@@ -285,6 +324,7 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
+  newconf->log_workers = INHERIT_VALUE(parent, child, log_workers);
 
   if (parent->fs_path)
     ap_log_error(APLOG_MARK, APLOG_WARNING, 0, NULL,
@@ -652,6 +692,40 @@ SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNCheckoutCacheDir_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->checkout_cache_dir = svn_dirent_internal_style(arg1, cmd->pool);
+
+  if (!svn_dirent_is_absolute(conf->checkout_cache_dir))
+    return "SVNCheckoutCacheDir must be an absolute path.";
+
+  return NULL;
+}
+
+static const char *
+SVNCheckoutCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err || value == 0)
+    {
+      svn_error_clear(err);
+      return "Invalid positive decimal number for the checkout cache size.";
+    }
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->checkout_cache_size = value;
+
+  return NULL;
+}
+
 static const char *
 SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -674,6 +748,26 @@ SVNHooksEnv_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNLogWorkers_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the number of log workers.";
+    }
+
+  if (value < 0)
+    return "The number of log workers must not be negative.";
+
+  conf->log_workers = value;
+
+  return NULL;
+}
+
 static svn_boolean_t
 get_conf_flag(enum conf_flag flag, svn_boolean_t default_value)
 {
@@ -876,6 +970,14 @@ dav_svn__get_vtxn_root_stub(request_rec *r)
 }
 
 
+const char *
+dav_svn__get_sha1_stub(request_rec *r)
+{
+  return apr_pstrcat(r->pool, dav_svn__get_special_uri(r), "/sha1",
+                     SVN_VA_NULL);
+}
+
+
 svn_boolean_t
 dav_svn__get_autoversioning_flag(request_rec *r)
 {
@@ -1027,6 +1129,17 @@ dav_svn__get_block_read_flag(request_rec *r)
   return get_conf_flag(conf->block_read, FALSE);
 }
 
+svn_repos__checkout_cache_t *
+dav_svn__get_checkout_cache(request_rec *r)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(r->server->module_config,
+                              &dav_svn_module);
+
+  return conf->checkout_cache;
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1054,6 +1167,15 @@ dav_svn__get_hooks_env(request_rec *r)
   return conf->hooks_env;
 }
 
+int
+dav_svn__get_log_workers(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->log_workers;
+}
+
 static void
 merge_xml_filter_insert(request_rec *r)
 {
@@ -1395,6 +1517,21 @@ static const command_rec cmds[] =
                 "content over the network (0 for no compression, 9 for "
                 "maximum, 5 is default)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNCheckoutCacheDir", SVNCheckoutCacheDir_cmd, NULL,
+                RSRC_CONF,
+                "specifies a directory in which to keep recorded checkouts. "
+                "Checkouts of the same path and revision get replayed from "
+                "there if no path-based authorization is active "
+                "(default is no checkout cache)."),
+
+  /* per server */
+  AP_INIT_TAKE1("SVNCheckoutCacheSize", SVNCheckoutCacheSize_cmd, NULL,
+                RSRC_CONF,
+                "specifies the size limit in MB of the checkout cache "
+                "directory; the least recently used checkouts get removed "
+                "when it is exceeded (default is 1024)."),
+
   /* per server */
   AP_INIT_FLAG("SVNUseUTF8",
                SVNUseUTF8_cmd, NULL,
@@ -1408,6 +1545,13 @@ static const command_rec cmds[] =
                 "of hook scripts. If not absolute, the path is relative to "
                 "the repository's conf directory (by default the hooks-env "
                 "file in the repository is used)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNLogWorkers", SVNLogWorkers_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the number of additional threads per log request "
+                "that read changed paths and revision properties ahead of "
+                "sending them (default is 0)."),
   { NULL }
 };
 
@@ -86,6 +86,10 @@ typedef struct update_ctx_t {
      inline.  (This is implied when "send_all" is set.)  */
   svn_boolean_t include_props;
 
+  /* In skelta mode, the contents of files up to this size are sent
+     inline, just like in "send_all" mode.  0 if disabled. */
+  svn_filesize_t inline_max_size;
+
   /* SVNDIFF version to send to client.  */
   int svndiff_version;
 
@@ -127,6 +131,9 @@ typedef struct item_baton_t {
   /* File/dir copied? */
   svn_boolean_t copyfrom;
 
+  /* File contents sent inline in skelta mode? */
+  svn_boolean_t inlined;
+
   /* Array of const char * names of removed properties.  (Used only
      for copied files/dirs in skelta mode.)  */
   apr_array_header_t *removed_props;
@@ -136,6 +143,10 @@ typedef struct item_baton_t {
 
 #define DIR_OR_FILE(is_dir) ((is_dir) ? "directory" : "file")
 
+/* Upper limit for the inline-max-size requested by clients.  Larger files
+   are better fetched with separate, parallel GET requests. */
+#define MAX_INLINE_FILE_SIZE (64 * 1024)
+
 
 /* add PATH to the pathmap HASH with a repository path of LINKPATH.
    if LINKPATH is NULL, PATH will map to itself. */
@@ -335,6 +346,7 @@ add_helper(svn_boolean_t is_dir,
       const char *real_path = get_real_fs_path(child, pool);
       const char *bc_url_str = "";
       const char *sha1_checksum_str = "";
+      const char *size_str = "";
 
       if (is_dir)
         {
@@ -374,25 +386,36 @@ add_helper(svn_boolean_t is_dir,
             sha1_checksum_str =
               apr_psprintf(pool, " sha1-checksum=\"%s\"",
                            svn_checksum_to_cstring(sha1_checksum, pool));
+
+          /* Let skelta mode clients schedule their GETs by size. */
+          if (! uc->send_all)
+            {
+              svn_filesize_t size;
+
+              SVN_ERR(svn_fs_file_length(&size, uc->rev_root, real_path,
+                                         pool));
+              size_str = apr_psprintf(pool, " size=\"%" SVN_FILESIZE_T_FMT
+                                      "\"", size);
+            }
         }
 
       if (copyfrom_path == NULL)
         {
           elt = apr_psprintf(pool,
-                             "<S:add-%s name=\"%s\"%s%s>" DEBUG_CR,
+                             "<S:add-%s name=\"%s\"%s%s%s>" DEBUG_CR,
                              DIR_OR_FILE(is_dir), qname, bc_url_str,
-                             sha1_checksum_str);
+                             sha1_checksum_str, size_str);
         }
       else
         {
           const char *qcopy = apr_xml_quote_string(pool, copyfrom_path, 1);
 
           elt = apr_psprintf(pool,
-                             "<S:add-%s name=\"%s\"%s%s "
+                             "<S:add-%s name=\"%s\"%s%s%s "
                              "copyfrom-path=\"%s\" copyfrom-rev=\"%ld\">"
                              DEBUG_CR,
                              DIR_OR_FILE(is_dir),
-                             qname, bc_url_str, sha1_checksum_str,
+                             qname, bc_url_str, sha1_checksum_str, size_str,
                              qcopy, copyfrom_revision);
           child->copyfrom = TRUE;
         }
@@ -482,13 +505,22 @@ maybe_start_update_report(update_ctx_t *uc)
 {
   if ((! uc->resource_walk) && (! uc->started_update))
     {
+      const char *inline_size_str = "";
+
+      if (uc->inline_max_size)
+        inline_size_str = apr_psprintf(uc->resource->pool,
+                                       " inline-max-size=\"%"
+                                       SVN_FILESIZE_T_FMT "\"",
+                                       uc->inline_max_size);
+
       SVN_ERR(dav_svn__brigade_printf(
                   uc->bb, uc->output,
                   DAV_XML_HEADER DEBUG_CR "<S:update-report xmlns:S=\""
                   SVN_XML_NAMESPACE "\" xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
-                  "xmlns:D=\"DAV:\" %s %s>" DEBUG_CR,
+                  "xmlns:D=\"DAV:\" %s %s%s>" DEBUG_CR,
                   uc->send_all ? "send-all=\"true\"" : "",
-                  uc->include_props ? "inline-props=\"true\"" : ""));
+                  uc->include_props ? "inline-props=\"true\"" : "",
+                  inline_size_str));
 
       uc->started_update = TRUE;
     }
@@ -811,9 +843,22 @@ upd_apply_textdelta(void *file_baton,
   file->base_checksum = apr_pstrdup(file->pool, base_checksum);
   file->text_changed = TRUE;
 
+  /* In skelta mode, small files may be sent inline if the client
+     asked for that.  This is decided per request, also when the edit
+     is replayed from the checkout cache. */
+  if (!file->uc->resource_walk && !file->uc->send_all
+      && file->uc->inline_max_size)
+    {
+      svn_filesize_t size;
+
+      SVN_ERR(svn_fs_file_length(&size, file->uc->rev_root,
+                                 get_real_fs_path(file, pool), pool));
+      file->inlined = (size <= file->uc->inline_max_size);
+    }
+
   /* If this is a resource walk, or if we're not in "send-all" mode,
      we don't actually want to transmit text-deltas. */
-  if (file->uc->resource_walk || (! file->uc->send_all))
+  if (file->uc->resource_walk || (! file->uc->send_all && ! file->inlined))
     {
       *handler = svn_delta_noop_window_handler;
       *handler_baton = NULL;
@@ -846,10 +891,12 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
 
   /* If we are not in "send all" mode, and this file is not a new
      addition or didn't otherwise have changed text, tell the client
-     to fetch it. */
-  if ((! file->uc->send_all) && (! file->added) && file->text_changed)
+     to fetch it -- unless we already sent its contents inline. */
+  if ((! file->uc->send_all) && (! file->added) && file->text_changed
+      && (! file->inlined))
     {
       svn_checksum_t *sha1_checksum;
+      svn_filesize_t size;
       const char *real_path = get_real_fs_path(file, pool);
       const char *sha1_digest = NULL;
 
@@ -860,15 +907,21 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
       if (sha1_checksum)
         sha1_digest = svn_checksum_to_cstring(sha1_checksum, pool);
 
+      /* The fulltext size is an upper bound for the delta we will send. */
+      SVN_ERR(svn_fs_file_length(&size, file->uc->rev_root, real_path,
+                                 pool));
+
       SVN_ERR(dav_svn__brigade_printf
               (file->uc->bb, file->uc->output,
-               "<S:fetch-file%s%s%s%s%s%s/>" DEBUG_CR,
+               "<S:fetch-file%s%s%s%s%s%s size=\"%" SVN_FILESIZE_T_FMT
+               "\"/>" DEBUG_CR,
                file->base_checksum ? " base-checksum=\"" : "",
                file->base_checksum ? file->base_checksum : "",
                file->base_checksum ? "\"" : "",
                sha1_digest ? " sha1-checksum=\"" : "",
                sha1_digest ? sha1_digest : "",
-               sha1_digest ? "\"" : ""));
+               sha1_digest ? "\"" : "",
+               size));
     }
 
   if (text_checksum)
@@ -1164,8 +1217,31 @@ dav_svn__update_report(const dav_resource *resource,
           if (strcmp(cdata, "no") != 0)
             uc.include_props = TRUE;
         }
+      if (child->ns == ns && strcmp(child->name, "inline-max-size") == 0)
+        {
+          apr_int64_t size;
+
+          cdata = dav_xml_get_cdata(child, resource->pool, 1);
+          if (! *cdata)
+            return malformed_element_error(child->name, resource->pool);
+          serr = svn_cstring_atoi64(&size, cdata);
+          if (serr)
+            {
+              svn_error_clear(serr);
+              return malformed_element_error(child->name, resource->pool);
+            }
+          if (size > 0)
+            uc.inline_max_size = (size < MAX_INLINE_FILE_SIZE)
+                                   ? (svn_filesize_t)size
+                                   : MAX_INLINE_FILE_SIZE;
+        }
     }
 
+  /* Inlining files only makes sense for skelta mode reports that
+     transmit contents at all. */
+  if (uc.send_all || ! text_deltas)
+    uc.inline_max_size = 0;
+
   /* If a target revision wasn't requested, or the requested target
      revision was invalid, just update to HEAD as of the moment we
      queried the youngest revision.  Otherwise, at least make sure the
@@ -1244,8 +1320,10 @@ dav_svn__update_report(const dav_resource *resource,
 
   /* If the client did *not* request 'send-all' mode, then we will be
      sending only a "skelta" of the difference, which will not need to
-     contain actual text deltas. */
-  if (! uc.send_all)
+     contain actual text deltas -- except for the small files that the
+     client asked us to inline.  (The delta of the others won't be
+     calculated because we use a noop window handler for them.) */
+  if (! uc.send_all && ! uc.inline_max_size)
     text_deltas = FALSE;
 
   /* When we call svn_repos_finish_report, it will ultimately run
@@ -1288,6 +1366,23 @@ dav_svn__update_report(const dav_resource *resource,
                                   resource->pool);
     }
 
+  /* Recorded checkouts are only valid for a single authz view.  We can't
+     identify those of path-based authz, so only use them without it.
+     Send-all mode and the inline size don't matter: text deltas are
+     always recorded in full and we decide what to send on replay. */
+  if (dav_svn__get_checkout_cache(resource->info->r)
+      && dav_svn__authz_read_func(&arb) == NULL)
+    {
+      serr = svn_repos__report_set_checkout_cache(
+                 rbaton, dav_svn__get_checkout_cache(resource->info->r),
+                 "mod_dav_svn:no-path-authz");
+      if (serr)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "The checkout cache could not be "
+                                    "enabled.",
+                                    resource->pool);
+    }
+
   /* scan the XML doc for state information */
   for (child = doc->root->first_child; child != NULL; child = child->next)
     if (child->ns == ns)
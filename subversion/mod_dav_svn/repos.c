@@ -26,6 +26,7 @@
 #include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_lib.h>
+#include <apr_sha1.h>
 
 #include <httpd.h>
 #include <http_request.h>
@@ -597,6 +598,40 @@ parse_vtxnroot_uri(dav_resource_combined *comb,
 }
 
 
+static int
+parse_sha1_uri(dav_resource_combined *comb,
+               const char *path,
+               const char *label,
+               int use_checked_in)
+{
+  /* format: !svn/sha1/DIGEST
+
+     In HTTP protocol v2, this represents the file contents with the
+     given (lowercase hex) SHA1 digest, wherever they live in the
+     repository.  Clients GET it so that caches can share identical
+     contents across paths.  Which file to read the contents from is
+     only known once we see the request's SVN_DAV_SHA1_SOURCE_HEADER;
+     see parse_sha1_source().
+   */
+  int i;
+
+  for (i = 0; i < 2 * APR_SHA1_DIGESTSIZE; i++)
+    if (! svn_ctype_isxdigit(path[i]) || svn_ctype_isupper(path[i]))
+      return TRUE;
+
+  if (path[i] != '\0')
+    return TRUE;
+
+  comb->res.type = DAV_RESOURCE_TYPE_REGULAR;
+  comb->res.versioned = TRUE;
+  comb->priv.sha1_digest = apr_pstrdup(comb->res.pool, path);
+
+  /* NOTE: comb->priv.repos_path == NULL */
+
+  return FALSE;
+}
+
+
 static int
 parse_wrk_baseline_uri(dav_resource_combined *comb,
                        const char *path,
@@ -678,6 +713,7 @@ static const struct special_defn
   { "txr", parse_txnroot_uri, 1, TRUE, DAV_SVN_RESTYPE_TXNROOT_COLLECTION},
   { "vtxn", parse_vtxnstub_uri, 1, FALSE, DAV_SVN_RESTYPE_TXN_COLLECTION},
   { "vtxr", parse_vtxnroot_uri, 1, TRUE, DAV_SVN_RESTYPE_TXNROOT_COLLECTION},
+  { "sha1", parse_sha1_uri, 1, FALSE, DAV_SVN_RESTYPE_SHA1_COLLECTION },
 
   { NULL } /* sentinel */
 };
@@ -2156,6 +2192,104 @@ parse_querystring(request_rec *r, const char *query,
   return NULL;
 }
 
+/* Helper for get_resource().
+ *
+ * Given a COMB object parsed from a "!svn/sha1/DIGEST" URI, parse the
+ * PEGREV/PATH in the SVN_DAV_SHA1_SOURCE_HEADER of R, and modify COMB
+ * so that prep_regular() opens that file.
+ */
+static dav_error *
+parse_sha1_source(request_rec *r,
+                  dav_resource_combined *comb,
+                  apr_pool_t *pool)
+{
+  const char *source = apr_table_get(r->headers_in,
+                                     SVN_DAV_SHA1_SOURCE_HEADER);
+  const char *slash;
+  char *path;
+  svn_revnum_t revnum;
+
+  /* Contents are all there is to these resources. */
+  if (r->method_number != M_GET)
+    return dav_svn__new_error(pool, HTTP_METHOD_NOT_ALLOWED, 0, 0,
+                              "Contents addressed by their SHA1 can only "
+                              "be fetched with GET.");
+
+  if (source == NULL)
+    return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
+                              "Missing " SVN_DAV_SHA1_SOURCE_HEADER
+                              " header.");
+
+  revnum = SVN_STR_TO_REV(source);  /* assume slash terminates conversion */
+  slash = ap_strchr_c(source, '/');
+  if (!SVN_IS_VALID_REVNUM(revnum) || slash == NULL)
+    return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
+                              "Invalid " SVN_DAV_SHA1_SOURCE_HEADER
+                              " header.");
+
+  path = apr_pstrdup(pool, slash);
+  if (ap_unescape_url(path) != OK)
+    return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
+                              "Invalid " SVN_DAV_SHA1_SOURCE_HEADER
+                              " header.");
+
+  comb->priv.root.rev = revnum;
+  comb->priv.repos_path = svn_fspath__canonicalize(path, pool);
+
+  return NULL;
+}
+
+/* Helper for get_resource().
+ *
+ * Given a prepared COMB object for a "!svn/sha1/DIGEST" URI, verify that
+ * R may read the file that COMB has been located at and that the file
+ * has the requested contents.
+ */
+static dav_error *
+check_sha1_resource(request_rec *r,
+                    dav_resource_combined *comb,
+                    apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  svn_error_t *serr;
+
+  /* mod_authz_svn only knows that the user may read *something* in this
+     repository.  Check the actual source path. */
+  if (! dav_svn__allow_read(r, comb->priv.repos, comb->priv.repos_path,
+                            comb->priv.root.rev, pool))
+    return dav_svn__new_error(pool, HTTP_FORBIDDEN, 0, 0,
+                              "Access to the source of the requested "
+                              "contents is forbidden.");
+
+  /* The response must depend on nothing but the URI. */
+  if (comb->priv.keyword_subst
+      || apr_table_get(r->headers_in, SVN_DAV_DELTA_BASE_HEADER))
+    return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
+                              "Contents addressed by their SHA1 are only "
+                              "available as fulltext.");
+
+  if (! comb->res.exists || comb->res.collection)
+    return dav_svn__new_error(pool, HTTP_NOT_FOUND, 0, 0,
+                              "The source of the requested contents is "
+                              "not a file.");
+
+  serr = svn_fs_file_checksum(&checksum, svn_checksum_sha1,
+                              comb->priv.root.root, comb->priv.repos_path,
+                              TRUE, pool);
+  if (serr != NULL)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Could not get the SHA1 checksum of the "
+                                "source.", pool);
+
+  if (strcmp(svn_checksum_to_cstring_display(checksum, pool),
+             comb->priv.sha1_digest) != 0)
+    return dav_svn__new_error(pool, HTTP_NOT_FOUND, 0, 0,
+                              "The source does not have the requested "
+                              "contents.");
+
+  return NULL;
+}
+
 static dav_error *
 get_resource(request_rec *r,
              const char *root_path,
@@ -2480,6 +2614,10 @@ get_resource(request_rec *r,
         return dav_svn__sanitize_error(serr,
                                        "Error settings hooks environment",
                                        HTTP_INTERNAL_SERVER_ERROR, r);
+
+      /* Let log requests prepare upcoming entries on worker threads. */
+      svn_repos__set_log_workers(repos->repos, dav_svn__get_log_workers(r),
+                                 fs_config);
     }
 
   /* cache the filesystem object */
@@ -2587,6 +2725,12 @@ get_resource(request_rec *r,
       && ((err = parse_querystring(r, r->parsed_uri.query, comb, r->pool))))
     return err;
 
+  /* Contents addressed by their SHA1 are read from the path named in
+     the request.  */
+  if (comb->priv.sha1_digest
+      && ((err = parse_sha1_source(r, comb, r->pool))))
+    return err;
+
 #ifdef SVN_DEBUG
   if (comb->res.type == DAV_RESOURCE_TYPE_UNKNOWN)
     {
@@ -2601,6 +2745,10 @@ get_resource(request_rec *r,
   if ((err = prep_resource(comb)) != NULL)
     return err;
 
+  if (comb->priv.sha1_digest
+      && ((err = check_sha1_resource(r, comb, r->pool))))
+    return err;
+
   /* a GET request for a REGULAR collection resource MUST have a trailing
      slash. Redirect to include one if it does not. */
   if (comb->res.collection && comb->res.type == DAV_RESOURCE_TYPE_REGULAR
@@ -3109,6 +3257,32 @@ dav_svn__getetag(const dav_resource *resource, apr_pool_t *pool)
 
   /* ### what kind of etag to return for activities, etc.? */
 
+  /* The plain contents of a file addressed by a fixed revision can never
+     change, so its SHA1 checksum makes a strong ETag that even identifies
+     equal contents across revisions.  FSFS keeps that checksum in the
+     node-revision, i.e. we don't need to touch the fulltext here.  Keyword
+     expanded texts and svndiffs are different representations of the
+     same resource and keep using the revision-based ETag below. */
+  if (resource->info->idempotent
+      && !resource->collection
+      && !resource->info->keyword_subst
+      && resource->info->delta_base == NULL)
+    {
+      svn_checksum_t *checksum;
+
+      serr = svn_fs_file_checksum(&checksum, svn_checksum_sha1,
+                                  resource->info->root.root,
+                                  resource->info->repos_path,
+                                  FALSE, pool);
+      if (serr)
+        svn_error_clear(serr);
+      else if (checksum)
+        return apr_psprintf(pool, "\"sha1-%s\"",
+                            svn_checksum_to_cstring(checksum, pool));
+
+      /* Older repositories may not have stored a SHA1 checksum. */
+    }
+
   if ((serr = svn_fs_node_created_rev(&created_rev, resource->info->root.root,
                                       resource->info->repos_path,
                                       pool)))
@@ -3167,11 +3341,14 @@ set_headers(request_rec *r, const dav_resource *resource)
   svn_error_t *serr;
   svn_filesize_t length;
   const char *mimetype = NULL;
+  svn_boolean_t cacheable = is_cacheable(r, resource);
 
-  /* As version resources don't change, encourage caching. */
-  if (is_cacheable(r, resource))
+  /* As version resources don't change, encourage caching.  Tell caches
+     that they don't even need to revalidate them. */
+  if (cacheable)
     /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   "max-age=604800, immutable");
   else
     apr_table_setn(r->headers_out, "Cache-Control", "max-age=0");
 
@@ -3182,6 +3359,15 @@ set_headers(request_rec *r, const dav_resource *resource)
   apr_table_setn(r->headers_out, "ETag",
                  dav_svn__getetag(resource, resource->pool));
 
+  /* mod_dav will answer a conditional GET right after we return and the
+     ETag is all that ap_meets_conditions() needs.  For revalidations of
+     immutable resources, skip looking up the MIME type and the length of
+     the contents. */
+  if (cacheable
+      && apr_table_get(r->headers_in, "If-None-Match")
+      && ap_meets_conditions(r) == HTTP_NOT_MODIFIED)
+    return NULL;
+
   /* we accept byte-ranges */
   apr_table_setn(r->headers_out, "Accept-Ranges", "bytes");
 
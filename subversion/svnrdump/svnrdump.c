@@ -342,7 +342,8 @@ init_client_context(svn_client_ctx_t **ctx_p,
      ### options in order to get ra_serf to try a bulk-update if the
      ### server will allow it, or at least try to limit all its
      ### auxiliary GETs/PROPFINDs to happening (well-ordered) on a
-     ### single server connection.
+     ### single server connection.  The same goes for 'http2', which
+     ### would multiplex the GETs/PROPFINDs on that connection.
      ###
      ### See http://subversion.tigris.org/issues/show_bug.cgi?id=4116.
   */
@@ -351,6 +352,8 @@ init_client_context(svn_client_ctx_t **ctx_p,
                       SVN_CONFIG_OPTION_HTTP_BULK_UPDATES, TRUE);
   svn_config_set_int64(cfg_servers, SVN_CONFIG_SECTION_GLOBAL,
                        SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS, 2);
+  svn_config_set_bool(cfg_servers, SVN_CONFIG_SECTION_GLOBAL,
+                      SVN_CONFIG_OPTION_HTTP2, FALSE);
   if (cfg_servers)
     {
       apr_status_t status;
@@ -369,6 +372,8 @@ init_client_context(svn_client_ctx_t **ctx_p,
                                   SVN_CONFIG_OPTION_HTTP_BULK_UPDATES, TRUE);
               svn_config_set_int64(cfg_servers, server_group,
                                    SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS, 2);
+              svn_config_set_bool(cfg_servers, server_group,
+                                  SVN_CONFIG_OPTION_HTTP2, FALSE);
             }
         }
     }
@@ -50,19 +50,35 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
+#include "svn_sorts.h"
 
+#include "private/svn_fs_private.h"
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_cache.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
 #endif
 
+#if HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>  /* For getrusage() */
+#endif
+
 #include "server.h"
 #include "logger.h"
 
+/* Files smaller than this will always be sent through the regular
+   stream interface. */
+#define FILE_RANGE_MIN_SIZE 0x10000
+
+/* Maximum size of a single string item when sending file contents
+   with zero-copy. */
+#define FILE_RANGE_CHUNK_SIZE 0x40000
+
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
   svn_revnum_t *new_rev;
@@ -142,25 +158,21 @@ log_fail_and_flush(svn_error_t *err, server_baton_t *server,
   return svn_ra_svn__flush(conn, pool);
 }
 
-/* Log a client command. */
-static svn_error_t *log_command(server_baton_t *b,
-                                svn_ra_svn_conn_t *conn,
-                                apr_pool_t *pool,
-                                const char *fmt, ...)
+/* Write the message FMT / AP about the client command currently handled
+   by B on CONN to LOGGER, prefixed with the standard client info. */
+static svn_error_t *vlog_line(struct logger_t *logger,
+                              server_baton_t *b,
+                              svn_ra_svn_conn_t *conn,
+                              apr_pool_t *pool,
+                              const char *fmt,
+                              va_list ap)
 {
   const char *remote_host, *timestr, *log, *line;
-  va_list ap;
   apr_size_t nbytes;
 
-  if (b->logger == NULL)
-    return SVN_NO_ERROR;
-
   remote_host = svn_ra_svn_conn_remote_host(conn);
   timestr = svn_time_to_cstring(apr_time_now(), pool);
-
-  va_start(ap, fmt);
   log = apr_pvsprintf(pool, fmt, ap);
-  va_end(ap);
 
   line = apr_psprintf(pool, "%" APR_PID_T_FMT
                       " %s %s %s %s %s" APR_EOL_STR,
@@ -170,7 +182,45 @@ static svn_error_t *log_command(server_baton_t *b,
                       b->repository->repos_name, log);
   nbytes = strlen(line);
 
-  return logger__write(b->logger, line, nbytes);
+  return logger__write(logger, line, nbytes);
+}
+
+/* Log a client command. */
+static svn_error_t *log_command(server_baton_t *b,
+                                svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool,
+                                const char *fmt, ...)
+{
+  svn_error_t *err;
+  va_list ap;
+
+  if (b->logger == NULL)
+    return SVN_NO_ERROR;
+
+  va_start(ap, fmt);
+  err = vlog_line(b->logger, b, conn, pool, fmt, ap);
+  va_end(ap);
+
+  return svn_error_trace(err);
+}
+
+/* Log to the slow request log. */
+static svn_error_t *log_slow_request(server_baton_t *b,
+                                     svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     const char *fmt, ...)
+{
+  svn_error_t *err;
+  va_list ap;
+
+  if (b->slow_logger == NULL)
+    return SVN_NO_ERROR;
+
+  va_start(ap, fmt);
+  err = vlog_line(b->slow_logger, b, conn, pool, fmt, ap);
+  va_end(ap);
+
+  return svn_error_trace(err);
 }
 
 /* Log an authz failure */
@@ -944,6 +994,67 @@ static const svn_ra_svn__cmd_entry_t report_commands[] = {
   { NULL }
 };
 
+/* Append CSTR, which may be NULL, to KEY such that the result can't be
+ * mistaken for any other combination of key elements. */
+static void
+append_cstring_to_key(svn_stringbuf_t *key,
+                      const char *cstr)
+{
+  char buffer[SVN_INT64_BUFFER_SIZE];
+
+  if (cstr)
+    {
+      apr_size_t len = strlen(cstr);
+      svn_stringbuf_appendbytes(key, buffer, svn__ui64toa(buffer, len));
+      svn_stringbuf_appendbyte(key, ':');
+      svn_stringbuf_appendbytes(key, cstr, len);
+    }
+  else
+    {
+      svn_stringbuf_appendbyte(key, '-');
+    }
+
+  svn_stringbuf_appendbyte(key, ' ');
+}
+
+/* Set *VIEW to a string that identifies the read access that the session
+ * described by B has, i.e. the authz rules and the user they get applied
+ * to.  Set it to NULL if the rules can't be identified.  Allocate the
+ * result in POOL. */
+static void
+get_authz_view(const char **view,
+               server_baton_t *b,
+               apr_pool_t *pool)
+{
+  repository_t *repository = b->repository;
+  const svn_membuf_t *authz_id = NULL;
+  svn_stringbuf_t *result;
+
+  *view = NULL;
+  if (repository->authzdb)
+    {
+      authz_id = svn_repos__authz_get_id(repository->authzdb);
+      if (!authz_id)
+        return;
+    }
+
+  result = svn_stringbuf_createf(pool, "%d %d ", repository->anon_access,
+                                 repository->auth_access);
+  append_cstring_to_key(result, repository->authz_repos_name);
+  append_cstring_to_key(result, b->client_info->user);
+
+  if (authz_id)
+    {
+      const unsigned char *id = authz_id->data;
+      apr_size_t k;
+
+      for (k = 0; k < authz_id->size; ++k)
+        svn_stringbuf_appendcstr(result, apr_psprintf(pool, "%02x", id[k]));
+    }
+
+  *view = result->data;
+}
+
 /* Accept a report from the client, drive the network editor with the
  * result, and then write an empty command response.  If there is a
  * non-protocol failure, accept_report will abort the edit and return
@@ -988,6 +1099,17 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       authz_check_access_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  SVN_CMD_ERR(svn_repos__report_set_workers(report_baton, b->report_workers,
+                                            b->fs_config));
+  if (b->checkout_cache)
+    {
+      const char *view;
+
+      get_authz_view(&view, b, pool);
+      SVN_CMD_ERR(svn_repos__report_set_checkout_cache(report_baton,
+                                                       b->checkout_cache,
+                                                       view));
+    }
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -1551,6 +1673,36 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* If the contents of the file PATH in ROOT can be sent to the client
+   straight from the repository files, set *FILE, *OFFSET and *LENGTH to
+   the respective data range.  Otherwise, set *FILE to NULL.  Small files
+   are not worth the extra system calls and will always be rejected.
+   Allocate *FILE in POOL. */
+static svn_error_t *
+try_get_file_range(apr_file_t **file,
+                   apr_off_t *offset,
+                   svn_filesize_t *length,
+                   svn_fs_root_t *root,
+                   const char *path,
+                   apr_pool_t *pool)
+{
+  svn_boolean_t success;
+  svn_filesize_t file_length;
+
+  *file = NULL;
+
+  SVN_ERR(svn_fs_file_length(&file_length, root, path, pool));
+  if (file_length < FILE_RANGE_MIN_SIZE)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs__try_get_file_range(&success, file, offset, length,
+                                     root, path, pool, pool));
+  if (!success || *length != file_length)
+    *file = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1573,6 +1725,9 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_error_t *err, *write_err;
   int i;
   authz_baton_t ab;
+  apr_file_t *range_file = NULL;
+  apr_off_t range_offset;
+  svn_filesize_t range_length;
 
   ab.server = b;
   ab.conn = conn;
@@ -1613,7 +1768,10 @@ get_file(svn_ra_svn_conn_t *conn,
                           wants_inherited_props ? &inherited_props : NULL,
                           &ab, root, full_path,
                           pool));
-  if (want_contents)
+  if (want_contents && svn_ra_svn__can_write_file_range(conn))
+    SVN_CMD_ERR(try_get_file_range(&range_file, &range_offset, &range_length,
+                                   root, full_path, pool));
+  if (want_contents && !range_file)
     SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
 
   /* Send successful command response with revision and props. */
@@ -1644,7 +1802,23 @@ get_file(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (range_file)
+    {
+      /* Zero-copy.  Chop the data into reasonably sized string items
+         such that the client does not need to buffer the whole file. */
+      while (range_length > 0)
+        {
+          len = (apr_size_t)MIN(range_length, FILE_RANGE_CHUNK_SIZE);
+          SVN_ERR(svn_ra_svn__write_file_range(conn, pool, range_file,
+                                               range_offset, len));
+          range_offset += len;
+          range_length -= len;
+        }
+
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -1736,6 +1910,223 @@ parse_dirent_fields(apr_uint32_t *dirent_fields_p,
   return SVN_NO_ERROR;
 }
 
+/* Send the contents of the file PATH under ROOT over CONN as a series of
+   strings, terminated by the empty string and followed by a command
+   response that tells the client whether an error occurred while reading
+   the data.  If so, log that error for server baton B and set *FAILED.
+   Only errors writing to CONN will be returned.  Use POOL for all
+   allocations. */
+static svn_error_t *
+write_file_contents(svn_boolean_t *failed,
+                    svn_ra_svn_conn_t *conn,
+                    server_baton_t *b,
+                    svn_fs_root_t *root,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  apr_file_t *range_file = NULL;
+  apr_off_t range_offset;
+  svn_filesize_t range_length;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *write_err;
+
+  if (svn_ra_svn__can_write_file_range(conn))
+    err = try_get_file_range(&range_file, &range_offset, &range_length,
+                             root, path, pool);
+
+  if (!err && range_file)
+    {
+      while (range_length > 0)
+        {
+          apr_size_t len = (apr_size_t)MIN(range_length,
+                                           FILE_RANGE_CHUNK_SIZE);
+          SVN_ERR(svn_ra_svn__write_file_range(conn, pool, range_file,
+                                               range_offset, len));
+          range_offset += len;
+          range_length -= len;
+        }
+    }
+  else if (!err)
+    {
+      char buf[4096];
+      svn_string_t write_str;
+      apr_size_t len;
+
+      err = svn_fs_file_contents(&contents, root, path, pool);
+      while (!err)
+        {
+          len = sizeof(buf);
+          err = svn_stream_read_full(contents, buf, &len);
+          if (err)
+            break;
+          if (len > 0)
+            {
+              write_str.data = buf;
+              write_str.len = len;
+              SVN_ERR(svn_ra_svn__write_string(conn, pool, &write_str));
+            }
+          if (len < sizeof(buf))
+            {
+              err = svn_stream_close(contents);
+              break;
+            }
+        }
+    }
+
+  write_err = svn_ra_svn__write_cstring(conn, pool, "");
+  if (!write_err)
+    {
+      if (err)
+        {
+          log_error(err, b);
+          write_err = svn_ra_svn__write_cmd_failure(conn, pool, err);
+        }
+      else
+        write_err = svn_ra_svn__write_cmd_response(conn, pool, "");
+    }
+
+  *failed = (err != SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  return svn_error_trace(write_err);
+}
+
+/* Fetch the checksum of the file PATH in ROOT into *HEX_DIGEST and its
+   properties into *PROPS if WANT_PROPS is set, using authz baton AB.
+   Allocate the results in POOL. */
+static svn_error_t *
+get_file_info(const char **hex_digest,
+              apr_hash_t **props,
+              svn_boolean_t want_props,
+              authz_baton_t *ab,
+              svn_fs_root_t *root,
+              const char *path,
+              apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root, path,
+                               TRUE, pool));
+  *hex_digest = svn_checksum_to_cstring_display(checksum, pool);
+
+  *props = NULL;
+  if (want_props)
+    SVN_ERR(get_props(props, NULL, ab, root, path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *file_specs;
+  svn_boolean_t want_props, want_contents;
+  svn_revnum_t youngest;
+  apr_hash_t *roots = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  authz_baton_t ab;
+  int i;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "lbb", &file_specs,
+                                  &want_props, &want_contents));
+
+  /* We can only send a single auth reply per request.  Per-path authz
+     failures will be reported for the respective file below. */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, NULL, FALSE));
+
+  /* All HEAD requests within this command see the same revision.  Once
+     we started sending file responses, we can't report errors as a
+     command failure anymore.  So, get that revision up-front. */
+  SVN_CMD_ERR(svn_fs_youngest_rev(&youngest, b->repository->fs, pool));
+
+  for (i = 0; i < file_specs->nelts; ++i)
+    {
+      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(file_specs, i);
+      const char *path, *full_path, *hex_digest;
+      svn_revnum_t rev;
+      svn_fs_root_t *root;
+      apr_hash_t *props;
+      svn_boolean_t failed = FALSE;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                "File specs should be list of lists");
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "c(?r)", &path, &rev));
+      full_path = svn_fspath__join(b->repository->fs_path->data,
+                                   svn_relpath_canonicalize(path, iterpool),
+                                   iterpool);
+
+      if (!SVN_IS_VALID_REVNUM(rev))
+        rev = youngest;
+
+      SVN_ERR(log_command(b, conn, iterpool, "%s",
+                          svn_log__get_file(full_path, rev, want_contents,
+                                            want_props, iterpool)));
+
+      /* Share revision roots and their caches between files. */
+      root = apr_hash_get(roots, &rev, sizeof(rev));
+      if (!root)
+        {
+          err = svn_fs_revision_root(&root, b->repository->fs, rev, pool);
+          if (!err)
+            apr_hash_set(roots, apr_pmemdup(pool, &rev, sizeof(rev)),
+                         sizeof(rev), root);
+        }
+      else
+        err = SVN_NO_ERROR;
+
+      if (!err && !lookup_access(iterpool, b, svn_authz_read, full_path,
+                                 FALSE))
+        err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL, NULL, b);
+      if (!err)
+        err = get_file_info(&hex_digest, &props, want_props, &ab, root,
+                            full_path, iterpool);
+
+      /* Stop at the first failure. */
+      if (err)
+        {
+          svn_error_t *write_err = svn_ra_svn__write_cmd_failure(conn,
+                                                                 iterpool,
+                                                                 err);
+          svn_error_clear(err);
+          SVN_ERR(write_err);
+          break;
+        }
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w((?c)r(!",
+                                      "success", hex_digest, rev));
+      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))"));
+
+      if (want_contents)
+        {
+          SVN_ERR(write_file_contents(&failed, conn, b, root, full_path,
+                                      iterpool));
+          if (failed)
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_ra_svn__write_word(conn, pool, "done"));
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_dir(svn_ra_svn_conn_t *conn,
         apr_pool_t *pool,
@@ -2466,6 +2857,8 @@ log_cmd(svn_ra_svn_conn_t *conn,
   lb.conn = conn;
   lb.stack_depth = 0;
   lb.started = FALSE;
+  svn_repos__set_log_workers(b->repository->repos, b->log_workers,
+                             b->fs_config);
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
@@ -3686,6 +4079,281 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* --- Response cache --- */
+
+/* Responses larger than this will not be cached. */
+#define MAX_CACHED_RESPONSE_SIZE 0x40000
+
+/* A read-only command whose response depends on nothing but its parameters,
+ * the repository contents and the access rules for the respective user. */
+typedef struct cacheable_command_t
+{
+  /* Name of the command as used in the cache key. */
+  const char *cmdname;
+
+  /* The actual command implementation. */
+  svn_ra_svn__command_handler handler;
+
+  /* Number of optional revision numbers following the leading path
+   * parameter.  Unless all of them are given, the response depends on
+   * the youngest revision and can't be cached. */
+  int rev_count;
+} cacheable_command_t;
+
+/* Append a canonical representation of ITEM to KEY.  It is independent
+ * of the whitespace used by the client. */
+static void
+append_item_to_key(svn_stringbuf_t *key,
+                   const svn_ra_svn__item_t *item)
+{
+  char buffer[SVN_INT64_BUFFER_SIZE];
+  int i;
+
+  switch (item->kind)
+    {
+      case SVN_RA_SVN_NUMBER:
+        svn_stringbuf_appendbytes(key, buffer,
+                                  svn__ui64toa(buffer, item->u.number));
+        svn_stringbuf_appendbyte(key, ' ');
+        break;
+
+      case SVN_RA_SVN_STRING:
+        svn_stringbuf_appendbytes(key, buffer,
+                                  svn__ui64toa(buffer, item->u.string.len));
+        svn_stringbuf_appendbyte(key, ':');
+        svn_stringbuf_appendbytes(key, item->u.string.data,
+                                  item->u.string.len);
+        svn_stringbuf_appendbyte(key, ' ');
+        break;
+
+      case SVN_RA_SVN_WORD:
+        svn_stringbuf_appendbytes(key, item->u.word.data, item->u.word.len);
+        svn_stringbuf_appendbyte(key, ' ');
+        break;
+
+      case SVN_RA_SVN_LIST:
+        svn_stringbuf_appendbytes(key, "( ", 2);
+        for (i = 0; i < item->u.list.nelts; ++i)
+          append_item_to_key(key, &SVN_RA_SVN__LIST_ITEM(&item->u.list, i));
+        svn_stringbuf_appendbytes(key, ") ", 2);
+        break;
+    }
+}
+
+/* Set *KEY to the response cache key for CMD being called with PARAMS on
+ * CONN for the session described by B.  Set it to NULL if the response must not
+ * be cached.  Allocate the result in POOL.
+ *
+ * Set *GENERATION to the revprop generation that the key refers to. */
+static svn_error_t *
+get_response_key(const char **key,
+                 apr_int64_t *generation,
+                 svn_ra_svn_conn_t *conn,
+                 server_baton_t *b,
+                 const cacheable_command_t *cmd,
+                 svn_ra_svn__list_t *params,
+                 apr_pool_t *pool)
+{
+  repository_t *repository = b->repository;
+  const char *view;
+  svn_boolean_t supported;
+  svn_stringbuf_t *result;
+  int i;
+
+  *key = NULL;
+
+  /* Only the contents of committed revisions are immutable. */
+  if (   params->nelts <= cmd->rev_count
+      || SVN_RA_SVN__LIST_ITEM(params, 0).kind != SVN_RA_SVN_STRING)
+    return SVN_NO_ERROR;
+
+  for (i = 1; i <= cmd->rev_count; ++i)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(params, i);
+      if (elt->kind != SVN_RA_SVN_LIST || elt->u.list.nelts != 1)
+        return SVN_NO_ERROR;
+    }
+
+  /* Responses may contain revprops like svn:author, which can change.
+   * Without a revprop generation, we could not detect that.  Also skip
+   * caching while a revprop change is in progress. */
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, generation,
+                                             repository->fs, pool));
+  if (!supported || *generation % 2)
+    return SVN_NO_ERROR;
+
+  /* The response is filtered by the authz rules, so these must be part of
+   * the key as well.  Those that we can't identify are not cacheable. */
+  get_authz_view(&view, b, pool);
+  if (!view)
+    return SVN_NO_ERROR;
+
+  result = svn_stringbuf_createf(pool, "%" APR_INT64_T_FMT " ", *generation);
+  append_cstring_to_key(result, repository->uuid);
+  append_cstring_to_key(result, repository->repos_root);
+  append_cstring_to_key(result, repository->fs_path->data);
+  svn_stringbuf_appendcstr(result, view);
+
+  /* Responses containing deltas, e.g. for get-file-revs, are encoded
+   * according to what the client supports. */
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(pool, " %d %d",
+                                        svn_ra_svn__svndiff_version(conn),
+                                        svn_ra_svn_compression_level(conn)));
+
+  svn_stringbuf_appendbyte(result, ' ');
+  svn_stringbuf_appendcstr(result, cmd->cmdname);
+  svn_stringbuf_appendbyte(result, ' ');
+  for (i = 0; i < params->nelts; ++i)
+    append_item_to_key(result, &SVN_RA_SVN__LIST_ITEM(params, i));
+
+  /* Cache keys are C strings. */
+  if (strlen(result->data) == result->len)
+    *key = result->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Execute CMD with PARAMS on CONN for the session described by B.  If the
+ * response is already in B's response cache, send it from there instead.
+ * Otherwise, try to add the response to the cache.  Use POOL for all
+ * allocations. */
+static svn_error_t *
+handle_cacheable_command(const cacheable_command_t *cmd,
+                         svn_ra_svn_conn_t *conn,
+                         apr_pool_t *pool,
+                         svn_ra_svn__list_t *params,
+                         server_baton_t *b)
+{
+  const char *key, *user, *full_path;
+  apr_int64_t generation, new_generation;
+  svn_stringbuf_t *response;
+  svn_boolean_t found, supported;
+  svn_error_t *err;
+
+  if (b->response_cache == NULL)
+    return svn_error_trace(cmd->handler(conn, pool, params, b));
+
+  SVN_ERR(get_response_key(&key, &generation, conn, b, cmd, params, pool));
+  if (key == NULL)
+    return svn_error_trace(cmd->handler(conn, pool, params, b));
+
+  SVN_ERR(svn_cache__get((void **)&response, &found, b->response_cache,
+                         key, pool));
+  if (found)
+    {
+      full_path = svn_fspath__join(b->repository->fs_path->data,
+                    svn_relpath_canonicalize(
+                      SVN_RA_SVN__LIST_ITEM(params, 0).u.string.data, pool),
+                    pool);
+      SVN_ERR(log_command(b, conn, pool, "%s %s (cached)", cmd->cmdname,
+                          svn_path_uri_encode(full_path, pool)));
+
+      return svn_error_trace(svn_ra_svn__write_raw(conn, pool,
+                                                   response->data,
+                                                   response->len));
+    }
+
+  /* Run the command and record everything it sends.  Failed commands
+   * are not cached as their errors might be transient. */
+  user = b->client_info->user;
+  SVN_ERR(svn_ra_svn__start_recording(conn, MAX_CACHED_RESPONSE_SIZE, pool));
+  err = cmd->handler(conn, pool, params, b);
+  response = svn_ra_svn__stop_recording(conn);
+  SVN_ERR(err);
+
+  /* The recording fails if the command interacted with the client, e.g.
+   * for authentication.  If the latter succeeded, the response refers
+   * to a different user than the key does. */
+  if (response == NULL || user != b->client_info->user)
+    return SVN_NO_ERROR;
+
+  /* The response may reflect revprop changes made while we assembled it.
+   * Those are not covered by the generation in KEY. */
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &new_generation,
+                                             b->repository->fs, pool));
+  if (supported && new_generation == generation)
+    SVN_ERR(svn_cache__set(b->response_cache, key, response, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static const cacheable_command_t cacheable_get_dir
+  = { "get-dir", get_dir, 1 };
+static const cacheable_command_t cacheable_stat
+  = { "stat", stat_cmd, 1 };
+static const cacheable_command_t cacheable_get_location_segments
+  = { "get-location-segments", get_location_segments, 3 };
+static const cacheable_command_t cacheable_get_file_revs
+  = { "get-file-revs", get_file_revs, 2 };
+static const cacheable_command_t cacheable_get_inherited_props
+  = { "get-iprops", get_inherited_props, 1 };
+static const cacheable_command_t cacheable_list
+  = { "list", list, 1 };
+
+static svn_error_t *
+cached_get_dir(svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool,
+               svn_ra_svn__list_t *params,
+               void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(&cacheable_get_dir, conn,
+                                                  pool, params, baton));
+}
+
+static svn_error_t *
+cached_stat(svn_ra_svn_conn_t *conn,
+            apr_pool_t *pool,
+            svn_ra_svn__list_t *params,
+            void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(&cacheable_stat, conn,
+                                                  pool, params, baton));
+}
+
+static svn_error_t *
+cached_get_location_segments(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             svn_ra_svn__list_t *params,
+                             void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(
+                           &cacheable_get_location_segments, conn, pool,
+                           params, baton));
+}
+
+static svn_error_t *
+cached_get_file_revs(svn_ra_svn_conn_t *conn,
+                     apr_pool_t *pool,
+                     svn_ra_svn__list_t *params,
+                     void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(&cacheable_get_file_revs,
+                                                  conn, pool, params,
+                                                  baton));
+}
+
+static svn_error_t *
+cached_get_inherited_props(svn_ra_svn_conn_t *conn,
+                           apr_pool_t *pool,
+                           svn_ra_svn__list_t *params,
+                           void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(
+                           &cacheable_get_inherited_props, conn, pool,
+                           params, baton));
+}
+
+static svn_error_t *
+cached_list(svn_ra_svn_conn_t *conn,
+            apr_pool_t *pool,
+            svn_ra_svn__list_t *params,
+            void *baton)
+{
+  return svn_error_trace(handle_cacheable_command(&cacheable_list, conn,
+                                                  pool, params, baton));
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3696,7 +4364,8 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "rev-prop",        rev_prop },
   { "commit",          commit },
   { "get-file",        get_file },
-  { "get-dir",         get_dir },
+  { "get-files",       get_files },
+  { "get-dir",         cached_get_dir },
   { "update",          update },
   { "switch",          switch_cmd },
   { "status",          status },
@@ -3704,10 +4373,10 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-mergeinfo",   get_mergeinfo },
   { "log",             log_cmd },
   { "check-path",      check_path },
-  { "stat",            stat_cmd },
+  { "stat",            cached_stat },
   { "get-locations",   get_locations },
-  { "get-location-segments",   get_location_segments },
-  { "get-file-revs",   get_file_revs },
+  { "get-location-segments",   cached_get_location_segments },
+  { "get-file-revs",   cached_get_file_revs },
   { "lock",            lock },
   { "lock-many",       lock_many },
   { "unlock",          unlock },
@@ -3717,8 +4386,8 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "replay",          replay },
   { "replay-range",    replay_range },
   { "get-deleted-rev", get_deleted_rev },
-  { "get-iprops",      get_inherited_props },
-  { "list",            list },
+  { "get-iprops",      cached_get_inherited_props },
+  { "list",            cached_list },
   { NULL }
 };
 
@@ -4092,6 +4761,147 @@ get_client_info(svn_ra_svn_conn_t *conn,
   return client_info;
 }
 
+/* Resource usage of the commands on a single connection, collected for
+   the slow request log. */
+typedef struct request_stats_t
+{
+  /* Commands taking at least this long get logged. */
+  apr_interval_time_t slow_request_time;
+
+  /* State at the start of the current command. */
+  apr_time_t start_time;
+  apr_interval_time_t start_cpu;
+  svn_ra_svn__io_stats_t start_io;
+  apr_uint64_t start_cache_gets;
+  apr_uint64_t start_cache_hits;
+
+  /* Totals over all commands completed on this connection. */
+  apr_uint64_t commands;
+  apr_uint64_t slow_commands;
+  apr_interval_time_t wall_time;
+  apr_interval_time_t cpu_time;
+} request_stats_t;
+
+/* Return the CPU time (user + system) consumed so far by the current
+   thread or, if the platform cannot tell, by the whole process.
+   Return -1 if that information is not available at all. */
+static apr_interval_time_t
+get_cpu_time(void)
+{
+#if HAVE_SYS_RESOURCE_H && HAVE_GETRUSAGE
+  struct rusage usage;
+#ifdef RUSAGE_THREAD
+  int who = RUSAGE_THREAD;
+#else
+  int who = RUSAGE_SELF;
+#endif
+
+  if (getrusage(who, &usage) == 0)
+    return apr_time_make(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec,
+                         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+
+  return -1;
+}
+
+/* Format the CPU time difference between START and END in ms,
+   allocated in POOL.  Returns "-" if either is unknown. */
+static const char *
+cpu_time_str(apr_interval_time_t start,
+             apr_interval_time_t end,
+             apr_pool_t *pool)
+{
+  if (start < 0 || end < 0)
+    return "-";
+
+  return apr_psprintf(pool, "%" APR_TIME_T_FMT, apr_time_as_msec(end - start));
+}
+
+/* Implements svn_ra_svn__command_cb_t for server_baton_t BATON.
+   Takes a snapshot of the resource counters when a command starts and
+   logs the differences for commands that took too long. */
+static svn_error_t *
+command_stats_cb(void *baton,
+                 svn_ra_svn_conn_t *conn,
+                 const char *cmdname,
+                 svn_boolean_t finished,
+                 apr_pool_t *pool)
+{
+  server_baton_t *b = baton;
+  request_stats_t *stats = b->request_stats;
+  const svn_ra_svn__io_stats_t *io = svn_ra_svn__get_io_stats(conn);
+  apr_interval_time_t wall_time, cpu_time;
+  apr_uint64_t cache_gets, cache_hits;
+
+  if (!finished)
+    {
+      stats->start_io = *io;
+      svn_cache__membuffer_get_global_access_stats(&stats->start_cache_gets,
+                                                   &stats->start_cache_hits);
+      stats->start_cpu = get_cpu_time();
+      stats->start_time = apr_time_now();
+
+      return SVN_NO_ERROR;
+    }
+
+  wall_time = apr_time_now() - stats->start_time;
+  cpu_time = get_cpu_time();
+
+  stats->commands++;
+  stats->wall_time += wall_time;
+  if (cpu_time >= 0 && stats->start_cpu >= 0)
+    stats->cpu_time += cpu_time - stats->start_cpu;
+
+  if (wall_time < stats->slow_request_time)
+    return SVN_NO_ERROR;
+
+  /* The cache counters are shared by all connections of this process,
+     i.e. concurrent commands will be included in the numbers. */
+  stats->slow_commands++;
+  svn_cache__membuffer_get_global_access_stats(&cache_gets, &cache_hits);
+
+  return svn_error_trace(log_slow_request(b, conn, pool,
+                         "slow-request %s wall=%" APR_TIME_T_FMT "ms"
+                         " cpu=%sms sent=%" APR_UINT64_T_FMT
+                         " received=%" APR_UINT64_T_FMT
+                         " cache-gets=%" APR_UINT64_T_FMT
+                         " cache-hits=%" APR_UINT64_T_FMT,
+                         cmdname, apr_time_as_msec(wall_time),
+                         cpu_time_str(stats->start_cpu, cpu_time, pool),
+                         io->bytes_sent - stats->start_io.bytes_sent,
+                         io->bytes_received - stats->start_io.bytes_received,
+                         cache_gets - stats->start_cache_gets,
+                         cache_hits - stats->start_cache_hits));
+}
+
+/* Write the resource usage summary for the connection CONN served by B
+   to the slow request log. */
+static svn_error_t *
+log_connection_stats(server_baton_t *b,
+                     svn_ra_svn_conn_t *conn,
+                     apr_pool_t *pool)
+{
+  request_stats_t *stats = b->request_stats;
+  const svn_ra_svn__io_stats_t *io;
+
+  if (stats == NULL)
+    return SVN_NO_ERROR;
+
+  io = svn_ra_svn__get_io_stats(conn);
+  return svn_error_trace(log_slow_request(b, conn, pool,
+                         "connection-summary commands=%" APR_UINT64_T_FMT
+                         " slow=%" APR_UINT64_T_FMT
+                         " wall=%" APR_TIME_T_FMT "ms"
+                         " cpu=%" APR_TIME_T_FMT "ms"
+                         " sent=%" APR_UINT64_T_FMT
+                         " received=%" APR_UINT64_T_FMT,
+                         stats->commands, stats->slow_commands,
+                         apr_time_as_msec(stats->wall_time),
+                         apr_time_as_msec(stats->cpu_time),
+                         io->bytes_sent, io->bytes_received));
+}
+
+
 /* Construct the server baton for CONN using PARAMS and return it in *BATON.
  * It's lifetime is the same as that of CONN.  SCRATCH_POOL
  */
@@ -4121,15 +4931,28 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->response_cache = params->response_cache;
+  b->checkout_cache = params->checkout_cache;
+  b->report_workers = params->report_workers;
+  b->log_workers = params->log_workers;
+  b->fs_config = params->fs_config;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
 
+  if (params->slow_logger)
+    {
+      b->slow_logger = params->slow_logger;
+      b->request_stats = apr_pcalloc(conn_pool, sizeof(*b->request_stats));
+      b->request_stats->slow_request_time = params->slow_request_time;
+      svn_ra_svn__set_command_callback(conn, command_stats_cb, b);
+    }
+
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4143,11 +4966,15 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           params->stream_compression
+                                             ? SVN_RA_SVN_CAP_COMPRESSED_STREAM
+                                             : NULL
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4986,11 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           params->stream_compression
+                                             ? SVN_RA_SVN_CAP_COMPRESSED_STREAM
+                                             : NULL
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4175,6 +5006,12 @@ construct_server_baton(server_baton_t **baton,
   client_url = svn_uri_canonicalize(client_url, conn_pool);
   SVN_ERR(svn_ra_svn__set_capabilities(conn, caplist));
 
+  /* If we offered stream compression and the client accepted it, all
+   * further data will be compressed, starting with our auth request. */
+  if (params->stream_compression
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESSED_STREAM))
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, scratch_pool));
+
   /* All released versions of Subversion support edit-pipeline,
    * so we do not accept connections from clients that do not. */
   if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
@@ -4402,6 +5239,29 @@ serve_interruptable(svn_boolean_t *terminate_p,
 
   /* error or normal end of session. Close the connection */
   svn_pool_destroy(iterpool);
+  if (terminate && connection->baton)
+    {
+      const svn_ra_svn__io_stats_t *stats
+        = svn_ra_svn__get_io_stats(connection->conn);
+
+      /* Allow slow connections to be diagnosed from the log. */
+      err = svn_error_compose_create(err,
+              log_command(connection->baton, connection->conn, pool,
+                          "disconnect sent=%" APR_UINT64_T_FMT
+                          " received=%" APR_UINT64_T_FMT
+                          " send-calls=%" APR_UINT64_T_FMT
+                          " receive-calls=%" APR_UINT64_T_FMT
+                          " send-wait=%" APR_TIME_T_FMT "ms"
+                          " receive-wait=%" APR_TIME_T_FMT "ms",
+                          stats->bytes_sent, stats->bytes_received,
+                          stats->send_calls, stats->receive_calls,
+                          apr_time_as_msec(stats->send_time),
+                          apr_time_as_msec(stats->receive_time)));
+      err = svn_error_compose_create(err,
+              log_connection_stats(connection->baton, connection->conn,
+                                   pool));
+    }
+
   if (terminate_p)
     *terminate_p = terminate;
 
@@ -4415,5 +5275,8 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn,
   server_baton_t *baton = NULL;
 
   SVN_ERR(construct_server_baton(&baton, conn, params, pool));
-  return svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  return svn_error_compose_create(
+           svn_ra_svn__handle_commands2(conn, pool, main_commands, baton,
+                                        FALSE),
+           log_connection_stats(baton, conn, pool));
 }
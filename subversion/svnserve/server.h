@@ -37,6 +37,7 @@ extern "C" {
 #include "svn_ra_svn.h"
 
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
@@ -90,6 +91,15 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  svn_cache__t *response_cache; /* Replayable responses.  May be NULL. */
+  svn_repos__checkout_cache_t *checkout_cache; /* Recorded checkouts.
+                                                  May be NULL. */
+  int report_workers;      /* Threads computing deltas for reports. */
+  int log_workers;         /* Threads preparing log entries. */
+  struct logger_t *slow_logger; /* Slow request log.  May be NULL. */
+  struct request_stats_t *request_stats; /* Per-command accounting.
+                                            NULL if slow_logger is. */
+  apr_hash_t *fs_config;   /* FS config to open the workers' FS with. */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -124,6 +134,13 @@ typedef struct serve_params_t {
   /* logging data structure; possibly NULL. */
   struct logger_t *logger;
 
+  /* log for commands taking longer than SLOW_REQUEST_TIME, plus
+     per-connection summaries; possibly NULL. */
+  struct logger_t *slow_logger;
+
+  /* Minimum wall clock time of a command to be reported in SLOW_LOGGER. */
+  apr_interval_time_t slow_request_time;
+
   /* all configurations should be opened through this factory */
   svn_repos__config_pool_t *config_pool;
 
@@ -147,6 +164,26 @@ typedef struct serve_params_t {
      them over the network.  0 disables that code path. */
   apr_size_t zero_copy_limit;
 
+  /* Offer clients to compress the whole connection and not just the
+     svndiff data.  This disables the sendfile code path. */
+  svn_boolean_t stream_compression;
+
+  /* Process-wide cache of responses to read-only queries on explicitly
+     given revisions.  NULL if response caching is disabled. */
+  svn_cache__t *response_cache;
+
+  /* Process-wide directory of recorded checkout editor drives.  NULL if
+     checkout caching is disabled. */
+  svn_repos__checkout_cache_t *checkout_cache;
+
+  /* Number of worker threads per report that compute file deltas ahead
+     of the editor drive.  0 disables that feature. */
+  int report_workers;
+
+  /* Number of worker threads per log request that prepare upcoming log
+     entries.  0 disables that feature. */
+  int log_workers;
+
   /* Amount of data to send between checks for cancellation requests
      coming in from the client. */
   apr_size_t error_check_interval;
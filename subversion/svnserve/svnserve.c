@@ -56,10 +56,12 @@
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #endif
 
 #include "winservice.h"
@@ -76,6 +78,7 @@
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
+  connection_mode_event,  /* Multiplex connections; threads per command */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -145,6 +148,14 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Initial capacity of the pollset used in event loop mode.
+ *
+ * For epoll and kqueue based pollsets, this is merely a hint and more
+ * connections may be added later.  Other implementations will reject
+ * connections beyond this limit.
+ */
+#define EVENT_LOOP_POLLSET_SIZE 1024
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -164,6 +175,15 @@ enum run_mode {
  */
 #define MAX_REQUEST_SIZE 16
 
+/* Default limit for the size of the checkout cache directory in MB.
+ */
+#define CHECKOUT_CACHE_SIZE 1024
+
+/* Default minimum execution time in ms of a command to be reported in the
+ * slow request log.
+ */
+#define SLOW_REQUEST_TIME 1000
+
 #ifdef WIN32
 static apr_os_sock_t winservice_svnserve_accept_socket = INVALID_SOCKET;
 
@@ -222,6 +242,15 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_EVENT_LOOP      277
+#define SVNSERVE_OPT_STREAM_COMPRESSION 278
+#define SVNSERVE_OPT_CACHE_RESPONSES 279
+#define SVNSERVE_OPT_REPORT_WORKERS  280
+#define SVNSERVE_OPT_CHECKOUT_CACHE  281
+#define SVNSERVE_OPT_CHECKOUT_CACHE_SIZE 282
+#define SVNSERVE_OPT_SLOW_REQUEST_LOG 283
+#define SVNSERVE_OPT_SLOW_REQUEST_TIME 284
+#define SVNSERVE_OPT_LOG_WORKERS     285
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -287,6 +316,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "[0 .. no compression, 5 .. default, \n"
         "                             "
         " 9 .. maximum compression]")},
+    {"stream-compression", SVNSERVE_OPT_STREAM_COMPRESSION, 0,
+     N_("offer clients to compress all data sent over the\n"
+        "                             "
+        "connection and not just file contents.  This uses\n"
+        "                             "
+        "more CPU but helps with slow links.")},
     {"memory-cache-size", 'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             "
@@ -325,6 +360,36 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-responses", SVNSERVE_OPT_CACHE_RESPONSES, 1,
+     N_("enable or disable caching of complete responses\n"
+        "                             "
+        "to queries on explicitly given revisions, e.g.\n"
+        "                             "
+        "directory listings.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[used for FSFS format 9+ repositories only]")},
+    {"checkout-cache", SVNSERVE_OPT_CHECKOUT_CACHE, 1,
+     N_("directory in which to keep recorded checkouts.\n"
+        "                             "
+        "Checkouts of the same path and revision by users\n"
+        "                             "
+        "with the same access rights get replayed from\n"
+        "                             "
+        "there instead of being computed again.\n"
+        "                             "
+        "Default is no checkout cache.\n"
+        "                             "
+        "[used for FSFS format 9+ repositories only]")},
+    {"checkout-cache-size", SVNSERVE_OPT_CHECKOUT_CACHE_SIZE, 1,
+     N_("size of the checkout cache directory in MB.\n"
+        "                             "
+        "The least recently used checkouts get removed\n"
+        "                             "
+        "once the limit is exceeded.\n"
+        "                             "
+        "Default is " APR_STRINGIFY(CHECKOUT_CACHE_SIZE) ".")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -348,6 +413,16 @@ static const apr_getopt_option_t svnserve__options[] =
                                     "[mode: daemon]")},
 #endif
 #if APR_HAS_THREADS
+    {"event-loop",       SVNSERVE_OPT_EVENT_LOOP, 0,
+     N_("wait for requests on all connections in a single\n"
+        "                             "
+        "event loop and use a thread only while a command\n"
+        "                             "
+        "is being executed.  Idle connections don't occupy\n"
+        "                             "
+        "server threads in this mode.\n"
+        "                             "
+        "[mode: daemon]")},
     {"min-threads",      SVNSERVE_OPT_MIN_THREADS, 1,
      N_("Minimum number of server threads, even if idle.\n"
         "                             "
@@ -362,6 +437,26 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"report-workers",   SVNSERVE_OPT_REPORT_WORKERS, 1,
+     N_("Number of additional threads per update, switch,\n"
+        "                             "
+        "status or diff request that compute file deltas\n"
+        "                             "
+        "ahead of sending them.  This speeds up large\n"
+        "                             "
+        "checkouts at the expense of more CPU load.\n"
+        "                             "
+        "Default is 0 (disabled).")},
+    {"log-workers",      SVNSERVE_OPT_LOG_WORKERS, 1,
+     N_("Number of additional threads per log request\n"
+        "                             "
+        "that read changed paths and revision properties\n"
+        "                             "
+        "ahead of sending them.  This speeds up long\n"
+        "                             "
+        "'svn log -v' requests at the expense of more CPU\n"
+        "                             "
+        "load.  Default is 0 (disabled).")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -396,6 +491,22 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"slow-request-log", SVNSERVE_OPT_SLOW_REQUEST_LOG, 1,
+     N_("log commands taking longer than the\n"
+        "                             "
+        "--slow-request-time to file ARG, together with\n"
+        "                             "
+        "their CPU time, traffic and cache usage, plus\n"
+        "                             "
+        "a per-connection summary.\n"
+        "                             "
+        "Default is no slow request log.")},
+    {"slow-request-time", SVNSERVE_OPT_SLOW_REQUEST_TIME, 1,
+     N_("minimum execution time in ms of commands to\n"
+        "                             "
+        "be logged in the --slow-request-log.\n"
+        "                             "
+        "Default is " APR_STRINGIFY(SLOW_REQUEST_TIME) ".")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -656,6 +767,168 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   return NULL;
 }
 
+/* The pollset used in event loop mode.  It contains the listening socket
+   as well as all connections that currently wait for the next command. */
+static apr_pollset_t *event_pollset;
+
+/* Load determination callback for serve_interruptable in event loop mode:
+   Never block a worker thread waiting for the next command to arrive. */
+static svn_boolean_t
+is_always_busy(connection_t *connection)
+{
+  return TRUE;
+}
+
+/* Add CONNECTION to EVENT_POLLSET, i.e. start watching it for incoming
+   commands. */
+static apr_status_t
+watch_connection(connection_t *connection)
+{
+  apr_pollfd_t pfd = { 0 };
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.desc.s = connection->usock;
+  pfd.reqevents = APR_POLLIN;
+  pfd.client_data = connection;
+
+  return apr_pollset_add(event_pollset, &pfd);
+}
+
+/* Serve the connection given by DATA in event loop mode: Execute all
+   commands that already arrived and then hand the connection back to
+   the event loop.  Close the connection once it got terminated. */
+static void * APR_THREAD_FUNC serve_event_thread(apr_thread_t *tid,
+                                                 void *data)
+{
+  svn_boolean_t done = FALSE;
+  svn_boolean_t pending = TRUE;
+  connection_t *connection = data;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* serve_interruptable executes at most one command per call in this
+     mode.  Since the client may have sent more than one command in one
+     go, we must not wait for the socket to become readable again before
+     we processed everything that is already in our receive buffer. */
+  while (!done && pending && !err)
+    {
+      svn_pool_clear(iterpool);
+      err = serve_interruptable(&done, connection, is_always_busy,
+                                iterpool);
+      if (!done && !err)
+        err = svn_ra_svn__has_command(&pending, &done, connection->conn,
+                                      iterpool);
+    }
+
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        pool));
+      svn_error_clear(err);
+      done = TRUE;
+    }
+
+  /* Give the connection back to the event loop. */
+  if (!done)
+    {
+      status = watch_connection(connection);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't watch connection"));
+          logger__log_error(connection->params->logger, err, NULL,
+                            get_client_info(connection->conn,
+                                            connection->params, pool));
+          svn_error_clear(err);
+          done = TRUE;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  if (done)
+    close_connection(connection);
+
+  return NULL;
+}
+
+/* Accept connections coming in on SOCK and serve them according to PARAMS
+   using an event loop.  All connections are being watched in a single
+   pollset (epoll on Linux) and a worker thread from THREADS is only
+   attached to a connection while there are commands for it to execute.
+   Use POOL for allocations. */
+static svn_error_t *
+serve_event_loop(apr_socket_t *sock,
+                 serve_params_t *params,
+                 apr_pool_t *pool)
+{
+  apr_pollfd_t listener = { 0 };
+  apr_status_t status;
+
+  status = apr_pollset_create(&event_pollset, EVENT_LOOP_POLLSET_SIZE,
+                              pool, APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create pollset for the event loop"));
+
+  listener.p = pool;
+  listener.desc_type = APR_POLL_SOCKET;
+  listener.desc.s = sock;
+  listener.reqevents = APR_POLLIN;
+  listener.client_data = NULL;
+
+  status = apr_pollset_add(event_pollset, &listener);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't watch server socket"));
+
+  while (1)
+    {
+      const apr_pollfd_t *results;
+      apr_int32_t count;
+      apr_int32_t i;
+
+      status = apr_pollset_poll(event_pollset, -1, &count, &results);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll connections"));
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = results[i].client_data;
+
+          if (connection == NULL)
+            {
+              /* New client.  The server speaks first, so serve it right
+                 away instead of waiting for the client to send data. */
+              SVN_ERR(accept_connection(&connection, sock, params,
+                                        connection_mode_event, pool));
+            }
+          else
+            {
+              /* Don't report further activity on this connection while a
+                 worker is processing it. */
+              status = apr_pollset_remove(event_pollset, &results[i]);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't unwatch connection"));
+            }
+
+          status = apr_thread_pool_push(threads, serve_event_thread,
+                                        connection, 0, NULL);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+    }
+
+  /* NOTREACHED */
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -724,6 +997,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_nodeprops = TRUE;
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
+  svn_boolean_t cache_responses = FALSE;
+  const char *checkout_cache_dir = NULL;
+  apr_uint64_t checkout_cache_size = CHECKOUT_CACHE_SIZE * 0x100000;
   svn_boolean_t use_block_read = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
@@ -739,6 +1015,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *slow_log_filename = NULL;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
@@ -765,12 +1042,19 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.cfg = NULL;
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
   params.logger = NULL;
+  params.slow_logger = NULL;
+  params.slow_request_time = apr_time_from_msec(SLOW_REQUEST_TIME);
   params.config_pool = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
   params.zero_copy_limit = 0;
+  params.stream_compression = FALSE;
+  params.response_cache = NULL;
+  params.checkout_cache = NULL;
+  params.report_workers = 0;
+  params.log_workers = 0;
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
@@ -892,6 +1176,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           handling_opt_count++;
           break;
 
+#if APR_HAS_THREADS
+        case SVNSERVE_OPT_EVENT_LOOP:
+          handling_mode = connection_mode_event;
+          handling_opt_count++;
+          break;
+#endif
+
         case 'c':
           params.compression_level = atoi(arg);
           if (params.compression_level < SVN_DELTA_COMPRESSION_LEVEL_NONE)
@@ -900,6 +1191,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_MAX;
           break;
 
+        case SVNSERVE_OPT_STREAM_COMPRESSION:
+          params.stream_compression = TRUE;
+          break;
+
         case 'M':
           {
             apr_uint64_t sz_val;
@@ -925,6 +1220,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_RESPONSES:
+          cache_responses = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
+        case SVNSERVE_OPT_CHECKOUT_CACHE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&checkout_cache_dir, arg, pool));
+          checkout_cache_dir = svn_dirent_internal_style(checkout_cache_dir,
+                                                         pool);
+          SVN_ERR(svn_dirent_get_absolute(&checkout_cache_dir,
+                                          checkout_cache_dir, pool));
+          break;
+
+        case SVNSERVE_OPT_CHECKOUT_CACHE_SIZE:
+          checkout_cache_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -962,6 +1273,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_REPORT_WORKERS:
+          params.report_workers = (int)apr_strtoi64(arg, NULL, 0);
+          if (params.report_workers < 0)
+            params.report_workers = 0;
+          break;
+
+        case SVNSERVE_OPT_LOG_WORKERS:
+          params.log_workers = (int)apr_strtoi64(arg, NULL, 0);
+          if (params.log_workers < 0)
+            params.log_workers = 0;
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1318,25 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+         case SVNSERVE_OPT_SLOW_REQUEST_LOG:
+          SVN_ERR(svn_utf_cstring_to_utf8(&slow_log_filename, arg, pool));
+          slow_log_filename = svn_dirent_internal_style(slow_log_filename,
+                                                        pool);
+          SVN_ERR(svn_dirent_get_absolute(&slow_log_filename,
+                                          slow_log_filename, pool));
+          break;
+
+         case SVNSERVE_OPT_SLOW_REQUEST_TIME:
+          {
+            apr_int64_t msec;
+            SVN_ERR(svn_cstring_atoi64(&msec, arg));
+            if (msec < 0)
+              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("--slow-request-time must not be negative"));
+            params.slow_request_time = apr_time_from_msec(msec);
+          }
+          break;
+
         }
     }
 
@@ -1029,7 +1371,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   if (handling_opt_count > 1)
     {
       svn_error_clear(svn_cmdline_fputs(
-                      _("You may only specify one of -T or --single-thread\n"),
+                      _("You may only specify one of -T, --event-loop "
+                        "or --single-thread\n"),
                       stderr, pool));
       usage(argv[0], pool);
       *exit_code = EXIT_FAILURE;
@@ -1037,7 +1380,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
   /* construct object pools */
-  is_multi_threaded = handling_mode == connection_mode_thread;
+  is_multi_threaded = handling_mode == connection_mode_thread
+                   || handling_mode == connection_mode_event;
   params.fs_config = apr_hash_make(pool);
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1073,6 +1417,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else if (run_mode == run_mode_listen_once)
     SVN_ERR(logger__create_for_stderr(&params.logger, pool));
 
+  if (slow_log_filename)
+    SVN_ERR(logger__create(&params.slow_logger, slow_log_filename, pool));
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
@@ -1279,8 +1626,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     if (params.memory_cache_size != -1)
       settings.cache_size = params.memory_cache_size;
 
+    /* Report and log workers access the caches concurrently as well. */
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (is_multi_threaded || params.report_workers > 0
+        || params.log_workers > 0)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
@@ -1297,10 +1646,25 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_set(&settings);
   }
 
+  /* Responses get cached alongside the FS data, i.e. they compete for
+   * the same memory.  Prefer to keep the latter. */
+  if (cache_responses && svn_cache__get_global_membuffer_cache())
+    SVN_ERR(svn_cache__create_membuffer_cache(
+                &params.response_cache,
+                svn_cache__get_global_membuffer_cache(),
+                NULL, NULL, APR_HASH_KEY_STRING, "svnserve:responses:",
+                SVN_CACHE__MEMBUFFER_LOW_PRIORITY, is_multi_threaded,
+                FALSE, pool, pool));
+
+  if (checkout_cache_dir)
+    SVN_ERR(svn_repos__checkout_cache_create(&params.checkout_cache,
+                                             checkout_cache_dir,
+                                             checkout_cache_size, pool));
+
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
-  if (handling_mode == connection_mode_thread)
+  if (is_multi_threaded)
     {
       /* create the thread pool with a valid range of threads */
       if (max_thread_count < 1)
@@ -1330,6 +1694,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif
 
+#if APR_HAS_THREADS
+  if (handling_mode == connection_mode_event
+      && run_mode != run_mode_listen_once)
+    return svn_error_trace(serve_event_loop(sock, &params, pool));
+#endif
+
   while (1)
     {
       connection_t *connection = NULL;
@@ -1382,6 +1752,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
           break;
 
+        case connection_mode_event:
+          /* Handled by serve_event_loop(). */
+          break;
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           /* serve_socket() logs any error it returns, so ignore it. */
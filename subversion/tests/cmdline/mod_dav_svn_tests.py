@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import os, logging, base64, functools
+import os, re, logging, base64, functools, hashlib
 
 try:
   # Python <3.0
@@ -206,7 +206,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=604800, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -218,7 +218,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=604800, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -230,11 +230,232 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           'max-age=604800, immutable',
                                            r.getheader('Cache-Control'))
   r.read()
 
 
+@SkipUnless(svntest.main.is_ra_type_dav)
+def immutable_etag(sbox):
+  "verify strong ETags and conditional GETs"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  # GET /repos/!svn/rvr/1/iota
+  # The ETag of immutable contents is based on their SHA1.
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  etag = r.getheader('ETag')
+  if not etag or not etag.startswith('"sha1-'):
+    raise svntest.Failure('Unexpected ETag: %s' % etag)
+  r.read()
+
+  # The same contents at another URL have the same ETag.
+  h.request('GET', sbox.repo_url + '/iota?p=1', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'ETag', etag,
+                                           r.getheader('ETag'))
+  r.read()
+
+  # Revalidation with a matching ETag returns 304 Not Modified.
+  conditional_headers = dict(headers)
+  conditional_headers['If-None-Match'] = etag
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None,
+            conditional_headers)
+  r = h.getresponse()
+  if r.status != httplib.NOT_MODIFIED:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+  r.read()
+
+  # A different ETag returns the contents.
+  conditional_headers['If-None-Match'] = '"sha1-0"'
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None,
+            conditional_headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+  r.read()
+
+  # Unpegged resources keep their revision-based ETag.
+  h.request('GET', sbox.repo_url + '/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'ETag', '"1//iota"',
+                                           r.getheader('ETag'))
+  r.read()
+
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+def inline_small_files(sbox):
+  "skelta REPORT with small files inline"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  # OPTIONS advertises the capability.
+  h.request('OPTIONS', sbox.repo_url, None, headers)
+  r = h.getresponse()
+  r.read()
+  if 'http://subversion.tigris.org/xmlns/dav/svn/inline-files' \
+      not in r.getheader('DAV', ''):
+    raise svntest.Failure('Capability not advertised')
+
+  def checkout_report(extra_elements):
+    req_body = (
+      '<?xml version="1.0" encoding="utf-8"?>\n'
+      '<S:update-report xmlns:S="svn:">'
+      '<S:include-props>yes</S:include-props>'
+      + extra_elements +
+      '<S:src-path>' + sbox.repo_url + '</S:src-path>'
+      '<S:target-revision>1</S:target-revision>'
+      '<S:depth>infinity</S:depth>'
+      '<S:entry rev="1" depth="infinity" start-empty="true"></S:entry>'
+      '</S:update-report>'
+      )
+    h.request('REPORT', sbox.repo_url + '/!svn/me', req_body, headers)
+    r = h.getresponse()
+    if r.status != httplib.OK:
+      raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+    return r.read().decode()
+
+  # A plain skelta report has no contents.
+  response = checkout_report('')
+  if 'inline-max-size=' in response or '<S:txdelta' in response:
+    raise svntest.Failure('Unexpected inline contents:\n%s' % response)
+
+  # All files of the Greek tree are small enough to be inlined.
+  response = checkout_report('<S:inline-max-size>1024</S:inline-max-size>')
+  if 'inline-max-size="1024"' not in response:
+    raise svntest.Failure('Inlining not acknowledged:\n%s' % response)
+  if response.count('<S:txdelta') != 12:
+    raise svntest.Failure('Unexpected inline contents:\n%s' % response)
+
+  # None of them is as small as this.
+  response = checkout_report('<S:inline-max-size>10</S:inline-max-size>')
+  if '<S:txdelta' in response:
+    raise svntest.Failure('Unexpected inline contents:\n%s' % response)
+
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+def skelta_file_sizes(sbox):
+  "skelta REPORT announces file sizes"
+
+  sbox.build()
+  sbox.simple_append('iota', 'more\n')
+  sbox.simple_commit()
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  def update_report(entry):
+    req_body = (
+      '<?xml version="1.0" encoding="utf-8"?>\n'
+      '<S:update-report xmlns:S="svn:">'
+      '<S:src-path>' + sbox.repo_url + '</S:src-path>'
+      '<S:target-revision>2</S:target-revision>'
+      '<S:depth>infinity</S:depth>'
+      + entry +
+      '</S:update-report>'
+      )
+    h.request('REPORT', sbox.repo_url + '/!svn/me', req_body, headers)
+    r = h.getresponse()
+    if r.status != httplib.OK:
+      raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+    return r.read().decode()
+
+  def expect_size(response, element, name, size):
+    if not re.search(element + r'[^>]* size="%d"' % size, response):
+      raise svntest.Failure('No size="%d" for %s:\n%s'
+                            % (size, name, response))
+
+  # Every added file comes with the size of its contents.
+  response = update_report('<S:entry rev="2" depth="infinity" '
+                           'start-empty="true"></S:entry>')
+  if (response.count('<S:add-file ')
+      != len(re.findall(r'<S:add-file [^>]* size="\d+"', response))):
+    raise svntest.Failure('Missing sizes:\n%s' % response)
+  expect_size(response, r'<S:add-file name="iota"', 'iota', 30)
+  expect_size(response, r'<S:add-file name="mu"', 'mu', 23)
+
+  # So does a file that has to be fetched because it changed.
+  response = update_report('<S:entry rev="1" depth="infinity"></S:entry>')
+  expect_size(response, r'<S:fetch-file', 'iota', 30)
+
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+def sha1_get(sbox):
+  "GET file contents by their SHA1"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  # OPTIONS advertises the stub.
+  h.request('OPTIONS', sbox.repo_url, None, headers)
+  r = h.getresponse()
+  r.read()
+  sha1_stub = r.getheader('SVN-Sha1-Stub')
+  if not sha1_stub:
+    raise svntest.Failure('Missing SVN-Sha1-Stub header')
+
+  contents = b"This is the file 'iota'.\n"
+  url = sha1_stub + '/' + hashlib.sha1(contents).hexdigest()
+
+  def get(url, source):
+    get_headers = dict(headers)
+    if source:
+      get_headers['SVN-Sha1-Source'] = source
+    h.request('GET', url, None, get_headers)
+    r = h.getresponse()
+    return r, r.read()
+
+  # The contents are found through the named source.
+  r, body = get(url, '1/iota')
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'GET', [contents], [body])
+  if not r.getheader('ETag', '').startswith('"sha1-'):
+    raise svntest.Failure('Unexpected ETag: %s' % r.getheader('ETag'))
+
+  # A source with other contents doesn't provide them.
+  r, body = get(url, '1/A/mu')
+  if r.status != httplib.NOT_FOUND:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+
+  # Neither does a directory.
+  r, body = get(url, '1/A')
+  if r.status != httplib.NOT_FOUND:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+
+  # The source is required.
+  r, body = get(url, None)
+  if r.status != httplib.BAD_REQUEST:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+
+
 @SkipUnless(svntest.main.is_ra_type_dav)
 def simple_propfind(sbox):
   "verify simple PROPFIND responses"
@@ -647,6 +868,10 @@ def propfind_propname(sbox):
 # list all tests here, starting with None:
 test_list = [ None,
               cache_control_header,
+              immutable_etag,
+              inline_small_files,
+              skelta_file_sizes,
+              sha1_get,
               simple_propfind,
               propfind_multiple_props,
               propfind_404,
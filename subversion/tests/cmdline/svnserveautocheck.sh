@@ -31,6 +31,8 @@
 # distribution; it's easiest to just run it as "make svnserveautocheck".
 # Like "make check", you can specify further options like
 # "make svnserveautocheck FS_TYPE=bdb TESTS=subversion/tests/cmdline/basic.py".
+# Set THREADED to run svnserve with -T or EVENT_LOOP to run it with
+# --event-loop.
 
 PYTHON=${PYTHON:-python}
 
@@ -116,7 +118,9 @@ while \
   SVNSERVE_PORT=$(random_port)
 done
 
-if [ "$THREADED" != "" ]; then
+if [ "$EVENT_LOOP" != "" ]; then
+  SVNSERVE_ARGS="--event-loop"
+elif [ "$THREADED" != "" ]; then
   SVNSERVE_ARGS="-T"
 fi
 
@@ -27,7 +27,10 @@
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/id.h"
+#include "../../libsvn_fs_fs/index.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
 #include "../../libsvn_fs_fs/util.h"
@@ -36,6 +39,7 @@
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_string_private.h"
 
 #include "../svn_test_fs.h"
@@ -1180,6 +1184,163 @@ revprop_caching_on_off(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-revprop_generation_caching"
+static svn_error_t *
+revprop_generation_caching(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_fs_t *fs1;
+  svn_fs_t *fs2;
+  apr_hash_t *fs_config;
+  apr_hash_t *props;
+  svn_stringbuf_t *generation;
+  apr_int64_t old_generation;
+  apr_int64_t new_generation;
+  svn_string_t *value;
+  const svn_string_t *another_value_for_avoiding_warnings_from_a_broken_api;
+  const svn_string_t *new_value = svn_string_create("new", pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't track revprop generations");
+
+  /* Open two filesystem objects with revprop caching enabled. */
+  SVN_ERR(svn_test__create_fs(&fs1, REPO_NAME, opts, pool));
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, "1");
+
+  SVN_ERR(svn_fs_open2(&fs2, svn_fs_path(fs1, pool), fs_config, pool, pool));
+  svn_fs_set_warning_func(fs2, ignore_fs_warnings, NULL);
+
+  SVN_ERR(svn_stringbuf_from_file2(&generation,
+              svn_fs_fs__path_revprop_generation(fs1, pool), pool));
+  SVN_ERR(svn_cstring_atoi64(&old_generation, generation->data));
+
+  /* Populate the revprop cache of FS2.  A refresh must not fail nor
+   * invalidate the cached contents. */
+  SVN_ERR(svn_fs_revision_proplist2(&props, fs2, 0, FALSE, pool, pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", TRUE,
+                                pool, pool));
+  another_value_for_avoiding_warnings_from_a_broken_api = value;
+
+  /* Change the revprop through the other object. */
+  SVN_ERR(svn_fs_change_rev_prop2(
+              fs1, 0, "svn:date",
+              &another_value_for_avoiding_warnings_from_a_broken_api,
+              new_value, pool));
+
+  /* The generation file must have moved on to the next even value. */
+  SVN_ERR(svn_stringbuf_from_file2(&generation,
+              svn_fs_fs__path_revprop_generation(fs1, pool), pool));
+  SVN_ERR(svn_cstring_atoi64(&new_generation, generation->data));
+  SVN_TEST_ASSERT(new_generation == old_generation + 2);
+
+  /* After a refresh, FS2 must see the new value instead of the
+   * cached one. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", TRUE,
+                                pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "new");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+/* Read the revprop generation of the FSFS repository at PATH into
+ * *GENERATION.  Use POOL for allocations. */
+static svn_error_t *
+read_revprop_generation(apr_int64_t *generation,
+                        const char *path,
+                        apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_dirent_join(path,
+                                                   PATH_REVPROP_GENERATION,
+                                                   pool),
+                                   pool));
+  SVN_ERR(svn_cstring_atoi64(generation, contents->data));
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-revprop_generation_hotcopy"
+static svn_error_t *
+revprop_generation_hotcopy(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  const char *dst_path = REPO_NAME "-copy";
+  apr_hash_t *fs_config;
+  svn_string_t *value;
+  apr_int64_t old_generation;
+  apr_int64_t new_generation;
+  const svn_string_t *new_value = svn_string_create("new", pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't track revprop generations");
+
+  SVN_ERR(svn_test__create_fs(&src_fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_remove_dir2(dst_path, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_path, FALSE, FALSE,
+                          NULL, NULL, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(dst_path);
+
+  /* Have a long-running reader of the copy cache its revprops. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, "1");
+
+  SVN_ERR(svn_fs_open2(&dst_fs, dst_path, fs_config, pool, pool));
+  svn_fs_set_warning_func(dst_fs, ignore_fs_warnings, NULL);
+  SVN_ERR(svn_fs_revision_prop2(&value, dst_fs, 0, "svn:date", TRUE,
+                                pool, pool));
+  SVN_ERR(read_revprop_generation(&old_generation, dst_path, pool));
+
+  /* Change a revprop in the source and bring the copy up to date. */
+  SVN_ERR(svn_fs_change_rev_prop2(src_fs, 0, "svn:date", NULL, new_value,
+                                  pool));
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst_path, FALSE, TRUE,
+                          NULL, NULL, NULL, NULL, pool));
+
+  /* The copy must have moved on to a new, consistent generation ... */
+  SVN_ERR(read_revprop_generation(&new_generation, dst_path, pool));
+  SVN_TEST_ASSERT(new_generation > old_generation);
+  SVN_TEST_ASSERT(new_generation % 2 == 0);
+
+  /* ... such that the reader does not get the cached value. */
+  SVN_ERR(svn_fs_refresh_revision_props(dst_fs, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, dst_fs, 0, "svn:date", TRUE,
+                                pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "new");
+
+  /* Recovery must not go back to an older generation either. */
+  old_generation = new_generation;
+  SVN_ERR(svn_fs_recover(dst_path, NULL, NULL, pool));
+  SVN_ERR(read_revprop_generation(&new_generation, dst_path, pool));
+  SVN_TEST_ASSERT(new_generation > old_generation);
+  SVN_TEST_ASSERT(new_generation % 2 == 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 static svn_error_t *
 id_parser_test(const svn_test_opts_t *opts,
                apr_pool_t *pool)
@@ -1889,6 +2050,522 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 
 
+#define REPO_NAME "test-repo-block_read_ahead"
+
+/* Set *CACHED to the number of noderevs among the P2L ENTRIES
+ * (svn_fs_fs__p2l_entry_t *) that lie completely within [START, END) and
+ * are in FS' noderev cache.  Set *TOTAL to the number of noderevs in that
+ * range.  Use POOL for temporary allocations. */
+static svn_error_t *
+count_cached_noderevs(int *cached,
+                      int *total,
+                      svn_fs_t *fs,
+                      const apr_array_header_t *entries,
+                      apr_off_t start,
+                      apr_off_t end,
+                      apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  *cached = 0;
+  *total = 0;
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, const svn_fs_fs__p2l_entry_t *);
+      pair_cache_key_t key = { 0 };
+      svn_boolean_t found;
+
+      if (   entry->type != SVN_FS_FS__ITEM_TYPE_NODEREV
+          || entry->offset < start
+          || entry->offset + entry->size > end)
+        continue;
+
+      key.revision = entry->item.revision;
+      key.second = entry->item.number;
+      SVN_ERR(svn_cache__has_key(&found, ffd->node_revision_cache, &key,
+                                 pool));
+
+      ++*total;
+      if (found)
+        ++*cached;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+block_read_ahead(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  const char *conf_path;
+  apr_array_header_t *entries;
+  const svn_fs_fs__p2l_entry_t *first = NULL;
+  svn_fs_fs__id_part_t no_id = { 0 };
+  node_revision_t *noderev;
+  apr_off_t block_size, block_start;
+  int cached, total, i;
+
+  /* Skip this test unless we are FSFS 1.11+.  Block-read requires logical
+   * addressing, which is also checked below. */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 11)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support block read-ahead");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "block read-ahead requires logical addressing");
+
+  /* The block size is given in kBytes.  With 1 kB blocks, the rev file
+   * of the greek tree spans several blocks.  Read ahead 4 blocks. */
+  conf_path = svn_dirent_join(REPO_NAME, PATH_CONFIG, pool);
+  SVN_ERR(svn_io_remove_file2(conf_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(conf_path,
+                             "[" CONFIG_SECTION_IO "]\n"
+                             CONFIG_OPTION_BLOCK_SIZE " = 1\n"
+                             CONFIG_OPTION_BLOCK_READ_AHEAD " = 4\n",
+                             pool));
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  entries = apr_array_make(pool, 64, sizeof(svn_fs_fs__p2l_entry_t *));
+  SVN_ERR(svn_fs_fs__dump_index(fs, rev, receive_index, entries,
+                                NULL, NULL, pool));
+
+  /* Open a FS instance with cold caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  block_size = ffd->block_size;
+  SVN_TEST_ASSERT(block_size == 1024);
+  SVN_TEST_ASSERT(ffd->node_revision_cache);
+
+  /* Read the first noderev in r1.  That is a single block read. */
+  for (i = 0; i < entries->nelts && !first; ++i)
+    {
+      const svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, const svn_fs_fs__p2l_entry_t *);
+      if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
+        first = entry;
+    }
+
+  SVN_TEST_ASSERT(first);
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs,
+                                       svn_fs_fs__id_rev_create(&no_id,
+                                                                &no_id,
+                                                                &first->item,
+                                                                pool),
+                                       pool, pool));
+
+  /* Block-read parses the block containing FIRST plus the next one if an
+   * item crosses the boundary.  Read-ahead then covers the following 4
+   * blocks.  So, the noderevs in the 3 blocks after the next one must
+   * all be cached now. */
+  block_start = first->offset - first->offset % block_size;
+  SVN_ERR(count_cached_noderevs(&cached, &total, fs, entries,
+                                block_start + 2 * block_size,
+                                block_start + 5 * block_size, pool));
+  SVN_TEST_ASSERT(total > 0);
+  SVN_TEST_INT_ASSERT(cached, total);
+
+  /* Nothing beyond the read-ahead range must have been read. */
+  SVN_ERR(count_cached_noderevs(&cached, &total, fs, entries,
+                                block_start + 6 * block_size,
+                                APR_INT64_MAX, pool));
+  SVN_TEST_INT_ASSERT(cached, 0);
+
+  /* Read everything back.  The remaining items get read on demand. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__check_greek_tree(root, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-batch_noderev_fetch"
+
+static svn_error_t *
+batch_noderev_fetch(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+  apr_array_header_t *ids;
+  apr_array_header_t *noderevs;
+  svn_fs_id_t *root_id;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Use a FS instance with cold caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Request a sub-directory's entries in hash order, plus the root nodes
+   * of r0 and r1 and a duplicate. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "A/D/G", pool));
+  ids = apr_array_make(pool, 8, sizeof(const svn_fs_id_t *));
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      APR_ARRAY_PUSH(ids, const svn_fs_id_t *) = dirent->id;
+    }
+
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, 0, pool, pool));
+  APR_ARRAY_PUSH(ids, const svn_fs_id_t *) = root_id;
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, pool, pool));
+  APR_ARRAY_PUSH(ids, const svn_fs_id_t *) = root_id;
+  APR_ARRAY_PUSH(ids, const svn_fs_id_t *)
+    = APR_ARRAY_IDX(ids, 0, const svn_fs_id_t *);
+
+  SVN_ERR(svn_fs_fs__get_node_revisions(&noderevs, fs, ids, pool, pool));
+  SVN_TEST_INT_ASSERT(noderevs->nelts, ids->nelts);
+
+  /* Results must match what the single-noderev API returns. */
+  for (i = 0; i < ids->nelts; ++i)
+    {
+      const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+      node_revision_t *batch_noderev
+        = APR_ARRAY_IDX(noderevs, i, node_revision_t *);
+      node_revision_t *noderev;
+
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+      SVN_TEST_ASSERT(batch_noderev);
+      SVN_TEST_ASSERT(svn_fs_fs__id_eq(batch_noderev->id, id));
+      SVN_TEST_ASSERT(batch_noderev->kind == noderev->kind);
+      SVN_TEST_STRING_ASSERT(batch_noderev->created_path,
+                             noderev->created_path);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-binary_directories"
+
+static svn_error_t *
+binary_directories(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  svn_stream_t *stream;
+  svn_stringbuf_t *text;
+  svn_stringbuf_t *written;
+  apr_array_header_t *entries;
+  static const char *expected_names[] = { "p", "pi", "pi2", "rho", "tau" };
+  int i;
+
+  /* Skip this test unless we are FSFS f9+ */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 11)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't store binary directories");
+
+  /* r1: the greek tree plus a few entries sharing name prefixes. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_make_file(root, "A/D/G/pi2", pool));
+  SVN_ERR(svn_fs_make_dir(root, "A/D/G/p", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Use a FS instance with cold caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__check_greek_tree(root, pool));
+
+  /* The directory rep must use the binary encoding. */
+  SVN_ERR(svn_fs_node_id(&id, root, "A/D/G", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->data_rep, FALSE,
+                                  pool));
+  SVN_ERR(svn_stringbuf_from_stream(&text, stream, 0, pool));
+  SVN_TEST_ASSERT(svn_fs_fs__is_binary_dir(text->data, text->len));
+
+  SVN_ERR(svn_fs_fs__read_binary_dir(&entries, text->data, text->len,
+                                     pool, pool));
+  SVN_TEST_INT_ASSERT(entries->nelts, 5);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      SVN_TEST_STRING_ASSERT(dirent->name, expected_names[i]);
+      SVN_TEST_ASSERT(dirent->kind == (i == 0 ? svn_node_dir
+                                              : svn_node_file));
+      SVN_TEST_ASSERT(svn_fs_fs__id_rev(dirent->id) == rev);
+    }
+
+  /* Writing the entries again must give the same data. */
+  written = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_fs_fs__write_binary_dir(svn_stream_from_stringbuf(written,
+                                                                pool),
+                                      entries, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(text, written));
+
+  /* Truncated data must be detected. */
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__read_binary_dir(&entries, text->data,
+                                                   text->len - 1,
+                                                   pool, pool),
+                        SVN_ERR_FS_CORRUPT);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-large_txn_directory"
+
+static svn_error_t *
+large_txn_directory(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_t *fs2;
+  svn_fs_txn_t *txn;
+  svn_fs_txn_t *txn2;
+  svn_fs_root_t *root;
+  svn_fs_root_t *root2;
+  svn_revnum_t rev;
+  const char *txn_name;
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  enum { COUNT = 2000 };
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+
+  /* Add many entries in no particular order, so they get inserted all
+   * over the directory, and remove every third of them again. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root,
+                               apr_psprintf(iterpool, "big/f%05d",
+                                            (i * 7919) % COUNT),
+                               iterpool));
+    }
+
+  for (i = 0; i < COUNT; i += 3)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_delete(root, apr_psprintf(iterpool, "big/f%05d", i),
+                            iterpool));
+    }
+
+  /* Change the directory through another FS instance.  Our instance
+   * must pick up these changes as well. */
+  SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open_txn(&txn2, fs2, txn_name, pool));
+  SVN_ERR(svn_fs_txn_root(&root2, txn2, pool));
+  SVN_ERR(svn_fs_make_dir(root2, "big/f00000", pool));
+  SVN_ERR(svn_fs_delete(root2, "big/f00001", pool));
+
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f00000", pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f00001", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f00002", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f00003", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* 667 entries got deleted, one got re-added and another one deleted. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), COUNT - 667);
+
+  /* The committed directory must match the txn contents. */
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), COUNT - 667);
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      svn_fs_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      dirent = svn_hash_gets(entries, apr_psprintf(iterpool, "f%05d", i));
+      if (i == 0)
+        SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+      else if (i % 3 == 0 || i == 1)
+        SVN_TEST_ASSERT(dirent == NULL);
+      else
+        SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-plain_file_range"
+
+/* Verify that svn_fs__try_get_file_range() under ROOT provides exactly
+   CONTENTS for PATH.  Use POOL for allocations. */
+static svn_error_t *
+check_file_range(svn_fs_root_t *root,
+                 const char *path,
+                 const svn_stringbuf_t *contents,
+                 apr_pool_t *pool)
+{
+  svn_boolean_t success;
+  apr_file_t *file;
+  apr_off_t offset;
+  svn_filesize_t length;
+  char *buffer;
+
+  SVN_ERR(svn_fs__try_get_file_range(&success, &file, &offset, &length,
+                                     root, path, pool, pool));
+  SVN_TEST_ASSERT(success);
+  SVN_TEST_ASSERT(length == contents->len);
+
+  buffer = apr_palloc(pool, contents->len);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, contents->len, NULL, NULL,
+                                 pool));
+  SVN_TEST_ASSERT(memcmp(buffer, contents->data, contents->len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+plain_file_range(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents, *read_back;
+  svn_boolean_t success;
+  apr_file_t *file;
+  apr_off_t offset;
+  svn_filesize_t length;
+  const char *conf_path;
+  apr_size_t i;
+
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 11)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support plain fulltexts");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Store all file contents as PLAIN fulltexts. */
+  conf_path = svn_dirent_join(REPO_NAME, PATH_CONFIG, pool);
+  SVN_ERR(svn_io_remove_file2(conf_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(conf_path,
+                             "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                             CONFIG_OPTION_MAX_DELTIFICATION_WALK " = 0\n"
+                             CONFIG_OPTION_STORE_PLAIN_FULLTEXTS " = true\n",
+                             pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  contents = svn_stringbuf_create_ensure(100000, pool);
+  for (i = 0; i < 100000; ++i)
+    svn_stringbuf_appendbyte(contents, (char)('a' + i % 23));
+
+  /* r1: add a large file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "/file", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "/file", contents->data, pool));
+
+  /* Uncommitted data must not be exposed. */
+  SVN_ERR(svn_fs__try_get_file_range(&success, &file, &offset, &length,
+                                     root, "/file", pool, pool));
+  SVN_TEST_ASSERT(!success);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(check_file_range(root, "/file", contents, pool));
+
+  /* r2: modify it. */
+  contents->data[50000] = 'X';
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "/file", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(check_file_range(root, "/file", contents, pool));
+
+  /* The regular read path must still work for PLAIN reps. */
+  SVN_ERR(svn_test__get_file_contents(root, "/file", &read_back, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(read_back, contents));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1928,6 +2605,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "metadata checksums being checked"),
     SVN_TEST_OPTS_PASS(revprop_caching_on_off,
                        "change revprops with enabled and disabled caching"),
+    SVN_TEST_OPTS_PASS(revprop_generation_caching,
+                       "revprop caching across FS instances"),
+    SVN_TEST_OPTS_PASS(revprop_generation_hotcopy,
+                       "revprop generation after hotcopy and recover"),
     SVN_TEST_OPTS_PASS(id_parser_test,
                        "id parser test"),
     SVN_TEST_OPTS_PASS(plain_0_length,
@@ -1942,6 +2623,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(block_read_ahead,
+                       "read ahead following blocks in FSFS"),
+    SVN_TEST_OPTS_PASS(batch_noderev_fetch,
+                       "fetch multiple noderevs in one batch"),
+    SVN_TEST_OPTS_PASS(binary_directories,
+                       "binary directory representations"),
+    SVN_TEST_OPTS_PASS(large_txn_directory,
+                       "many changes to a single txn directory"),
+    SVN_TEST_OPTS_PASS(plain_file_range,
+                       "locate PLAIN file contents in rev files"),
     SVN_TEST_NULL
   };
 
@@ -36,10 +36,17 @@
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_props.h"
+#include "svn_ra_svn.h"
+
+#include "private/svn_ra_svn_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
 #include "../../libsvn_ra_local/ra_local.h"
+#include "../../libsvn_ra_serf/fetch_sched.h"
+
+#include "svn_private_config.h"
 
 /*-------------------------------------------------------------------*/
 
@@ -143,6 +150,8 @@ typedef struct tunnel_baton_t
   int magic; /* TUNNEL_MAGIC */
   int open_count;
   svn_boolean_t last_check;
+  svn_boolean_t stream_compression; /* Run svnserve --stream-compression */
+  svn_boolean_t cache_responses; /* Run svnserve --cache-responses yes */
 } tunnel_baton_t;
 
 #define TUNNEL_MAGIC 0xF00DF00F
@@ -185,13 +194,23 @@ open_tunnel(svn_stream_t **request, svn_stream_t **response,
   apr_proc_t *proc;
   apr_procattr_t *attr;
   apr_status_t status;
-  const char *args[] = { "svnserve", "-t", "-r", ".", NULL };
+  const char *args[] = { "svnserve", "-t", "-r", ".",
+                         NULL, NULL, NULL, NULL };
+  int arg_count = 4;
   const char *svnserve;
   tunnel_baton_t *b = tunnel_baton;
   close_baton_t *cb;
 
   SVN_TEST_ASSERT(b->magic == TUNNEL_MAGIC);
 
+  if (b->stream_compression)
+    args[arg_count++] = "--stream-compression";
+  if (b->cache_responses)
+    {
+      args[arg_count++] = "--cache-responses";
+      args[arg_count++] = "yes";
+    }
+
   SVN_ERR(svn_dirent_get_absolute(&svnserve, "../../svnserve/svnserve", pool));
 #ifdef WIN32
   svnserve = apr_pstrcat(pool, svnserve, ".exe", SVN_VA_NULL);
@@ -1784,6 +1803,697 @@ commit_locked_file(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Baton for get_files_receiver. */
+typedef struct get_files_baton_t
+{
+  /* Per requested file: the fetched contents, revision and properties. */
+  svn_stringbuf_t *contents[3];
+  svn_revnum_t revs[3];
+  apr_hash_t *props[3];
+  apr_pool_t *pool;
+} get_files_baton_t;
+
+/* Implements svn_ra_file_receiver_t. */
+static svn_error_t *
+get_files_receiver(svn_stream_t **stream,
+                   void *baton,
+                   int idx,
+                   svn_revnum_t fetched_rev,
+                   apr_hash_t *props,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  get_files_baton_t *b = baton;
+
+  SVN_TEST_ASSERT(idx >= 0 && idx < 3);
+  SVN_TEST_ASSERT(b->contents[idx] == NULL);
+
+  b->contents[idx] = svn_stringbuf_create_empty(b->pool);
+  b->revs[idx] = fetched_rev;
+  b->props[idx] = props ? svn_prop_hash_dup(props, b->pool) : NULL;
+  *stream = svn_stream_from_stringbuf(b->contents[idx], result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the contents of the file FILE_BATON of EDITOR with CONTENTS. */
+static svn_error_t *
+put_file_contents(const svn_delta_editor_t *editor,
+                  void *file_baton,
+                  const char *contents,
+                  apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool, &handler,
+                                  &handler_baton));
+  SVN_ERR(svn_txdelta_send_string(svn_string_create(contents, pool),
+                                  handler, handler_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit r1 with files A/f and A/g and r2 changing A/f through SESSION
+   and check that svn_ra_get_files() fetches the expected data. */
+static svn_error_t *
+check_get_files(svn_ra_session_t *session,
+                apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  void *root_baton, *dir_baton, *file_baton;
+  apr_array_header_t *files = apr_array_make(pool, 3,
+                                             sizeof(svn_ra_file_spec_t *));
+  svn_ra_file_spec_t *spec;
+  get_files_baton_t b = { { NULL } };
+  svn_string_t *propval;
+
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool),
+                                    NULL, NULL, NULL, TRUE, pool));
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                            pool, &root_baton));
+  SVN_ERR(editor->add_directory("A", root_baton, NULL, SVN_INVALID_REVNUM,
+                                pool, &dir_baton));
+  SVN_ERR(editor->add_file("A/f", dir_baton, NULL, SVN_INVALID_REVNUM,
+                           pool, &file_baton));
+  SVN_ERR(put_file_contents(editor, file_baton, "alpha", pool));
+  SVN_ERR(editor->change_file_prop(file_baton, "propname",
+                                   svn_string_create("propval", pool),
+                                   pool));
+  SVN_ERR(editor->close_file(file_baton, NULL, pool));
+  SVN_ERR(editor->add_file("A/g", dir_baton, NULL, SVN_INVALID_REVNUM,
+                           pool, &file_baton));
+  SVN_ERR(put_file_contents(editor, file_baton, "gamma", pool));
+  SVN_ERR(editor->close_file(file_baton, NULL, pool));
+  SVN_ERR(editor->close_directory(dir_baton, pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool),
+                                    NULL, NULL, NULL, TRUE, pool));
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                            pool, &root_baton));
+  SVN_ERR(editor->open_directory("A", root_baton, SVN_INVALID_REVNUM,
+                                 pool, &dir_baton));
+  SVN_ERR(editor->open_file("A/f", dir_baton, SVN_INVALID_REVNUM,
+                            pool, &file_baton));
+  SVN_ERR(put_file_contents(editor, file_baton, "alpha2", pool));
+  SVN_ERR(editor->close_file(file_baton, NULL, pool));
+  SVN_ERR(editor->close_directory(dir_baton, pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  spec = apr_pcalloc(pool, sizeof(*spec));
+  spec->path = "A/f";
+  spec->revision = 1;
+  APR_ARRAY_PUSH(files, svn_ra_file_spec_t *) = spec;
+  spec = apr_pcalloc(pool, sizeof(*spec));
+  spec->path = "A/g";
+  spec->revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(files, svn_ra_file_spec_t *) = spec;
+  spec = apr_pcalloc(pool, sizeof(*spec));
+  spec->path = "A/f";
+  spec->revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(files, svn_ra_file_spec_t *) = spec;
+
+  b.pool = pool;
+  SVN_ERR(svn_ra_get_files(session, files, TRUE, TRUE,
+                           get_files_receiver, &b, pool));
+
+  SVN_TEST_STRING_ASSERT(b.contents[0]->data, "alpha");
+  SVN_TEST_STRING_ASSERT(b.contents[1]->data, "gamma");
+  SVN_TEST_STRING_ASSERT(b.contents[2]->data, "alpha2");
+  SVN_TEST_INT_ASSERT(b.revs[0], 1);
+  SVN_TEST_INT_ASSERT(b.revs[1], 2);
+  SVN_TEST_INT_ASSERT(b.revs[2], 2);
+  propval = svn_hash_gets(b.props[0], "propname");
+  SVN_TEST_ASSERT(propval);
+  SVN_TEST_STRING_ASSERT(propval->data, "propval");
+  SVN_TEST_ASSERT(svn_hash_gets(b.props[0], SVN_PROP_ENTRY_COMMITTED_REV));
+  SVN_TEST_ASSERT(!svn_hash_gets(b.props[1], "propname"));
+
+  /* Without properties. */
+  memset(&b, 0, sizeof(b));
+  b.pool = pool;
+  SVN_ERR(svn_ra_get_files(session, files, FALSE, TRUE,
+                           get_files_receiver, &b, pool));
+  SVN_TEST_STRING_ASSERT(b.contents[2]->data, "alpha2");
+  SVN_TEST_ASSERT(b.props[2] == NULL);
+
+  /* Processing stops at the first failing file. */
+  spec = APR_ARRAY_IDX(files, 1, svn_ra_file_spec_t *);
+  spec->path = "Z";
+  memset(&b, 0, sizeof(b));
+  b.pool = pool;
+  SVN_TEST_ASSERT_ERROR(svn_ra_get_files(session, files, TRUE, TRUE,
+                                         get_files_receiver, &b, pool),
+                        SVN_ERR_FS_NOT_FOUND);
+  SVN_TEST_STRING_ASSERT(b.contents[0]->data, "alpha");
+  SVN_TEST_ASSERT(b.contents[2] == NULL);
+
+  spec->path = "A";
+  memset(&b, 0, sizeof(b));
+  b.pool = pool;
+  SVN_TEST_ASSERT_ERROR(svn_ra_get_files(session, files, TRUE, TRUE,
+                                         get_files_receiver, &b, pool),
+                        SVN_ERR_FS_NOT_FILE);
+
+  /* The session is still usable. */
+  SVN_ERR(svn_ra_get_file(session, "A/f", 1, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+
+  SVN_ERR(make_and_open_repos(&session, "test-get-files", opts, pool));
+  SVN_ERR(check_get_files(session, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Create a new repository TUNNEL_REPOS_NAME and open *SESSION to it,
+   allocated in POOL, through a tunnel configured by B. */
+static svn_error_t *
+make_tunnel_session(svn_ra_session_t **session,
+                    const svn_test_opts_t *opts,
+                    const char *tunnel_repos_name,
+                    tunnel_baton_t *b,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+     (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_destroy(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(session, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Run check_get_files over a tunnel to a new repository TUNNEL_REPOS_NAME
+   with svnserve's --stream-compression option set to STREAM_COMPRESSION. */
+static svn_error_t *
+run_tunnel_get_files(const svn_test_opts_t *opts,
+                     const char *tunnel_repos_name,
+                     svn_boolean_t stream_compression,
+                     apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_ra_session_t *session;
+
+  b->stream_compression = stream_compression;
+  SVN_ERR(make_tunnel_session(&session, opts, tunnel_repos_name, b,
+                              scratch_pool));
+  SVN_ERR(check_get_files(session, scratch_pool));
+
+  svn_pool_destroy(scratch_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tunnel_get_files_test(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  return svn_error_trace(run_tunnel_get_files(opts, "test-tunnel-get-files",
+                                              FALSE, pool));
+}
+
+static svn_error_t *
+tunnel_stream_compression_test(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  /* The same traffic as above but through a compressed connection. */
+  return svn_error_trace(run_tunnel_get_files(opts,
+                                              "test-tunnel-compression",
+                                              TRUE, pool));
+}
+
+/* Fetch the entries of "A/B" in r1 through SESSION and verify that their
+   last author is AUTHOR or, if AUTHOR is NULL, return it in *AUTHOR_P.
+   Use POOL for all allocations. */
+static svn_error_t *
+check_dir_author(const char **author_p,
+                 svn_ra_session_t *session,
+                 const char *author,
+                 apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "A/B", 1,
+                          SVN_DIRENT_ALL, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+
+  dirent = svn_hash_gets(dirents, "f");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_ASSERT(dirent->created_rev == 1);
+  if (author)
+    SVN_TEST_STRING_ASSERT(dirent->last_author, author);
+
+  if (author_p)
+    *author_p = dirent->last_author;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tunnel_response_cache_test(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  const char *repos_name = "test-tunnel-response-cache";
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  svn_dirent_t *dirent;
+  const char *author;
+  int i;
+
+  b->cache_responses = TRUE;
+  SVN_ERR(make_tunnel_session(&session, opts, repos_name, b, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  /* Repeated queries must yield the same result, whether or not they are
+   * answered from the cache. */
+  SVN_ERR(check_dir_author(&author, session, NULL, pool));
+  for (i = 0; i < 3; ++i)
+    {
+      SVN_ERR(check_dir_author(NULL, session, author, pool));
+
+      SVN_ERR(svn_ra_stat(session, "A/B/g", 1, &dirent, pool));
+      SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+      SVN_TEST_ASSERT(dirent->created_rev == 1);
+
+      SVN_ERR(svn_ra_stat(session, "A/B/h", 1, &dirent, pool));
+      SVN_TEST_ASSERT(dirent == NULL);
+    }
+
+  /* Changing a revprop behind svnserve's back must not leave stale
+   * responses behind. */
+  SVN_ERR(svn_repos_open3(&repos, repos_name, NULL, pool, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), 1,
+                                  SVN_PROP_REVISION_AUTHOR, NULL,
+                                  svn_string_create("someone-else", pool),
+                                  pool));
+  SVN_ERR(check_dir_author(NULL, session, "someone-else", pool));
+  SVN_ERR(check_dir_author(NULL, session, "someone-else", pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a connection that reads TRANSCRIPT. */
+static svn_ra_svn_conn_t *
+create_transcript_conn(const char *transcript,
+                       apr_pool_t *pool)
+{
+  return svn_ra_svn_create_conn5(NULL,
+                                 svn_stream_from_string(
+                                   svn_string_create(transcript, pool),
+                                   pool),
+                                 svn_stream_empty(pool),
+                                 0, 0, 0, 0, 0, pool);
+}
+
+static svn_error_t *
+ra_svn_read_items(apr_pool_t *pool)
+{
+  svn_stringbuf_t *transcript = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_ra_svn_conn_t *conn;
+  svn_ra_svn__item_t *item;
+  int i;
+
+  /* Generate a transcript much larger than the connection's read buffer
+     with a few strings larger than the buffer itself.  Items will then
+     be parsed from the buffer as well as while streaming. */
+  for (i = 0; i < 1000; i++)
+    {
+      apr_size_t len = (i % 250 == 99) ? 40000 : i % 50;
+      svn_stringbuf_t *str = svn_stringbuf_create_ensure(len, iterpool);
+
+      svn_stringbuf_appendfill(str, 'x', len);
+      svn_stringbuf_appendcstr(transcript,
+                               apr_psprintf(iterpool,
+                                            "( item-%d %d %" APR_SIZE_T_FMT
+                                            ":%s ( ( ) %d ) )%s",
+                                            i, i, len, str->data, i * 7,
+                                            i % 3 ? " " : "\n  "));
+    }
+
+  conn = create_transcript_conn(transcript->data, pool);
+  for (i = 0; i < 1000; i++)
+    {
+      svn_ra_svn__list_t *list;
+      svn_ra_svn__item_t *elt;
+      apr_size_t len = (i % 250 == 99) ? 40000 : i % 50;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+
+      SVN_TEST_ASSERT(item->kind == SVN_RA_SVN_LIST);
+      list = &item->u.list;
+      SVN_TEST_INT_ASSERT(list->nelts, 4);
+
+      elt = &SVN_RA_SVN__LIST_ITEM(list, 0);
+      SVN_TEST_ASSERT(elt->kind == SVN_RA_SVN_WORD);
+      SVN_TEST_STRING_ASSERT(elt->u.word.data,
+                             apr_psprintf(iterpool, "item-%d", i));
+
+      elt = &SVN_RA_SVN__LIST_ITEM(list, 1);
+      SVN_TEST_ASSERT(elt->kind == SVN_RA_SVN_NUMBER);
+      SVN_TEST_INT_ASSERT(elt->u.number, i);
+
+      elt = &SVN_RA_SVN__LIST_ITEM(list, 2);
+      SVN_TEST_ASSERT(elt->kind == SVN_RA_SVN_STRING);
+      SVN_TEST_INT_ASSERT(elt->u.string.len, len);
+      SVN_TEST_ASSERT(elt->u.string.data[len] == '\0');
+      SVN_TEST_ASSERT(len == 0 || (   elt->u.string.data[0] == 'x'
+                                   && elt->u.string.data[len - 1] == 'x'));
+
+      elt = &SVN_RA_SVN__LIST_ITEM(list, 3);
+      SVN_TEST_ASSERT(elt->kind == SVN_RA_SVN_LIST);
+      list = &elt->u.list;
+      SVN_TEST_INT_ASSERT(list->nelts, 2);
+      SVN_TEST_ASSERT(SVN_RA_SVN__LIST_ITEM(list, 0).kind == SVN_RA_SVN_LIST);
+      SVN_TEST_INT_ASSERT(SVN_RA_SVN__LIST_ITEM(list, 0).u.list.nelts, 0);
+      SVN_TEST_ASSERT(SVN_RA_SVN__LIST_ITEM(list, 1).kind
+                      == SVN_RA_SVN_NUMBER);
+      SVN_TEST_INT_ASSERT(SVN_RA_SVN__LIST_ITEM(list, 1).u.number, i * 7);
+    }
+
+  SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                        SVN_ERR_RA_SVN_CONNECTION_CLOSED);
+
+  /* Malformed data must be rejected, no matter which parser sees it. */
+  conn = create_transcript_conn("( abc) ", pool);
+  SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                        SVN_ERR_RA_SVN_MALFORMED_DATA);
+  conn = create_transcript_conn("( abcdefghijklmnopqrstuvwxyz ) ", pool);
+  SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                        SVN_ERR_RA_SVN_MALFORMED_DATA);
+  conn = create_transcript_conn("( 3:ab)x ) ", pool);
+  SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                        SVN_ERR_RA_SVN_MALFORMED_DATA);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_write_items(apr_pool_t *pool)
+{
+  svn_stringbuf_t *output = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *large = svn_stringbuf_create_empty(pool);
+  const svn_ra_svn__io_stats_t *stats;
+  svn_ra_svn_conn_t *conn;
+  svn_ra_svn__item_t *item;
+  int i;
+
+  svn_stringbuf_appendfill(large, 'x', 20000);
+  conn = svn_ra_svn_create_conn5(NULL, svn_stream_empty(pool),
+                                 svn_stream_from_stringbuf(output, pool),
+                                 0, 0, 0, 0, 0, pool);
+
+  /* Interleave buffered data with strings that bypass the write buffer.
+     Both must arrive in the original order. */
+  for (i = 0; i < 10; i++)
+    {
+      svn_string_t str;
+
+      str.data = large->data;
+      str.len = (i % 2) ? large->len : i;
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "wns", "item",
+                                      (apr_uint64_t)i, &str));
+      svn_stringbuf_appendcstr(expected,
+                               apr_psprintf(pool, "( item %d %" APR_SIZE_T_FMT
+                                            ":", i, str.len));
+      svn_stringbuf_appendbytes(expected, str.data, str.len);
+      svn_stringbuf_appendcstr(expected, " ) ");
+    }
+
+  SVN_ERR(svn_ra_svn__flush(conn, pool));
+  SVN_TEST_STRING_ASSERT(output->data, expected->data);
+
+  stats = svn_ra_svn__get_io_stats(conn);
+  SVN_TEST_INT_ASSERT(stats->bytes_sent, output->len);
+  SVN_TEST_ASSERT(stats->send_calls > 0);
+  SVN_TEST_INT_ASSERT(stats->bytes_received, 0);
+
+  /* Reading accounts for the data as well. */
+  conn = create_transcript_conn(output->data, pool);
+  for (i = 0; i < 10; i++)
+    SVN_ERR(svn_ra_svn__read_item(conn, pool, &item));
+
+  stats = svn_ra_svn__get_io_stats(conn);
+  SVN_TEST_INT_ASSERT(stats->bytes_received, output->len);
+  SVN_TEST_ASSERT(stats->receive_calls > 0);
+  SVN_TEST_INT_ASSERT(stats->bytes_sent, 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_svn__command_cb_t, appending the notifications to
+   the svn_stringbuf_t BATON. */
+static svn_error_t *
+record_command_cb(void *baton,
+                  svn_ra_svn_conn_t *conn,
+                  const char *cmdname,
+                  svn_boolean_t finished,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *log = baton;
+
+  svn_stringbuf_appendcstr(log, cmdname);
+  svn_stringbuf_appendcstr(log, finished ? "-end " : "-start ");
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_svn__command_handler.
+   Handles nested commands the way e.g. the reporter does. */
+static svn_error_t *
+nesting_command(svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool,
+                svn_ra_svn__list_t *params,
+                void *baton)
+{
+  static const svn_ra_svn__cmd_entry_t nested_commands[] =
+    {
+      { "inner", nesting_command },
+      { "done",  nesting_command, NULL, TRUE },
+      { NULL }
+    };
+
+  if (baton)
+    SVN_ERR(svn_ra_svn__handle_commands2(conn, pool, nested_commands,
+                                         NULL, TRUE));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_command_callback(apr_pool_t *pool)
+{
+  static const svn_ra_svn__cmd_entry_t commands[] =
+    {
+      { "outer", nesting_command },
+      { NULL }
+    };
+
+  svn_stringbuf_t *log = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *conn
+    = create_transcript_conn("( outer ( ) ) ( inner ( ) ) ( done ( ) ) "
+                             "( outer ( ) ) ( done ( ) ) "
+                             "( unknown ( ) ) ", pool);
+
+  svn_ra_svn__set_command_callback(conn, record_command_cb, log);
+  SVN_ERR(svn_ra_svn__handle_commands2(conn, pool, commands, log, FALSE));
+
+  /* Nested and unknown commands don't get reported. */
+  SVN_TEST_STRING_ASSERT(log->data,
+                         "outer-start outer-end outer-start outer-end ");
+
+  return SVN_NO_ERROR;
+}
+
+#ifdef SVN_LIBSVN_RA_LINKS_RA_SERF
+/* Take the next fetch from SCHED, which has NUM_CONNS connections, at
+   time NOW.  Verify that it is EXPECTED_NAME, sent on connection
+   EXPECTED_CONN, or that there is none if EXPECTED_NAME is NULL. */
+static svn_error_t *
+check_next_fetch(svn_ra_serf__fetch_sched_t *sched,
+                 int num_conns,
+                 apr_time_t now,
+                 const char *expected_name,
+                 int expected_conn)
+{
+  int conn_idx = -1;
+  const char *name = svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0,
+                                                   num_conns, now);
+
+  SVN_TEST_STRING_ASSERT(name, expected_name);
+  if (expected_name)
+    SVN_TEST_INT_ASSERT(conn_idx, expected_conn);
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+static svn_error_t *
+ra_serf_fetch_order(apr_pool_t *pool)
+{
+#ifdef SVN_LIBSVN_RA_LINKS_RA_SERF
+  svn_ra_serf__fetch_sched_t *sched
+    = svn_ra_serf__fetch_sched_create(2, 2, 8, 0, pool);
+  const svn_ra_serf__fetch_stats_t *stats
+    = svn_ra_serf__fetch_sched_stats(sched);
+  char names[] = "A\0B\0C\0D\0E";
+
+  /* Small files go first, files of unknown size count as medium sized,
+     and files queued later are treated as if they were larger. */
+  svn_ra_serf__fetch_sched_queue(sched, &names[0], 100000);
+  svn_ra_serf__fetch_sched_queue(sched, &names[2], 10);
+  svn_ra_serf__fetch_sched_queue(sched, &names[4], -1);
+  svn_ra_serf__fetch_sched_queue(sched, &names[6], 500);
+  svn_ra_serf__fetch_sched_queue(sched, &names[8], 50);
+
+  /* The fetches get spread over both connections until their pipelines
+     are full. */
+  SVN_ERR(check_next_fetch(sched, 2, 0, "B", 0));
+  SVN_ERR(check_next_fetch(sched, 2, 0, "D", 1));
+  SVN_ERR(check_next_fetch(sched, 2, 0, "E", 0));
+  SVN_ERR(check_next_fetch(sched, 2, 0, "C", 1));
+  SVN_ERR(check_next_fetch(sched, 2, 0, NULL, 0));
+  SVN_TEST_INT_ASSERT(svn_ra_serf__fetch_sched_depth(sched, 2), 4);
+  SVN_TEST_INT_ASSERT(stats->queued, 5);
+  SVN_TEST_INT_ASSERT(stats->max_queued, 5);
+  SVN_TEST_INT_ASSERT(stats->max_in_flight, 4);
+  SVN_TEST_INT_ASSERT(stats->completed, 0);
+
+  /* Completing a fetch makes room for the next one. */
+  svn_ra_serf__fetch_sched_completed(sched, 0, 10, 1000);
+  SVN_ERR(check_next_fetch(sched, 2, 1000, "A", 0));
+  SVN_ERR(check_next_fetch(sched, 2, 1000, NULL, 0));
+  SVN_TEST_INT_ASSERT(stats->completed, 1);
+  SVN_TEST_INT_ASSERT(stats->bytes, 10);
+  SVN_TEST_INT_ASSERT(stats->max_in_flight, 4);
+  SVN_TEST_INT_ASSERT(stats->max_depth, 2);
+  SVN_TEST_INT_ASSERT(stats->min_latency, 0);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "libsvn_ra_serf is not linked into libsvn_ra");
+#endif
+}
+
+static svn_error_t *
+ra_serf_fetch_pipeline_depth(apr_pool_t *pool)
+{
+#ifdef SVN_LIBSVN_RA_LINKS_RA_SERF
+  svn_ra_serf__fetch_sched_t *sched;
+  const svn_ra_serf__fetch_stats_t *stats;
+  char fetch[1];
+  int conn_idx;
+  int i;
+
+  /* Small responses arriving 1ms apart after a round trip of 10ms:
+     The connection is latency bound and gets a deeper pipeline. */
+  sched = svn_ra_serf__fetch_sched_create(1, 8, 64, 0, pool);
+  for (i = 0; i < 20; i++)
+    svn_ra_serf__fetch_sched_queue(sched, fetch, 1000);
+
+  for (i = 0; i < 8; i++)
+    SVN_TEST_ASSERT(svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0, 1, 0));
+  SVN_TEST_ASSERT(!svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0, 1, 0));
+
+  for (i = 0; i < 8; i++)
+    {
+      svn_ra_serf__fetch_sched_started(sched, 0, 0, 10000 + i * 1000);
+      svn_ra_serf__fetch_sched_completed(sched, 0, 1000, 11000 + i * 1000);
+    }
+  SVN_TEST_INT_ASSERT(svn_ra_serf__fetch_sched_depth(sched, 1), 10);
+
+  for (i = 0; i < 10; i++)
+    SVN_TEST_ASSERT(svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0, 1,
+                                                  20000));
+  SVN_TEST_ASSERT(!svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0, 1,
+                                                 20000));
+
+  stats = svn_ra_serf__fetch_sched_stats(sched);
+  SVN_TEST_INT_ASSERT(stats->queued, 20);
+  SVN_TEST_INT_ASSERT(stats->max_queued, 20);
+  SVN_TEST_INT_ASSERT(stats->completed, 8);
+  SVN_TEST_INT_ASSERT(stats->bytes, 8000);
+  SVN_TEST_INT_ASSERT(stats->max_in_flight, 10);
+  SVN_TEST_INT_ASSERT(stats->max_depth, 10);
+  SVN_TEST_INT_ASSERT(stats->min_latency, 10000);
+
+  /* Large responses arriving 100ms apart: The connection is bandwidth
+     bound and the pipeline shrinks to its minimum. */
+  sched = svn_ra_serf__fetch_sched_create(1, 8, 64, 0, pool);
+  for (i = 0; i < 8; i++)
+    {
+      svn_ra_serf__fetch_sched_queue(sched, fetch, 0x100000);
+      SVN_TEST_ASSERT(svn_ra_serf__fetch_sched_next(&conn_idx, sched, 0, 1,
+                                                    0));
+    }
+
+  for (i = 0; i < 8; i++)
+    {
+      svn_ra_serf__fetch_sched_started(sched, 0, 0, 10000 + i * 100000);
+      svn_ra_serf__fetch_sched_completed(sched, 0, 0x100000,
+                                         110000 + i * 100000);
+    }
+  SVN_TEST_INT_ASSERT(svn_ra_serf__fetch_sched_depth(sched, 1), 2);
+
+  stats = svn_ra_serf__fetch_sched_stats(sched);
+  SVN_TEST_INT_ASSERT(stats->max_queued, 1);
+  SVN_TEST_INT_ASSERT(stats->max_in_flight, 8);
+  SVN_TEST_INT_ASSERT(stats->bytes, 8 * 0x100000);
+  SVN_TEST_INT_ASSERT(stats->max_depth, 8);
+  SVN_TEST_INT_ASSERT(stats->min_latency, 10000);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "libsvn_ra_serf is not linked into libsvn_ra");
+#endif
+}
+
 
 /* The test table.  */
 
@@ -1820,6 +2530,24 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check how last change applies to empty commit"),
     SVN_TEST_OPTS_PASS(commit_locked_file,
                        "check commit editor for a locked file"),
+    SVN_TEST_OPTS_PASS(get_files_test,
+                       "test svn_ra_get_files"),
+    SVN_TEST_OPTS_PASS(tunnel_get_files_test,
+                       "test svn_ra_get_files over a tunnel"),
+    SVN_TEST_PASS2(ra_svn_read_items,
+                   "parse ra_svn protocol items"),
+    SVN_TEST_PASS2(ra_svn_write_items,
+                   "write ra_svn protocol items"),
+    SVN_TEST_PASS2(ra_svn_command_callback,
+                   "ra_svn per-command notification"),
+    SVN_TEST_OPTS_PASS(tunnel_stream_compression_test,
+                       "test a compressed connection over a tunnel"),
+    SVN_TEST_OPTS_PASS(tunnel_response_cache_test,
+                       "test svnserve's response cache over a tunnel"),
+    SVN_TEST_PASS2(ra_serf_fetch_order,
+                   "ra_serf GET scheduling order"),
+    SVN_TEST_PASS2(ra_serf_fetch_pipeline_depth,
+                   "ra_serf GET pipeline depth adaptation"),
     SVN_TEST_NULL
   };
 
@@ -444,6 +444,385 @@ test_global_rights(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Parse the authz rules in CONTENTS into *AUTHZ_P, allocated in POOL. */
+static svn_error_t *
+parse_authz_string(svn_authz_t **authz_p,
+                   const char *contents,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create(contents, pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(buffer, pool);
+
+  return svn_error_trace(svn_repos_authz_parse(authz_p, stream, NULL, pool));
+}
+
+static svn_error_t *
+test_authz_lookup_reuse(apr_pool_t *pool)
+{
+  const char *contents =
+    "[/]"                                                                NL
+    "* = r"                                                              NL
+    ""                                                                   NL
+    "[/trunk/secret]"                                                    NL
+    "* ="                                                                NL
+    "alice = rw"                                                         NL
+    ""                                                                   NL
+    "[:glob:/**/private]"                                                NL
+    "* ="                                                                NL
+    ""                                                                   NL
+    "[:glob:/branches/*/src]"                                            NL
+    "bob = rw"                                                           NL
+    ""                                                                   NL
+    "[:glob:/branches/1.*/src/*.c]"                                      NL
+    "bob = r"                                                            NL
+    ""                                                                   NL
+    "[:glob:/*x/secret]"                                                 NL
+    "* ="                                                                NL;
+
+  /* A depth-first walk that keeps returning to different parents,
+   * followed by a few random jumps. */
+  const char *paths[] =
+    {
+      "/",
+      "/trunk",
+      "/trunk/a",
+      "/trunk/a/b",
+      "/trunk/a/b/private",
+      "/trunk/a/b/private/x",
+      "/trunk/a/b/c",
+      "/trunk/a/d",
+      "/trunk/secret",
+      "/trunk/secret/x",
+      "/trunk/secret/x/private",
+      "/trunk/z",
+      "/branches",
+      "/branches/1.x",
+      "/branches/1.x/src",
+      "/branches/1.x/src/main.c",
+      "/branches/1.x/src/main.h",
+      "/branches/1.x/doc",
+      "/branches/2.x/src/main.c",
+      "/trunk/secret/x",
+      "/trunk",
+      "/trunk/a/b/private",
+      "/branches/1.x/src/sub/private",
+      "/ax/secret",
+      "/xa/secret",
+      "/ax/public",
+      "/xa/secret",
+      NULL
+    };
+
+  const char *users[] = { NULL, "alice", "bob" };
+  const svn_repos_authz_access_t requests[] =
+    {
+      svn_authz_read,
+      svn_authz_write,
+      svn_authz_read | svn_authz_recursive,
+      svn_authz_write | svn_authz_recursive
+    };
+
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_authz_t *authz;
+  int u, r, pass, i;
+
+  /* All checks go through the same AUTHZ object and may therefore reuse
+   * lookup states and access decisions from the checks before them.
+   * Compare each result to that of a fresh AUTHZ object. */
+  SVN_ERR(parse_authz_string(&authz, contents, pool));
+
+  for (u = 0; u < (int)(sizeof(users) / sizeof(users[0])); ++u)
+    for (r = 0; r < (int)(sizeof(requests) / sizeof(requests[0])); ++r)
+      for (pass = 0; pass < 2; ++pass)
+        for (i = 0; paths[i]; ++i)
+          {
+            svn_authz_t *fresh_authz;
+            svn_boolean_t expected;
+            svn_boolean_t granted;
+
+            svn_pool_clear(iterpool);
+            SVN_ERR(parse_authz_string(&fresh_authz, contents, iterpool));
+
+            SVN_ERR(svn_repos_authz_check_access(fresh_authz, "repo",
+                                                 paths[i], users[u],
+                                                 requests[r], &expected,
+                                                 iterpool));
+            SVN_ERR(svn_repos_authz_check_access(authz, "repo",
+                                                 paths[i], users[u],
+                                                 requests[r], &granted,
+                                                 iterpool));
+
+            if (granted != expected)
+              return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                       "Access check %d for '%s' on '%s' "
+                                       "returned %s, expected %s",
+                                       (int)requests[r],
+                                       users[u] ? users[u] : "(anonymous)",
+                                       paths[i],
+                                       granted ? "TRUE" : "FALSE",
+                                       expected ? "TRUE" : "FALSE");
+          }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Return a large set of synthetic authz rules, most of them using
+ * wildcards, similar to what gets generated from directory services. */
+static const char *
+make_synthetic_rules(int rule_count,
+                     apr_pool_t *pool)
+{
+  svn_stringbuf_t *rules = svn_stringbuf_create("[/]" NL "* = r" NL NL,
+                                                pool);
+  int i;
+
+  /* A suffix pattern on a segment that is not the last one. */
+  svn_stringbuf_appendcstr(rules, "[:glob:/projects/*/*.private]" NL
+                                  "* =" NL NL);
+
+  for (i = 0; i < rule_count; ++i)
+    switch (i % 4)
+      {
+        case 0:
+          svn_stringbuf_appendcstr(rules,
+            apr_psprintf(pool, "[:glob:/projects/p%d/**/secret*]" NL
+                               "* =" NL
+                               "user%d = r" NL NL, i, i % 50));
+          break;
+
+        case 1:
+          svn_stringbuf_appendcstr(rules,
+            apr_psprintf(pool, "[:glob:/projects/*/branches/b%d*]" NL
+                               "user%d = rw" NL NL, i, i % 50));
+          break;
+
+        case 2:
+          svn_stringbuf_appendcstr(rules,
+            apr_psprintf(pool, "[:glob:/projects/p%d/trunk/*.c]" NL
+                               "* =" NL
+                               "user%d = rw" NL NL, i - 2, i % 50));
+          break;
+
+        default:
+          svn_stringbuf_appendcstr(rules,
+            apr_psprintf(pool, "[/projects/p%d/tags]" NL
+                               "user%d = rw" NL NL, i - 3, i % 50));
+          break;
+      }
+
+  return rules->data;
+}
+
+/* Return the paths to check against the rules of make_synthetic_rules()
+ * in the order of a depth-first tree walk. */
+static apr_array_header_t *
+make_synthetic_paths(int rule_count,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 0, sizeof(const char *));
+  int project, i;
+
+  for (project = 0; project < rule_count; project += 12)
+    {
+      const char *root = apr_psprintf(pool, "/projects/p%d", project);
+
+      APR_ARRAY_PUSH(paths, const char *) = root;
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(pool, root, "/trunk", SVN_VA_NULL);
+      for (i = 0; i < 8; ++i)
+        {
+          APR_ARRAY_PUSH(paths, const char *)
+            = apr_psprintf(pool, "%s/trunk/file%d.c", root, i);
+          APR_ARRAY_PUSH(paths, const char *)
+            = apr_psprintf(pool, "%s/trunk/sub/secret%d", root, i);
+        }
+
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(pool, root, "/branches", SVN_VA_NULL);
+      for (i = 0; i < 8; ++i)
+        APR_ARRAY_PUSH(paths, const char *)
+          = apr_psprintf(pool, "%s/branches/b%d/file.c", root, i * 5 + 1);
+
+      /* The second name is the first one reversed. */
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(pool, root, "/x.private/file", SVN_VA_NULL);
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(pool, root, "/etavirp.x/file", SVN_VA_NULL);
+
+      APR_ARRAY_PUSH(paths, const char *)
+        = apr_pstrcat(pool, root, "/tags/1.0/README", SVN_VA_NULL);
+    }
+
+  return paths;
+}
+
+/* Check USER's REQUIRED access to PATH in AUTHZ and return it in
+ * *GRANTED.  Compare the result to that of an authz object with the same
+ * rules but without any lookup state, i.e. to a walk of the rule tree that
+ * does not reuse anything from previous lookups.  Use POOL for all
+ * allocations. */
+static svn_error_t *
+check_against_fresh_authz(svn_boolean_t *granted,
+                          svn_authz_t *authz,
+                          const char *path,
+                          const char *user,
+                          svn_repos_authz_access_t required,
+                          apr_pool_t *pool)
+{
+  svn_authz_t *fresh_authz = apr_pcalloc(pool, sizeof(*fresh_authz));
+  svn_boolean_t expected;
+
+  fresh_authz->full = authz->full;
+  fresh_authz->authz_id = authz->authz_id;
+  fresh_authz->pool = pool;
+
+  SVN_ERR(svn_repos_authz_check_access(fresh_authz, "repo", path, user,
+                                       required, &expected, pool));
+  SVN_ERR(svn_repos_authz_check_access(authz, "repo", path, user,
+                                       required, granted, pool));
+
+  if (*granted != expected)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Access check %d for '%s' on '%s' "
+                             "returned %s, expected %s",
+                             (int)required, user ? user : "(anonymous)",
+                             path, *granted ? "TRUE" : "FALSE",
+                             expected ? "TRUE" : "FALSE");
+
+  return SVN_NO_ERROR;
+}
+
+/* Time checking USER's REQUIRED access on all PATHS in AUTHZ, print the
+ * result labelled with WHAT. */
+static svn_error_t *
+time_access_checks(svn_authz_t *authz,
+                   const apr_array_header_t *paths,
+                   const char *user,
+                   svn_repos_authz_access_t required,
+                   const char *what,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_boolean_t granted;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_repos_authz_check_access(authz, "repo",
+                                           APR_ARRAY_IDX(paths, i,
+                                                         const char *),
+                                           user, required, &granted,
+                                           iterpool));
+    }
+
+  printf("%s, %s: %d checks in %" APR_TIME_T_FMT " usec\n",
+         user ? user : "anonymous", what, paths->nelts,
+         apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Benchmark access checks against a large set of wildcard rules and
+ * verify their results. */
+static svn_error_t *
+test_authz_wildcard_bench(apr_pool_t *pool)
+{
+  const int rule_count = 2000;
+  const char *rules = make_synthetic_rules(rule_count, pool);
+  apr_array_header_t *paths = make_synthetic_paths(rule_count, pool);
+  const char *users[] = { NULL, "user2", "user7" };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_authz_t *authz;
+  apr_time_t start;
+  int u, i;
+
+  /* Known results for user7. */
+  const struct
+    {
+      const char *path;
+      svn_repos_authz_access_t required;
+      svn_boolean_t granted;
+    } expected[] =
+    {
+      { "/projects/p0", svn_authz_read, TRUE },
+      { "/projects/p0", svn_authz_write, FALSE },
+      { "/projects/p0/trunk/file1.c", svn_authz_read, FALSE },
+      { "/projects/p0/trunk/file1.h", svn_authz_read, TRUE },
+      { "/projects/p0/trunk/sub/secret1", svn_authz_read, FALSE },
+      { "/projects/p0/trunk/sub/public", svn_authz_read, TRUE },
+      { "/projects/p0/trunk", svn_authz_read | svn_authz_recursive, FALSE },
+      { "/projects/p1/trunk/file1.c", svn_authz_read, TRUE },
+      { "/projects/p0/x.private/file", svn_authz_read, FALSE },
+      { "/projects/p0/etavirp.x/file", svn_authz_read, TRUE },
+      { "/projects/p0/x.private", svn_authz_read, FALSE },
+      { "/projects/p0/etavirp.x", svn_authz_read, TRUE },
+      { "/projects/p0/etavirp.x/file", svn_authz_read, TRUE },
+      { NULL }
+    };
+
+  start = apr_time_now();
+  SVN_ERR(parse_authz_string(&authz, rules, pool));
+  printf("Parsed %d rules in %" APR_TIME_T_FMT " usec\n",
+         rule_count, apr_time_now() - start);
+
+  for (u = 0; u < (int)(sizeof(users) / sizeof(users[0])); ++u)
+    {
+      /* The first run constructs the lookup automaton.  The second run
+       * asks a different question and cannot use the decisions cached
+       * by the first, but follows the same automaton transitions.  Only
+       * the third one gets all its answers from the decision cache. */
+      SVN_ERR(time_access_checks(authz, paths, users[u], svn_authz_read,
+                                 "new automaton", iterpool));
+      SVN_ERR(time_access_checks(authz, paths, users[u],
+                                 svn_authz_read | svn_authz_recursive,
+                                 "existing automaton", iterpool));
+      SVN_ERR(time_access_checks(authz, paths, users[u], svn_authz_read,
+                                 "cached decisions", iterpool));
+    }
+
+  /* Verify a sample of the results against lookups from scratch.
+   * This is done in reverse order on a new AUTHZ to exercise different
+   * transitions and parent path reuse. */
+  SVN_ERR(parse_authz_string(&authz, rules, pool));
+  for (u = 0; u < (int)(sizeof(users) / sizeof(users[0])); ++u)
+    for (i = paths->nelts - 1; i >= 0; i -= 7)
+      {
+        svn_boolean_t granted;
+
+        svn_pool_clear(iterpool);
+        SVN_ERR(check_against_fresh_authz(&granted, authz,
+                                          APR_ARRAY_IDX(paths, i,
+                                                        const char *),
+                                          users[u], svn_authz_read,
+                                          iterpool));
+      }
+
+  for (i = 0; expected[i].path; ++i)
+    {
+      svn_boolean_t granted;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_against_fresh_authz(&granted, authz, expected[i].path,
+                                        "user7", expected[i].required,
+                                        iterpool));
+      if (granted != expected[i].granted)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Access check %d for 'user7' on '%s' "
+                                 "returned %s",
+                                 (int)expected[i].required,
+                                 expected[i].path,
+                                 granted ? "TRUE" : "FALSE");
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -453,6 +832,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_authz__parse"),
     SVN_TEST_PASS2(test_global_rights,
                    "test svn_authz__get_global_rights"),
+    SVN_TEST_PASS2(test_authz_lookup_reuse,
+                   "test reuse of authz lookup results"),
+    SVN_TEST_PASS2(test_authz_wildcard_bench,
+                   "benchmark authz checks with many wildcard rules"),
     SVN_TEST_NULL
   };
 
@@ -41,6 +41,7 @@
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_fs_private.h"
 
 /* be able to look into svn_config_t */
 #include "../../libsvn_subr/config_impl.h"
@@ -3274,6 +3275,557 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 }
 
 
+/* Test that the reporter produces the same edits when computing file
+   deltas on worker threads. */
+static svn_error_t *
+reporter_workers(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  svn_string_t *value;
+  svn_revnum_t base_rev;
+
+  /* The tree expected after updating to r2. */
+  static svn_test__tree_entry_t entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "Changed file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/bar",     "New file 'bar'.\n" },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/foo",     "New file 'foo'.\n" },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "Changed file 'pi'.\n" },
+    { "A/D/G/rho",   "This is the file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-workers",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Revision 2: change contents and properties, add and delete files. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  {
+    static svn_test__txn_script_command_t script_entries[] = {
+      { 'e', "iota",      "Changed file 'iota'.\n" },
+      { 'e', "A/D/G/pi",  "Changed file 'pi'.\n" },
+      { 'e', "A/mu",      "Changed file 'mu'.\n" },
+      { 'a', "A/D/foo",    "New file 'foo'.\n" },
+      { 'a', "A/B/bar",    "New file 'bar'.\n" },
+      { 'd', "A/D/H",      NULL },
+      { 'd', "A/B/E/beta", NULL }
+    };
+    SVN_ERR(svn_test__txn_script_exec(txn_root,
+                                      script_entries,
+                                      sizeof(script_entries)/
+                                       sizeof(script_entries[0]),
+                                      subpool));
+  }
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/gamma", "prop",
+                                  svn_string_create("value", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Run an update from r1 to r2 as well as a checkout of r2, each time
+     recording the editor commands in a temporary txn. */
+  for (base_rev = 0; base_rev <= 1; ++base_rev)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, base_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                                   txn_root, "", subpool));
+
+      SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+                                      TRUE, svn_depth_infinity, FALSE, FALSE,
+                                      editor, edit_baton, NULL, NULL, 0,
+                                      subpool));
+      SVN_ERR(svn_repos__report_set_workers(report_baton, 4, NULL));
+      SVN_ERR(svn_repos_set_path3(report_baton, "", base_rev,
+                                  svn_depth_infinity,
+                                  base_rev == 0, NULL, subpool));
+      SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+      SVN_ERR(svn_test__validate_tree(txn_root,
+                                      entries,
+                                      sizeof(entries)/sizeof(entries[0]),
+                                      subpool));
+      SVN_ERR(svn_fs_node_prop(&value, txn_root, "A/D/gamma", "prop",
+                               subpool));
+      SVN_TEST_STRING_ASSERT(value ? value->data : NULL, "value");
+
+      svn_error_clear(svn_fs_abort_txn(txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+reporter_checkout_cache(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  svn_repos__checkout_cache_t *cache;
+  const char *cache_dir;
+  apr_hash_t *dirents;
+  svn_string_t *value;
+  svn_boolean_t supported;
+  apr_int64_t generation;
+  int i;
+
+  /* The views to check out with and the expected number of cache entries
+     afterwards. */
+  static const struct
+    {
+      const char *view;
+      unsigned int entries;
+    } runs[] = {
+      { "view1", 1 },
+      { "view1", 1 },
+      { "view2", 2 },
+      { NULL,    2 }
+    };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-checkout-cache",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Checkouts get only cached if revprop changes can be detected. */
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &generation, fs,
+                                             pool));
+  if (!supported)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "revprop generation not supported");
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "test-checkout-cache",
+                                    pool));
+  SVN_ERR(svn_repos__checkout_cache_create(&cache, cache_dir, 0x100000,
+                                           pool));
+
+  /* Revision 1: the greek tree with a property. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/gamma", "prop",
+                                  svn_string_create("value", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Check out r1 repeatedly.  The first checkout for each view gets
+     recorded, later ones get replayed from the cache. */
+  for (i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                                   txn_root, "", subpool));
+
+      SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                      "/", "", NULL, TRUE,
+                                      svn_depth_infinity, FALSE, FALSE,
+                                      editor, edit_baton, NULL, NULL, 0,
+                                      subpool));
+      SVN_ERR(svn_repos__report_set_checkout_cache(report_baton, cache,
+                                                   runs[i].view));
+      SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                                  TRUE, NULL, subpool));
+      SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+      SVN_ERR(svn_test__check_greek_tree(txn_root, subpool));
+      SVN_ERR(svn_fs_node_prop(&value, txn_root, "A/D/gamma", "prop",
+                               subpool));
+      SVN_TEST_STRING_ASSERT(value ? value->data : NULL, "value");
+
+      SVN_ERR(svn_io_get_dirents3(&dirents, cache_dir, TRUE, subpool,
+                                  subpool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(dirents), runs[i].entries);
+
+      svn_error_clear(svn_fs_abort_txn(txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check out REVISION of REPOS to EDITOR / EDIT_BATON, using CACHE.
+   Use POOL for allocations. */
+static svn_error_t *
+cached_checkout(svn_repos_t *repos,
+                svn_revnum_t revision,
+                svn_repos__checkout_cache_t *cache,
+                const svn_delta_editor_t *editor,
+                void *edit_baton,
+                apr_pool_t *pool)
+{
+  void *report_baton;
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, revision, repos,
+                                  "/", "", NULL, TRUE,
+                                  svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, 0,
+                                  pool));
+  SVN_ERR(svn_repos__report_set_checkout_cache(report_baton, cache,
+                                               "view"));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                              TRUE, NULL, pool));
+
+  return svn_error_trace(svn_repos_finish_report(report_baton, pool));
+}
+
+/* Set *COUNT to the number of entries in the checkout cache directory
+   CACHE_DIR.  Use POOL for temporary allocations. */
+static svn_error_t *
+count_cache_entries(unsigned int *count,
+                    const char *cache_dir,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, cache_dir, TRUE, pool, pool));
+  *count = apr_hash_count(dirents);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+reporter_checkout_cache_skelta(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_repos__checkout_cache_t *cache;
+  const char *cache_dir;
+  svn_boolean_t supported;
+  apr_int64_t generation;
+  unsigned int count;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-checkout-cache-skelta",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &generation, fs,
+                                             pool));
+  if (!supported)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "revprop generation not supported");
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir,
+                                    "test-checkout-cache-skelta", pool));
+  SVN_ERR(svn_repos__checkout_cache_create(&cache, cache_dir, 0x100000,
+                                           pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Record the checkout for a consumer that discards all text deltas,
+     like mod_dav_svn does in skelta mode. */
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache,
+                          svn_delta_default_editor(pool), NULL, pool));
+  SVN_ERR(count_cache_entries(&count, cache_dir, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+
+  /* Replaying it to a consumer that wants the texts must produce them. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs, txn_root, "",
+                               pool));
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache, editor, edit_baton,
+                          pool));
+  SVN_ERR(svn_test__check_greek_tree(txn_root, pool));
+
+  SVN_ERR(count_cache_entries(&count, cache_dir, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  svn_error_clear(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+reporter_checkout_cache_recreate(const svn_test_opts_t *opts,
+                                 apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-checkout-cache-recreate";
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_repos__checkout_cache_t *cache;
+  const char *cache_dir;
+  const char *uuid;
+  svn_stringbuf_t *contents;
+  svn_boolean_t supported;
+  apr_int64_t generation;
+  unsigned int count;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &generation, fs,
+                                             pool));
+  if (!supported)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "revprop generation not supported");
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir,
+                                    "test-checkout-cache-recreate", pool));
+  SVN_ERR(svn_repos__checkout_cache_create(&cache, cache_dir, 0x100000,
+                                           pool));
+
+  /* Record a checkout of r1. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs, txn_root, "",
+                               pool));
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache, editor, edit_baton,
+                          pool));
+  SVN_ERR(svn_test__check_greek_tree(txn_root, pool));
+  svn_error_clear(svn_fs_abort_txn(txn, pool));
+
+  /* Replace the repository with a different one at the same path, with
+     the same UUID, youngest revision and revprop generation. */
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_fs_set_uuid(fs, uuid, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "Replaced file 'iota'.\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 1);
+
+  /* The old recording must not be replayed for the new repository. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs, txn_root, "",
+                               pool));
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache, editor, edit_baton,
+                          pool));
+  SVN_ERR(svn_test__get_file_contents(txn_root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "Replaced file 'iota'.\n");
+
+  SVN_ERR(count_cache_entries(&count, cache_dir, pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+  svn_error_clear(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Edit baton for an editor that wants the text deltas of files no
+   larger than MAX_SIZE only, like mod_dav_svn does for the texts it
+   inlines into its update report. */
+struct inline_edit_baton
+{
+  svn_fs_root_t *root;
+  svn_filesize_t max_size;
+  int inlined;
+  int skipped;
+};
+
+/* File baton for the editor above. */
+struct inline_file_baton
+{
+  struct inline_edit_baton *eb;
+  const char *path;
+};
+
+static svn_error_t *
+inline_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *dir_pool,
+                 void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inline_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *dir_pool,
+                     void **child_baton)
+{
+  *child_baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inline_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *file_pool,
+                void **file_baton)
+{
+  struct inline_file_baton *fb = apr_pcalloc(file_pool, sizeof(*fb));
+
+  fb->eb = parent_baton;
+  fb->path = apr_pstrdup(file_pool, path);
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inline_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  struct inline_file_baton *fb = file_baton;
+  svn_filesize_t length;
+
+  SVN_ERR(svn_fs_file_length(&length, fb->eb->root, fb->path, pool));
+  if (length > fb->eb->max_size)
+    {
+      fb->eb->skipped++;
+      *handler = svn_delta_noop_window_handler;
+      *handler_baton = NULL;
+    }
+  else
+    {
+      fb->eb->inlined++;
+      svn_txdelta_apply(svn_stream_empty(pool), svn_stream_empty(pool),
+                        NULL, NULL, pool, handler, handler_baton);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+reporter_checkout_cache_inline_size(const svn_test_opts_t *opts,
+                                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  svn_delta_editor_t *inline_editor;
+  struct inline_edit_baton inline_baton = { 0 };
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_repos__checkout_cache_t *cache;
+  const char *cache_dir;
+  svn_boolean_t supported;
+  apr_int64_t generation;
+  unsigned int count;
+
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-checkout-cache-inline-size",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs__try_get_revprop_generation(&supported, &generation, fs,
+                                             pool));
+  if (!supported)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "revprop generation not supported");
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir,
+                                    "test-checkout-cache-inline-size",
+                                    pool));
+  SVN_ERR(svn_repos__checkout_cache_create(&cache, cache_dir, 0x100000,
+                                           pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Record the checkout for a consumer that wants the shorter texts of
+     the greek tree only. */
+  inline_editor = svn_delta_default_editor(pool);
+  inline_editor->open_root = inline_open_root;
+  inline_editor->add_directory = inline_add_directory;
+  inline_editor->add_file = inline_add_file;
+  inline_editor->apply_textdelta = inline_apply_textdelta;
+  SVN_ERR(svn_fs_revision_root(&inline_baton.root, fs, youngest_rev, pool));
+  inline_baton.max_size = 24;
+
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache, inline_editor,
+                          &inline_baton, pool));
+  SVN_TEST_ASSERT(inline_baton.inlined > 0);
+  SVN_TEST_ASSERT(inline_baton.skipped > 0);
+
+  /* A consumer with a larger inline size must get all texts. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs, txn_root, "",
+                               pool));
+  SVN_ERR(cached_checkout(repos, youngest_rev, cache, editor, edit_baton,
+                          pool));
+  SVN_ERR(svn_test__check_greek_tree(txn_root, pool));
+
+  SVN_ERR(count_cache_entries(&count, cache_dir, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  svn_error_clear(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
@@ -3512,6 +4064,141 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_path_change_receiver_t, appending CHANGE to the
+   svn_stringbuf_t in BATON. */
+static svn_error_t *
+log_change_printer(void *baton,
+                   svn_repos_path_change_t *change,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = baton;
+
+  svn_stringbuf_appendcstr(buf,
+                           apr_psprintf(scratch_pool, "  %d %d %s\n",
+                                        (int)change->change_kind,
+                                        (int)change->node_kind,
+                                        change->path.data));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_log_entry_receiver_t, appending LOG_ENTRY to the
+   svn_stringbuf_t in BATON. */
+static svn_error_t *
+log_entry_printer(void *baton,
+                  svn_repos_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = baton;
+  svn_string_t *msg = log_entry->revprops
+                    ? svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_LOG)
+                    : NULL;
+
+  svn_stringbuf_appendcstr(buf,
+                           apr_psprintf(scratch_pool, "r%ld %s\n",
+                                        log_entry->revision,
+                                        msg ? msg->data : "(no log)"));
+  return SVN_NO_ERROR;
+}
+
+/* Test that preparing log entries on worker threads yields the same
+   logs as doing it on the receiving thread. */
+static svn_error_t *
+get_logs_workers(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+
+  /* Logs to compare: start, end, limit and path. */
+  static const struct {
+    svn_revnum_t start;
+    svn_revnum_t end;
+    int limit;
+    const char *path;
+  } tests[] = {
+    { SVN_INVALID_REVNUM, 0, 0, NULL },
+    { 0, SVN_INVALID_REVNUM, 0, NULL },
+    { 20, 3, 7, NULL },
+    { 1, SVN_INVALID_REVNUM, 0, "A/mu" },
+    { 1, SVN_INVALID_REVNUM, 4, "A/B" },
+    { SVN_INVALID_REVNUM, 1, 0, "A/mu" }
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-workers",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Revisions 2 to 30:  Tweak A/mu or A/B/lambda, sometimes add a file. */
+  for (i = 2; i <= 30; i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                     svn_string_createf(subpool, "Log %d", i),
+                                     subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          i % 2 ? "A/mu" : "A/B/lambda",
+                                          apr_psprintf(subpool, "r%d", i),
+                                          subpool));
+      if (i % 3 == 0)
+        SVN_ERR(svn_fs_make_file(txn_root,
+                                 apr_psprintf(subpool, "A/D/file%d", i),
+                                 subpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+    }
+
+  for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+      svn_stringbuf_t *expected;
+      svn_stringbuf_t *actual;
+      apr_array_header_t *paths = NULL;
+
+      svn_pool_clear(subpool);
+      expected = svn_stringbuf_create_empty(subpool);
+      actual = svn_stringbuf_create_empty(subpool);
+      if (tests[i].path)
+        {
+          paths = apr_array_make(subpool, 1, sizeof(const char *));
+          APR_ARRAY_PUSH(paths, const char *) = tests[i].path;
+        }
+
+      svn_repos__set_log_workers(repos, 0, NULL);
+      SVN_ERR(svn_repos_get_logs5(repos, paths, tests[i].start, tests[i].end,
+                                  tests[i].limit, FALSE, FALSE, NULL,
+                                  NULL, NULL,
+                                  log_change_printer, expected,
+                                  log_entry_printer, expected, subpool));
+
+      svn_repos__set_log_workers(repos, 3, NULL);
+      SVN_ERR(svn_repos_get_logs5(repos, paths, tests[i].start, tests[i].end,
+                                  tests[i].limit, FALSE, FALSE, NULL,
+                                  NULL, NULL,
+                                  log_change_printer, actual,
+                                  log_entry_printer, actual, subpool));
+
+      SVN_TEST_ASSERT(expected->len > 0);
+      SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -4501,10 +5188,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_workers,
+                       "test reporter with delta worker threads"),
+    SVN_TEST_OPTS_PASS(reporter_checkout_cache,
+                       "test reporter with checkout cache"),
+    SVN_TEST_OPTS_PASS(reporter_checkout_cache_skelta,
+                       "replay a checkout recorded without text deltas"),
+    SVN_TEST_OPTS_PASS(reporter_checkout_cache_recreate,
+                       "checkout cache after recreating the repository"),
+    SVN_TEST_OPTS_PASS(reporter_checkout_cache_inline_size,
+                       "replay a checkout recorded with a small inline size"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(get_logs_workers,
+                       "test svn_repos_get_logs with worker threads"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
     SVN_TEST_OPTS_PASS(issue_4060,
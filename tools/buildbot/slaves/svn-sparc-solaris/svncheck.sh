@@ -28,7 +28,12 @@ cd ../obj
 LD_PRELOAD_64=/export/home/wandisco/buildbot/install/lib/preloadable_libiconv.so
 export LD_PRELOAD_64
 
-if [ $SVN_VER_MINOR -ge 10 ]; then
+if [ $SVN_VER_MINOR -ge 11 ]; then
+  echo "============ make svnserveautocheck"
+  make svnserveautocheck CLEANUP=1 PARALLEL=30 THREADED=1 GLOBAL_SCHEDULER=1 || exit $?
+  echo "============ make svnserveautocheck EVENT_LOOP=1"
+  make svnserveautocheck CLEANUP=1 PARALLEL=30 EVENT_LOOP=1 GLOBAL_SCHEDULER=1 || exit $?
+elif [ $SVN_VER_MINOR -ge 10 ]; then
   echo "============ make svnserveautocheck"
   make svnserveautocheck CLEANUP=1 PARALLEL=30 THREADED=1 GLOBAL_SCHEDULER=1 || exit $?
 elif [ $SVN_VER_MINOR -ge 9 ]; then
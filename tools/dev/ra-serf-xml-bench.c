@@ -0,0 +1,279 @@
+/* ra-serf-xml-bench.c -- measure ra_serf XML response parsing performance
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* This tool generates a log-report response body with a given number
+ * of log items and feeds it through the transition table driven XML
+ * parser of libsvn_ra_serf, just like a response to "svn log -v" would
+ * be processed.  It reports the parser throughput.
+ *
+ * Only long-standing ra_serf internals are used, so the same source can
+ * be built against older revisions of the library to compare the cost
+ * of their state and pool handling.
+ */
+
+#include <stdlib.h>
+
+#include <serf.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_string.h"
+#include "svn_time.h"
+#include "svn_xml.h"
+
+#include "../../subversion/libsvn_ra_serf/ra_serf.h"
+
+#include "svn_private_config.h"
+
+/* Parser states, modeled after the log-report parser in ra_serf. */
+enum log_state_e {
+  INITIAL = 0,
+  REPORT,
+  ITEM,
+  VERSION,
+  CREATOR,
+  DATE,
+  COMMENT,
+  ADDED_PATH,
+  MODIFIED_PATH
+};
+
+#define D_ "DAV:"
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t log_ttable[] = {
+  { INITIAL, S_, "log-report", REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, "log-item", ITEM,
+    FALSE, { NULL }, TRUE },
+
+  { ITEM, D_, "version-name", VERSION,
+    TRUE, { NULL }, TRUE },
+
+  { ITEM, D_, "creator-displayname", CREATOR,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { ITEM, S_, "date", DATE,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { ITEM, D_, "comment", COMMENT,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { ITEM, S_, "added-path", ADDED_PATH,
+    TRUE, { "?node-kind", "?text-mods", "?prop-mods",
+            "?copyfrom-path", "?copyfrom-rev", NULL }, TRUE },
+
+  { ITEM, S_, "modified-path", MODIFIED_PATH,
+    TRUE, { "?node-kind", "?text-mods", "?prop-mods", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Conforms to svn_ra_serf__xml_closed_t.  BATON is an apr_uint64_t
+ * counting the log items. */
+static svn_error_t *
+log_closed(svn_ra_serf__xml_estate_t *xes,
+           void *baton,
+           int leaving_state,
+           const svn_string_t *cdata,
+           apr_hash_t *attrs,
+           apr_pool_t *scratch_pool)
+{
+  apr_uint64_t *items = baton;
+
+  if (leaving_state == ITEM)
+    ++*items;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a log-report response body with ITEMS log items, each of them
+ * listing PATHS changed paths.  Allocate the result in RESULT_POOL. */
+static svn_string_t *
+make_log_report(int items,
+                int paths,
+                apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *body = svn_stringbuf_create_empty(result_pool);
+  apr_pool_t *iterpool = svn_pool_create(result_pool);
+  int i, k;
+
+  svn_stringbuf_appendcstr(body,
+                           "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                           "<S:log-report xmlns:S=\"svn:\" "
+                           "xmlns:D=\"DAV:\">\n");
+  for (i = 0; i < items; ++i)
+    {
+      svn_pool_clear(iterpool);
+      svn_stringbuf_appendcstr(body, apr_psprintf(iterpool,
+        "<S:log-item>\n"
+        "<D:version-name>%d</D:version-name>\n"
+        "<D:creator-displayname>user%d</D:creator-displayname>\n"
+        "<S:date>2018-01-01T00:00:00.%06dZ</S:date>\n"
+        "<D:comment>Change number %d.</D:comment>\n",
+        items - i, i % 10, i % 1000000, items - i));
+
+      for (k = 0; k < paths; ++k)
+        svn_stringbuf_appendcstr(body, apr_psprintf(iterpool,
+          (k == 0)
+            ? "<S:added-path node-kind=\"file\" text-mods=\"true\" "
+              "prop-mods=\"false\">/trunk/dir%d/file%d</S:added-path>\n"
+            : "<S:modified-path node-kind=\"file\" text-mods=\"true\" "
+              "prop-mods=\"false\">/trunk/dir%d/file%d</S:modified-path>\n",
+          i % 100, k));
+
+      svn_stringbuf_appendcstr(body, "</S:log-item>\n");
+    }
+  svn_stringbuf_appendcstr(body, "</S:log-report>\n");
+
+  svn_pool_destroy(iterpool);
+  return svn_string_create_from_buf(body, result_pool);
+}
+
+/* Parse BODY as a 200 response and add the number of log items to *ITEMS.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parse_body(apr_uint64_t *items,
+           const svn_string_t *body,
+           apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session;
+  svn_ra_serf__xml_context_t *xmlctx;
+  svn_ra_serf__handler_t *handler;
+  serf_bucket_alloc_t *bkt_alloc;
+  serf_bucket_t *response;
+  svn_error_t *err;
+
+  /* The handler requires a session but does not use it for parsing. */
+  session = apr_pcalloc(scratch_pool, sizeof(*session));
+
+  xmlctx = svn_ra_serf__xml_context_create(log_ttable, NULL, log_closed,
+                                           NULL, items, scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+  handler->sline.code = 200;
+
+  bkt_alloc = serf_bucket_allocator_create(scratch_pool, NULL, NULL);
+  response = serf_bucket_simple_create(body->data, body->len, NULL, NULL,
+                                       bkt_alloc);
+
+  err = handler->response_handler(NULL, response, handler->response_baton,
+                                  scratch_pool);
+
+  /* Running out of data is the expected way to end the response. */
+  if (err && APR_STATUS_IS_EOF(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Parse a log-report with ITEMS items ITERATIONS times and print the
+ * results.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_benchmark(int items,
+              int iterations,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_string_t *body;
+  apr_uint64_t parsed = 0;
+  apr_time_t start, duration;
+  double seconds;
+  int i;
+
+  body = make_log_report(items, 5, scratch_pool);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(parse_body(&parsed, body, iterpool));
+    }
+  duration = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  if (parsed != (apr_uint64_t)items * iterations)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             _("Parsed %" APR_UINT64_T_FMT " log items "
+                               "instead of %d"),
+                             parsed / iterations, items);
+
+  seconds = duration > 0 ? (double)duration / APR_USEC_PER_SEC : 1e-6;
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             _("%d log items, %" APR_SIZE_T_FMT " bytes, "
+                               "%d iterations\n"),
+                             items, body->len, iterations));
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             _("  %.3f s, %.0f items/s, %.1f MB/s\n"),
+                             seconds, parsed / seconds,
+                             (double)body->len * iterations
+                               / seconds / 0x100000));
+
+  return SVN_NO_ERROR;
+}
+
+int main (int argc, const char *argv[])
+{
+  apr_pool_t *pool = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int items = 100000;
+  int iterations = 10;
+
+  apr_initialize();
+  atexit(apr_terminate);
+
+  pool = svn_pool_create(NULL);
+
+  if (argc > 3)
+    err = svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                           _("Usage: ra-serf-xml-bench [ITEMS [ITERATIONS]]"));
+  else
+    {
+      if (argc > 1)
+        {
+          items = atoi(argv[1]);
+          if (items <= 0)
+            err = svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                    _("Invalid number of items '%s'"),
+                                    argv[1]);
+        }
+      if (!err && argc > 2)
+        {
+          iterations = atoi(argv[2]);
+          if (iterations <= 0)
+            err = svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                    _("Invalid number of iterations '%s'"),
+                                    argv[2]);
+        }
+    }
+
+  if (!err)
+    err = run_benchmark(items, iterations, pool);
+
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "ra-serf-xml-bench: ");
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+/* ra-svn-parser-bench.c -- measure ra_svn protocol parsing performance
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* This tool replays a captured ra_svn protocol transcript, i.e. the raw
+ * data sent in one direction of an svn:// connection, through the item
+ * parser of libsvn_ra_svn and reports the parser throughput.
+ *
+ * Such transcripts can be recorded e.g. by putting "socat -r req -R resp"
+ * between client and svnserve.  Server responses ("resp") exercise the
+ * client-side parser while requests ("req") exercise svnserve's one.
+ */
+
+#include <stdlib.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_string.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_time.h"
+#include "svn_ra_svn.h"
+
+#include "private/svn_ra_svn_private.h"
+
+#include "svn_private_config.h"
+
+/* Parse all items in TRANSCRIPT and add the number of items to *ITEMS.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parse_transcript(apr_uint64_t *items,
+                 const svn_string_t *transcript,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_ra_svn_conn_t *conn;
+  svn_error_t *err;
+
+  conn = svn_ra_svn_create_conn5(NULL,
+                                 svn_stream_from_string(transcript,
+                                                        scratch_pool),
+                                 svn_stream_empty(scratch_pool),
+                                 0, 0, 0, 0, 0, scratch_pool);
+  while (TRUE)
+    {
+      svn_ra_svn__item_t *item;
+
+      /* Per-item pool, just like the command loop in svnserve. */
+      svn_pool_clear(iterpool);
+      err = svn_ra_svn__read_item(conn, iterpool, &item);
+      if (err)
+        break;
+
+      ++*items;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Running out of data is the expected way to end the replay. */
+  if (err && err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Replay the transcript at PATH ITERATIONS times and print the results.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_benchmark(const char *path,
+              int iterations,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *contents;
+  svn_string_t *transcript;
+  apr_uint64_t items = 0;
+  apr_time_t start, duration;
+  double seconds;
+  int i;
+
+  /* Read the whole transcript up-front to not measure disk I/O. */
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, scratch_pool));
+  transcript = svn_string_create_from_buf(contents, scratch_pool);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(parse_transcript(&items, transcript, iterpool));
+    }
+  duration = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  seconds = duration > 0 ? (double)duration / APR_USEC_PER_SEC : 1e-6;
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             _("%s: %" APR_UINT64_T_FMT " items, "
+                               "%" APR_SIZE_T_FMT " bytes, %d iterations\n"),
+                             path, items / iterations, transcript->len,
+                             iterations));
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             _("  %.3f s, %.0f items/s, %.1f MB/s\n"),
+                             seconds, items / seconds,
+                             (double)transcript->len * iterations
+                               / seconds / 0x100000));
+
+  return SVN_NO_ERROR;
+}
+
+int main (int argc, const char *argv[])
+{
+  apr_pool_t *pool = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int iterations = 100;
+
+  apr_initialize();
+  atexit(apr_terminate);
+
+  pool = svn_pool_create(NULL);
+
+  if (argc < 2 || argc > 3)
+    err = svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                           _("Usage: ra-svn-parser-bench TRANSCRIPT "
+                             "[ITERATIONS]"));
+  else if (argc == 3)
+    {
+      iterations = atoi(argv[2]);
+      if (iterations <= 0)
+        err = svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("Invalid number of iterations '%s'"),
+                                argv[2]);
+    }
+
+  if (!err)
+    err = run_benchmark(svn_dirent_canonicalize(argv[1], pool), iterations,
+                        pool);
+
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "ra-svn-parser-bench: ");
+
+  return 0;
+}